@@ -30,6 +30,7 @@
 
 #include "DetectorConstruction.hh"
 #include "ActionInitialization.hh"
+#include "K600PhysicsList.hh"
 
 #ifdef G4MULTITHREADED
 #include "G4MTRunManager.hh"
@@ -43,9 +44,6 @@
 #include "QGSP_BERT.hh"
 #include "QGSP_BERT_HP.hh"
 
-#include "G4PhysListFactory.hh"
-#include "G4RadioactiveDecayPhysics.hh"
-
 #include "Randomize.hh"
 
 #ifdef G4VIS_USE
@@ -61,9 +59,13 @@
 namespace {
     void PrintUsage() {
         G4cerr << " Usage: " << G4endl;
-        G4cerr << " exampleB4a [-m macro ] [-u UIsession] [-t nThreads]" << G4endl;
+        G4cerr << " exampleB4a [-m macro ] [-u UIsession] [-t nThreads] [-p physics]" << G4endl;
         G4cerr << "   note: -t option is available only for multi-threaded mode."
         << G4endl;
+        G4cerr << "   physics: full (default), em_decay, emstandard_opt4 or emlivermore,"
+        << G4endl;
+        G4cerr << "   also /K600/physics/list before /run/initialize in the macro."
+        << G4endl;
     }
 }
 
@@ -73,19 +75,21 @@ int main(int argc,char** argv)
 {
     // Evaluate arguments
     //
-    if ( argc > 7 ) {
+    if ( argc > 9 ) {
         PrintUsage();
         return 1;
     }
     
     G4String macro;
     G4String session;
+    G4String physics = "full";
 #ifdef G4MULTITHREADED
     G4int nThreads = 3;
 #endif
     for ( G4int i=1; i<argc; i=i+2 ) {
         if      ( G4String(argv[i]) == "-m" ) macro = argv[i+1];
         else if ( G4String(argv[i]) == "-u" ) session = argv[i+1];
+        else if ( G4String(argv[i]) == "-p" ) physics = argv[i+1];
 #ifdef G4MULTITHREADED
         else if ( G4String(argv[i]) == "-t" ) {
             nThreads = G4UIcommand::ConvertToInt(argv[i+1]);
@@ -134,15 +138,11 @@ int main(int argc,char** argv)
      */
     
     ////////////////////////////////////////////////////////////////////
-    //      Initialising the Physics List with Radioactive Decay
+    //      Initialising the Physics List (QGSP_BERT with Radioactive Decay,
+    //      or electromagnetic only: see K600PhysicsList)
     ////////////////////////////////////////////////////////////////////
     
-    G4PhysListFactory factory;
-    G4VModularPhysicsList* phys = 0;
-    G4String physName = "QGSP_BERT";
-    // reference PhysicsList via its name
-    phys = factory.GetReferencePhysList(physName);
-    phys->RegisterPhysics(new G4RadioactiveDecayPhysics());
+    K600PhysicsList* phys = new K600PhysicsList(physics);
     runManager->SetUserInitialization(phys);
     
     
@@ -150,9 +150,9 @@ int main(int argc,char** argv)
     = new ActionInitialization(detConstruction);
     runManager->SetUserInitialization(actionInitialization);
     
-    // Initialize G4 kernel
+    // Initialize G4 kernel: /run/initialize in the macros, after the
+    // physics configuration (/K600/physics/list) if any
     //
-    runManager->Initialize();
     
 #ifdef G4VIS_USE
     // Initialize visualization
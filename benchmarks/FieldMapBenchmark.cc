@@ -0,0 +1,324 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+//      Micro-benchmark of the mapped quadrupole field
+//
+//      Compares field evaluations per second of MagneticFieldMapping (flat,
+//      interleaved cells) against the previous storage of three nested
+//      vector<vector<vector<double>>> tables, and checks that both agree.
+//      The quadrupole-folded, single-precision and tiled variants of the
+//      flat map are compared in the same way.
+//
+//      Random points defeat the last-cell cache of MagneticFieldMapping; the
+//      points of straight tracks sampled like the stages of RK4 steps show
+//      its effect. The gradient of GetFieldValueAndGradient is checked
+//      against central differences.
+//
+//      Usage: FieldMapBenchmark [fieldMap.TABLE] [nEvaluations] [stepLength/mm]
+//
+
+#include "MagneticFieldMapping.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+namespace {
+
+  //------------------------------------------------------------------
+  //    The previous implementation, kept here as the reference
+  class NestedFieldMap
+  {
+  public:
+    NestedFieldMap(const char* filename, double zOffset)
+      : fZoffset(zOffset), invertX(false), invertY(false), invertZ(false)
+    {
+      ifstream file(filename);
+      char buffer[256];
+      file.getline(buffer,256);
+      file >> nx >> ny >> nz;
+
+      xField.assign(nx, vector< vector<double> >(ny, vector<double>(nz)));
+      yField = xField;
+      zField = xField;
+
+      do {
+        file.getline(buffer,256);
+      } while ( buffer[1]!='0');
+
+      double xval=0.,yval=0.,zval=0.,bx,by,bz,permeability;
+      for (int ix=0; ix<nx; ix++) {
+        for (int iy=0; iy<ny; iy++) {
+          for (int iz=0; iz<nz; iz++) {
+            file >> xval >> yval >> zval >> bx >> by >> bz >> permeability;
+            if ( ix==0 && iy==0 && iz==0 ) {
+              minx = xval*meter; miny = yval*meter; minz = zval*meter;
+            }
+            xField[ix][iy][iz] = bx*tesla;
+            yField[ix][iy][iz] = by*tesla;
+            zField[ix][iy][iz] = bz*tesla;
+          }
+        }
+      }
+      maxx = xval*meter; maxy = yval*meter; maxz = zval*meter;
+
+      if (maxx < minx) {swap(maxx,minx); invertX = true;}
+      if (maxy < miny) {swap(maxy,miny); invertY = true;}
+      if (maxz < minz) {swap(maxz,minz); invertZ = true;}
+      dx = maxx - minx; dy = maxy - miny; dz = maxz - minz;
+    }
+
+    void GetFieldValue(const double point[4], double* Bfield) const
+    {
+      double x = point[0], y = point[1], z = point[2] + fZoffset;
+
+      // The upper edges are excluded: the previous code read one cell past the table there
+      if ( x>=minx && x<maxx && y>=miny && y<maxy && z>=minz && z<maxz ) {
+        double xfraction = (x - minx)/dx, yfraction = (y - miny)/dy, zfraction = (z - minz)/dz;
+        if (invertX) { xfraction = 1 - xfraction;}
+        if (invertY) { yfraction = 1 - yfraction;}
+        if (invertZ) { zfraction = 1 - zfraction;}
+
+        double xdindex, ydindex, zdindex;
+        double xlocal = std::modf(xfraction*(nx-1), &xdindex);
+        double ylocal = std::modf(yfraction*(ny-1), &ydindex);
+        double zlocal = std::modf(zfraction*(nz-1), &zdindex);
+        int xi = static_cast<int>(xdindex), yi = static_cast<int>(ydindex), zi = static_cast<int>(zdindex);
+
+        const vector< vector< vector<double> > >* tables[3] = { &xField, &yField, &zField };
+        for (int k=0; k<3; k++) {
+          const vector< vector< vector<double> > >& t = *tables[k];
+          Bfield[k] =
+            t[xi  ][yi  ][zi  ] * (1-xlocal) * (1-ylocal) * (1-zlocal) +
+            t[xi  ][yi  ][zi+1] * (1-xlocal) * (1-ylocal) *    zlocal  +
+            t[xi  ][yi+1][zi  ] * (1-xlocal) *    ylocal  * (1-zlocal) +
+            t[xi  ][yi+1][zi+1] * (1-xlocal) *    ylocal  *    zlocal  +
+            t[xi+1][yi  ][zi  ] *    xlocal  * (1-ylocal) * (1-zlocal) +
+            t[xi+1][yi  ][zi+1] *    xlocal  * (1-ylocal) *    zlocal  +
+            t[xi+1][yi+1][zi  ] *    xlocal  *    ylocal  * (1-zlocal) +
+            t[xi+1][yi+1][zi+1] *    xlocal  *    ylocal  *    zlocal ;
+        }
+      } else {
+        Bfield[0] = Bfield[1] = Bfield[2] = 0.0;
+      }
+    }
+
+    double minx, maxx, miny, maxy, minz, maxz;
+
+  private:
+    vector< vector< vector<double> > > xField, yField, zField;
+    int nx, ny, nz;
+    double dx, dy, dz;
+    double fZoffset;
+    bool invertX, invertY, invertZ;
+  };
+
+  //------------------------------------------------------------------
+  template <class FieldMap, class ReferenceMap>
+  double MaxDifference(const FieldMap& map, const ReferenceMap& reference, const vector<double>& points)
+  {
+    double maxDifference = 0., B0[3], B1[3];
+    for (size_t i=0; i<std::min(points.size(), size_t(400000)); i+=4) {
+      map.GetFieldValue(&points[i], B0);
+      reference.GetFieldValue(&points[i], B1);
+      for (int k=0; k<3; k++) maxDifference = std::max(maxDifference, std::abs(B0[k] - B1[k]));
+    }
+    return maxDifference;
+  }
+
+  //------------------------------------------------------------------
+  template <class FieldMap>
+  double EvaluationsPerSecond(const FieldMap& map, const vector<double>& points, double& checksum)
+  {
+    double B[3];
+    checksum = 0.;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i=0; i<points.size(); i+=4) {
+      map.GetFieldValue(&points[i], B);
+      checksum += B[0] + B[1] + B[2];
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return (points.size()/4)/elapsed.count();
+  }
+
+  //------------------------------------------------------------------
+  //    Points of straight tracks through the box, four per step of length h
+  //    (the stages of RK4: s, s+h/2, s+h/2, s+h)
+  vector<double> TrackPoints(const NestedFieldMap& box, long nEvaluations, double h, std::mt19937_64& engine)
+  {
+    std::uniform_real_distribution<double> uniform(0., 1.);
+    std::normal_distribution<double> normal(0., 1.);
+    vector<double> points;
+    points.reserve(4*nEvaluations);
+
+    const double lower[3] = { box.minx, box.miny, box.minz };
+    const double upper[3] = { box.maxx, box.maxy, box.maxz };
+    double position[3], direction[3];
+    bool inside = false;
+
+    while (long(points.size()) < 4*nEvaluations) {
+      if (!inside) {
+        double norm = 0.;
+        for (int k=0; k<3; k++) {
+          position[k] = lower[k] + (upper[k] - lower[k])*uniform(engine);
+          direction[k] = normal(engine);
+          norm += direction[k]*direction[k];
+        }
+        for (int k=0; k<3; k++) direction[k] /= std::sqrt(norm);
+      }
+      const double stage[4] = { 0., 0.5*h, 0.5*h, h };
+      for (int i=0; i<4; i++) {
+        for (int k=0; k<3; k++) points.push_back(position[k] + stage[i]*direction[k]);
+        points.push_back(0.);
+      }
+      inside = true;
+      for (int k=0; k<3; k++) {
+        position[k] += h*direction[k];
+        if (position[k]<lower[k] || position[k]>upper[k]) inside = false;
+      }
+    }
+    points.resize(4*nEvaluations);
+    return points;
+  }
+
+  //------------------------------------------------------------------
+  //    Largest difference of the analytic gradient to central differences
+  //    of the field, relative to the largest gradient
+  double GradientError(const MagneticFieldMapping& map, const vector<double>& points, double delta)
+  {
+    double maxError = 0., maxGradient = 0.;
+    for (size_t i=0; i<std::min(points.size(), size_t(40000)); i+=4) {
+      double B[3], gradient[9];
+      map.GetFieldValueAndGradient(&points[i], B, gradient);
+      for (int j=0; j<3; j++) {
+        double plus[4], minus[4], Bplus[3], Bminus[3], gradientPlus[9], gradientMinus[9];
+        for (int k=0; k<4; k++) plus[k] = minus[k] = points[i+k];
+        plus[j] += delta;
+        minus[j] -= delta;
+        map.GetFieldValueAndGradient(plus, Bplus, gradientPlus);
+        map.GetFieldValueAndGradient(minus, Bminus, gradientMinus);
+        for (int k=0; k<3; k++) {
+          // Differences across a cell boundary see two cells: skip them
+          if (gradientPlus[3*k+j]!=gradient[3*k+j] || gradientMinus[3*k+j]!=gradient[3*k+j]) continue;
+          maxError = std::max(maxError, std::abs((Bplus[k] - Bminus[k])/(2*delta) - gradient[3*k+j]));
+          maxGradient = std::max(maxGradient, std::abs(gradient[3*k+j]));
+        }
+      }
+    }
+    return maxGradient>0. ? maxError/maxGradient : 0.;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  const char* filename = (argc>1) ? argv[1] : "MagneticFieldMaps/Quadrupole_MagneticFieldMap.TABLE";
+  const long nEvaluations = (argc>2) ? std::atol(argv[2]) : 10000000;
+  const double stepLength = ((argc>3) ? std::atof(argv[3]) : 1.)*mm;
+
+  MagneticFieldMapping flatMap(filename, 0.);
+  NestedFieldMap nestedMap(filename, 0.);
+
+  // Random points inside the mapped volume (x, y, z, t)
+  std::mt19937_64 engine(12345);
+  std::uniform_real_distribution<double> uniform(0., 1.);
+  vector<double> points(4*nEvaluations);
+  for (long i=0; i<nEvaluations; i++) {
+    points[4*i  ] = nestedMap.minx + (nestedMap.maxx - nestedMap.minx)*uniform(engine);
+    points[4*i+1] = nestedMap.miny + (nestedMap.maxy - nestedMap.miny)*uniform(engine);
+    points[4*i+2] = nestedMap.minz + (nestedMap.maxz - nestedMap.minz)*uniform(engine);
+    points[4*i+3] = 0.;
+  }
+
+  // Agreement
+  const double maxDifference = MaxDifference(flatMap, nestedMap, points);
+
+  double checksumNested, checksumFlat;
+  const double rateNested = EvaluationsPerSecond(nestedMap, points, checksumNested);
+  const double rateFlat = EvaluationsPerSecond(flatMap, points, checksumFlat);
+
+  // Reduced storage, compared with the full double-precision map
+  MagneticFieldMapOptions singleOptions;
+  singleOptions.singlePrecision = true;
+  MagneticFieldMapOptions foldedOptions = MagneticFieldMapOptions::Quadrupole();
+  MagneticFieldMapOptions foldedSingleOptions = foldedOptions;
+  foldedSingleOptions.singlePrecision = true;
+  MagneticFieldMapOptions tiledOptions;
+  tiledOptions.tileSize = 8;
+
+  const int nVariants = 4;
+  const MagneticFieldMapOptions* variants[nVariants] = { &singleOptions, &foldedOptions, &foldedSingleOptions, &tiledOptions };
+  const char* variantNames[nVariants] = { "Single precision:  ", "Quadrupole folded: ", "Folded, single:    ", "Tiled (8^3 cells): " };
+
+  G4cout << "\n Field evaluations:     " << nEvaluations
+         << "\n Nested vectors:        " << rateNested/1e6 << " M evaluations/s"
+         << "\n Flat interleaved:      " << rateFlat/1e6 << " M evaluations/s"
+#ifdef __AVX__
+         << " (AVX)"
+#endif
+         << "\n Speed-up:              " << rateFlat/rateNested
+         << "\n Max |difference|:      " << maxDifference/tesla << " T"
+         << "\n Checksums:             " << checksumNested << " " << checksumFlat
+         << "\n Cells:                 " << flatMap.GetMap()->GetMemorySize() << " bytes" << G4endl;
+
+  // Along tracks, where the last-cell cache applies
+  const vector<double> trackPoints = TrackPoints(nestedMap, nEvaluations, stepLength, engine);
+  const double rateNestedTrack = EvaluationsPerSecond(nestedMap, trackPoints, checksumNested);
+  const double rateFlatTrack = EvaluationsPerSecond(flatMap, trackPoints, checksumFlat);
+
+  G4cout << "\n Along tracks (RK4 stages, " << stepLength/mm << " mm steps):"
+         << "\n Nested vectors:        " << rateNestedTrack/1e6 << " M evaluations/s"
+         << "\n Flat, last-cell cache: " << rateFlatTrack/1e6 << " M evaluations/s"
+         << "\n Speed-up:              " << rateFlatTrack/rateNestedTrack
+         << "\n Max |difference|:      " << MaxDifference(flatMap, nestedMap, trackPoints)/tesla << " T"
+         << "\n Gradient, max relative error to central differences: "
+         << GradientError(flatMap, points, 1e-3*mm) << G4endl;
+
+  for (int v=0; v<nVariants; v++) {
+    MagneticFieldMapping variantMap(filename, 0., *variants[v]);
+    double checksum;
+    const double rate = EvaluationsPerSecond(variantMap, points, checksum);
+    const double rateTrack = EvaluationsPerSecond(variantMap, trackPoints, checksum);
+    G4cout << "\n " << variantNames[v] << "  " << rate/1e6 << " M evaluations/s, "
+           << rateTrack/1e6 << " M/s along tracks, "
+           << variantMap.GetMap()->GetMemorySize() << " bytes, max |difference| to the full map "
+           << MaxDifference(variantMap, flatMap, points)/tesla << " T" << G4endl;
+  }
+
+  return 0;
+}
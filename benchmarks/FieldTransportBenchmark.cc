@@ -0,0 +1,453 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+//      Transport benchmark of the K600 magnet settings
+//
+//      Sends a fan of reference ejectiles (protons by default) from the
+//      target through the quadrupole and the two dipoles to a focal plane at
+//      the position of VDC 1, once for each set of integration settings.
+//      Reports the wall time and the deviations of the focal-plane position
+//      and angles from a tightly converged reference run, so that steppers,
+//      drivers and tolerances for /K600/field/ can be chosen quantitatively.
+//
+//      The magnet volumes and fields are those of DetectorConstruction; only
+//      transportation is active, in vacuum.
+//
+//      Usage: FieldTransportBenchmark [-energy MeV] [-repeat n] [-map quadrupoleFieldMap.TABLE]
+//
+
+#include "K600FieldSetup.hh"
+#include "MagneticFieldMapping.hh"
+
+#include "G4RunManager.hh"
+#include "G4VUserDetectorConstruction.hh"
+#include "G4VUserPhysicsList.hh"
+#include "G4VUserPrimaryGeneratorAction.hh"
+#include "G4UserSteppingAction.hh"
+#include "G4ParticleGun.hh"
+#include "G4Proton.hh"
+#include "G4Geantino.hh"
+#include "G4ChargedGeantino.hh"
+#include "G4NistManager.hh"
+#include "G4Box.hh"
+#include "G4Tubs.hh"
+#include "G4LogicalVolume.hh"
+#include "G4PVPlacement.hh"
+#include "G4UniformMagField.hh"
+#include "G4QuadrupoleMagField.hh"
+#include "G4TransportationManager.hh"
+#include "G4PropagatorInField.hh"
+#include "G4Event.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4TouchableHistory.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <vector>
+
+namespace {
+    
+    ////    Reference rays: horizontal and vertical angle (rad) and relative momentum deviation
+    struct ReferenceRay
+    {
+        G4double    thetaX, thetaY, delta;
+    };
+    
+    struct FocalPlaneHit
+    {
+        G4bool      hit;
+        G4double    x, y;           // focal-plane coordinates (mm)
+        G4double    theta, phi;     // angles to the focal-plane normal (rad)
+    };
+    
+    ////    Integration settings of one benchmark run. Non-positive values keep the Geant4 defaults.
+    struct TransportSettings
+    {
+        const char* name;
+        const char* quadrupoleStepper;
+        const char* dipoleStepper;
+        const char* driver;
+        G4double    largestStep;
+        G4double    minStep;
+        G4double    deltaChord;
+        G4double    deltaOneStep;
+        G4double    deltaIntersection;
+        G4double    epsilonMin;
+        G4double    epsilonMax;
+    };
+    
+    //------------------------------------------------------------------
+    //      Magnets and focal plane, as in DetectorConstruction
+    class BenchmarkGeometry : public G4VUserDetectorConstruction
+    {
+    public:
+        BenchmarkGeometry(const char* quadrupoleFieldMap)
+        : fQuadrupoleFieldMap(quadrupoleFieldMap),
+        fFocalPlane(0),
+        fLogicQuadrupole(0),
+        fLogicDipole1(0),
+        fLogicDipole2(0)
+        {}
+        
+        virtual ~BenchmarkGeometry()
+        {
+            for(size_t i=0; i<fFieldSetups.size(); i++) delete fFieldSetups[i];
+        }
+        
+        virtual G4VPhysicalVolume* Construct()
+        {
+            G4Material* vacuum = G4NistManager::Instance()->FindOrBuildMaterial("G4_Galactic");
+            
+            G4Box* solidWorld = new G4Box("World", 7.5*m, 7.5*m, 7.5*m);
+            G4LogicalVolume* logicWorld = new G4LogicalVolume(solidWorld, vacuum, "World");
+            G4VPhysicalVolume* physiWorld = new G4PVPlacement(0, G4ThreeVector(), logicWorld, "World", 0, false, 0);
+            
+            ////    Quadrupole
+            G4Box* solidQuadrupole = new G4Box("Solid_K600_Quadrupole", (50./2)*cm, (50./2)*cm, (30./2)*cm);
+            fLogicQuadrupole = new G4LogicalVolume(solidQuadrupole, vacuum, "Logic_K600_Quadrupole");
+            new G4PVPlacement(0, G4ThreeVector(0., 0., 100.*cm), fLogicQuadrupole, "K600_Quadrupole", logicWorld, false, 0);
+            
+            ////    Dipoles
+            G4RotationMatrix dipoleRotation;
+            dipoleRotation.rotateX(-90.*deg);
+            dipoleRotation.rotateY(180.*deg);
+            G4Transform3D dipoleTransform(dipoleRotation, G4ThreeVector(75*cm, 0.*cm, 250*cm));
+            
+            G4Tubs* solidDipole1 = new G4Tubs("Solid_K600_Dipole1", 30.*cm, 150.0*cm, 30.*cm, 0.*deg, 40.*deg);
+            fLogicDipole1 = new G4LogicalVolume(solidDipole1, vacuum, "Logic_K600_Dipole1");
+            new G4PVPlacement(dipoleTransform, fLogicDipole1, "K600_Dipole1", logicWorld, false, 0);
+            
+            G4Tubs* solidDipole2 = new G4Tubs("Solid_K600_Dipole2", 30.*cm, 150.0*cm, 30.*cm, 50.*deg, 70.*deg);
+            fLogicDipole2 = new G4LogicalVolume(solidDipole2, vacuum, "Logic_K600_Dipole2");
+            new G4PVPlacement(dipoleTransform, fLogicDipole2, "K600_Dipole2", logicWorld, false, 0);
+            
+            ////    Focal plane: the wire plane of VDC 1
+            G4RotationMatrix focalPlaneRotation;
+            focalPlaneRotation.rotateY(-14.03*deg);
+            G4ThreeVector focalPlanePosition(481.93*cm - 200.*cm, 0., 352.050*cm - 100.*cm);
+            
+            G4Box* solidFocalPlane = new G4Box("FocalPlane", 100.*cm, 50.*cm, 0.5*mm);
+            G4LogicalVolume* logicFocalPlane = new G4LogicalVolume(solidFocalPlane, vacuum, "FocalPlane");
+            fFocalPlane = new G4PVPlacement(G4Transform3D(focalPlaneRotation, focalPlanePosition), logicFocalPlane, "FocalPlane", logicWorld, false, 0);
+            
+            return physiWorld;
+        }
+        
+        virtual void ConstructSDandField()
+        {
+            G4MagneticField* quadrupoleField = 0;
+            
+            if(fQuadrupoleFieldMap) quadrupoleField = new MagneticFieldMapping(fQuadrupoleFieldMap, 4.4*mm + 100*cm);
+            else quadrupoleField = new G4QuadrupoleMagField(0.001*tesla/cm, G4ThreeVector(0., 0., 100.*cm), new G4RotationMatrix);
+            
+            fFieldSetups.push_back(new K600FieldSetup(quadrupoleField, 0.0025*mm));
+            fFieldSetups.push_back(new K600FieldSetup(new G4UniformMagField(G4ThreeVector(0., -2.30*tesla, 0.)), 0.0025*mm));
+            fFieldSetups.push_back(new K600FieldSetup(new G4UniformMagField(G4ThreeVector(0., -2.40*tesla, 0.)), 0.0025*mm));
+            
+            fLogicQuadrupole->SetFieldManager(fFieldSetups[0]->GetFieldManager(), true);
+            fLogicDipole1->SetFieldManager(fFieldSetups[1]->GetFieldManager(), true);
+            fLogicDipole2->SetFieldManager(fFieldSetups[2]->GetFieldManager(), true);
+        }
+        
+        const G4VPhysicalVolume* GetFocalPlane() const      { return fFocalPlane; }
+        
+        ////    0: quadrupole, 1, 2: dipoles
+        K600FieldSetup* GetFieldSetup(G4int i) const        { return fFieldSetups[i]; }
+        
+    private:
+        const char*             fQuadrupoleFieldMap;
+        G4VPhysicalVolume*      fFocalPlane;
+        G4LogicalVolume*        fLogicQuadrupole;
+        G4LogicalVolume*        fLogicDipole1;
+        G4LogicalVolume*        fLogicDipole2;
+        std::vector<K600FieldSetup*>    fFieldSetups;
+    };
+    
+    //------------------------------------------------------------------
+    class TransportOnlyPhysicsList : public G4VUserPhysicsList
+    {
+    public:
+        virtual void ConstructParticle()
+        {
+            G4Proton::ProtonDefinition();
+            G4Geantino::GeantinoDefinition();
+            G4ChargedGeantino::ChargedGeantinoDefinition();
+        }
+        
+        virtual void ConstructProcess()     { AddTransportation(); }
+        virtual void SetCuts()              { SetCutsWithDefault(); }
+    };
+    
+    //------------------------------------------------------------------
+    ////    Event i transports ray i modulo the number of rays
+    class RayGenerator : public G4VUserPrimaryGeneratorAction
+    {
+    public:
+        RayGenerator(const std::vector<ReferenceRay>& rays, G4double kineticEnergy)
+        : fRays(rays),
+        fGun(new G4ParticleGun(1))
+        {
+            const G4double mass = G4Proton::ProtonDefinition()->GetPDGMass();
+            fMomentum = std::sqrt(kineticEnergy*(kineticEnergy + 2.0*mass));
+            fGun->SetParticleDefinition(G4Proton::ProtonDefinition());
+            fGun->SetParticlePosition(G4ThreeVector());
+        }
+        
+        virtual ~RayGenerator()     { delete fGun; }
+        
+        virtual void GeneratePrimaries(G4Event* anEvent)
+        {
+            const ReferenceRay& ray = fRays[anEvent->GetEventID() % fRays.size()];
+            
+            fGun->SetParticleMomentum(fMomentum*(1.0 + ray.delta));
+            fGun->SetParticleMomentumDirection(G4ThreeVector(std::tan(ray.thetaX), std::tan(ray.thetaY), 1.0).unit());
+            fGun->GeneratePrimaryVertex(anEvent);
+        }
+        
+    private:
+        const std::vector<ReferenceRay>&    fRays;
+        G4ParticleGun*                      fGun;
+        G4double                            fMomentum;
+    };
+    
+    //------------------------------------------------------------------
+    class FocalPlaneRecorder : public G4UserSteppingAction
+    {
+    public:
+        FocalPlaneRecorder(const BenchmarkGeometry* geometry, G4int nRays)
+        : fGeometry(geometry),
+        fHits(nRays),
+        fNSteps(0)
+        {}
+        
+        void Reset()
+        {
+            FocalPlaneHit noHit = { false, 0., 0., 0., 0. };
+            fHits.assign(fHits.size(), noHit);
+            fNSteps = 0;
+        }
+        
+        virtual void UserSteppingAction(const G4Step* step)
+        {
+            fNSteps++;
+            
+            const G4StepPoint* postStepPoint = step->GetPostStepPoint();
+            if(postStepPoint->GetStepStatus()!=fGeomBoundary || postStepPoint->GetPhysicalVolume()!=fGeometry->GetFocalPlane()) return;
+            
+            const G4AffineTransform& toLocal = postStepPoint->GetTouchable()->GetHistory()->GetTopTransform();
+            const G4ThreeVector position = toLocal.TransformPoint(postStepPoint->GetPosition());
+            const G4ThreeVector direction = toLocal.TransformAxis(postStepPoint->GetMomentumDirection());
+            
+            const G4int eventID = G4RunManager::GetRunManager()->GetCurrentEvent()->GetEventID();
+            FocalPlaneHit& hit = fHits[eventID % fHits.size()];
+            
+            hit.hit = true;
+            hit.x = position.x();
+            hit.y = position.y();
+            hit.theta = std::atan2(direction.x(), direction.z());
+            hit.phi = std::atan2(direction.y(), direction.z());
+            
+            step->GetTrack()->SetTrackStatus(fStopAndKill);
+        }
+        
+        const std::vector<FocalPlaneHit>&   GetHits() const     { return fHits; }
+        long                                GetNSteps() const   { return fNSteps; }
+        
+    private:
+        const BenchmarkGeometry*    fGeometry;
+        std::vector<FocalPlaneHit>  fHits;
+        long                        fNSteps;
+    };
+    
+    //------------------------------------------------------------------
+    G4bool ApplySettings(const TransportSettings& settings, const BenchmarkGeometry* geometry, const TransportSettings& defaults)
+    {
+        G4TransportationManager::GetTransportationManager()->GetPropagatorInField()
+        ->SetLargestAcceptableStep(settings.largestStep>0. ? settings.largestStep : defaults.largestStep);
+        
+        for(G4int i=0; i<3; i++)
+        {
+            K600FieldSetup* fieldSetup = geometry->GetFieldSetup(i);
+            
+            if(!fieldSetup->SetIntegrator((i==0) ? settings.quadrupoleStepper : settings.dipoleStepper, settings.driver)) return false;
+            
+            fieldSetup->SetMinStep(settings.minStep>0. ? settings.minStep : defaults.minStep);
+            fieldSetup->SetDeltaChord(settings.deltaChord>0. ? settings.deltaChord : defaults.deltaChord);
+            fieldSetup->SetDeltaOneStep(settings.deltaOneStep>0. ? settings.deltaOneStep : defaults.deltaOneStep);
+            fieldSetup->SetDeltaIntersection(settings.deltaIntersection>0. ? settings.deltaIntersection : defaults.deltaIntersection);
+            fieldSetup->SetEpsilonMin(settings.epsilonMin>0. ? settings.epsilonMin : defaults.epsilonMin);
+            fieldSetup->SetEpsilonMax(settings.epsilonMax>0. ? settings.epsilonMax : defaults.epsilonMax);
+        }
+        
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    G4double kineticEnergy = 160.*MeV;
+    G4int nRepeat = 20;
+    const char* quadrupoleFieldMap = 0;
+    
+    for(G4int i=1; i<argc; i++)
+    {
+        if(!std::strcmp(argv[i], "-energy") && i+1<argc) kineticEnergy = std::atof(argv[++i])*MeV;
+        else if(!std::strcmp(argv[i], "-repeat") && i+1<argc) nRepeat = std::max(1, std::atoi(argv[++i]));
+        else if(!std::strcmp(argv[i], "-map") && i+1<argc) quadrupoleFieldMap = argv[++i];
+        else
+        {
+            G4cerr << "Usage: " << argv[0] << " [-energy MeV] [-repeat n] [-map quadrupoleFieldMap.TABLE]" << G4endl;
+            return 1;
+        }
+    }
+    
+    ////    Fan of rays: +-20 mrad in both planes, +-2% in momentum
+    std::vector<ReferenceRay> rays;
+    for(G4int i=-2; i<=2; i++)
+    {
+        for(G4int j=-2; j<=2; j++)
+        {
+            for(G4int k=-1; k<=1; k++)
+            {
+                ReferenceRay ray = { 0.010*i, 0.010*j, 0.02*k };
+                rays.push_back(ray);
+            }
+        }
+    }
+    const G4int nRays = G4int(rays.size());
+    
+    G4RunManager* runManager = new G4RunManager;
+    BenchmarkGeometry* geometry = new BenchmarkGeometry(quadrupoleFieldMap);
+    runManager->SetUserInitialization(geometry);
+    runManager->SetUserInitialization(new TransportOnlyPhysicsList);
+    runManager->SetUserAction(new RayGenerator(rays, kineticEnergy));
+    FocalPlaneRecorder* recorder = new FocalPlaneRecorder(geometry, nRays);
+    runManager->SetUserAction(recorder);
+    runManager->Initialize();
+    
+    ////    Geant4 defaults, and the settings of DetectorConstruction
+    const K600FieldSetup* quadrupoleSetup = geometry->GetFieldSetup(0);
+    const TransportSettings defaults = { "Geant4 defaults", "ClassicalRK4", "ClassicalRK4", "standard",
+        G4TransportationManager::GetTransportationManager()->GetPropagatorInField()->GetLargestAcceptableStep(),
+        quadrupoleSetup->GetMinStep(), quadrupoleSetup->GetDeltaChord(), quadrupoleSetup->GetDeltaOneStep(),
+        quadrupoleSetup->GetDeltaIntersection(), quadrupoleSetup->GetEpsilonMin(), quadrupoleSetup->GetEpsilonMax() };
+    
+    const G4double dflt = 0.;
+    const TransportSettings settings[] =
+    {
+        //  name                            quadrupole          dipoles             driver           largestStep  minStep      deltaChord  deltaOneStep  deltaIntersection  epsMin  epsMax
+        { "reference (DP745, tight)",       "DormandPrince745", "DormandPrince745", "standard",      1*mm,        1.0e-4*mm,   1.0e-3*mm,  1.0e-6*mm,    1.0e-6*mm,         1.0e-8, 1.0e-7 },
+        { "current (RK4, 1 mm steps)",      "ClassicalRK4",     "ClassicalRK4",     "standard",      1*mm,        dflt,        dflt,       dflt,         dflt,              dflt,   dflt   },
+        { "RK4",                            "ClassicalRK4",     "ClassicalRK4",     "standard",      1*m,         dflt,        dflt,       dflt,         dflt,              dflt,   dflt   },
+        { "CashKarpRKF45",                  "CashKarpRKF45",    "CashKarpRKF45",    "standard",      1*m,         dflt,        dflt,       dflt,         dflt,              dflt,   dflt   },
+        { "BogackiShampine23",              "BogackiShampine23","BogackiShampine23","standard",      1*m,         dflt,        dflt,       dflt,         dflt,              dflt,   dflt   },
+        { "BogackiShampine45",              "BogackiShampine45","BogackiShampine45","standard",      1*m,         dflt,        dflt,       dflt,         dflt,              dflt,   dflt   },
+        { "DormandPrince745",               "DormandPrince745", "DormandPrince745", "standard",      1*m,         dflt,        dflt,       dflt,         dflt,              dflt,   dflt   },
+        { "DormandPrince745, interpolating","DormandPrince745", "DormandPrince745", "interpolating", 1*m,         dflt,        dflt,       dflt,         dflt,              dflt,   dflt   },
+        { "DP745 + exact helix dipoles",    "DormandPrince745", "ExactHelix",       "standard",      1*m,         dflt,        dflt,       dflt,         dflt,              dflt,   dflt   },
+        { "DP745 + helix, relaxed",         "DormandPrince745", "ExactHelix",       "standard",      1*m,         dflt,        1.0*mm,     0.05*mm,      0.01*mm,           1.0e-4, 1.0e-3 },
+        { "DP745 + helix, tight",           "DormandPrince745", "ExactHelix",       "standard",      1*m,         dflt,        0.05*mm,    1.0e-3*mm,    1.0e-4*mm,         1.0e-6, 1.0e-5 }
+    };
+    const G4int nSettings = sizeof(settings)/sizeof(settings[0]);
+    
+    const G4int nEvents = nRays*nRepeat;
+    std::vector<FocalPlaneHit> reference;
+    
+    ////    Warm-up (geometry optimisation, first-touch of the field maps)
+    ApplySettings(settings[0], geometry, defaults);
+    runManager->BeamOn(nRays);
+    
+    G4cout << "\n Reference ejectiles:   " << nRays << " protons of " << kineticEnergy/MeV << " MeV (+-20 mrad, +-2%), "
+    << nRepeat << " times each" << G4endl;
+    G4cout << "\n " << std::left << std::setw(34) << "settings" << std::right
+    << std::setw(10) << "time [s]" << std::setw(12) << "steps/ray" << std::setw(8) << "lost"
+    << std::setw(14) << "<|dx|> [um]" << std::setw(14) << "max|dx| [um]" << std::setw(14) << "max|dy| [um]"
+    << std::setw(18) << "max|dth| [urad]" << std::setw(18) << "max|dph| [urad]" << G4endl;
+    
+    for(G4int s=0; s<nSettings; s++)
+    {
+        if(!ApplySettings(settings[s], geometry, defaults))
+        {
+            G4cout << " " << std::left << std::setw(34) << settings[s].name << std::right << std::setw(10) << "n/a" << G4endl;
+            continue;
+        }
+        
+        recorder->Reset();
+        
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        runManager->BeamOn(nEvents);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        
+        const std::vector<FocalPlaneHit>& hits = recorder->GetHits();
+        if(s==0) reference = hits;
+        
+        G4int nLost = 0, nCompared = 0;
+        G4double sumDx = 0., maxDx = 0., maxDy = 0., maxDtheta = 0., maxDphi = 0.;
+        
+        for(G4int i=0; i<nRays; i++)
+        {
+            if(!hits[i].hit) { nLost++; continue; }
+            if(!reference[i].hit) continue;
+            
+            const G4double dx = std::abs(hits[i].x - reference[i].x);
+            sumDx += dx;
+            maxDx = std::max(maxDx, dx);
+            maxDy = std::max(maxDy, std::abs(hits[i].y - reference[i].y));
+            maxDtheta = std::max(maxDtheta, std::abs(hits[i].theta - reference[i].theta));
+            maxDphi = std::max(maxDphi, std::abs(hits[i].phi - reference[i].phi));
+            nCompared++;
+        }
+        
+        G4cout << " " << std::left << std::setw(34) << settings[s].name << std::right << std::fixed
+        << std::setw(10) << std::setprecision(3) << elapsed.count()
+        << std::setw(12) << std::setprecision(1) << double(recorder->GetNSteps())/nEvents
+        << std::setw(8) << nLost
+        << std::setw(14) << std::setprecision(2) << ((nCompared>0) ? sumDx/nCompared/um : 0.)
+        << std::setw(14) << maxDx/um << std::setw(14) << maxDy/um
+        << std::setw(18) << maxDtheta*1.0e6 << std::setw(18) << maxDphi*1.0e6
+        << std::defaultfloat << G4endl;
+    }
+    
+    delete runManager;
+    
+    return 0;
+}
@@ -0,0 +1,452 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+//      Navigation benchmark of the K600 geometry
+//
+//      Builds DetectorConstruction in one of its canned layouts
+//      (DetectorConstruction::SetBenchmarkLayout) and tracks reproducible
+//      rays from the target with transportation only:
+//
+//          - geantinos, isotropic;
+//          - charged geantinos into the acceptance of the spectrometer,
+//            through the quadrupole and dipole fields when they are present.
+//
+//      Reports navigation steps per second of both, the time spent per step
+//      in each logical volume (wall time between successive steps, i.e.
+//      ComputeStep, the field propagation and the relocation), and the time
+//      per LocateGlobalPointAndSetup() and per ComputeSafety() at points
+//      along the geantino rays, per volume the points are located in.
+//
+//      Field maps are read from the paths configured in DetectorConstruction,
+//      relative to the working directory as for K600 itself.
+//
+//      Usage: GeometryNavigationBenchmark [options]
+//
+//      Options:
+//          -layout <name>      CLOVER, ALBA_LaBr3Ce or Spectrometer (default: as configured in DetectorConstruction)
+//          -events <n>         events of each ray type (default 10000)
+//          -points <n>         safety points (default 100000)
+//          -radius <mm>        largest distance of the safety points from the target
+//                              (default 300 mm, 5 m for the Spectrometer layout)
+//          -momentum <MeV/c>   charged geantino momentum (default 571 MeV/c, 160 MeV protons)
+//          -seed <n>           random seed (default 12345)
+//          -top <n>            volumes listed per table (default 20)
+//
+
+#include "DetectorConstruction.hh"
+
+#include "G4RunManager.hh"
+#include "G4VUserPhysicsList.hh"
+#include "G4VUserPrimaryGeneratorAction.hh"
+#include "G4UserSteppingAction.hh"
+#include "G4UserTrackingAction.hh"
+#include "G4ParticleGun.hh"
+#include "G4Geantino.hh"
+#include "G4ChargedGeantino.hh"
+#include "G4TransportationManager.hh"
+#include "G4Navigator.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4Event.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+    
+    typedef std::chrono::steady_clock Clock;
+    
+    struct VolumeTiming
+    {
+        const G4LogicalVolume*  volume;
+        long                    n;
+        G4double                seconds;
+        G4double                safetySeconds;
+    };
+    
+    //------------------------------------------------------------------
+    class TransportOnlyPhysicsList : public G4VUserPhysicsList
+    {
+    public:
+        virtual void ConstructParticle()
+        {
+            G4Geantino::GeantinoDefinition();
+            G4ChargedGeantino::ChargedGeantinoDefinition();
+        }
+        
+        virtual void ConstructProcess()     { AddTransportation(); }
+        virtual void SetCuts()              { SetCutsWithDefault(); }
+    };
+    
+    //------------------------------------------------------------------
+    G4ThreeVector IsotropicDirection(std::mt19937_64& engine)
+    {
+        std::uniform_real_distribution<G4double> uniform(0., 1.);
+        const G4double cosTheta = 2.0*uniform(engine) - 1.0;
+        const G4double sinTheta = std::sqrt(std::max(0., 1.0 - cosTheta*cosTheta));
+        const G4double phi = twopi*uniform(engine);
+        return G4ThreeVector(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta);
+    }
+    
+    //------------------------------------------------------------------
+    ////    Geantinos from the target, isotropic, or charged geantinos into the spectrometer
+    ////    (+-30 mrad in both planes, +-2% in momentum). Reseeded before every run.
+    class RayGenerator : public G4VUserPrimaryGeneratorAction
+    {
+    public:
+        RayGenerator(G4double momentum)
+        : fGun(new G4ParticleGun(1)),
+        fMomentum(momentum),
+        fCharged(false)
+        {
+            fGun->SetParticlePosition(G4ThreeVector());
+        }
+        
+        virtual ~RayGenerator()     { delete fGun; }
+        
+        void Start(G4bool charged, unsigned long seed)
+        {
+            fCharged = charged;
+            fEngine.seed(seed);
+        }
+        
+        virtual void GeneratePrimaries(G4Event* anEvent)
+        {
+            if(fCharged)
+            {
+                std::uniform_real_distribution<G4double> uniform(-1., 1.);
+                const G4double thetaX = 0.030*uniform(fEngine);
+                const G4double thetaY = 0.030*uniform(fEngine);
+                
+                fGun->SetParticleDefinition(G4ChargedGeantino::ChargedGeantinoDefinition());
+                fGun->SetParticleMomentum(fMomentum*(1.0 + 0.02*uniform(fEngine)));
+                fGun->SetParticleMomentumDirection(G4ThreeVector(std::tan(thetaX), std::tan(thetaY), 1.0).unit());
+            }
+            else
+            {
+                fGun->SetParticleDefinition(G4Geantino::GeantinoDefinition());
+                fGun->SetParticleEnergy(1.*MeV);
+                fGun->SetParticleMomentumDirection(IsotropicDirection(fEngine));
+            }
+            
+            fGun->GeneratePrimaryVertex(anEvent);
+        }
+        
+    private:
+        G4ParticleGun*      fGun;
+        G4double            fMomentum;
+        G4bool              fCharged;
+        std::mt19937_64     fEngine;
+    };
+    
+    //------------------------------------------------------------------
+    ////    Steps and wall time per logical volume of the pre-step point
+    class VolumeTimer : public G4UserSteppingAction
+    {
+    public:
+        VolumeTimer()
+        : fNSteps(0)
+        {}
+        
+        void Reset()
+        {
+            fTimings.clear();
+            fNSteps = 0;
+        }
+        
+        void StartTrack()           { fLast = Clock::now(); }
+        
+        virtual void UserSteppingAction(const G4Step* step)
+        {
+            const Clock::time_point now = Clock::now();
+            
+            VolumeTiming& timing = fTimings[step->GetPreStepPoint()->GetPhysicalVolume()->GetLogicalVolume()];
+            timing.n++;
+            timing.seconds += std::chrono::duration<G4double>(now - fLast).count();
+            
+            fNSteps++;
+            fLast = Clock::now();
+        }
+        
+        long                    GetNSteps() const   { return fNSteps; }
+        std::vector<VolumeTiming> GetTimings() const
+        {
+            std::vector<VolumeTiming> timings;
+            for(std::map<const G4LogicalVolume*, VolumeTiming>::const_iterator it=fTimings.begin(); it!=fTimings.end(); ++it)
+            {
+                VolumeTiming timing = it->second;
+                timing.volume = it->first;
+                timings.push_back(timing);
+            }
+            return timings;
+        }
+        
+    private:
+        std::map<const G4LogicalVolume*, VolumeTiming>  fTimings;
+        long                                            fNSteps;
+        Clock::time_point                               fLast;
+    };
+    
+    //------------------------------------------------------------------
+    class TrackStart : public G4UserTrackingAction
+    {
+    public:
+        TrackStart(VolumeTimer* timer)
+        : fTimer(timer)
+        {}
+        
+        virtual void PreUserTrackingAction(const G4Track*)     { fTimer->StartTrack(); }
+        
+    private:
+        VolumeTimer*    fTimer;
+    };
+    
+    //------------------------------------------------------------------
+    G4bool ByTime(const VolumeTiming& a, const VolumeTiming& b)
+    {
+        return (a.seconds + a.safetySeconds) > (b.seconds + b.safetySeconds);
+    }
+    
+    //------------------------------------------------------------------
+    void RunRays(G4RunManager* runManager, RayGenerator* generator, VolumeTimer* timer,
+                 G4bool charged, G4int nEvents, unsigned long seed, G4int nTop)
+    {
+        generator->Start(charged, seed);
+        timer->Reset();
+        
+        const Clock::time_point start = Clock::now();
+        runManager->BeamOn(nEvents);
+        const G4double seconds = std::chrono::duration<G4double>(Clock::now() - start).count();
+        
+        const long nSteps = timer->GetNSteps();
+        std::vector<VolumeTiming> timings = timer->GetTimings();
+        std::sort(timings.begin(), timings.end(), ByTime);
+        
+        G4double steppingSeconds = 0.;
+        for(size_t i=0; i<timings.size(); i++) steppingSeconds += timings[i].seconds;
+        
+        G4cout << "\n " << (charged ? "Charged geantinos" : "Geantinos") << ":   " << nEvents << " events, " << nSteps << " steps in "
+        << std::setprecision(3) << seconds << " s: " << std::setprecision(4) << nSteps/seconds << " steps/s, "
+        << std::setprecision(3) << 1.0e6*seconds/nEvents << " us/event, " << double(nSteps)/nEvents << " steps/event" << G4endl;
+        
+        G4cout << "\n    " << std::left << std::setw(44) << "Logical volume" << std::right
+        << std::setw(12) << "steps" << std::setw(12) << "time %" << std::setw(12) << "ns/step" << G4endl;
+        
+        for(size_t i=0; i<timings.size() && G4int(i)<nTop; i++)
+        {
+            const VolumeTiming& timing = timings[i];
+            G4cout << "    " << std::left << std::setw(44) << timing.volume->GetName() << std::right
+            << std::setw(12) << timing.n
+            << std::setw(12) << std::fixed << std::setprecision(2) << 100.0*timing.seconds/steppingSeconds
+            << std::setw(12) << std::setprecision(1) << 1.0e9*timing.seconds/timing.n << std::defaultfloat << G4endl;
+        }
+        if(G4int(timings.size())>nTop) G4cout << "    ... " << timings.size() - nTop << " more volumes" << G4endl;
+    }
+    
+    //------------------------------------------------------------------
+    ////    Locates points along isotropic rays from the target and times the relocation
+    ////    and the isotropic safety, with a navigator of its own
+    void TimeSafety(G4VPhysicalVolume* world, G4int nPoints, G4double radius, unsigned long seed, G4int nTop)
+    {
+        G4Navigator navigator;
+        navigator.SetWorldVolume(world);
+        
+        std::mt19937_64 engine(seed);
+        std::uniform_real_distribution<G4double> uniform(0., 1.);
+        
+        std::vector<G4ThreeVector> points(nPoints);
+        for(G4int i=0; i<nPoints; i++) points[i] = radius*uniform(engine)*IsotropicDirection(engine);
+        
+        ////    Overhead of the clock calls around every measurement
+        G4double clockOverhead = 0.;
+        for(G4int i=0; i<10000; i++)
+        {
+            const Clock::time_point t0 = Clock::now();
+            const Clock::time_point t1 = Clock::now();
+            clockOverhead += std::chrono::duration<G4double>(t1 - t0).count();
+        }
+        clockOverhead /= 10000;
+        
+        std::map<const G4LogicalVolume*, VolumeTiming> timings;
+        G4double locateSeconds = 0., safetySeconds = 0., safetySum = 0.;
+        long nOutside = 0;
+        
+        for(G4int i=0; i<nPoints; i++)
+        {
+            const Clock::time_point t0 = Clock::now();
+            G4VPhysicalVolume* volume = navigator.LocateGlobalPointAndSetup(points[i], 0, false, true);
+            const Clock::time_point t1 = Clock::now();
+            
+            if(!volume)
+            {
+                nOutside++;
+                continue;
+            }
+            
+            const G4double safety = navigator.ComputeSafety(points[i]);
+            const Clock::time_point t2 = Clock::now();
+            
+            const G4double locate = std::max(0., std::chrono::duration<G4double>(t1 - t0).count() - clockOverhead);
+            const G4double safe = std::max(0., std::chrono::duration<G4double>(t2 - t1).count() - clockOverhead);
+            
+            VolumeTiming& timing = timings[volume->GetLogicalVolume()];
+            timing.n++;
+            timing.seconds += locate;
+            timing.safetySeconds += safe;
+            
+            locateSeconds += locate;
+            safetySeconds += safe;
+            safetySum += safety;
+        }
+        
+        std::vector<VolumeTiming> sorted;
+        for(std::map<const G4LogicalVolume*, VolumeTiming>::const_iterator it=timings.begin(); it!=timings.end(); ++it)
+        {
+            VolumeTiming timing = it->second;
+            timing.volume = it->first;
+            sorted.push_back(timing);
+        }
+        std::sort(sorted.begin(), sorted.end(), ByTime);
+        
+        const long nInside = nPoints - nOutside;
+        if(nInside==0) return;
+        
+        G4cout << "\n Safety:   " << nInside << " points within " << radius/mm << " mm of the target: "
+        << std::setprecision(4) << 1.0e9*locateSeconds/nInside << " ns/locate, "
+        << 1.0e9*safetySeconds/nInside << " ns/safety, mean safety " << safetySum/nInside/mm << " mm"
+        << " (clock overhead of " << std::setprecision(2) << 1.0e9*clockOverhead << " ns subtracted)" << G4endl;
+        
+        G4cout << "\n    " << std::left << std::setw(44) << "Logical volume" << std::right
+        << std::setw(12) << "points" << std::setw(14) << "ns/locate" << std::setw(14) << "ns/safety" << G4endl;
+        
+        for(size_t i=0; i<sorted.size() && G4int(i)<nTop; i++)
+        {
+            const VolumeTiming& timing = sorted[i];
+            G4cout << "    " << std::left << std::setw(44) << timing.volume->GetName() << std::right
+            << std::setw(12) << timing.n << std::fixed << std::setprecision(1)
+            << std::setw(14) << 1.0e9*timing.seconds/timing.n
+            << std::setw(14) << 1.0e9*timing.safetySeconds/timing.n << std::defaultfloat << G4endl;
+        }
+        if(G4int(sorted.size())>nTop) G4cout << "    ... " << sorted.size() - nTop << " more volumes" << G4endl;
+    }
+    
+    //------------------------------------------------------------------
+    void PrintUsage(const char* program)
+    {
+        G4cerr << "Usage: " << program << " [options]\n"
+        << "    -layout <name>      CLOVER, ALBA_LaBr3Ce or Spectrometer (default: as configured in DetectorConstruction)\n"
+        << "    -events <n>         events of each ray type (default 10000)\n"
+        << "    -points <n>         safety points (default 100000)\n"
+        << "    -radius <mm>        largest distance of the safety points from the target (default 300 mm, 5 m for Spectrometer)\n"
+        << "    -momentum <MeV/c>   charged geantino momentum (default 571 MeV/c)\n"
+        << "    -seed <n>           random seed (default 12345)\n"
+        << "    -top <n>            volumes listed per table (default 20)" << G4endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    G4String layout = "";
+    G4int nEvents = 10000;
+    G4int nPoints = 100000;
+    G4double radius = 0.;
+    G4double momentum = 571.*MeV;
+    unsigned long seed = 12345;
+    G4int nTop = 20;
+    
+    for(G4int i=1; i<argc; i++)
+    {
+        if(!std::strcmp(argv[i], "-layout") && i+1<argc) layout = argv[++i];
+        else if(!std::strcmp(argv[i], "-events") && i+1<argc) nEvents = std::max(1, std::atoi(argv[++i]));
+        else if(!std::strcmp(argv[i], "-points") && i+1<argc) nPoints = std::max(1, std::atoi(argv[++i]));
+        else if(!std::strcmp(argv[i], "-radius") && i+1<argc) radius = std::atof(argv[++i])*mm;
+        else if(!std::strcmp(argv[i], "-momentum") && i+1<argc) momentum = std::atof(argv[++i])*MeV;
+        else if(!std::strcmp(argv[i], "-seed") && i+1<argc) seed = std::strtoul(argv[++i], 0, 10);
+        else if(!std::strcmp(argv[i], "-top") && i+1<argc) nTop = std::max(1, std::atoi(argv[++i]));
+        else
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if(radius<=0.) radius = (layout=="Spectrometer") ? 5.*m : 300.*mm;
+    
+    G4RunManager* runManager = new G4RunManager;
+    DetectorConstruction* detector = new DetectorConstruction;
+    detector->SetBenchmarkLayout(layout);
+    runManager->SetUserInitialization(detector);
+    runManager->SetUserInitialization(new TransportOnlyPhysicsList);
+    RayGenerator* generator = new RayGenerator(momentum);
+    runManager->SetUserAction(generator);
+    VolumeTimer* timer = new VolumeTimer;
+    runManager->SetUserAction(timer);
+    runManager->SetUserAction(new TrackStart(timer));
+    
+    const Clock::time_point start = Clock::now();
+    runManager->Initialize();
+    const G4double initialisationSeconds = std::chrono::duration<G4double>(Clock::now() - start).count();
+    
+    G4VPhysicalVolume* world = G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume();
+    
+    ////    Warm-up: voxelisation and first touch of the field maps
+    generator->Start(false, seed);
+    runManager->BeamOn(std::min(nEvents, 100));
+    
+    G4cout << "\n Layout:   " << (layout.empty() ? G4String("as configured") : layout) << ", "
+    << G4PhysicalVolumeStore::GetInstance()->size() << " physical volumes, initialisation in "
+    << std::setprecision(3) << initialisationSeconds << " s" << G4endl;
+    
+    RunRays(runManager, generator, timer, false, nEvents, seed, nTop);
+    RunRays(runManager, generator, timer, true, nEvents, seed + 1, nTop);
+    TimeSafety(world, nPoints, radius, seed + 2, nTop);
+    
+    G4cout << G4endl;
+    
+    delete runManager;
+    return 0;
+}
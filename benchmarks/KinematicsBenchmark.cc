@@ -0,0 +1,207 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+//      Micro-benchmark of the binary reaction kinematics
+//
+//      Compares evaluations per second of BiRelKin() (every invariant
+//      recomputed per angle) with the cached scalar
+//      BinaryReactionKinematics::Evaluate(), the vectorised EvaluateBatch()
+//      and the interpolated BinaryReactionKinematicsTable, for isotropic
+//      ejectile angles, and checks that all of them agree with BiRelKin().
+//
+//      The batch path is given cos(theta) and sin(theta) as a generator
+//      sampling cos(theta) uniformly has them; the scalar paths are given
+//      theta in degrees and do their own trigonometry, as in EventGenerator.h.
+//
+//      The benchmark fails (exit code 2) if
+//      - the cached scalar results differ from BiRelKin() by more than 1e-6 MeV
+//        or 1e-6 deg, away from 90 deg (|cos(theta)| > 0.01), where BiRelKin
+//        loses precision to the cancellation in its discriminant,
+//      - the batch results differ from the cached scalar ones by more than
+//        1e-8 MeV or 1e-8 deg, at any angle,
+//      - the table differs from the exact kinematics by more than 1e-4 MeV or
+//        0.02 deg (bilinear interpolation; the recoil angle is steep near 0
+//        and 180 deg).
+//      A batch evaluation slower than the cached scalar one is reported with a
+//      warning.
+//
+//      Usage: KinematicsBenchmark [nEvaluations] [beamEnergy/MeV] [Ex/MeV]
+//
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "BiRelKin.hh"
+#include "BinaryReactionKinematics.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace {
+
+  const double kBiRelKinCosTheta = 0.01;
+  const double kBiRelKinEnergyTolerance = 1e-6;    // MeV
+  const double kBiRelKinAngleTolerance = 1e-6;     // deg
+  const double kBatchEnergyTolerance = 1e-8;       // MeV
+  const double kBatchAngleTolerance = 1e-8;        // deg
+  const double kTableEnergyTolerance = 1e-4;       // MeV
+  const double kTableAngleTolerance = 0.02;        // deg
+
+  double Seconds(std::chrono::steady_clock::time_point start)
+  {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+}
+
+int main(int argc, char** argv)
+{
+  const long nEvaluations = (argc>1) ? std::atol(argv[1]) : 10000000;
+  const double beamEnergy = (argc>2) ? std::atof(argv[2]) : 200.0;
+  const double excitationEnergy = (argc>3) ? std::atof(argv[3]) : 15.097;
+
+  //  16O(alpha, alpha') as in EventGenerator.h
+  double m[4] = { 4.00260325413, 15.99491461956, 4.00260325413, 15.99491461956 };
+
+  //  Isotropic ejectile angles
+  std::mt19937_64 engine(12345);
+  std::uniform_real_distribution<double> uniform(-1., 1.);
+  std::vector<double> cosTheta(nEvaluations), sinTheta(nEvaluations), thetaDeg(nEvaluations);
+  for (long i=0; i<nEvaluations; i++) {
+    cosTheta[i] = uniform(engine);
+    sinTheta[i] = std::sqrt(1. - cosTheta[i]*cosTheta[i]);
+    thetaDeg[i] = std::acos(cosTheta[i])/0.017453292;
+  }
+
+  double T[4], E[4], p[4];
+
+  //  BiRelKin, the reference
+  std::vector<double> T2(nEvaluations), T3(nEvaluations), thetaRecoil(nEvaluations);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (long i=0; i<nEvaluations; i++) {
+    T[0] = beamEnergy;
+    T[1] = 0.;
+    BiRelKin(m, T, E, p, thetaDeg[i], thetaRecoil[i], excitationEnergy);
+    T2[i] = T[2];
+    T3[i] = T[3];
+  }
+  const double timeReference = Seconds(start);
+
+  //  Cached scalar
+  const BinaryReactionKinematics kinematics(m, beamEnergy, 0., excitationEnergy);
+  std::vector<BinaryReactionKinematicsResult> scalar(nEvaluations);
+  start = std::chrono::steady_clock::now();
+  for (long i=0; i<nEvaluations; i++) kinematics.Evaluate(thetaDeg[i], scalar[i]);
+  const double timeScalar = Seconds(start);
+
+  double maxScalarDifference = 0., maxScalarAngleDifference = 0.;
+  for (long i=0; i<nEvaluations; i++) {
+    if (std::abs(cosTheta[i])<kBiRelKinCosTheta) continue;
+    maxScalarDifference = std::max(maxScalarDifference, std::max(std::abs(scalar[i].T2 - T2[i]), std::abs(scalar[i].T3 - T3[i])));
+    maxScalarAngleDifference = std::max(maxScalarAngleDifference, std::abs(scalar[i].thetaRecoil - thetaRecoil[i]));
+  }
+
+  //  Batch
+  std::vector<double> T2Batch(nEvaluations), T3Batch(nEvaluations), cosRecoil(nEvaluations), sinRecoil(nEvaluations);
+  start = std::chrono::steady_clock::now();
+  kinematics.EvaluateBatch(&cosTheta[0], &sinTheta[0], nEvaluations, &T2Batch[0], &T3Batch[0], &cosRecoil[0], &sinRecoil[0]);
+  const double timeBatch = Seconds(start);
+
+  double maxBatchDifference = 0., maxBatchAngleDifference = 0.;
+  for (long i=0; i<nEvaluations; i++) {
+    maxBatchDifference = std::max(maxBatchDifference, std::max(std::abs(T2Batch[i] - scalar[i].T2), std::abs(T3Batch[i] - scalar[i].T3)));
+    maxBatchAngleDifference = std::max(maxBatchAngleDifference, std::abs(std::atan2(sinRecoil[i], cosRecoil[i])/0.0174532925 - scalar[i].thetaRecoil));
+  }
+
+  //  Table: 0.1 deg and 10 keV nodes around Ex, compared at random (theta, Ex)
+  const double ExMin = std::max(0., excitationEnergy - 1.), ExMax = excitationEnergy + 1.;
+  start = std::chrono::steady_clock::now();
+  const BinaryReactionKinematicsTable table(kinematics, 0., 180., 1801, ExMin, ExMax, 201);
+  const double timeTableSetup = Seconds(start);
+
+  std::uniform_real_distribution<double> uniformEx(ExMin, ExMax);
+  std::vector<double> Ex(nEvaluations);
+  for (long i=0; i<nEvaluations; i++) Ex[i] = uniformEx(engine);
+
+  double checksumTable = 0.;
+  start = std::chrono::steady_clock::now();
+  for (long i=0; i<nEvaluations; i++) {
+    BinaryReactionKinematicsResult result;
+    table.Interpolate(thetaDeg[i], Ex[i], result);
+    checksumTable += result.T2 + result.T3 + result.thetaRecoil;
+  }
+  const double timeTable = Seconds(start);
+
+  double maxTableDifference = 0., maxTableAngleDifference = 0.;
+  BinaryReactionKinematics exactKinematics(kinematics);
+  for (long i=0; i<std::min(nEvaluations, 100000L); i++) {
+    BinaryReactionKinematicsResult interpolated, exact;
+    table.Interpolate(thetaDeg[i], Ex[i], interpolated);
+    exactKinematics.SetExcitationEnergy(Ex[i]);
+    exactKinematics.Evaluate(thetaDeg[i], exact);
+    maxTableDifference = std::max(maxTableDifference, std::max(std::abs(interpolated.T2 - exact.T2), std::abs(interpolated.T3 - exact.T3)));
+    maxTableAngleDifference = std::max(maxTableAngleDifference, std::abs(interpolated.thetaRecoil - exact.thetaRecoil));
+  }
+
+  std::cout << "\n Evaluations:           " << nEvaluations << " (T0 = " << beamEnergy << " MeV, Ex = " << excitationEnergy << " MeV)"
+            << "\n BiRelKin:              " << nEvaluations/timeReference/1e6 << " M evaluations/s"
+            << "\n Cached scalar:         " << nEvaluations/timeScalar/1e6 << " M evaluations/s, speed-up " << timeReference/timeScalar
+            << "\n                        max difference to BiRelKin (|cos(theta)| > " << kBiRelKinCosTheta << ") "
+            << maxScalarDifference << " MeV, " << maxScalarAngleDifference << " deg"
+            << "\n Batch:                 " << nEvaluations/timeBatch/1e6 << " M evaluations/s, speed-up " << timeReference/timeBatch
+            << " (" << timeScalar/timeBatch << " over the cached scalar)"
+            << "\n                        max difference to the cached scalar " << maxBatchDifference << " MeV, " << maxBatchAngleDifference << " deg"
+            << "\n Table (1801 x 201):    " << nEvaluations/timeTable/1e6 << " M evaluations/s, speed-up " << timeReference/timeTable
+            << ", set up in " << timeTableSetup*1e3 << " ms"
+            << "\n                        max difference to the exact kinematics " << maxTableDifference << " MeV, " << maxTableAngleDifference << " deg"
+            << "\n Checksum:              " << checksumTable << std::endl;
+
+  if (timeBatch>timeScalar) {
+    std::cout << "\n WARNING: the batch evaluation is slower than the cached scalar one (not vectorised?)" << std::endl;
+  }
+
+  if (!(maxScalarDifference<=kBiRelKinEnergyTolerance && maxScalarAngleDifference<=kBiRelKinAngleTolerance
+        && maxBatchDifference<=kBatchEnergyTolerance && maxBatchAngleDifference<=kBatchAngleTolerance
+        && maxTableDifference<=kTableEnergyTolerance && maxTableAngleDifference<=kTableAngleTolerance)) {
+    std::cout << "\n FAILED: the kinematics differ beyond the tolerances" << std::endl;
+    return 2;
+  }
+
+  return 0;
+}
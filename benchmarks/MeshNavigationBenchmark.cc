@@ -0,0 +1,305 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+//      Navigation benchmark of decimated meshes (levels of detail)
+//
+//      Builds G4TessellatedSolids from a full PLY mesh and from its decimated
+//      version (read from file, or made here with MeshDecimation) and compares
+//
+//          - calls per second of Inside() at random points of the bounding box,
+//            and of the DistanceToIn()/DistanceToOut() walks of random rays
+//            crossing it, i.e. what the navigator asks of the solid;
+//          - the efficiency change: the fraction of rays hitting the solid,
+//            the mean path length in it and the mean absorption probability
+//            1 - exp(-mu L) for an attenuation coefficient mu, evaluated on
+//            the same rays for both meshes.
+//
+//      Usage: MeshNavigationBenchmark [options] full.ply [decimated.ply]
+//
+//      Options:
+//          -tolerance <mm>     decimation tolerance if no decimated mesh is given (default 0.1 mm)
+//          -rays <n>           number of rays and of Inside() points (default 100000)
+//          -mu <1/cm>          attenuation coefficient (default 0.5/cm, BGO at ~1 MeV)
+//
+
+#include "MeshDecimation.hh"
+
+#include "G4TessellatedSolid.hh"
+#include "G4TriangularFacet.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ThreeVector.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+
+namespace {
+    
+    void PrintUsage()
+    {
+        G4cerr << " Usage: MeshNavigationBenchmark [-tolerance mm] [-rays n] [-mu 1/cm] full.ply [decimated.ply]" << G4endl;
+    }
+    
+    G4ThreeVector Vertex(const TriangleMesh& mesh, std::uint32_t i)
+    {
+        return G4ThreeVector(mesh.vertices[3*i], mesh.vertices[3*i + 1], mesh.vertices[3*i + 2])*mm;
+    }
+    
+    G4TessellatedSolid* BuildSolid(const TriangleMesh& mesh, const G4String& name)
+    {
+        G4TessellatedSolid* solid = new G4TessellatedSolid(name);
+        for(std::size_t t=0; t<mesh.GetNumberOfTriangles(); t++)
+        {
+            const std::uint32_t* i = &mesh.triangles[3*t];
+            G4TriangularFacet* facet = new G4TriangularFacet(Vertex(mesh, i[0]), Vertex(mesh, i[1]), Vertex(mesh, i[2]), ABSOLUTE);
+            if(!solid->AddFacet(facet)) delete facet;
+        }
+        solid->SetSolidClosed(true);
+        return solid;
+    }
+    
+    struct Ray
+    {
+        G4ThreeVector position;
+        G4ThreeVector direction;
+    };
+    
+    struct NavigationResult
+    {
+        double  insideRate;         // Inside() calls per second
+        double  rayRate;            // rays per second
+        double  distanceRate;       // DistanceToIn() + DistanceToOut() calls per second
+        long    nInside;
+        long    nHits;
+        double  meanLength;         // over all rays
+        double  meanAbsorption;
+        std::vector<double> lengths;
+    };
+    
+    ////    Path length of the ray in the solid, crossing it as many times as it re-enters
+    double PathLength(const G4VSolid* solid, const Ray& ray, long& nCalls)
+    {
+        G4ThreeVector position = ray.position;
+        double length = 0.;
+        
+        for(int crossing=0; crossing<1000; crossing++)
+        {
+            const double in = solid->DistanceToIn(position, ray.direction);
+            nCalls++;
+            if(in>=kInfinity) break;
+            position += in*ray.direction;
+            
+            const double out = solid->DistanceToOut(position, ray.direction);
+            nCalls++;
+            if(out>=kInfinity) break;
+            position += out*ray.direction;
+            length += out;
+        }
+        return length;
+    }
+    
+    NavigationResult Navigate(const G4VSolid* solid, const std::vector<G4ThreeVector>& points,
+                              const std::vector<Ray>& rays, double mu)
+    {
+        NavigationResult result;
+        
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        result.nInside = 0;
+        for(std::size_t i=0; i<points.size(); i++)
+        {
+            if(solid->Inside(points[i])==kInside) result.nInside++;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        result.insideRate = points.size()/elapsed.count();
+        
+        start = std::chrono::steady_clock::now();
+        long nCalls = 0;
+        result.lengths.resize(rays.size());
+        for(std::size_t r=0; r<rays.size(); r++) result.lengths[r] = PathLength(solid, rays[r], nCalls);
+        elapsed = std::chrono::steady_clock::now() - start;
+        result.rayRate = rays.size()/elapsed.count();
+        result.distanceRate = nCalls/elapsed.count();
+        
+        result.nHits = 0;
+        result.meanLength = result.meanAbsorption = 0.;
+        for(std::size_t r=0; r<rays.size(); r++)
+        {
+            if(result.lengths[r]>0.) result.nHits++;
+            result.meanLength += result.lengths[r];
+            result.meanAbsorption += 1. - std::exp(-mu*result.lengths[r]);
+        }
+        result.meanLength /= rays.size();
+        result.meanAbsorption /= rays.size();
+        
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double tolerance = 0.1*mm;
+    std::size_t nRays = 100000;
+    double mu = 0.5/cm;
+    std::vector<G4String> files;
+    
+    for(int i=1; i<argc; i++)
+    {
+        const G4String argument = argv[i];
+        const bool hasValue = (i+1<argc);
+        
+        if(argument=="-tolerance" && hasValue)      tolerance = std::atof(argv[++i])*mm;
+        else if(argument=="-rays" && hasValue)      nRays = std::strtoul(argv[++i], 0, 10);
+        else if(argument=="-mu" && hasValue)        mu = std::atof(argv[++i])/cm;
+        else if(argument.size()>1 && argument[0]=='-')
+        {
+            PrintUsage();
+            return 1;
+        }
+        else files.push_back(argument);
+    }
+    
+    if(files.empty() || files.size()>2 || nRays==0)
+    {
+        PrintUsage();
+        return 1;
+    }
+    
+    //------------------------------------------------
+    //      Meshes
+    TriangleMesh full, decimated;
+    if(!full.ReadPLY(files[0]))
+    {
+        G4cerr << "MeshNavigationBenchmark: cannot read " << files[0] << G4endl;
+        return 1;
+    }
+    full.WeldVertices();
+    
+    if(files.size()==2)
+    {
+        if(!decimated.ReadPLY(files[1]))
+        {
+            G4cerr << "MeshNavigationBenchmark: cannot read " << files[1] << G4endl;
+            return 1;
+        }
+    }
+    else decimated = MeshDecimation::Decimate(full, tolerance/mm);
+    
+    G4TessellatedSolid* fullSolid = BuildSolid(full, "Full");
+    G4TessellatedSolid* decimatedSolid = BuildSolid(decimated, "Decimated");
+    
+    //------------------------------------------------
+    //      Random points in the bounding box, enlarged by 10%, and rays from
+    //      a sphere around it towards random points of the box
+    G4ThreeVector lower(kInfinity, kInfinity, kInfinity), upper(-kInfinity, -kInfinity, -kInfinity);
+    for(std::size_t i=0; i<full.GetNumberOfVertices(); i++)
+    {
+        const G4ThreeVector p = Vertex(full, i);
+        lower = G4ThreeVector(std::min(lower.x(), p.x()), std::min(lower.y(), p.y()), std::min(lower.z(), p.z()));
+        upper = G4ThreeVector(std::max(upper.x(), p.x()), std::max(upper.y(), p.y()), std::max(upper.z(), p.z()));
+    }
+    const G4ThreeVector centre = 0.5*(lower + upper);
+    const G4ThreeVector halfSize = 0.55*(upper - lower);
+    const double radius = 2.*halfSize.mag();
+    
+    std::mt19937_64 engine(4357);
+    std::uniform_real_distribution<double> uniform(-1., 1.);
+    
+    std::vector<G4ThreeVector> points(nRays);
+    std::vector<Ray> rays(nRays);
+    for(std::size_t i=0; i<nRays; i++)
+    {
+        points[i] = centre + G4ThreeVector(uniform(engine)*halfSize.x(), uniform(engine)*halfSize.y(), uniform(engine)*halfSize.z());
+        
+        G4ThreeVector start;
+        do start = G4ThreeVector(uniform(engine), uniform(engine), uniform(engine));
+        while(start.mag2()>1. || start.mag2()<1e-6);
+        rays[i].position = centre + radius*start.unit();
+        rays[i].direction = (centre + G4ThreeVector(uniform(engine)*halfSize.x(), uniform(engine)*halfSize.y(), uniform(engine)*halfSize.z())
+                             - rays[i].position).unit();
+    }
+    
+    //------------------------------------------------
+    //      Navigation
+    const NavigationResult fullResult = Navigate(fullSolid, points, rays, mu);
+    const NavigationResult decimatedResult = Navigate(decimatedSolid, points, rays, mu);
+    
+    ////    Per-ray differences: the statistical error of the change is that of the (correlated) difference
+    double meanDifference = 0., meanDifference2 = 0.;
+    for(std::size_t r=0; r<nRays; r++)
+    {
+        const double difference = std::exp(-mu*fullResult.lengths[r]) - std::exp(-mu*decimatedResult.lengths[r]);
+        meanDifference += difference;
+        meanDifference2 += difference*difference;
+    }
+    meanDifference /= nRays;
+    meanDifference2 /= nRays;
+    const double differenceError = std::sqrt(std::max(0., meanDifference2 - meanDifference*meanDifference)/nRays);
+    
+    G4cout << "\n Mesh:                  " << files[0]
+    << "\n Triangles:             " << fullSolid->GetNumberOfFacets() << " full, " << decimatedSolid->GetNumberOfFacets() << " decimated"
+    << "\n Volume:                " << fullSolid->GetCubicVolume()/cm3 << " cm3 full, " << decimatedSolid->GetCubicVolume()/cm3 << " cm3 decimated"
+    << "\n Rays / points:         " << nRays << ", mu = " << mu*cm << " /cm\n" << G4endl;
+    
+    const char* names[2] = {"full", "decimated"};
+    const NavigationResult* results[2] = {&fullResult, &decimatedResult};
+    G4cout << " " << std::left << std::setw(12) << "mesh" << std::right
+    << std::setw(14) << "Inside M/s" << std::setw(14) << "Dist. M/s" << std::setw(12) << "rays k/s"
+    << std::setw(12) << "inside %" << std::setw(10) << "hits %" << std::setw(14) << "<L> mm" << std::setw(14) << "<1-e^-muL>" << G4endl;
+    for(int m=0; m<2; m++)
+    {
+        const NavigationResult& result = *results[m];
+        G4cout << " " << std::left << std::setw(12) << names[m] << std::right << std::fixed << std::setprecision(3)
+        << std::setw(14) << result.insideRate/1e6 << std::setw(14) << result.distanceRate/1e6 << std::setw(12) << result.rayRate/1e3
+        << std::setw(12) << 100.*result.nInside/nRays << std::setw(10) << 100.*result.nHits/nRays
+        << std::setw(14) << result.meanLength/mm << std::setprecision(6) << std::setw(14) << result.meanAbsorption << G4endl;
+    }
+    G4cout.unsetf(std::ios::fixed);
+    G4cout << std::setprecision(6);
+    
+    G4cout << "\n Speed-up:              Inside x" << decimatedResult.insideRate/fullResult.insideRate
+    << ", rays x" << decimatedResult.rayRate/fullResult.rayRate
+    << "\n Absorption change:     " << 100.*meanDifference/fullResult.meanAbsorption << " +- "
+    << 100.*differenceError/fullResult.meanAbsorption << " % (relative)"
+    << "\n Path length change:    " << 100.*(decimatedResult.meanLength - fullResult.meanLength)/fullResult.meanLength << " %\n" << G4endl;
+    
+    delete fullSolid;
+    delete decimatedSolid;
+    
+    return 0;
+}
@@ -0,0 +1,368 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+//      Benchmark of the representations of a heavy tessellated volume
+//
+//      Builds, from one PLY mesh,
+//
+//          - the G4TessellatedSolid with the default voxelisation (the reference);
+//          - the G4TessellatedSolid with each of the given largest numbers of
+//            voxels (CachedCADMesh::SetMaxVoxels());
+//          - the G4MultiUnion of its convex decomposition (read from file, or
+//            made here with MeshConvexDecomposition), as used with
+//            CachedCADMesh::SetConvexDecomposition();
+//
+//      and measures, for each, the calls per second of Inside() at random
+//      points of the bounding box, of the safeties DistanceToIn(p) and
+//      DistanceToOut(p) at the points outside and inside the reference, and of
+//      the DistanceToIn(p,v)/DistanceToOut(p,v) walks of random rays. As a
+//      regression check, the inside/outside classification of the points is
+//      compared with that of the reference: the benchmark fails (exit code 2)
+//      if a representation misclassifies more than the given fraction of the
+//      points inside the reference.
+//
+//      Usage: TessellatedSolidBenchmark [options] mesh.ply [decomposition.ply]
+//
+//      Options:
+//          -voxels <n,n,...>   largest numbers of voxels to try (default 1000,10000,100000)
+//          -tolerance <mm>     decomposition tolerance if no decomposition is given (default 0.5 mm)
+//          -pieces <n>         largest number of pieces of that decomposition (default 256)
+//          -points <n>         number of points and of rays (default 100000)
+//          -mismatch <f>       largest misclassified fraction (default 0.01)
+//
+
+#include "MeshConvexDecomposition.hh"
+
+#include "G4TessellatedSolid.hh"
+#include "G4TriangularFacet.hh"
+#include "G4MultiUnion.hh"
+#include "G4Transform3D.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ThreeVector.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+namespace {
+    
+    void PrintUsage()
+    {
+        G4cerr << " Usage: TessellatedSolidBenchmark [-voxels n,n,...] [-tolerance mm] [-pieces n] [-points n] [-mismatch f] mesh.ply [decomposition.ply]" << G4endl;
+    }
+    
+    G4ThreeVector Vertex(const TriangleMesh& mesh, std::uint32_t i)
+    {
+        return G4ThreeVector(mesh.vertices[3*i], mesh.vertices[3*i + 1], mesh.vertices[3*i + 2])*mm;
+    }
+    
+    ////    maxVoxels 0: the Geant4 default
+    G4TessellatedSolid* BuildSolid(const TriangleMesh& mesh, const G4String& name, G4int maxVoxels)
+    {
+        G4TessellatedSolid* solid = new G4TessellatedSolid(name);
+        for(std::size_t t=0; t<mesh.GetNumberOfTriangles(); t++)
+        {
+            const std::uint32_t* i = &mesh.triangles[3*t];
+            G4TriangularFacet* facet = new G4TriangularFacet(Vertex(mesh, i[0]), Vertex(mesh, i[1]), Vertex(mesh, i[2]), ABSOLUTE);
+            if(!solid->AddFacet(facet)) delete facet;
+        }
+        if(maxVoxels>0) solid->SetMaxVoxels(maxVoxels);
+        solid->SetSolidClosed(true);
+        return solid;
+    }
+    
+    struct Representation
+    {
+        G4String    name;
+        G4VSolid*   solid;
+        std::size_t nFacets;
+        std::vector<G4VSolid*> parts;
+    };
+    
+    struct Result
+    {
+        double  insideRate;         // Inside() calls per second
+        double  safetyInRate;       // DistanceToIn(p) calls per second
+        double  safetyOutRate;      // DistanceToOut(p) calls per second
+        double  distanceRate;       // DistanceToIn(p,v) + DistanceToOut(p,v) calls per second
+        std::vector<bool> inside;
+    };
+    
+    struct Ray
+    {
+        G4ThreeVector position;
+        G4ThreeVector direction;
+    };
+    
+    Result Measure(const G4VSolid* solid, const std::vector<G4ThreeVector>& points,
+                   const std::vector<G4ThreeVector>& outsidePoints, const std::vector<G4ThreeVector>& insidePoints,
+                   const std::vector<Ray>& rays)
+    {
+        Result result;
+        result.inside.resize(points.size());
+        
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(std::size_t i=0; i<points.size(); i++) result.inside[i] = (solid->Inside(points[i])!=kOutside);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        result.insideRate = points.size()/elapsed.count();
+        
+        ////    The sums keep the calls from being optimised away
+        double sum = 0.;
+        start = std::chrono::steady_clock::now();
+        for(std::size_t i=0; i<outsidePoints.size(); i++) sum += solid->DistanceToIn(outsidePoints[i]);
+        elapsed = std::chrono::steady_clock::now() - start;
+        result.safetyInRate = outsidePoints.size()/elapsed.count();
+        
+        start = std::chrono::steady_clock::now();
+        for(std::size_t i=0; i<insidePoints.size(); i++) sum += solid->DistanceToOut(insidePoints[i]);
+        elapsed = std::chrono::steady_clock::now() - start;
+        result.safetyOutRate = insidePoints.size()/elapsed.count();
+        
+        ////    Rays crossing the solid as many times as they re-enter it
+        long nCalls = 0;
+        start = std::chrono::steady_clock::now();
+        for(std::size_t r=0; r<rays.size(); r++)
+        {
+            G4ThreeVector position = rays[r].position;
+            for(int crossing=0; crossing<1000; crossing++)
+            {
+                const double in = solid->DistanceToIn(position, rays[r].direction);
+                nCalls++;
+                if(in>=kInfinity) break;
+                position += in*rays[r].direction;
+                
+                const double out = solid->DistanceToOut(position, rays[r].direction);
+                nCalls++;
+                if(out>=kInfinity) break;
+                position += out*rays[r].direction;
+                sum += out;
+            }
+        }
+        elapsed = std::chrono::steady_clock::now() - start;
+        result.distanceRate = nCalls/elapsed.count();
+        
+        if(sum<0.) G4cout << sum << G4endl;
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<G4int> maxVoxels;
+    maxVoxels.push_back(1000);
+    maxVoxels.push_back(10000);
+    maxVoxels.push_back(100000);
+    double tolerance = 0.5*mm;
+    std::size_t maxPieces = 256;
+    std::size_t nPoints = 100000;
+    double maxMismatch = 0.01;
+    std::vector<G4String> files;
+    
+    for(int i=1; i<argc; i++)
+    {
+        const G4String argument = argv[i];
+        const bool hasValue = (i+1<argc);
+        
+        if(argument=="-voxels" && hasValue)
+        {
+            maxVoxels.clear();
+            std::istringstream values(argv[++i]);
+            std::string value;
+            while(std::getline(values, value, ',')) if(std::atoi(value.c_str())>0) maxVoxels.push_back(std::atoi(value.c_str()));
+        }
+        else if(argument=="-tolerance" && hasValue) tolerance = std::atof(argv[++i])*mm;
+        else if(argument=="-pieces" && hasValue)    maxPieces = std::strtoul(argv[++i], 0, 10);
+        else if(argument=="-points" && hasValue)    nPoints = std::strtoul(argv[++i], 0, 10);
+        else if(argument=="-mismatch" && hasValue)  maxMismatch = std::atof(argv[++i]);
+        else if(argument.size()>1 && argument[0]=='-')
+        {
+            PrintUsage();
+            return 1;
+        }
+        else files.push_back(argument);
+    }
+    
+    if(files.empty() || files.size()>2 || nPoints==0 || tolerance<=0. || maxPieces==0)
+    {
+        PrintUsage();
+        return 1;
+    }
+    
+    //------------------------------------------------
+    //      Mesh and its convex decomposition
+    TriangleMesh mesh;
+    if(!mesh.ReadPLY(files[0]))
+    {
+        G4cerr << "TessellatedSolidBenchmark: cannot read " << files[0] << G4endl;
+        return 1;
+    }
+    mesh.WeldVertices();
+    
+    std::vector<TriangleMesh> pieces;
+    if(files.size()==2)
+    {
+        if(!MeshConvexDecomposition::ReadPLY(files[1], pieces))
+        {
+            G4cerr << "TessellatedSolidBenchmark: cannot read " << files[1] << G4endl;
+            return 1;
+        }
+    }
+    else pieces = MeshConvexDecomposition::Decompose(mesh, tolerance/mm, maxPieces);
+    
+    //------------------------------------------------
+    //      Representations, the first one the reference
+    std::vector<Representation> representations;
+    
+    Representation reference;
+    reference.name = "default voxels";
+    reference.solid = BuildSolid(mesh, "Default", 0);
+    reference.nFacets = mesh.GetNumberOfTriangles();
+    representations.push_back(reference);
+    
+    for(std::size_t v=0; v<maxVoxels.size(); v++)
+    {
+        std::ostringstream name;
+        name << maxVoxels[v] << " voxels";
+        
+        Representation voxels;
+        voxels.name = name.str();
+        voxels.solid = BuildSolid(mesh, voxels.name, maxVoxels[v]);
+        voxels.nFacets = mesh.GetNumberOfTriangles();
+        representations.push_back(voxels);
+    }
+    
+    if(!pieces.empty())
+    {
+        std::ostringstream name;
+        name << pieces.size() << " convex";
+        
+        Representation convex;
+        convex.name = name.str();
+        convex.nFacets = 0;
+        G4MultiUnion* solid = new G4MultiUnion("Convex");
+        G4Transform3D placement;
+        for(std::size_t p=0; p<pieces.size(); p++)
+        {
+            G4TessellatedSolid* part = BuildSolid(pieces[p], "ConvexPiece", 0);
+            solid->AddNode(*part, placement);
+            convex.parts.push_back(part);
+            convex.nFacets += pieces[p].GetNumberOfTriangles();
+        }
+        solid->Voxelize();
+        convex.solid = solid;
+        representations.push_back(convex);
+    }
+    
+    //------------------------------------------------
+    //      Random points in the bounding box, enlarged by 10%, split into
+    //      outside and inside by the reference, and rays from a sphere
+    //      around it towards random points of the box
+    G4ThreeVector lower(kInfinity, kInfinity, kInfinity), upper(-kInfinity, -kInfinity, -kInfinity);
+    for(std::size_t i=0; i<mesh.GetNumberOfVertices(); i++)
+    {
+        const G4ThreeVector p = Vertex(mesh, i);
+        lower = G4ThreeVector(std::min(lower.x(), p.x()), std::min(lower.y(), p.y()), std::min(lower.z(), p.z()));
+        upper = G4ThreeVector(std::max(upper.x(), p.x()), std::max(upper.y(), p.y()), std::max(upper.z(), p.z()));
+    }
+    const G4ThreeVector centre = 0.5*(lower + upper);
+    const G4ThreeVector halfSize = 0.55*(upper - lower);
+    const double radius = 2.*halfSize.mag();
+    
+    std::mt19937_64 engine(4357);
+    std::uniform_real_distribution<double> uniform(-1., 1.);
+    
+    std::vector<G4ThreeVector> points(nPoints), outsidePoints, insidePoints;
+    std::vector<Ray> rays(nPoints);
+    for(std::size_t i=0; i<nPoints; i++)
+    {
+        points[i] = centre + G4ThreeVector(uniform(engine)*halfSize.x(), uniform(engine)*halfSize.y(), uniform(engine)*halfSize.z());
+        
+        G4ThreeVector start;
+        do start = G4ThreeVector(uniform(engine), uniform(engine), uniform(engine));
+        while(start.mag2()>1. || start.mag2()<1e-6);
+        rays[i].position = centre + radius*start.unit();
+        rays[i].direction = (centre + G4ThreeVector(uniform(engine)*halfSize.x(), uniform(engine)*halfSize.y(), uniform(engine)*halfSize.z())
+                             - rays[i].position).unit();
+    }
+    for(std::size_t i=0; i<nPoints; i++)
+    {
+        const EInside inside = reference.solid->Inside(points[i]);
+        if(inside==kOutside) outsidePoints.push_back(points[i]);
+        else if(inside==kInside) insidePoints.push_back(points[i]);
+    }
+    
+    //------------------------------------------------
+    //      Measurements and regression check
+    G4cout << "\n Mesh:                  " << files[0]
+    << "\n Points / rays:         " << nPoints << ", " << insidePoints.size() << " inside the reference\n" << G4endl;
+    
+    G4cout << " " << std::left << std::setw(16) << "solid" << std::right << std::setw(10) << "facets"
+    << std::setw(14) << "Inside M/s" << std::setw(14) << "SafeIn M/s" << std::setw(14) << "SafeOut M/s" << std::setw(14) << "Dist. M/s"
+    << std::setw(14) << "mismatch %" << G4endl;
+    
+    std::vector<bool> referenceInside;
+    G4bool passed = true;
+    for(std::size_t r=0; r<representations.size(); r++)
+    {
+        const Result result = Measure(representations[r].solid, points, outsidePoints, insidePoints, rays);
+        if(r==0) referenceInside = result.inside;
+        
+        std::size_t nMismatches = 0;
+        for(std::size_t i=0; i<nPoints; i++) if(result.inside[i]!=referenceInside[i]) nMismatches++;
+        const double mismatch = nMismatches/double(std::max<std::size_t>(insidePoints.size(), 1));
+        if(mismatch>maxMismatch) passed = false;
+        
+        G4cout << " " << std::left << std::setw(16) << representations[r].name << std::right << std::setw(10) << representations[r].nFacets
+        << std::fixed << std::setprecision(3)
+        << std::setw(14) << result.insideRate/1e6 << std::setw(14) << result.safetyInRate/1e6
+        << std::setw(14) << result.safetyOutRate/1e6 << std::setw(14) << result.distanceRate/1e6
+        << std::setw(14) << 100.*mismatch << (mismatch>maxMismatch ? "  FAILED" : "") << G4endl;
+        G4cout.unsetf(std::ios::fixed);
+        G4cout << std::setprecision(6);
+    }
+    G4cout << "\n Regression check:      " << (passed ? "passed" : "FAILED") << " (limit " << 100.*maxMismatch << "% of the inside points)\n" << G4endl;
+    
+    for(std::size_t r=0; r<representations.size(); r++)
+    {
+        delete representations[r].solid;
+        for(std::size_t p=0; p<representations[r].parts.size(); p++) delete representations[r].parts[p];
+    }
+    
+    return passed ? 0 : 2;
+}
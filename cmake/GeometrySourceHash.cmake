@@ -0,0 +1,16 @@
+#----------------------------------------------------------------------------
+# SHA-256 of the sources that determine the geometry, as K600_GEOMETRY_SOURCE_HASH
+# in OUTPUT, for the configuration hash of the geometry snapshot (GeometrySnapshot).
+#
+#   cmake -DSOURCES="a.cc|b.hh|..." -DOUTPUT=K600GeometrySourceHash.hh -P GeometrySourceHash.cmake
+#
+string(REPLACE "|" ";" _sources "${SOURCES}")
+
+set(_hashes "")
+foreach(_source ${_sources})
+  file(SHA256 ${_source} _hash)
+  set(_hashes "${_hashes}${_hash}")
+endforeach()
+string(SHA256 _hash "${_hashes}")
+
+file(WRITE ${OUTPUT} "#define K600_GEOMETRY_SOURCE_HASH \"${_hash}\"\n")
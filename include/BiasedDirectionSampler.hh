@@ -0,0 +1,84 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef BiasedDirectionSampler_h
+#define BiasedDirectionSampler_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+
+/// Importance sampling of primary directions towards a set of detectors.
+///
+/// Directions are drawn from the mixture
+///
+///     p(w) = f/(4 pi) + (1-f)/N * sum_i [w in cone i]/Omega_i
+///
+/// i.e. isotropically with probability f (so that every direction can still
+/// be reached) and otherwise uniformly inside the cone of one of the N
+/// detectors. Sample() returns the weight p_isotropic(w)/p(w) = 1/(4 pi p(w)),
+/// so that weighted tallies are unbiased estimates of the isotropic ones.
+
+class BiasedDirectionSampler
+{
+public:
+    BiasedDirectionSampler();
+
+    void    Clear();
+
+    ////    direction: detector axis (need not be normalised), halfAngle: cone half-opening angle
+    void    AddCone(const G4ThreeVector& direction, G4double halfAngle);
+    ////    Fraction of the primaries that are still emitted isotropically (0 < f <= 1)
+    void    SetIsotropicFraction(G4double fraction);
+
+    G4int       GetNumberOfCones() const        { return G4int(fAxes.size()); }
+    G4double    GetIsotropicFraction() const    { return fIsotropicFraction; }
+
+    ////    Samples a unit direction and returns its statistical weight
+    G4double    Sample(G4ThreeVector& direction) const;
+
+    ////    Weight of a given unit direction under this sampler
+    G4double    GetWeight(const G4ThreeVector& direction) const;
+
+private:
+    std::vector<G4ThreeVector>  fAxes;
+    std::vector<G4double>       fCosHalfAngles;
+    std::vector<G4double>       fInvSolidAngles;
+    G4double                    fIsotropicFraction;
+};
+
+#endif
@@ -0,0 +1,148 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef BinaryReactionKinematics_h
+#define BinaryReactionKinematics_h 1
+
+#include <cstddef>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//      Cached binary relativistic kinematics
+////////////////////////////////////////////////////////////////////////////////
+//
+//      Same physics (and units) as BiRelKin(): masses in u, energies in MeV,
+//      momenta in the BiRelKin convention p = sqrt(E^2 - m^2c^4)/sqrt(c^2) and
+//      angles in degrees. Everything that depends only on the masses, the
+//      beam energy and the excitation energy is evaluated once, so that for
+//      each ejectile angle only the theta-dependent terms of the quadratic
+//      remain:
+//
+//          a(theta)      = A0 + A1*cos^2(theta)
+//          b             = B
+//          b^2 - 4ac     = 16 p0^2c^2 cos^2(theta) (D0 + D1*cos^2(theta))
+//
+//      The discriminant is used in this factorised form, which keeps its
+//      precision near 90 deg, where b^2 and 4ac cancel (and BiRelKin loses
+//      up to ~1e-4 MeV of the ejectile energy).
+//
+
+struct BinaryReactionKinematicsResult
+{
+    double  T2, E2, p2;         // ejectile
+    double  T3, E3, p3;         // recoil
+    double  thetaRecoil;        // recoil angle w.r.t. the beam axis (deg)
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class BinaryReactionKinematics
+{
+public:
+    ////    m[0..3]: projectile, target, ejectile, recoil (u)
+    ////    T0, T1: projectile and target kinetic energies (MeV), Ex: recoil excitation (MeV)
+    BinaryReactionKinematics(const double* m, double T0, double T1 = 0.0, double Ex = 0.0);
+
+    ////    Only the Ex-dependent invariants are recomputed
+    void    SetExcitationEnergy(double Ex);
+    double  GetExcitationEnergy() const     { return fEx; }
+    double  GetQValue() const               { return fQ; }
+
+    ////    True if this object was set up for exactly this reaction
+    bool    Matches(const double* m, double T0, double T1, double Ex) const;
+
+    ////    Scalar evaluation for one ejectile angle (deg)
+    void    Evaluate(double thetaEjectile, BinaryReactionKinematicsResult& result) const;
+
+    ////    Drop-in replacement for BiRelKin(m, T, E, p, thetaEjectile, thetaRecoil, Ex)
+    void    Evaluate(double thetaEjectile, double* T, double* E, double* p, double& thetaRecoil) const;
+
+    ////    Batch evaluation for n ejectile angles, given as cos(theta) and sin(theta) (e.g. sampled
+    ////    isotropically as cos(theta), sin(theta) = sqrt(1 - cos^2)), structure-of-arrays output.
+    ////    The recoil angle is returned as its cosine and sine, i.e. as a direction: asin() of
+    ////    sinThetaRecoil is the thetaRecoil of Evaluate(). Any output pointer may be null.
+    ////    The work is done in fixed-size blocks of branch-free loops with only square roots,
+    ////    which the compiler vectorises (see CMakeLists.txt for the flags this needs).
+    void    EvaluateBatch(const double* cosTheta, const double* sinTheta, std::size_t n,
+                          double* T2, double* T3, double* cosThetaRecoil, double* sinThetaRecoil) const;
+
+private:
+    double  fM[4];
+    double  fT0, fT1, fEx;
+
+    ////    Reaction invariants
+    double  fQ;
+    double  fE0, fE1;
+    double  fP0sq_c2;           // p0^2 c^2
+    double  fM2sq_c4;           // m2^2 c^4
+    double  fM3sq_c4;           // m3^2 c^4
+    double  fInvSqrtC2;
+
+    ////    Ex-dependent invariants
+    double  fEtotal;
+    double  fA0, fA1, fB;
+    double  fD0, fD1;           // discriminant / (16 p0^2c^2 cos^2(theta)) = D0 + D1*cos^2(theta)
+    double  f4P0_c;             // 4 p0 c
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Dense (theta, Ex) table of the kinematics with bilinear interpolation,
+/// for very high-rate generation where even the cached quadratic is too slow.
+/// The interpolation error falls with the square of the node spacing: check
+/// it for the chosen grid with benchmarks/KinematicsBenchmark.
+
+class BinaryReactionKinematicsTable
+{
+public:
+    ////    nTheta nodes over [thetaMin, thetaMax] (deg), nEx nodes over [ExMin, ExMax] (MeV)
+    BinaryReactionKinematicsTable(const BinaryReactionKinematics& kinematics,
+                                  double thetaMin, double thetaMax, int nTheta,
+                                  double ExMin, double ExMax, int nEx);
+
+    ////    Returns false (result untouched) outside the tabulated range
+    bool    Interpolate(double thetaEjectile, double Ex, BinaryReactionKinematicsResult& result) const;
+
+private:
+    double  fThetaMin, fThetaMax, fInvDTheta;
+    double  fExMin, fExMax, fInvDEx;
+    int     fNTheta, fNEx;
+
+    ////    Node (iEx, iTheta) at fNodes[iEx*fNTheta + iTheta]
+    std::vector<BinaryReactionKinematicsResult>     fNodes;
+};
+
+#endif
@@ -0,0 +1,129 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef CLOVERParametricGeometry_h
+#define CLOVERParametricGeometry_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+class G4VSolid;
+
+////////////////////////////////////////////////////////////////////////////////
+//      Parametric (CSG) model of the CLOVER detectors
+////////////////////////////////////////////////////////////////////////////////
+//
+//      Analytic solids for the volumes otherwise imported as meshes, in the
+//      same frames (mm, before the offset), so that they can be swapped in
+//      one for one:
+//
+//      HPGe crystals (HPGe_pureCylindricalBorehole_RoundedCrystal<n>_10um):
+//      a cylinder with a rounded front edge (G4Polycone and G4Torus) cut by
+//      the two flat faces towards the neighbouring crystals and the two
+//      tapered outer faces (G4Trap), with a cylindrical borehole from the
+//      back. Crystal n is crystal 1 turned by (n - 1) x 90 degrees about the
+//      CLOVER axis.
+//
+//      Lithium contacts (HPGe_pureCylindricalBorehole_LithiumContact<n>_10um):
+//      the lining of the borehole (G4Polycone), a daughter of the crystal.
+//
+//      BGO shield crystals (BGO-Crystal_Modified_<n>): on each of the four
+//      sides of the shield, two segments at the middle of the side and two at
+//      its corners, mitred at 45 degrees. Their inner and side faces taper
+//      uniformly; the outer face is steeper in front of a kink. Every segment
+//      is the union of two G4GenericTraps, before and behind the kink.
+//
+//      The default dimensions are those of the meshes; the CLOVERParametricValidator
+//      tool compares the solids with the meshes by volume and surface distance.
+//
+
+////    Eurogam clover HPGe crystal, lithium contact and borehole
+struct CLOVERCrystalDimensions
+{
+    CLOVERCrystalDimensions();
+    
+    G4double    radius;             // of the crystal before it is shaped
+    G4double    length;
+    G4double    frontZ;             // of the front face
+    G4double    axisOffset;         // of the crystal axes from the CLOVER axis, in x and in y
+    G4double    flatDistance;       // of the flat inner faces from the crystal axis (also of the tapered faces at the front)
+    G4double    taperAngle;         // of the outer faces
+    G4double    frontRounding;      // radius of the rounded front edge
+    G4double    boreholeRadius;
+    G4double    boreholeDepth;      // from the back face
+    G4double    contactThickness;   // lithium-diffused contact around the borehole
+    G4double    contactDepth;       // from the back face
+    G4double    contactGap;         // between the borehole and the contact (left by the meshes)
+};
+
+////    BGO crystals of the Compton-suppression shield
+struct CLOVERShieldDimensions
+{
+    CLOVERShieldDimensions();
+    
+    G4double    frontZ;             // of the front faces
+    G4double    length;
+    G4double    kinkDepth;          // of the kink of the outer faces, from the front
+    G4double    innerDistance;      // of the inner faces from the CLOVER axis, at the front
+    G4double    outerDistance;      // of the outer faces from the CLOVER axis, at the front
+    G4double    outerKinkDistance;  // of the outer faces from the CLOVER axis, at the kink
+    G4double    segmentBoundary;    // between the middle and corner segments of a side, from its centre, at the front
+    G4double    taperAngle;         // of the inner faces, the boundaries and the outer faces behind the kink
+    G4double    gap;                // between a segment and each of its boundaries
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class CLOVERParametricGeometry
+{
+public:
+    static const G4int kNumberOfCrystals = 4;
+    static const G4int kNumberOfShieldCrystals = 16;
+    
+    ////    crystal: 0-3, for HPGe_pureCylindricalBorehole_RoundedCrystal1-4. The offset is added, as for the meshes.
+    static G4VSolid*    HPGeCrystal(const G4String& name, G4int crystal, const G4ThreeVector& offset,
+                                    const CLOVERCrystalDimensions& dimensions = CLOVERCrystalDimensions());
+    
+    ////    crystal: 0-3, for HPGe_pureCylindricalBorehole_LithiumContact1-4, in the frame of the crystal
+    static G4VSolid*    LithiumContact(const G4String& name, G4int crystal, const G4ThreeVector& offset,
+                                       const CLOVERCrystalDimensions& dimensions = CLOVERCrystalDimensions());
+    
+    ////    segment: 0-15, for BGO-Crystal_Modified_1-16
+    static G4VSolid*    BGOCrystal(const G4String& name, G4int segment, const G4ThreeVector& offset,
+                                   const CLOVERShieldDimensions& dimensions = CLOVERShieldDimensions());
+};
+
+#endif
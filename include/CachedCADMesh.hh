@@ -0,0 +1,176 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef CachedCADMesh_h
+#define CachedCADMesh_h 1
+
+#include "MeshDecimation.hh"
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+class G4VSolid;
+class G4VFacet;
+class G4TessellatedSolid;
+
+////////////////////////////////////////////////////////////////////////////////
+//      Binary cache of a tessellated mesh
+////////////////////////////////////////////////////////////////////////////////
+//
+//      Written after the first import of a mesh file through CADMesh, next to
+//      the mesh, and read back through a read-only memory mapping:
+//
+//      [CADMeshCacheHeader]                    (128 bytes)
+//      [vertices: nVertices x (x, y, z)]       double, mm (Geant4 internal units)
+//      [facets: nFacets x (i0, i1, i2)]        uint32 vertex indices, outward order
+//
+//      The vertices are those of the facets accepted by G4TessellatedSolid,
+//      i.e. already scaled, offset and, if requested, reversed, and shared
+//      between facets. A cache is used only if its source file has the same
+//      size and 64-bit FNV-1a hash, and the same scale, offset and
+//      orientation, so a changed mesh is simply imported again.
+//
+
+struct CADMeshCacheHeader
+{
+    char            magic[8];               // "K600MSH"
+    std::uint32_t   version;
+    std::uint32_t   headerSize;
+    std::uint64_t   nVertices;
+    std::uint64_t   nFacets;
+    std::uint64_t   sourceSize;             // bytes of the mesh file
+    std::uint64_t   sourceHash;             // FNV-1a of the mesh file
+    double          scale;
+    double          offset[3];
+    std::uint8_t    reverse;
+    std::uint8_t    reserved[47];
+};
+
+static_assert(sizeof(CADMeshCacheHeader) == 128, "CADMeshCacheHeader must be 128 bytes");
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Drop-in replacement for CADMesh(meshPath, meshType, scale, offset, reverse)->TessellatedMesh().
+///
+/// The constructor starts loading the mesh in the background: the source file
+/// is hashed and a valid cache is turned into facets, on at most one thread
+/// per core. Meshes constructed one after the other (the crystals, the BGO
+/// and PMT sets of the CLOVERs) are therefore loaded in parallel, and
+/// TessellatedMesh() only waits for its own. The solid itself is always
+/// assembled on the calling thread. Without a valid cache the mesh is imported
+/// by CADMesh, as before, and the cache is written for the next run.
+///
+/// A mesh given a level of detail with SetLevelOfDetail() before it is
+/// constructed is replaced by its decimated version (see MeshDecimation.hh and
+/// the MeshDecimator tool), if that has been generated; otherwise the full
+/// mesh is used with a warning.
+///
+/// Per mesh, the voxelisation of the tessellated solid can be set with
+/// SetMaxVoxels(), or the solid replaced by a G4MultiUnion of the convex
+/// pieces written by the MeshConvexDecomposer tool, with
+/// SetConvexDecomposition(). Check both with
+/// benchmarks/TessellatedSolidBenchmark before using them.
+
+class CachedCADMesh
+{
+public:
+    static const std::uint32_t  kVersion = 1;
+
+    CachedCADMesh(const char* meshPath, const char* meshType, G4double scale,
+                  const G4ThreeVector& offset, G4bool reverse);
+    ~CachedCADMesh();
+
+    G4VSolid*   TessellatedMesh();
+
+    ////    The cache of a mesh, e.g. "Crystal1.ply.3fa2b1c0.bin" (hash of scale, offset and orientation)
+    static G4String GetCacheFileName(const G4String& meshPath, G4double scale,
+                                     const G4ThreeVector& offset, G4bool reverse);
+
+    ////    Use the mesh decimated to tolerance for meshName (file name without directory and extension, e.g. "Body_Modified2_tol_10um").
+    ////    A tolerance of 0 restores the full mesh.
+    static void     SetLevelOfDetail(const G4String& meshName, G4double tolerance);
+
+    ////    Largest number of voxels of the G4TessellatedSolid of meshName (0: the Geant4 default)
+    static void     SetMaxVoxels(const G4String& meshName, G4int maxVoxels);
+
+    ////    Use the G4MultiUnion of the convex decomposition of meshName (MeshConvexDecomposition), if generated.
+    ////    Takes precedence over the level of detail.
+    static void     SetConvexDecomposition(const G4String& meshName, G4bool use = true);
+
+    ////    The settings above, one line per mesh name, for the geometry snapshot configuration
+    static G4String GetSettingsDescription();
+
+    ////    The mesh files, levels of detail and convex decompositions looked for by the meshes constructed so far
+    static std::vector<G4String> GetSourceFiles();
+
+private:
+    CachedCADMesh(const CachedCADMesh&);
+    CachedCADMesh& operator=(const CachedCADMesh&);
+
+    ////    The mesh file to load: meshPath or its level of detail
+    static G4String SelectLevelOfDetail(const G4String& meshPath);
+    ////    The convex decomposition to load instead, if any
+    static G4String SelectConvexDecomposition(const G4String& meshPath);
+
+    G4VSolid*   ConvexUnion();
+
+    ////    Background part: source hash and facets from the cache
+    void    Load();
+    G4bool  ReadCache();
+    G4bool  SaveCache(const G4TessellatedSolid* solid) const;
+
+    G4String                fMeshPath;
+    G4String                fDecompositionFile;
+    G4int                   fMaxVoxels;
+    G4String                fMeshType;
+    G4double                fScale;
+    G4ThreeVector           fOffset;
+    G4bool                  fReverse;
+    G4String                fCacheFile;
+
+    std::thread             fLoader;
+    G4bool                  fHaveSource;
+    std::uint64_t           fSourceSize;
+    std::uint64_t           fSourceHash;
+    std::vector<G4VFacet*>  fFacets;
+    std::vector<TriangleMesh> fPieces;
+};
+
+#endif
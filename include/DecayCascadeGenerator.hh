@@ -0,0 +1,251 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef DecayCascadeGenerator_h
+#define DecayCascadeGenerator_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4LorentzVector.hh"
+#include "BinaryReactionKinematics.hh"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+class G4Event;
+class G4ParticleDefinition;
+class G4PrimaryVertex;
+class G4PrimaryParticle;
+
+////////////////////////////////////////////////////////////////////////////////
+//      Tabulated inverse-CDF sampler for polar angles
+////////////////////////////////////////////////////////////////////////////////
+//
+//      Built once from a (theta [deg], W) table, e.g. the fAngCor_X / fAngDist_X
+//      arrays of the Distributions headers. W(theta) is the density per unit
+//      solid angle, so the sampled polar angle follows W(theta)*sin(theta).
+//      Without a table the sampler is isotropic.
+//
+
+class AngularDistributionSampler
+{
+public:
+    AngularDistributionSampler();
+
+    void    SetIsotropic();
+    void    SetTable(const double (*table)[2], int nPoints, double thetaMin = 0.0, double thetaMax = 180.0);
+
+    ////    Returns theta (deg)
+    double  Sample() const;
+
+private:
+    std::vector<double>     fTheta;     // deg
+    std::vector<double>     fCDF;
+    bool                    fIsotropic;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Generates complete reaction + decay cascade events.
+///
+/// A binary reaction (projectile + target -> ejectile + recoil*) populates
+/// one of a set of recoil levels; each level then decays through a chain of
+/// gamma-ray or particle transitions, chosen by branching ratio, until a
+/// level without transitions is reached. Every decay is a two-body decay in
+/// the rest frame of the parent, emitted with the transition's angular
+/// correlation about the parent's direction of motion, and then boosted into
+/// the laboratory.
+///
+/// All branching CDFs, angular samplers, level masses and kinematics are
+/// prepared in Initialise(), so GeneratePrimaries() only samples and boosts.
+///
+/// The reaction and the decay scheme are read from a cascade file
+/// (ReadFile(), /K600/generator/cascadeFile): one keyword per line, '#'
+/// starts a comment, energies in MeV and angles in deg.
+///
+///     reaction        <projectile> <targetZ> <targetA> <ejectile> <recoilZ> <recoilA>
+///     beamEnergy      <T>
+///     ejectileAngles  <thetaMin> <thetaMax> [table]
+///     level           <name> <Z> <A> <Ex>
+///     populate        <level> <weight>
+///     transition      <name> <initialLevel> <finalLevel> <particle|gamma> <branching> [table]
+///     emitEjectile    <0|1>
+///     emitResiduals   <0|1>
+///
+/// Particles are Geant4 particle names. The branching ratios and population
+/// weights are relative per level and must be given explicitly: a missing,
+/// non-positive or placeholder ("?") value makes the file unusable. A table
+/// is the (theta, W) angular correlation of the transition (or distribution
+/// of the ejectile), either registered by name with RegisterAngularTable()
+/// or read from a two-column text file; without one the emission is isotropic.
+
+class DecayCascadeGenerator
+{
+public:
+    DecayCascadeGenerator();
+    ~DecayCascadeGenerator();
+
+    //------------------------------------------------
+    //      Reaction
+    void    SetReaction(G4ParticleDefinition* projectile, G4ParticleDefinition* target,
+                        G4ParticleDefinition* ejectile, G4int recoilZ, G4int recoilA);
+    void    SetBeamEnergy(G4double beamEnergy);
+
+    ////    Ejectile polar angle (lab): flat in cos(theta) over a range, or a tabulated distribution
+    void    SetEjectileAngularRange(G4double thetaMin, G4double thetaMax);
+    void    SetEjectileAngularDistribution(const double (*table)[2], int nPoints, G4double thetaMin, G4double thetaMax);
+
+    //------------------------------------------------
+    //      Cascade file
+    ////    Named (theta, W) tables that a cascade file may refer to. The table must outlive the generator.
+    void    RegisterAngularTable(const G4String& name, const double (*table)[2], int nPoints);
+    ////    Reads the reaction and decay scheme of filename (see above) into an empty generator.
+    ////    Returns false, with a warning naming the offending line, if the file is unusable.
+    G4bool  ReadFile(const G4String& filename);
+
+    //------------------------------------------------
+    //      Decay scheme
+    ////    Returns the level index
+    G4int   AddLevel(G4int Z, G4int A, G4double excitationEnergy);
+    ////    Recoil levels fed directly by the reaction, with relative weights
+    void    AddPopulatedLevel(G4int level, G4double weight = 1.0);
+
+    ////    Returns the transition index. Without a table the emission is isotropic.
+    G4int   AddGammaTransition(const G4String& name, G4int initialLevel, G4int finalLevel, G4double branching,
+                               const double (*angCor)[2] = 0, int nPoints = 0);
+    G4int   AddParticleTransition(const G4String& name, G4int initialLevel, G4int finalLevel,
+                                  G4ParticleDefinition* particle, G4double branching,
+                                  const double (*angCor)[2] = 0, int nPoints = 0);
+
+    ////    Whether the ejectile and the final residual nuclei are also emitted as primaries
+    void    SetEmitEjectile(G4bool emit)    { fEmitEjectile = emit; }
+    void    SetEmitResiduals(G4bool emit)   { fEmitResiduals = emit; }
+
+    ////    Prepares the branching CDFs, samplers and kinematics. Returns false if the scheme is unusable.
+    G4bool  Initialise();
+    G4bool  IsInitialised() const           { return fInitialised; }
+
+    //------------------------------------------------
+    //      Event generation
+    ////    Adds one vertex at position holding all products of one event
+    void    GeneratePrimaries(G4Event* anEvent, const G4ThreeVector& position);
+
+    ////    Information on the last generated event
+    G4double        GetLastExcitationEnergy() const         { return fLastExcitationEnergy; }
+    G4double        GetLastEjectileTheta() const            { return fLastEjectileTheta; }
+    const G4String& GetLastDecayPath() const                { return fLastDecayPath; }
+
+    ////    First decay product of the last event (kinetic energy, lab angles in deg)
+    G4double        GetLastFirstProductEnergy() const       { return fLastFirstProductEnergy; }
+    G4double        GetLastFirstProductTheta() const        { return fLastFirstProductTheta; }
+    G4double        GetLastFirstProductPhi() const          { return fLastFirstProductPhi; }
+
+private:
+    struct Level
+    {
+        G4int       Z, A;
+        G4double    excitationEnergy;
+        G4double    mass;                       // total mass including Ex (MeV)
+        G4ParticleDefinition*   ion;            // emitted when the cascade ends here
+        std::vector<G4int>      transitions;
+        std::vector<G4double>   branchingCDF;
+    };
+
+    struct Transition
+    {
+        G4String    name;
+        G4int       initialLevel, finalLevel;
+        G4ParticleDefinition*   particle;       // gamma for electromagnetic transitions
+        G4double    branching;
+        G4double    particleMass;
+        G4double    momentum;                   // two-body momentum in the parent rest frame (MeV/c)
+        G4double    particleEnergy;             // total energy in the parent rest frame (MeV)
+        const double (*angCor)[2];
+        int         nPoints;
+        AngularDistributionSampler  sampler;
+    };
+
+    G4int   AddTransition(const G4String& name, G4int initialLevel, G4int finalLevel,
+                          G4ParticleDefinition* particle, G4double branching,
+                          const double (*angCor)[2], int nPoints);
+
+    ////    Decays level (moving with fourMomentum) down to the end of its cascade
+    void    Decay(G4int level, const G4LorentzVector& fourMomentum, G4PrimaryVertex* vertex);
+    G4PrimaryParticle* AddPrimary(G4ParticleDefinition* particle, const G4LorentzVector& fourMomentum, G4PrimaryVertex* vertex);
+
+    G4int   SampleCDF(const std::vector<G4double>& cdf) const;
+
+    ////    A registered table, or one read from a two-column file and kept in fFileTables
+    G4bool  FindAngularTable(const G4String& name, const double (*&table)[2], int& nPoints);
+
+    //------------------------------------------------
+    G4ParticleDefinition*   fProjectile;
+    G4ParticleDefinition*   fTarget;
+    G4ParticleDefinition*   fEjectile;
+    G4int                   fRecoilZ, fRecoilA;
+    G4double                fBeamEnergy;
+
+    G4double                fEjectileThetaMin, fEjectileThetaMax;
+    const double            (*fEjectileTable)[2];
+    int                     fEjectileTableN;
+    AngularDistributionSampler  fEjectileSampler;
+
+    std::vector<Level>              fLevels;
+    std::vector<Transition>         fTransitions;
+
+    std::vector<G4int>              fPopulatedLevels;
+    std::vector<G4double>           fPopulatedWeights;
+    std::vector<G4double>           fPopulatedCDF;
+    std::vector<BinaryReactionKinematics*>  fReactionKinematics;   // one per populated level
+
+    std::map<G4String, std::pair<const double (*)[2], int>>    fAngularTables;
+    std::vector<std::unique_ptr<double[][2]>>                   fFileTables;
+
+    G4bool                  fEmitEjectile;
+    G4bool                  fEmitResiduals;
+    G4bool                  fInitialised;
+
+    G4double                fLastExcitationEnergy;
+    G4double                fLastEjectileTheta;
+    G4String                fLastDecayPath;
+    G4double                fLastFirstProductEnergy;
+    G4double                fLastFirstProductTheta;
+    G4double                fLastFirstProductPhi;
+    G4bool                  fFirstProductRecorded;
+};
+
+#endif
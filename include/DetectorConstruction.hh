@@ -52,6 +52,10 @@
 #include "G4PropagatorInField.hh"
 #include "G4PropagatorInField.hh"
 #include "G4FieldManager.hh"
+#include "MagneticFieldMapData.hh"
+#include "SpectrometerTransferMap.hh"
+
+#include <map>
 
 
 class G4VPhysicalVolume;
@@ -59,6 +63,7 @@ class G4GlobalMagFieldMessenger;
 
 ///////////////////////////////
 class G4LogicalVolume;
+class G4Region;
 class G4Material;
 class G4UserLimits;
 class G4Isotope;
@@ -71,6 +76,10 @@ class G4ChordFinder;
 class G4PropagatorInField;
 class G4FieldManager;
 class G4UniformMagField;
+class K600FieldSetup;
+class K600FieldMessenger;
+class K600RegionMessenger;
+class K600LayoutMessenger;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -115,26 +124,80 @@ public:
     
 public:
     virtual G4VPhysicalVolume* Construct();
+    ////    Per-thread: magnetic fields of the spectrometer (see K600FieldSetup)
+    virtual void ConstructSDandField();
     virtual void ConstructField();
     
     std::vector<std::tuple<int, double, double>> GetAngles_ALBA_LaBr3Ce();
     std::vector<std::tuple<int, double, double>> GetAngles_CLOVER();
+    
+    G4bool      GetPresence_CLOVER(G4int i) const {return CLOVER_Presence[i];};
+    G4double    GetDistance_CLOVER(G4int i) const {return CLOVER_Distance[i];};
+    G4bool      GetPresence_ALBA_LaBr3Ce(G4int i) const {return LaBr3Ce_Presence[i];};
+    G4double    GetDistance_ALBA_LaBr3Ce(G4int i) const {return LaBr3Ce_Distance[i];};
+    
+    ////    K600 spectrometer envelope (0 if not built) and the planes of its transfer map
+    const G4VPhysicalVolume*    GetSpectrometerEnvelope() const     {return PhysiK600_Envelope;};
+    const TransferMapPlane&     GetTransferMapEntryPlane() const    {return K600_TransferMap_EntryPlane;};
+    const TransferMapPlane&     GetTransferMapExitPlane() const     {return K600_TransferMap_ExitPlane;};
+    const G4String&             GetTransferMapSampleFile() const    {return K600_TransferMap_SampleFile;};
+    
+    ////    Canned layouts of benchmarks/GeometryNavigationBenchmark, applied on top of the configuration
+    ////    of Construct(): "CLOVER", "ALBA_LaBr3Ce" or "Spectrometer" (empty: as configured)
+    void        SetBenchmarkLayout(const G4String& layout) {BenchmarkLayout = layout;};
+    
+    ////    Layout changes between runs (/K600/layout/), master only: the CLOVER (with shield) and LaBr3Ce
+    ////    assemblies already built are moved, removed or put back, and only their mother volume is
+    ////    re-optimised. Detector index -1: all detectors.
+    void        SetDistance_CLOVER(G4int i, G4double distance);
+    void        SetPresence_CLOVER(G4int i, G4bool presence);
+    void        SetDistance_ALBA_LaBr3Ce(G4double distance);
+    void        SetPreconfiguredVersion_ALBA_LaBr3Ce(G4int version);
+    void        SetFaces_ALBA_LaBr3Ce(G4bool hexagons);
+    void        SetPresence_ALBA_LaBr3Ce(G4int i, G4bool presence);
+    void        PrintLayout() const;
+    ////    Number of layout changes so far: angles, distances and presence cached elsewhere are stale when it differs
+    G4int       GetLayoutChanges() const {return LayoutChanges;};
 
 private:
     // methods
     //
     void DefineMaterials();
     G4VPhysicalVolume* DefineVolumes();
+    ////    Everything Construct() sets that determines the geometry, for the snapshot configuration hash
+    G4String ConfigurationDescription() const;
+    ////    Members pointing into a geometry read from the snapshot
+    void FindSnapshotVolumes();
+    ////    Presence flags of the canned benchmark layouts
+    void ApplyBenchmarkLayout();
+    ////    The CLOVER and LaBr3Ce assemblies placed in the vacuum chamber, by name and copy number
+    void FindLayoutVolumes();
+    ////    Transform and presence of LaBr3Ce i from its distance, angles and presence flag
+    void PlaceLayout_ALBA_LaBr3Ce(G4int i, std::map<G4LogicalVolume*, G4VPhysicalVolume*>& modifiedMothers);
+    ////    Puts back or removes a volume from its mother
+    void SetLayoutPresence(G4VPhysicalVolume* physical, G4bool presence, std::map<G4LogicalVolume*, G4VPhysicalVolume*>& modifiedMothers);
+    ////    New voxels for the modified mothers only, if the geometry is already closed
+    void ReoptimiseLayout(const std::map<G4LogicalVolume*, G4VPhysicalVolume*>& modifiedMothers);
+    ////    Makes the volume a root of the named region, created with its cut from RegionProductionCuts
+    void AddToRegion(const G4String& regionName, G4LogicalVolume* logicalVolume);
+    ////    /K600/regions/ commands of all regions in the store
+    void AddRegionCommands();
     
     // data members
     //
     static G4ThreadLocal G4GlobalMagFieldMessenger*  fMagFieldMessenger;
     // magnetic field messenger
+    static G4ThreadLocal K600FieldMessenger*         fFieldMessenger;
+    // stepper/accuracy commands of the K600 magnets (/K600/field/)
+    K600RegionMessenger*    fRegionMessenger;
+    // cuts and user limits of the regions (/K600/regions/), master only
+    K600LayoutMessenger*    fLayoutMessenger;
+    // detector layout changes between runs (/K600/layout/), master only
     
     G4VPhysicalVolume*   fAbsorberPV; // the absorber physical volume
     G4VPhysicalVolume*   fGapPV;      // the gap physical volume
     
-    G4bool  fCheckOverlaps; // option to activate checking of volumes overlaps
+    G4bool  fCheckOverlaps; // option to activate checking of volumes overlaps (in parallel: tools/GeometryOverlapChecker)
     
     /////////////////////////////
     //          WORLD
@@ -173,15 +236,11 @@ private:
     G4RotationMatrix    VDC_Al_Frame_rotm[2];
     G4Transform3D       VDC_Al_Frame_transform;
     
-    //      VDC - X WIRES
+    //      VDC - X WIRES (parameterised, in the X wire plane)
     G4VPhysicalVolume*  PhysiVDC_X_WIRE;
-    G4RotationMatrix    VDC_X_WIRE_rotm;
-    G4Transform3D       VDC_X_WIRE_transform;
     
-    //      VDC - U WIRES
+    //      VDC - U WIRES (parameterised, in the U wire plane)
     G4VPhysicalVolume*  PhysiVDC_U_WIRE;
-    G4RotationMatrix    VDC_U_WIRE_rotm;
-    G4Transform3D       VDC_U_WIRE_transform;
     
     
     
@@ -197,14 +256,11 @@ private:
     G4ThreeVector       CAKE_AA_CentrePosition[numberOf_CAKE];
     G4double            offset_CAKE_BeamAxis;
     
-    G4RotationMatrix    CAKE_AA_RS_rotm[8];
-    G4Transform3D       CAKE_AA_RS_transform[8];
-    
     G4RotationMatrix    CAKE_DL_2M_rotm;
     G4Transform3D       CAKE_DL_transform[2];
     G4Transform3D       CAKE_2M_transform[2];
     
-    //  CAKE Active Area - Rings and Sectors
+    //  CAKE Active Area - Rings and Sectors (parameterised, channel i*128 + sector + 8*ring from the touchable)
     G4VPhysicalVolume*  PhysiCAKE_AA_RS;
     
     //  CAKE Silicon Wafer - Rings and Sectors
@@ -351,6 +407,8 @@ private:
     G4RotationMatrix    LaBr3Ce_LaBr3CeCrystal_rotm;
     
     void SetupPreconfiguredVersion(int a);
+    G4double PreconfiguredDistance_ALBA_LaBr3Ce(int a) const;
+    G4RotationMatrix Rotation_ALBA_LaBr3Ce(const G4ThreeVector& direction) const;
     bool setPreconfiguredVersion;
     int LaBr3CeSetupVersion;
     G4bool LaBR3Ce_SetGlobalDistance;
@@ -365,6 +423,15 @@ private:
     std::vector<G4ThreeVector> vertex_hexagonFaces_truncatedIcosahedron;
     void SetupTruncatedIcosahedron();
     
+    ////    Assemblies found by FindLayoutVolumes(): the LaBr3Ce internal vacuum, at the radius of its
+    ////    distance plus an offset, and all volumes of CLOVER i and its shield; the distances they were built for
+    G4VPhysicalVolume*              Layout_LaBr3Ce_PV[numberOf_LaBr3Ce];
+    G4double                        Layout_LaBr3Ce_Offset[numberOf_LaBr3Ce];
+    G4double                        Layout_LaBr3Ce_MinimumDistance;
+    std::vector<G4VPhysicalVolume*> Layout_CLOVER_PV[numberOf_CLOVER];
+    G4double                        Layout_CLOVER_MinimumDistance[numberOf_CLOVER];
+    G4int                           LayoutChanges;
+    
     ///////////////////////////////////////////////////////////////
     //          CLOVER - BGO Shield   (Manufacturer: Cyberstar)
     ///////////////////////////////////////////////////////////////
@@ -384,6 +451,18 @@ private:
     //  Boolean to use Walid's definition of the CLOVER crystal
     bool useCLOVER_Walid;
     
+    //  Boolean to use the parametric (CSG) CLOVER crystals, lithium contacts and BGO crystals instead of the meshes
+    bool useCLOVER_Parametric;
+    
+    //  Geometry snapshot file (GeometrySnapshot), empty: always construct
+    G4String GeometrySnapshot_File;
+    
+    //  Canned benchmark layout (SetBenchmarkLayout), empty: as configured
+    G4String BenchmarkLayout;
+    
+    //  Production cuts of the regions of the detector families and of the passive material
+    std::map<G4String, G4double> RegionProductionCuts;
+    
     //////////////////////////////////////
     //          K600 SPECTROMETER
     //////////////////////////////////////
@@ -392,6 +471,7 @@ private:
     //          K600 - QUADRUPOLE
     G4bool              Ideal_Quadrupole;
     G4bool              Mapped_Quadrupole;
+    G4bool              Fitted_Quadrupole;
     G4bool              K600_Quadrupole;
     
     G4VPhysicalVolume*  PhysiK600_Quadrupole;
@@ -401,13 +481,15 @@ private:
     G4Transform3D       K600_Quadrupole_transform;
     
     ////    MAGNETIC FIELD for QUADRUPOLE
-    static G4ThreadLocal G4FieldManager* fieldManagerMagneticField_K600_Q;
-    static G4ThreadLocal G4QuadrupoleMagField* MagneticField_K600_Q;
+    static G4ThreadLocal K600FieldSetup* fFieldSetup_K600_Q;
     
+    G4LogicalVolume*        Logic_K600_Quadrupole;
     G4double                K600_Q_gradient;   // gradient = dB/dr
-    G4Mag_UsualEqRhs*       fEquationMagneticField_K600_Q;
-    G4MagIntegratorStepper* stepperMagneticField_K600_Q;
-    G4ChordFinder*          fChordFinder_K600_Q;
+    G4RotationMatrix*       K600_Q_MagField_rotm;
+    G4String                K600_Q_FieldMapFile;
+    G4double                K600_Q_FieldMapOffset;
+    MagneticFieldMapOptions K600_Q_FieldMapOptions;    // declared symmetries, precision
+    G4String                K600_Q_MultipoleFile;      // MultipoleFieldFitter output
     
     
     //////////////////////////////////////
@@ -420,14 +502,13 @@ private:
     G4Transform3D       K600_Dipole1_transform;
     
     ////    MAGNETIC FIELD for DIPOLE 1
-    static G4ThreadLocal G4FieldManager* fieldManagerMagneticField_K600_D1;
-    static G4ThreadLocal G4UniformMagField* MagneticField_K600_D1;
+    static G4ThreadLocal K600FieldSetup* fFieldSetup_K600_D1;
     
+    G4LogicalVolume*        Logic_K600_Dipole1;
     G4double                K600_Dipole1_BZ;
-    G4Mag_UsualEqRhs*       fEquationMagneticField_K600_D1;
+    G4String                K600_Dipole1_FieldMapFile;  // empty: uniform K600_Dipole1_BZ
     G4double                minStepMagneticField;
-    G4MagIntegratorStepper* stepperMagneticField_K600_D1;
-    G4ChordFinder*          fChordFinder_K600_D1;
+    G4double                largestAcceptableStepMagneticField;
     
     //////////////////////////////////////
     //          K600 - DIPOLE 2
@@ -439,13 +520,29 @@ private:
     G4Transform3D       K600_Dipole2_transform;
     
     ////    MAGNETIC FIELD for DIPOLE 2
-    static G4ThreadLocal G4FieldManager* fieldManagerMagneticField_K600_D2;
-    static G4ThreadLocal G4UniformMagField* MagneticField_K600_D2;
+    static G4ThreadLocal K600FieldSetup* fFieldSetup_K600_D2;
     
+    G4LogicalVolume*        Logic_K600_Dipole2;
     G4double                K600_Dipole2_BZ;
-    G4Mag_UsualEqRhs*       fEquationMagneticField_K600_D2;
-    G4MagIntegratorStepper* stepperMagneticField_K600_D2;
-    G4ChordFinder*          fChordFinder_K600_D2;
+    G4String                K600_Dipole2_FieldMapFile;  // empty: uniform K600_Dipole2_BZ
+    MagneticFieldMapOptions K600_Dipole_FieldMapOptions;
+    
+    //////////////////////////////////////
+    //          K600 - SPECTROMETER ENVELOPE
+    ////    Vacuum box holding the magnets: region of the transfer-map fast simulation
+    G4bool              K600_Spectrometer_Envelope;
+    G4VPhysicalVolume*  PhysiK600_Envelope;
+    G4LogicalVolume*    Logic_K600_Envelope;
+    G4Region*           K600_Spectrometer_Region;
+    
+    G4ThreeVector       K600_Envelope_CentrePosition;
+    G4ThreeVector       K600_Envelope_HalfLengths;
+    
+    ////    TRANSFER MAP (planes in the frame of the envelope)
+    TransferMapPlane    K600_TransferMap_EntryPlane;
+    TransferMapPlane    K600_TransferMap_ExitPlane;
+    G4String            K600_TransferMap_File;          // not empty: fast simulation through the magnets
+    G4String            K600_TransferMap_SampleFile;    // not empty: record samples for TransferMapFitter
     
     ////////////////////////////////
     ////        STRUCTURES      ////
@@ -0,0 +1,146 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef DetectorParameterisations_h
+#define DetectorParameterisations_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4RotationMatrix.hh"
+#include "G4VPVParameterisation.hh"
+#include "G4SubtractionSolid.hh"
+
+#include <vector>
+
+class G4VSolid;
+class G4Tubs;
+class G4LogicalVolume;
+class G4VPhysicalVolume;
+class G4VTouchable;
+
+////////////////////////////////////////////////////////////////////////////////
+//      Parameterised placements of the CAKE pixels and the VDC wires
+////////////////////////////////////////////////////////////////////////////////
+//
+//      The 16 x 8 ring-sector pixels of a CAKE silicon wafer, and the sense,
+//      guard and thick guard wires of a VDC wire plane, are each placed as one
+//      G4PVParameterised rather than one G4PVPlacement per pixel or wire.
+//      Replicas do not apply: every pixel has its own shape, and the wires do
+//      not fill their mother (the wire planes are thin gas envelopes inside
+//      the frame windows, as a parameterised volume must be the only daughter
+//      of its mother).
+//
+
+////    G4SubtractionSolid that can be returned by ComputeSolid(): the navigator calls
+////    ComputeDimensions() on every such solid, which boolean solids do not implement.
+////    The pixel shapes are fixed per copy, so there is nothing to compute.
+class ParameterisedSubtractionSolid : public G4SubtractionSolid
+{
+public:
+    ParameterisedSubtractionSolid(const G4String& name,
+                                  G4VSolid* solidA,
+                                  G4VSolid* solidB,
+                                  G4RotationMatrix* rotMatrix,
+                                  const G4ThreeVector& transVector);
+    ////    solidB already placed, e.g. a G4DisplacedSolid (GeometrySnapshot)
+    ParameterisedSubtractionSolid(const G4String& name,
+                                  G4VSolid* solidA,
+                                  G4VSolid* solidB);
+    
+    void    ComputeDimensions(G4VPVParameterisation* parameterisation, const G4int copyNo,
+                              const G4VPhysicalVolume* physVol);
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+////    CAKE ring-sector pixels: one solid per copy, all at the same position in the wafer
+class CAKEPixelParameterisation : public G4VPVParameterisation
+{
+public:
+    ////    solids: in copy-number order, sector + 8*ring
+    CAKEPixelParameterisation(const std::vector<G4VSolid*>& solids, const G4ThreeVector& offset);
+    virtual ~CAKEPixelParameterisation();
+    
+    G4int       GetNumberOfPixels() const   {return G4int(fSolids.size());};
+    
+    ////    Channel i*128 + sector + 8*ring of the pixel at depth 0 of the touchable, i being
+    ////    the copy number of its wafer. The copy number of a parameterised volume is only
+    ////    that of the copy the navigator evaluated last: the touchable keeps the right one.
+    static G4int    GetChannel(const G4VTouchable* touchable);
+    
+    void        ComputeTransformation(const G4int copyNo, G4VPhysicalVolume* physVol) const;
+    G4VSolid*   ComputeSolid(const G4int copyNo, G4VPhysicalVolume* physVol);
+    
+private:
+    std::vector<G4VSolid*>  fSolids;
+    G4ThreeVector           fOffset;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+////    Wires of a VDC wire plane (G4Tubs), in the z = 0 plane of the wire-plane volume.
+////    Every wire is cut to the window |x| < halfWidth, |y| < halfHeight, with its end
+////    faces inside it, in place of the booleans that trimmed the individual U wires.
+class VDCWireParameterisation : public G4VPVParameterisation
+{
+public:
+    ////    angle: of the wires from the y axis, about z (0 for the X wires, 40 degrees for the U wires)
+    VDCWireParameterisation(G4double angle, G4double halfWidth, G4double halfHeight);
+    virtual ~VDCWireParameterisation();
+    
+    ////    Adds a wire crossing the x axis at x and returns its copy number
+    G4int       AddWire(G4double x, G4double radius);
+    G4int       GetNumberOfWires() const    {return G4int(fWires.size());};
+    
+    void        ComputeTransformation(const G4int copyNo, G4VPhysicalVolume* physVol) const;
+    void        ComputeDimensions(G4Tubs& wire, const G4int copyNo, const G4VPhysicalVolume* physVol) const;
+    
+private:
+    struct Wire
+    {
+        G4ThreeVector   centre;
+        G4double        radius;
+        G4double        halfLength;
+    };
+    
+    G4RotationMatrix*   fRotation;
+    G4ThreeVector       fDirection;
+    G4double            fHalfWidth;
+    G4double            fHalfHeight;
+    std::vector<Wire>   fWires;
+};
+
+#endif
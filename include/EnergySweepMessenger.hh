@@ -0,0 +1,83 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef EnergySweepMessenger_h
+#define EnergySweepMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class EnergySweepScheduler;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithABool;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithoutParameter;
+
+/// Messenger for the energy sweep scheduler (/K600/sweep/).
+///
+/// The commands are executed on the master only; they are not broadcast
+/// to the worker threads.
+
+class EnergySweepMessenger : public G4UImessenger
+{
+public:
+    EnergySweepMessenger(EnergySweepScheduler* scheduler);
+    virtual ~EnergySweepMessenger();
+    
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+    
+private:
+    EnergySweepScheduler*       fScheduler;
+    
+    G4UIdirectory*              fSweepDirectory;
+    G4UIcmdWithAString*         fEnergiesCmd;
+    G4UIcmdWithADoubleAndUnit*  fAddEnergyCmd;
+    G4UIcommand*                fRangeCmd;
+    G4UIcmdWithoutParameter*    fClearCmd;
+    G4UIcmdWithAnInteger*       fEventsPerEnergyCmd;
+    G4UIcmdWithAnInteger*       fChunkSizeCmd;
+    G4UIcmdWithADouble*         fPrecisionCmd;
+    G4UIcmdWithADoubleAndUnit*  fFullEnergyWindowCmd;
+    G4UIcmdWithAString*         fOutputPrefixCmd;
+    G4UIcmdWithABool*           fResumeCmd;
+    G4UIcmdWithoutParameter*    fBeamOnCmd;
+};
+
+#endif
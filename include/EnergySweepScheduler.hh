@@ -0,0 +1,152 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef EnergySweepScheduler_h
+#define EnergySweepScheduler_h 1
+
+#include "globals.hh"
+#include <vector>
+#include <mutex>
+
+class EnergySweepMessenger;
+
+/// Schedules a sweep of the particle gun over a list of energies,
+/// e.g. for detector efficiency curves.
+///
+/// Every energy is simulated in its own run (one BeamOn per energy), so that
+/// each energy is written to its own output file. Within a run the events are
+/// handed out to the worker threads in chunks (work units) under a lock, and
+/// each thread accumulates its detection tallies locally, merging them when it
+/// takes its next chunk. Once an optional precision target on the full-energy
+/// efficiency is reached, no further chunks are handed out and the remaining
+/// events of that energy are skipped.
+///
+/// At the end of every energy a summary file <prefix>_E<energy>keV.sweep is
+/// written. With resume enabled, energies whose summary already exists are not
+/// simulated again, so energies can be added to a sweep later on.
+///
+/// The scheduler is configured on the master through /K600/sweep/ and started
+/// with /K600/sweep/beamOn.
+
+struct EnergySweepResult
+{
+    G4double    energy;
+    G4long      nEvents;
+    G4double    efficiency;             // any CLOVER / LaBr3Ce trigger
+    G4double    efficiencyError;
+    G4double    fullEnergyEfficiency;   // deposited energy within the full-energy window
+    G4double    fullEnergyEfficiencyError;
+    G4bool      precisionReached;
+};
+
+class EnergySweepScheduler
+{
+public:
+    static EnergySweepScheduler* Instance();
+    
+    //------------------------------------------------
+    //      Configuration (master, between runs)
+    void    ClearEnergies()                         { fEnergies.clear(); }
+    void    AddEnergy(G4double energy)              { fEnergies.push_back(energy); }
+    void    SetEventsPerEnergy(G4long n)            { fEventsPerEnergy = n; }
+    void    SetChunkSize(G4int n)                   { fChunkSize = n; }
+    void    SetPrecisionTarget(G4double relError)   { fPrecisionTarget = relError; }
+    void    SetFullEnergyWindow(G4double window)    { fFullEnergyWindow = window; }
+    void    SetOutputPrefix(const G4String& prefix) { fOutputPrefix = prefix; }
+    void    SetResume(G4bool resume)                { fResume = resume; }
+    
+    const std::vector<G4double>& GetEnergies() const { return fEnergies; }
+    
+    ////    Runs the sweep, one BeamOn per energy
+    void    RunSweep();
+    
+    //------------------------------------------------
+    //      During a sweep
+    G4bool      IsActive() const                    { return fActive; }
+    G4double    GetFullEnergyWindow() const         { return fFullEnergyWindow; }
+    ////    Output file of the current energy (without extension)
+    G4String    GetOutputFileName() const;
+    
+    ////    Worker side: reserves the next event of the current energy.
+    ////    Returns false once the energy is exhausted or its precision target is reached.
+    G4bool      NextEvent(G4double& energy);
+    ////    Worker side: tallies the event reserved by the last NextEvent()
+    void        RecordEvent(G4double weight, G4bool detected, G4bool fullEnergy);
+    ////    Worker side: merges the local tallies at the end of a run
+    void        FlushThread();
+    
+private:
+    EnergySweepScheduler();
+    ~EnergySweepScheduler();
+    
+    struct Tally
+    {
+        G4long      nEvents;
+        G4double    sumW, sumW2;                // detected events
+        G4double    sumWFull, sumW2Full;        // full-energy events
+        G4long      nFull;
+    };
+    
+    void        MergeTally(Tally& local);       // fMutex must be held
+    G4bool      PrecisionReached() const;       // fMutex must be held
+    EnergySweepResult   GetResult() const;
+    
+    G4String    GetFileStem(G4double energy) const;
+    G4bool      ReadSummary(G4double energy, EnergySweepResult& result) const;
+    void        WriteSummary(const EnergySweepResult& result) const;
+    void        WriteSweepTable(const std::vector<EnergySweepResult>& results) const;
+    
+    //------------------------------------------------
+    std::vector<G4double>   fEnergies;
+    G4long                  fEventsPerEnergy;
+    G4int                   fChunkSize;
+    G4double                fPrecisionTarget;
+    G4double                fFullEnergyWindow;
+    G4String                fOutputPrefix;
+    G4bool                  fResume;
+    
+    G4bool                  fActive;
+    G4int                   fCurrentEnergy;
+    G4int                   fRunSerial;         // distinguishes the runs of a sweep for the thread-local units
+    G4long                  fNextEvent;
+    G4bool                  fEnergyComplete;
+    Tally                   fTally;
+    
+    mutable std::mutex      fMutex;
+    EnergySweepMessenger*   fMessenger;
+};
+
+#endif
@@ -177,6 +177,10 @@ public:
     G4double initialParticlePhi;
     void SetInitialParticleTheta(G4double a) {initialParticleTheta = a;};
     void SetInitialParticlePhi(G4double a) {initialParticlePhi = a;};
+    
+    ////    Statistical weight of the event (importance-sampled or pre-generated primaries)
+    G4double eventWeight;
+    void SetEventWeight(G4double a) {eventWeight = a;};
 
     /////////////////////
     //      CAKE
@@ -288,6 +292,10 @@ public:
 
     std::vector<std::tuple<int, double, double>> angles_ALBA_LaBr3Ce;
     
+    ////    Source of the detector angles, re-read after /K600/layout/ changes
+    DetectorConstruction*   fDetectorConstruction;
+    G4int                   fLayoutChanges;
+    
     /////////////////////////////////////////
     //          PADDLE DETECTORS
     G4double GainPADDLE;
@@ -2,6 +2,7 @@
 #include "G4ThreeVector.hh"
 
 #include "BiRelKin.hh"
+#include "BinaryReactionKinematics.hh"
 #include "DCS_PDR_1minus.h"
 #include "DCS_PDR_2plus.h"
 
@@ -350,7 +351,16 @@ void Sample_AngularDistribution_GammaDecay_LAB(double A0, double A1, double A2,
     
     //----------------------------------------------------------
     //      Calculating the relativistic binary kinematics
-    BiRelKin(m, T, E, p, theta_ejectile, theta_recoil, excitationEnergy);
+    //      The reaction invariants are only recomputed when the reaction changes
+    static G4ThreadLocal BinaryReactionKinematics* reactionKinematics = 0;
+    
+    if(!reactionKinematics || !reactionKinematics->Matches(m, T[0], T[1], excitationEnergy))
+    {
+        delete reactionKinematics;
+        reactionKinematics = new BinaryReactionKinematics(m, T[0], T[1], excitationEnergy);
+    }
+    
+    reactionKinematics->Evaluate(theta_ejectile, T, E, p, theta_recoil);
     
     //------------------------------------------------
     //      Choosing the gamma-ray decay angles
@@ -0,0 +1,115 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef GeometrySnapshot_h
+#define GeometrySnapshot_h 1
+
+#include "globals.hh"
+
+#include <cstdint>
+#include <vector>
+
+class G4VPhysicalVolume;
+
+////////////////////////////////////////////////////////////////////////////////
+//      Binary snapshot of the constructed geometry
+////////////////////////////////////////////////////////////////////////////////
+//
+//      Written after a full construction and read back by later runs in place
+//      of it, so that the meshes, booleans and thousands of placements of
+//      DetectorConstruction::DefineVolumes() are not built again:
+//
+//      [GeometrySnapshotHeader]                (64 bytes)
+//      [source files]                          path, size and modification time
+//      [isotopes, elements, materials]         definitions, NIST ones by name
+//      [solids]                                constituents first
+//      [logical volumes]                       solid, material, vis attributes
+//      [physical volumes]                      mothers first, in daughter order
+//      [regions]                               root logical volumes, production cuts
+//
+//      Lengths are in mm and all values in Geant4 internal units. A snapshot is
+//      used only if it has the same configuration hash (ConfigurationHash() of
+//      whatever determines the geometry) and Geant4 version, its payload the
+//      same FNV-1a hash and each of its source files (the meshes read, and the
+//      levels of detail and convex decompositions looked for) the same size and
+//      modification time, or still does not exist; otherwise Read() returns 0
+//      and the geometry is constructed as before.
+//
+//      Supported: the solids used by DetectorConstruction (G4Box, G4Tubs, G4Cons,
+//      G4Torus, G4Trap, G4GenericTrap, G4Polycone, G4TessellatedSolid,
+//      G4MultiUnion, G4DisplacedSolid and the booleans) and G4PVPlacement and
+//      G4PVParameterised volumes. A parameterised volume is written copy by copy
+//      (solid, material and transformation after ComputeDimensions()) and read
+//      back as a tabulated parameterisation with the same copy numbers.
+//      Write() refuses anything else (replicas, divisions, user limits, optical
+//      properties), with a warning, and writes no snapshot.
+//
+
+struct GeometrySnapshotHeader
+{
+    char            magic[8];               // "K600GEO"
+    std::uint32_t   version;
+    std::uint32_t   headerSize;
+    std::uint64_t   configurationHash;
+    std::int64_t    geant4Version;
+    std::uint64_t   payloadSize;            // bytes after the header
+    std::uint64_t   payloadHash;            // FNV-1a of the payload
+    std::uint8_t    reserved[16];
+};
+
+static_assert(sizeof(GeometrySnapshotHeader) == 64, "GeometrySnapshotHeader must be 64 bytes");
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class GeometrySnapshot
+{
+public:
+    static const std::uint32_t  kVersion = 2;
+    
+    ////    64-bit FNV-1a of a description of the configuration (DetectorConstruction::ConfigurationDescription())
+    static std::uint64_t        ConfigurationHash(const G4String& configuration);
+    
+    ////    Writes the geometry tree of world and the state of the files it was built from;
+    ////    false (and no file) if it holds anything unsupported
+    static G4bool               Write(const G4String& fileName, const G4VPhysicalVolume* world, std::uint64_t configurationHash,
+                                      const std::vector<G4String>& sourceFiles);
+    
+    ////    The world of the snapshot, with its logical volumes, regions and materials registered
+    ////    in the Geant4 stores; 0 if there is no valid snapshot for configurationHash
+    static G4VPhysicalVolume*   Read(const G4String& fileName, std::uint64_t configurationHash);
+};
+
+#endif
@@ -0,0 +1,96 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef K600FieldMessenger_h
+#define K600FieldMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class K600FieldSetup;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithoutParameter;
+
+/// Messenger for the field transport of the K600 magnets (/K600/field/).
+///
+/// Each magnet registered with AddMagnet() gets its own directory,
+/// /K600/field/<magnet>/, with the stepper, driver and accuracy commands of
+/// its K600FieldSetup. Like the field setups, one instance exists per thread
+/// (created in DetectorConstruction::ConstructSDandField()) and the commands
+/// are broadcast to every worker, so they take effect from the next run.
+
+class K600FieldMessenger : public G4UImessenger
+{
+public:
+    K600FieldMessenger();
+    virtual ~K600FieldMessenger();
+    
+    ////    Re-registering a magnet only replaces its field setup
+    void    AddMagnet(const G4String& name, K600FieldSetup* fieldSetup);
+    
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+    
+private:
+    struct MagnetCommands
+    {
+        G4String                    name;
+        K600FieldSetup*             fieldSetup;
+        
+        G4UIdirectory*              directory;
+        G4UIcmdWithAString*         stepperCmd;
+        G4UIcmdWithAString*         driverCmd;
+        G4UIcmdWithADoubleAndUnit*  minStepCmd;
+        G4UIcmdWithADoubleAndUnit*  deltaChordCmd;
+        G4UIcmdWithADoubleAndUnit*  deltaOneStepCmd;
+        G4UIcmdWithADoubleAndUnit*  deltaIntersectionCmd;
+        G4UIcmdWithADouble*         epsilonMinCmd;
+        G4UIcmdWithADouble*         epsilonMaxCmd;
+        G4UIcmdWithoutParameter*    printCmd;
+    };
+    
+    G4UIdirectory*              fFieldDirectory;
+    G4UIcmdWithADoubleAndUnit*  fLargestAcceptableStepCmd;
+    G4UIcmdWithoutParameter*    fPrintCmd;
+    
+    std::vector<MagnetCommands> fMagnets;
+};
+
+#endif
@@ -0,0 +1,123 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef K600FieldSetup_h
+#define K600FieldSetup_h 1
+
+#include "globals.hh"
+
+class G4MagneticField;
+class G4Mag_UsualEqRhs;
+class G4MagIntegratorStepper;
+class G4ChordFinder;
+class G4FieldManager;
+
+/// Per-thread field transport of one K600 magnet.
+///
+/// Holds the lightweight, stateful objects Geant4 needs to track through a
+/// magnetic field: equation of motion, stepper, chord finder and field
+/// manager. One instance is created per magnet on every thread in
+/// DetectorConstruction::ConstructSDandField(). The field object itself is
+/// cheap, and any tabulated data behind it (MagneticFieldMapData) is shared
+/// read-only between the threads.
+///
+/// The stepper, integration driver and accuracy parameters can be changed
+/// between runs (see K600FieldMessenger, /K600/field/<magnet>/).
+///
+///     Steppers:   ClassicalRK4 (default), CashKarpRKF45, BogackiShampine23,
+///                 BogackiShampine45, DormandPrince745, ExactHelix
+///     Drivers:    standard (G4MagInt_Driver, default), interpolating
+///                 (G4InterpolationDriver, DormandPrince745 only, Geant4 >= 10.7)
+///
+/// ExactHelix is exact only in a uniform field, i.e. for the dipoles
+/// without field maps.
+
+class K600FieldSetup
+{
+public:
+    ////    Takes ownership of field
+    K600FieldSetup(G4MagneticField* field, G4double minStep);
+    ~K600FieldSetup();
+    
+    G4MagneticField*    GetField() const            { return fField; }
+    G4FieldManager*     GetFieldManager() const     { return fFieldManager; }
+    
+    //------------------------------------------------
+    //      Integration
+    ////    Return false (and keep the present setting) for an unknown or unusable choice
+    G4bool      SetIntegrator(const G4String& stepperName, const G4String& driverName);
+    G4bool      SetStepper(const G4String& stepperName);
+    G4bool      SetDriver(const G4String& driverName);
+    void        SetMinStep(G4double minStep);
+    
+    const G4String& GetStepperName() const      { return fStepperName; }
+    const G4String& GetDriverName() const       { return fDriverName; }
+    G4double        GetMinStep() const          { return fMinStep; }
+    
+    //------------------------------------------------
+    //      Accuracy
+    void        SetDeltaChord(G4double deltaChord);
+    void        SetDeltaOneStep(G4double deltaOneStep);
+    void        SetDeltaIntersection(G4double deltaIntersection);
+    void        SetEpsilonMin(G4double epsilonMin);
+    void        SetEpsilonMax(G4double epsilonMax);
+    
+    G4double    GetDeltaChord() const;
+    G4double    GetDeltaOneStep() const;
+    G4double    GetDeltaIntersection() const;
+    G4double    GetEpsilonMin() const;
+    G4double    GetEpsilonMax() const;
+    
+    void        Print(const G4String& name) const;
+    
+private:
+    K600FieldSetup(const K600FieldSetup&);
+    K600FieldSetup& operator=(const K600FieldSetup&);
+    
+    G4MagIntegratorStepper* CreateStepper(const G4String& stepperName) const;
+    
+    G4MagneticField*        fField;
+    G4Mag_UsualEqRhs*       fEquation;
+    G4MagIntegratorStepper* fStepper;
+    G4ChordFinder*          fChordFinder;   // owns the driver
+    G4FieldManager*         fFieldManager;
+    
+    G4String                fStepperName;
+    G4String                fDriverName;
+    G4double                fMinStep;
+};
+
+#endif
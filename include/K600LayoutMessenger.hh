@@ -0,0 +1,84 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef K600LayoutMessenger_h
+#define K600LayoutMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class DetectorConstruction;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithoutParameter;
+
+/// Messenger for layout changes of the detector arrays between runs
+/// (/K600/layout/).
+///
+/// The CLOVER (with their shields) and LaBr3Ce assemblies built by
+/// DetectorConstruction are moved along their axes, moved to other faces of
+/// the truncated icosahedron, removed or put back; only the voxels of their
+/// mother volume are rebuilt, so that meshes, physics tables and the rest of
+/// the geometry are kept. Detectors absent from the built geometry cannot be
+/// added. The commands are executed on the master only, between runs.
+
+class K600LayoutMessenger : public G4UImessenger
+{
+public:
+    K600LayoutMessenger(DetectorConstruction* detectorConstruction);
+    virtual ~K600LayoutMessenger();
+    
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+    
+private:
+    DetectorConstruction*       fDetectorConstruction;
+    
+    G4UIdirectory*              fLayoutDirectory;
+    G4UIdirectory*              fCLOVERDirectory;
+    G4UIdirectory*              fLaBr3CeDirectory;
+    G4UIcommand*                fCLOVERDistanceCmd;
+    G4UIcommand*                fCLOVERPresenceCmd;
+    G4UIcmdWithADoubleAndUnit*  fLaBr3CeDistanceCmd;
+    G4UIcmdWithAnInteger*       fLaBr3CePreconfiguredVersionCmd;
+    G4UIcmdWithAString*         fLaBr3CeFacesCmd;
+    G4UIcommand*                fLaBr3CePresenceCmd;
+    G4UIcmdWithoutParameter*    fPrintCmd;
+};
+
+#endif
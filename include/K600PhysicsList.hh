@@ -0,0 +1,95 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef K600PhysicsList_h
+#define K600PhysicsList_h 1
+
+#include "G4VModularPhysicsList.hh"
+#include "G4Timer.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4VPhysicsConstructor;
+class G4StepLimiterPhysics;
+class G4FastSimulationPhysics;
+class K600PhysicsListMessenger;
+
+/// Modular physics list with a configuration chosen before initialisation,
+/// with the -p option of the executable or /K600/physics/list:
+///
+///  - "full":            QGSP_BERT with radioactive decay (default)
+///  - "em_decay":        electromagnetic option 4, decay and radioactive decay
+///  - "emstandard_opt4": electromagnetic option 4 only
+///  - "emlivermore":     Livermore electromagnetic physics only
+///
+/// The electromagnetic-only configurations avoid the hadronic tables for
+/// gamma-ray efficiency and silicon runs. All configurations keep
+/// G4StepLimiterPhysics (limits of /K600/regions/) and the fast simulation
+/// of the ejectiles through the K600 magnets. All particles are defined
+/// whatever the configuration.
+
+class K600PhysicsList : public G4VModularPhysicsList
+{
+public:
+    K600PhysicsList(const G4String& configuration = "full");
+    virtual ~K600PhysicsList();
+    
+    virtual void ConstructParticle();
+    virtual void ConstructProcess();
+    
+    ////    PreInit only; an unknown configuration leaves the current one
+    G4bool          SelectConfiguration(const G4String& configuration);
+    const G4String& GetConfiguration() const {return fConfiguration;};
+    
+    ////    Wall time [s] of the initialisation: from the construction of the processes (/run/initialize)
+    ////    to StopInitialisationTimer(), called at the beginning of the first run once the physics
+    ////    tables are built. Negative until then.
+    void            StopInitialisationTimer();
+    G4double        GetInitialisationTime() const {return fInitialisationTime;};
+    
+private:
+    G4String                            fConfiguration;
+    std::vector<G4VPhysicsConstructor*> fConfigurationPhysics;  // removed when the configuration changes
+    G4StepLimiterPhysics*               fStepLimiterPhysics;    // registered after those of the configuration
+    G4FastSimulationPhysics*            fFastSimulationPhysics;
+    K600PhysicsListMessenger*           fMessenger;
+    G4Timer                             fInitialisationTimer;  // master thread only
+    G4bool                              fInitialisationTimerStarted;
+    G4double                            fInitialisationTime;
+};
+
+#endif
@@ -0,0 +1,105 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef K600RegionMessenger_h
+#define K600RegionMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4Region;
+class G4UIdirectory;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithoutParameter;
+
+/// Messenger for the production cuts and user limits of the regions of the
+/// K600 geometry (/K600/regions/).
+///
+/// Each region registered with AddRegion() gets its own directory,
+/// /K600/regions/<region>/, with commands for its production cuts and for
+/// the step, track length, time and kinetic energy limits of its
+/// G4UserLimits (applied by G4StepLimiterPhysics). The regions are looked up
+/// by name, so that they may come from a geometry snapshot. Regions and their
+/// cuts and limits are shared by all threads: the commands are executed on
+/// the master only and take effect from the next run.
+
+class K600RegionMessenger : public G4UImessenger
+{
+public:
+    K600RegionMessenger();
+    virtual ~K600RegionMessenger();
+    
+    ////    Re-registering a region does nothing
+    void    AddRegion(const G4String& name);
+    
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+    
+    void    Print(const G4String& name) const;
+    
+private:
+    struct RegionCommands
+    {
+        G4String                    name;
+        
+        G4UIdirectory*              directory;
+        G4UIcmdWithADoubleAndUnit*  cutCmd;
+        G4UIcmdWithADoubleAndUnit*  gammaCutCmd;
+        G4UIcmdWithADoubleAndUnit*  electronCutCmd;
+        G4UIcmdWithADoubleAndUnit*  positronCutCmd;
+        G4UIcmdWithADoubleAndUnit*  protonCutCmd;
+        G4UIcmdWithADoubleAndUnit*  maxStepCmd;
+        G4UIcmdWithADoubleAndUnit*  maxTrackLengthCmd;
+        G4UIcmdWithADoubleAndUnit*  maxTimeCmd;
+        G4UIcmdWithADoubleAndUnit*  minKineticEnergyCmd;
+        G4UIcmdWithADoubleAndUnit*  minRangeCmd;
+        G4UIcmdWithoutParameter*    clearLimitsCmd;
+        G4UIcmdWithoutParameter*    printCmd;
+    };
+    
+    ////    The cuts of the region, made its own if it shares those of the default region
+    void    SetProductionCut(const G4String& name, G4double cut, const G4String& particle);
+    
+    G4UIcmdWithADoubleAndUnit*  MakeCommand(const G4String& path, const char* guidance, const char* unitCategory);
+    
+    G4UIdirectory*              fRegionsDirectory;
+    G4UIcmdWithoutParameter*    fPrintCmd;
+    
+    std::vector<RegionCommands> fRegions;
+};
+
+#endif
@@ -0,0 +1,248 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef MagneticFieldMapData_h
+#define MagneticFieldMapData_h 1
+
+#include "globals.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//      Declared symmetries and storage precision
+////////////////////////////////////////////////////////////////////////////////
+//
+//      A mirror plane a = 0 (a = x, y or z, in the coordinates of the table)
+//      relates the field on both of its sides by
+//
+//          B_k(.., -a, ..) = parity[a][k] * B_k(.., a, ..)
+//
+//      Only the a >= 0 half is then stored, plus the first grid plane below
+//      a = 0 when the grid points straddle the mirror plane, so that the cell
+//      across the plane can still be interpolated. Lookups at a < 0 are folded
+//      back with the signs of the parities. A table covering both sides is
+//      folded on loading, averaging every point with its mirror image.
+//
+//      Single precision halves the cells again; the field is still
+//      interpolated in double precision.
+//
+//      Large maps (e.g. of the full dipoles) can be stored in cubic tiles of
+//      tileSize^3 cells, see MagneticFieldMapCacheHeader.
+//
+
+struct MagneticFieldMapOptions
+{
+    G4bool  mirror[3];          // mirror planes x = 0, y = 0, z = 0
+    G4int   parity[3][3];       // [mirror plane][field component], +1 or -1
+    G4bool  singlePrecision;    // float32 cells
+    G4int   tileSize;           // cells per tile edge (a power of two), 0: one contiguous block
+
+    MagneticFieldMapOptions();
+
+    ////    axis: 0, 1, 2 for the planes x = 0, y = 0, z = 0
+    void    SetMirror(int axis, int parityBx, int parityBy, int parityBz);
+
+    ////    Ideal quadrupole, B ~ (y, x, 0) and Bz ~ xy in the fringe field:
+    ////    x = 0: (+,-,-),  y = 0: (-,+,-)
+    static MagneticFieldMapOptions Quadrupole();
+    ////    Dipole with its field along y: midplane y = 0: (-,+,-)
+    static MagneticFieldMapOptions DipoleMidplane();
+
+    G4bool  IsFolded() const    { return mirror[0] || mirror[1] || mirror[2]; }
+
+    ////    Distinguishes the caches of different options, e.g. ".x+--y-+-.f32.t8"
+    G4String    GetCacheSuffix() const;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+////////////////////////////////////////////////////////////////////////////////
+//      Binary field-map cache
+////////////////////////////////////////////////////////////////////////////////
+//
+//      Generated from a text .TABLE map (on first use, or with the
+//      FieldMapConverter tool) and read back through a read-only memory mapping:
+//
+//      [MagneticFieldMapCacheHeader]                       (128 bytes)
+//      [cells: nx*ny*nz x (Bx, By, Bz, pad) values]        x-major, then y, then z
+//
+//      or, for tileShift > 0, tiles of T = 2^tileShift cells per edge:
+//
+//      [MagneticFieldMapCacheHeader]                       (128 bytes)
+//      [tile][tile]...                                     in Morton (Z-) order of the tile indices
+//      tile: (T+1)^3 x (Bx, By, Bz, pad) values            x-major, then y, then z
+//
+//      Each tile repeats the first point plane of its upper neighbours, so the
+//      8 corners of any interpolation lie in one tile, and tiles that are close
+//      in space are close in the file. The OS then only pages in the tiles the
+//      tracks actually pass through.
+//
+//      Native byte order, Geant4 internal units (mm, field in internal units),
+//      values of valueSize bytes (8: double, 4: float). The grid is the stored,
+//      i.e. already folded, one. The size and modification time of the source
+//      table are recorded, so a stale or foreign cache is simply regenerated.
+//
+
+struct MagneticFieldMapCacheHeader
+{
+    char            magic[8];               // "K600FLD"
+    std::uint32_t   version;
+    std::uint32_t   headerSize;
+    std::int32_t    nx, ny, nz;
+    std::uint32_t   cellSize;               // values per cell
+    double          minx, maxx, miny, maxy, minz, maxz;
+    std::uint8_t    invertX, invertY, invertZ;
+    std::uint8_t    valueSize;              // bytes per value
+    std::uint8_t    mirror[3];
+    std::uint8_t    tileShift;              // log2 of the tile edge, 0: not tiled
+    std::uint64_t   sourceSize;             // bytes of the source table
+    std::int64_t    sourceModificationTime; // seconds since the epoch
+    std::int8_t     parity[3][3];
+    std::uint8_t    reserved[15];
+};
+
+static_assert(sizeof(MagneticFieldMapCacheHeader) == 128, "MagneticFieldMapCacheHeader must be 128 bytes");
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Immutable, tabulated magnetic field map.
+///
+/// A map is loaded once per process and shared by the field objects of every
+/// worker thread (see Load()). The cells are either memory-mapped from the
+/// binary cache or, when the cache cannot be written, held in memory.
+
+class MagneticFieldMapData
+{
+public:
+    static const std::uint32_t  kVersion = 3;
+    static const int            kCellSize = 4;      // Bx, By, Bz, pad
+    static const int            kUntiled = 30;      // tile shift of a single contiguous block
+
+    ~MagneticFieldMapData();
+
+    ////    Returns the shared map of a text table, loading it on first use.
+    ////    The binary cache GetCacheFileName() is used when valid, and (re)generated otherwise.
+    static std::shared_ptr<const MagneticFieldMapData> Load(const G4String& filename,
+                                                            const MagneticFieldMapOptions& options = MagneticFieldMapOptions());
+
+    ////    Converts a text table into a binary cache file
+    static G4bool   WriteCache(const G4String& tableFile, const G4String& cacheFile,
+                               const MagneticFieldMapOptions& options = MagneticFieldMapOptions());
+    static G4String GetCacheFileName(const G4String& tableFile, const MagneticFieldMapOptions& options = MagneticFieldMapOptions())
+    { return tableFile + options.GetCacheSuffix() + ".bin"; }
+
+    //------------------------------------------------
+    int         GetNx() const                   { return fNx; }
+    int         GetNy() const                   { return fNy; }
+    int         GetNz() const                   { return fNz; }
+    double      GetMinX() const                 { return fMinX; }
+    double      GetMaxX() const                 { return fMaxX; }
+    double      GetMinY() const                 { return fMinY; }
+    double      GetMaxY() const                 { return fMaxY; }
+    double      GetMinZ() const                 { return fMinZ; }
+    double      GetMaxZ() const                 { return fMaxZ; }
+    bool        GetInvertX() const              { return fInvertX; }
+    bool        GetInvertY() const              { return fInvertY; }
+    bool        GetInvertZ() const              { return fInvertZ; }
+    G4bool      IsMapped() const                { return fMapping!=0; }
+
+    ////    Folded axes (see MagneticFieldMapOptions)
+    bool        GetMirror(int axis) const                   { return fMirror[axis]; }
+    int         GetParity(int axis, int component) const    { return fParity[axis][component]; }
+
+    ////    32-byte aligned cells of either precision, and the strides (in values)
+    ////    between neighbouring cells along x, y and z within a tile (zero along an
+    ////    axis with a single point)
+    bool            IsSinglePrecision() const   { return fSinglePrecision; }
+    const double*   GetCells() const            { return fSinglePrecision ? 0 : static_cast<const double*>(fCells); }
+    const float*    GetSinglePrecisionCells() const { return fSinglePrecision ? static_cast<const float*>(fCells) : 0; }
+    std::size_t     GetMemorySize() const;
+    long        GetStrideX() const              { return fStrideX; }
+    long        GetStrideY() const              { return fStrideY; }
+    long        GetStrideZ() const              { return fStrideZ; }
+
+    ////    Tiles: the cell with lower corner (ix, iy, iz) lies in tile (ix, iy, iz) >> GetTileShift(),
+    ////    whose first value is at GetTileOffsets()[(tx*nTilesY + ty)*nTilesZ + tz].
+    ////    An untiled map is a single tile (shift kUntiled).
+    G4bool      IsTiled() const                 { return fTileShift!=kUntiled; }
+    int         GetTileShift() const            { return fTileShift; }
+    int         GetNumberOfTiles(int axis) const    { return fNTiles[axis]; }
+    const long* GetTileOffsets() const          { return &fTileOffsets[0]; }
+
+    ////    Tabulated field of one stored grid point
+    void        GetCellField(int ix, int iy, int iz, double* B) const;
+
+private:
+    MagneticFieldMapData();
+    MagneticFieldMapData(const MagneticFieldMapData&);
+    MagneticFieldMapData& operator=(const MagneticFieldMapData&);
+
+    G4bool  ReadTable(const G4String& filename);
+    ////    Reduces the (double precision) in-memory cells to the stored half along every mirror plane
+    void    Fold(const MagneticFieldMapOptions& options);
+    void    ConvertToSinglePrecision();
+    ////    Rearranges the contiguous cells into Morton-ordered tiles
+    void    Tile(int tileShift);
+    G4bool  MapCache(const G4String& cacheFile, std::uint64_t sourceSize, std::int64_t sourceModificationTime);
+    G4bool  SaveCache(const G4String& cacheFile, std::uint64_t sourceSize, std::int64_t sourceModificationTime) const;
+    void*   AllocateCells(std::size_t nBytes);
+    ////    Tile geometry and offsets for the current grid and fTileShift
+    void    SetStrides();
+    long    GetPointOffset(int ix, int iy, int iz) const;
+
+    //------------------------------------------------
+    std::vector<char>       fStorage;           // in-memory cells (unaligned block)
+    void*                   fMapping;           // or the mapped cache
+    std::size_t             fMappingSize;
+    const void*             fCells;
+    bool                    fSinglePrecision;
+
+    int                     fNx, fNy, fNz;
+    long                    fStrideX, fStrideY, fStrideZ;
+    int                     fTileShift;
+    int                     fNTiles[3];
+    long                    fTileValues;        // values per tile
+    std::vector<long>       fTileOffsets;
+    double                  fMinX, fMaxX, fMinY, fMaxY, fMinZ, fMaxZ;
+    bool                    fInvertX, fInvertY, fInvertZ;
+    bool                    fMirror[3];
+    int                     fParity[3][3];
+};
+
+#endif
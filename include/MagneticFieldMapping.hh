@@ -36,38 +36,108 @@
 //      Adapted from the Purging Magnet GEANT4 example (developed by S.Larsson)
 //
 
+#ifndef MagneticFieldMapping_h
+#define MagneticFieldMapping_h 1
+
 #include "globals.hh"
 #include "G4MagneticField.hh"
 #include "G4ios.hh"
+#include "MagneticFieldMapData.hh"
 
 #include <fstream>
+#include <memory>
 #include <vector>
 #include <cmath>
 
 using namespace std;
 
+//      The tabulated field itself (MagneticFieldMapData) is immutable and
+//      shared: every MagneticFieldMapping of the same table, on any thread,
+//      refers to the same cells, loaded once from the binary cache.
+//
+//      The cells are interleaved (Bx, By, Bz, pad) and 32-byte aligned, so
+//      that the 8 corners of a trilinear interpolation are 8 aligned 4-value
+//      loads. With AVX the blend is done on whole cells at once.
+//
+//      Maps folded along mirror planes (MagneticFieldMapOptions) are unfolded
+//      here: a point on the negative side of a plane is reflected onto the
+//      stored half and the field components pick up the parities of the plane.
+//      The planes pass through the origin of the table, i.e. before fZoffset.
+//
+//      Tiled maps only add a shift and a lookup in the small tile-offset table:
+//      all 8 corners of a cell are in the same tile.
+//
+//      The RK stages of one step nearly always fall in the same cell, so the
+//      last cell is cached: its corners are turned once into the coefficients
+//      of the trilinear polynomial
+//
+//          B(u,v,w) = a0 + a_x u + a_y v + a_z w + a_xy uv + a_xz uw + a_yz vw + a_xyz uvw
+//
+//      (u, v, w the position within the cell), and a query in the same cell is
+//      7 multiply-adds per component. The cache is per instance and mutable:
+//      as for the magnets in DetectorConstruction, every thread must have its
+//      own MagneticFieldMapping (they share the table).
+
 class MagneticFieldMapping
 #ifndef STANDALONE
  : public G4MagneticField
 #endif
 {
   
-  // Storage space for the table
-  vector< vector< vector< double > > > xField;
-  vector< vector< vector< double > > > yField;
-  vector< vector< vector< double > > > zField;
+  // The shared table
+  std::shared_ptr<const MagneticFieldMapData> fMap;
+  // Local copies of the grid description used by GetFieldValue
+  const double* fCells;
+  const float* fSinglePrecisionCells;
+  long strideX, strideY, strideZ;
+  // Tiles of 2^tileShift cells per edge (one tile if not tiled)
+  int tileShift;
+  int nTilesY, nTilesZ;
+  const long* tileOffsets;
   // The dimensions of the table
   int nx,ny,nz; 
   // The physical limits of the defined region
   double minx, maxx, miny, maxy, minz, maxz;
-  // The physical extent of the defined region
-  double dx, dy, dz;
+  // Grid points per unit length, (n-1)/extent
+  double invSpacingX, invSpacingY, invSpacingZ;
   double fZoffset;
   bool invertX, invertY, invertZ;
+  // Mirror planes x, y, z = 0 and the signs of (Bx, By, Bz) across them
+  bool mirrorX, mirrorY, mirrorZ;
+  double parityX[3], parityY[3], parityZ[3];
+
+  // The last cell: the lower corner in grid units and the coefficients
+  // a0, a_x, a_y, a_z, a_xy, a_xz, a_yz, a_xyz of each (Bx, By, Bz, pad)
+  struct CellCache {
+    double coefficients[8][MagneticFieldMapData::kCellSize];
+    double x0, y0, z0;
+  };
+  mutable CellCache fCache;
+
+  void  SetupGrid();
+  // Reflection onto the stored half and position in grid units; false outside the map
+  bool  ToGrid(const double point[4], double& xt, double& yt, double& zt,
+               double sign[3], double derivativeSign[3]) const;
+  // Position (u, v, w) within the cached cell, after loading the cell of (xt, yt, zt) if needed
+  void  LocateCell(double xt, double yt, double zt, double& u, double& v, double& w) const;
 
 public:
-  MagneticFieldMapping(const char* filename, double zOffset );
+  MagneticFieldMapping(const char* filename, double zOffset,
+                       const MagneticFieldMapOptions& options = MagneticFieldMapOptions() );
+  MagneticFieldMapping(std::shared_ptr<const MagneticFieldMapData> map, double zOffset );
   void  GetFieldValue( const  double Point[4],
 		       double *Bfield          ) const;
+  // The field and its gradient, gradient[3*i+j] = dB_i/dx_j (zero outside the map).
+  // The gradient is that of the trilinear interpolation, constant along the
+  // axis it differentiates within a cell.
+  void  GetFieldValueAndGradient( const double Point[4],
+                                  double *Bfield, double *gradient ) const;
+
+  const MagneticFieldMapData* GetMap() const { return fMap.get(); }
+
+  int   GetNx() const { return nx; }
+  int   GetNy() const { return ny; }
+  int   GetNz() const { return nz; }
 };
 
+#endif
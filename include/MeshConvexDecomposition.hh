@@ -0,0 +1,95 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef MeshConvexDecomposition_h
+#define MeshConvexDecomposition_h 1
+
+#include "MeshDecimation.hh"
+
+////////////////////////////////////////////////////////////////////////////////
+//      Approximate convex decomposition of a closed mesh
+////////////////////////////////////////////////////////////////////////////////
+//
+//      The surface of the mesh is cut recursively by axis-aligned planes, the
+//      worst piece first, until every point of a piece lies less than the
+//      tolerance below the convex hull of that piece, or the number of pieces
+//      reaches its limit. The depth is sampled at the vertices, at the facet
+//      centroids and at random points of the surface. Every cut is chosen
+//      among seven positions along each axis as the one with the smallest
+//      summed volume of the two new hulls (from a sample of the points), with
+//      a small penalty on unbalanced cuts.
+//
+//      A piece is the clipped, open surface within its axis-aligned cell; its
+//      hull is built by quickhull from that surface and from the corners of
+//      the cell inside the mesh. Points on the cell faces are kept exactly, so
+//      that neighbouring hulls meet without gaps, and other points within the
+//      tolerance of the hull are dropped, which keeps the hulls small. The
+//      union of the hulls therefore differs from the mesh in the concave
+//      corners left within the pieces; ClassificationMismatch() measures this
+//      on random probes.
+//
+//      Suited to compact solids (a few percent of the facets at 1 mm); thin
+//      curved shells need very many pieces and are better served by tuning
+//      the voxels of the tessellated solid. Written by the MeshConvexDecomposer
+//      tool next to the mesh (as GetDecompositionFileName(), all hulls in one
+//      PLY file) and used in place of the tessellated solid, as a
+//      G4MultiUnion, with CachedCADMesh::SetConvexDecomposition().
+//
+
+class MeshConvexDecomposition
+{
+public:
+    ////    Convex pieces of mesh, closed and with outward facets. Stops at maxPieces.
+    static std::vector<TriangleMesh>    Decompose(const TriangleMesh& mesh, G4double tolerance, std::size_t maxPieces = 256);
+
+    ////    Convex hull of the points (x, y, z, x, y, z, ...); points within tolerance of the hull are dropped.
+    ////    Empty if the points are (nearly) coplanar.
+    static TriangleMesh     ConvexHull(const std::vector<double>& points, G4double tolerance);
+
+    ////    Volume classified differently by the mesh and by the union of the pieces, relative to the volume of the mesh,
+    ////    from nProbes random points of the bounding box of the mesh
+    static G4double         ClassificationMismatch(const TriangleMesh& mesh, const std::vector<TriangleMesh>& pieces,
+                                                   std::size_t nProbes = 1000000);
+
+    ////    All pieces in one PLY file; read back as its connected parts
+    static G4bool           WritePLY(const G4String& filename, const std::vector<TriangleMesh>& pieces);
+    static G4bool           ReadPLY(const G4String& filename, std::vector<TriangleMesh>& pieces);
+
+    ////    e.g. "Body.ply" -> "Body.convex.ply"
+    static G4String         GetDecompositionFileName(const G4String& meshPath);
+};
+
+#endif
@@ -0,0 +1,109 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef MeshDecimation_h
+#define MeshDecimation_h 1
+
+#include "globals.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//      Indexed triangle mesh (as stored in the PLY files of Mesh-Models)
+////////////////////////////////////////////////////////////////////////////////
+
+struct TriangleMesh
+{
+    std::vector<double>         vertices;   // x, y, z in the units of the file (mm)
+    std::vector<std::uint32_t>  triangles;  // i0, i1, i2, counter-clockwise seen from outside
+
+    std::size_t GetNumberOfVertices() const     { return vertices.size()/3; }
+    std::size_t GetNumberOfTriangles() const    { return triangles.size()/3; }
+
+    ////    ascii or binary PLY; polygons are split into triangles
+    G4bool  ReadPLY(const G4String& filename);
+    ////    binary PLY in the layout of the exported meshes (float vertices, int indices)
+    G4bool  WritePLY(const G4String& filename) const;
+
+    ////    Merges vertices with identical coordinates (CAD exports often repeat them per facet)
+    void    WeldVertices();
+    ////    Enclosed volume (mm3), positive for outward facets
+    G4double    GetVolume() const;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+////////////////////////////////////////////////////////////////////////////////
+//      Level-of-detail meshes
+////////////////////////////////////////////////////////////////////////////////
+//
+//      Edge-collapse simplification with quadric error metrics (Garland and
+//      Heckbert). Every vertex carries the sum Q of the squared-distance
+//      quadrics of the (unweighted) planes of the original facets it has
+//      absorbed, and an edge is collapsed to the point minimising Q. Since
+//      Q(p) is a sum of squared distances, sqrt(Q(p)) bounds the distance of
+//      p to every one of those planes: collapses are only made while this
+//      stays below the tolerance. Collapses that would fold a facet over
+//      (normal turned by more than 60 degrees), make the surface
+//      non-manifold or move an open boundary are rejected, so a closed solid
+//      stays closed.
+//
+//      The result is checked with HausdorffDistance(), the symmetric distance
+//      between the two surfaces sampled at their vertices and at random
+//      points of their facets.
+//
+//      Decimated meshes are written by the MeshDecimator tool next to the full
+//      mesh, as GetLevelOfDetailFileName(), and selected per mesh with
+//      CachedCADMesh::SetLevelOfDetail().
+//
+
+class MeshDecimation
+{
+public:
+    ////    Simplified copy of mesh, deviating by at most tolerance from the original facet planes.
+    ////    Stops early at targetTriangles (0: as far as the tolerance allows).
+    static TriangleMesh Decimate(const TriangleMesh& mesh, G4double tolerance, std::size_t targetTriangles = 0);
+
+    ////    Symmetric Hausdorff distance, estimated from all vertices and samplesPerMesh random surface points of each mesh
+    static G4double     HausdorffDistance(const TriangleMesh& a, const TriangleMesh& b, std::size_t samplesPerMesh = 100000);
+
+    ////    e.g. "Body.ply", 0.1 mm -> "Body.lod100um.ply"
+    static G4String     GetLevelOfDetailFileName(const G4String& meshPath, G4double tolerance);
+};
+
+#endif
@@ -0,0 +1,132 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef MultipoleFieldExpansion_h
+#define MultipoleFieldExpansion_h 1
+
+#include "globals.hh"
+#include "G4MagneticField.hh"
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//      Multipole expansion of a straight magnet with Enge fringe fields
+////////////////////////////////////////////////////////////////////////////////
+//
+//      In the frame of the magnet (axis at (x0, y0) of the table, z along the
+//      axis) the field is B = -grad(Phi) of the scalar potential
+//
+//      Phi = - sum_n  R/n [ b_n Im(w^n) + a_n Re(w^n) ] sum_k c_nk F^(2k)(t) |w|^2k
+//
+//          w = (x + i y)/R,  t = z/R,  c_nk = (-1)^k n! / (4^k k! (n+k)!)
+//
+//      b_n, a_n:   normal and skew field of multipole n (1: dipole, 2: quadrupole, ...)
+//                  at the reference radius R in the body of the magnet
+//      F(z):       fringe-field profile, the product of an entrance and an exit
+//                  Enge function E(s) = 1/(1 + exp(e0 + e1 s + e2 s^2 + e3 s^3)),
+//                  s = distance outside the effective field boundary / D
+//
+//      The field is curl-free by construction, and the pseudo-multipole terms
+//      k > 0 keep Phi a solution of Laplace's equation through the fringe
+//      fields up to terms of order |w|^(2K), so it is divergence-free to that
+//      order. It is smooth to all orders. The derivatives F^(m) are evaluated
+//      exactly with truncated Taylor series.
+//
+//      The coefficients are fitted to a measured map with the MultipoleFieldFitter tool.
+//
+
+struct MultipoleFieldParameters
+{
+    G4int       order;                  // highest multipole n
+    G4int       pseudoOrder;            // highest k
+    G4double    referenceRadius;        // R
+    G4double    x0, y0;                 // magnet axis (table frame)
+    G4double    zEntrance, zExit;       // effective field boundaries (table frame)
+    G4double    engeLength;             // D
+    G4double    engeEntrance[4];
+    G4double    engeExit[4];
+    G4double    engeRange;              // |s| beyond which E is taken as 0 or 1
+    G4double    rMax, zMin, zMax;       // region of validity, zero field outside
+    std::vector<G4double>   normal;     // b_1 ... b_order
+    std::vector<G4double>   skew;       // a_1 ... a_order
+
+    MultipoleFieldParameters();
+
+    ////    Text file written by MultipoleFieldFitter
+    G4bool  Read(const G4String& filename);
+    G4bool  Write(const G4String& filename) const;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Magnetic field of a fitted multipole expansion (see MultipoleFieldParameters).
+///
+/// The field object holds only the coefficients and is cheap to create per
+/// thread. Like MagneticFieldMapping, the table frame is offset by zOffset
+/// along z.
+
+class MultipoleFieldExpansion
+#ifndef STANDALONE
+: public G4MagneticField
+#endif
+{
+public:
+    static const int kMaxOrder = 8;
+    static const int kMaxPseudoOrder = 3;
+    static const int kMaxBasis = 2*kMaxOrder;
+
+    MultipoleFieldExpansion(const G4String& filename, G4double zOffset);
+    MultipoleFieldExpansion(const MultipoleFieldParameters& parameters, G4double zOffset);
+
+    void    GetFieldValue(const G4double point[4], G4double* Bfield) const;
+
+    const MultipoleFieldParameters& GetParameters() const   { return fParameters; }
+
+    ////    Field of every unit coefficient at (x, y) relative to the axis and z of the table
+    ////    frame: basis[n-1] for b_n, basis[order+n-1] for a_n. Returns the number of
+    ////    basis fields, 2*order. Ignores the region of validity.
+    static G4int    EvaluateBasis(const MultipoleFieldParameters& parameters,
+                                  G4double x, G4double y, G4double z, G4double (*basis)[3]);
+
+private:
+    void    Setup();
+
+    MultipoleFieldParameters    fParameters;
+    G4double                    fZoffset;
+    G4double                    fRMax2;
+};
+
+#endif
@@ -0,0 +1,177 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef PrimaryEventFile_h
+#define PrimaryEventFile_h 1
+
+#include "globals.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//      Pre-generated primary event file
+////////////////////////////////////////////////////////////////////////////////
+//
+//      Compact little-endian binary layout, written by external reaction/decay
+//      codes (or PrimaryEventFileWriter) and read back through a read-only
+//      memory mapping:
+//
+//      [PrimaryEventFileHeader]                        (64 bytes)
+//      [PrimaryEventRecord    x nEvents]               (48 bytes each)
+//      [PrimaryParticleRecord x nParticles]            (40 bytes each)
+//
+//      The two tables are located through the offsets stored in the header,
+//      so a writer may emit them in either order.
+//
+//      Units: mm, ns and MeV. Directions are unit vectors in the world frame.
+//      The particles of event i are particles[firstParticle, firstParticle+nParticles).
+//
+
+struct PrimaryEventFileHeader
+{
+    char            magic[8];               // "K600EVT"
+    std::uint32_t   version;
+    std::uint32_t   headerSize;
+    std::uint64_t   nEvents;
+    std::uint64_t   nParticles;
+    std::uint64_t   eventTableOffset;       // bytes from the start of the file
+    std::uint64_t   particleTableOffset;    // bytes from the start of the file
+    std::uint8_t    reserved[16];
+};
+
+struct PrimaryEventRecord
+{
+    double          x, y, z;                // vertex position (mm)
+    double          t;                      // vertex time (ns)
+    std::uint64_t   firstParticle;
+    std::uint32_t   nParticles;
+    float           weight;                 // statistical weight of the event
+};
+
+struct PrimaryParticleRecord
+{
+    std::int32_t    pdg;                    // PDG code, ions as 100ZZZAAAI
+    float           weight;
+    double          kineticEnergy;          // MeV
+    double          time;                   // ns, relative to the vertex
+    float           dx, dy, dz;             // momentum direction
+    std::uint32_t   reserved;
+};
+
+static_assert(sizeof(PrimaryEventFileHeader) == 64, "PrimaryEventFileHeader must be 64 bytes");
+static_assert(sizeof(PrimaryEventRecord) == 48, "PrimaryEventRecord must be 48 bytes");
+static_assert(sizeof(PrimaryParticleRecord) == 40, "PrimaryParticleRecord must be 40 bytes");
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Read-only, memory-mapped view of a pre-generated primary event file.
+///
+/// A file is mapped once per process and shared by every worker thread
+/// (see Open()). The mapping is immutable, so the accessors need no locking;
+/// the only shared state is the atomic read cursor behind NextEvent().
+
+class PrimaryEventFile
+{
+public:
+    static const std::uint32_t  kVersion = 1;
+
+    ~PrimaryEventFile();
+
+    ////    Returns the shared mapping of filename, mapping it on first use.
+    ////    A null pointer is returned (with a warning) if the file is unusable.
+    static std::shared_ptr<const PrimaryEventFile> Open(const G4String& filename);
+
+    const G4String&     GetFileName() const             { return fFileName; }
+    std::uint64_t       GetNumberOfEvents() const       { return fNEvents; }
+    std::uint64_t       GetNumberOfParticles() const    { return fNParticles; }
+
+    const PrimaryEventRecord&       GetEvent(std::uint64_t i) const      { return fEvents[i]; }
+    const PrimaryParticleRecord&    GetParticle(std::uint64_t i) const   { return fParticles[i]; }
+
+    ////    Claims the next unread event for the calling thread. Every event of the
+    ////    file is handed out exactly once per mapping; false once all are used.
+    G4bool NextEvent(std::uint64_t& index) const;
+
+private:
+    PrimaryEventFile();
+    PrimaryEventFile(const PrimaryEventFile&) = delete;
+    PrimaryEventFile& operator=(const PrimaryEventFile&) = delete;
+
+    G4bool Map(const G4String& filename);
+
+    G4String                        fFileName;
+    void*                           fMapping;
+    std::size_t                     fMappingSize;
+    std::uint64_t                   fNEvents;
+    std::uint64_t                   fNParticles;
+    const PrimaryEventRecord*       fEvents;
+    const PrimaryParticleRecord*    fParticles;
+
+    mutable std::atomic<std::uint64_t>  fNextEvent;     // shared by every worker thread
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Sequential writer for the format above, for use by external generators
+/// linked against this project (or small conversion programs).
+
+class PrimaryEventFileWriter
+{
+public:
+    PrimaryEventFileWriter();
+    ~PrimaryEventFileWriter();
+
+    G4bool  Open(const G4String& filename);
+    void    BeginEvent(double x, double y, double z, double t, float weight = 1.0);
+    void    AddParticle(std::int32_t pdg, double kineticEnergy,
+                        double dx, double dy, double dz,
+                        double time = 0.0, float weight = 1.0);
+    ////    Appends the event table, completes the header and closes the file
+    G4bool  Close();
+
+private:
+    G4String                            fFileName;
+    std::FILE*                          fFile;
+    std::vector<PrimaryEventRecord>     fEvents;
+    std::uint64_t                       fNParticles;
+};
+
+#endif
@@ -41,11 +41,18 @@
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "globals.hh"
 #include "G4ThreeVector.hh"
+#include "PrimaryEventFile.hh"
+#include "DecayCascadeGenerator.hh"
+#include "BiasedDirectionSampler.hh"
+#include <map>
 #include <mutex>
 
 class G4ParticleGun;
 class G4Event;
+class G4ParticleDefinition;
 class EventAction;
+class DetectorConstruction;
+class PrimaryGeneratorMessenger;
 
 /// The primary generator action class with particle gum.
 ///
@@ -54,15 +61,12 @@ class EventAction;
 /// can be changed via the G4 build-in commands of G4ParticleGun class
 /// (see the macros provided with this example).
 
-static std::mutex mutex_particleN;  // protects particleN
-static int particleN;
-
-static  std::mutex mutex_EventGeneratorSetup;  // protects particleN
+static  std::mutex mutex_EventGeneratorSetup;  // protects the event generator setup
 
 class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
 {
 public:
-    PrimaryGeneratorAction(EventAction* eventAction);
+    PrimaryGeneratorAction(EventAction* eventAction, DetectorConstruction* detectorConstruction = 0);
     virtual ~PrimaryGeneratorAction();
     
     virtual void GeneratePrimaries(G4Event* event);
@@ -79,10 +83,54 @@ public:
     
     G4double EvaluateAngDist_interpolated(G4double chosenTheta);
 
+    ////    Primary event source: "gun" (default), "file" or "cascade"
+    void SetSource(const G4String& source);
+    void SetEventFile(const G4String& filename);
+    ////    False, with the current source kept, if the cascade file is unusable
+    G4bool SetCascadeFile(const G4String& filename);
+    
+    ////    Importance sampling of the gun direction towards the detector arrays
+    void SetDirectionBiasing(G4bool value)          {fBiasDirections = value; fBiasSamplerUpToDate = false;};
+    void SetBiasArrays(const G4String& arrays)      {fBiasArrays = arrays; fBiasSamplerUpToDate = false;};
+    void SetBiasRadius_CLOVER(G4double radius)      {fBiasRadius_CLOVER = radius; fBiasSamplerUpToDate = false;};
+    void SetBiasRadius_LaBr3Ce(G4double radius)     {fBiasRadius_LaBr3Ce = radius; fBiasSamplerUpToDate = false;};
+    void SetBiasIsotropicFraction(G4double value)   {fBiasIsotropicFraction = value; fBiasSamplerUpToDate = false;};
+
     
 private:
     G4ParticleGun*  fParticleGun; // G4 particle gun
     EventAction*  fEventAction;
+    PrimaryGeneratorMessenger*  fMessenger;
+
+    G4String        fSource;
+
+    //------------------------------------------------
+    //      Pre-generated event file source
+    std::shared_ptr<const PrimaryEventFile>  fEventFile;
+    std::map<G4int, G4ParticleDefinition*>  fParticleDefinitions;
+
+    void GeneratePrimariesFromFile(G4Event* anEvent);
+    G4ParticleDefinition* GetParticleDefinition(G4int pdg);
+
+    //------------------------------------------------
+    //      Reaction + decay cascade source
+    DecayCascadeGenerator*  fCascadeGenerator;
+
+    void GeneratePrimariesFromCascade(G4Event* anEvent);
+
+    //------------------------------------------------
+    //      Biased gun directions
+    DetectorConstruction*   fDetectorConstruction;
+    BiasedDirectionSampler  fBiasedDirectionSampler;
+    G4bool          fBiasDirections;
+    G4bool          fBiasSamplerUpToDate;
+    G4int           fBiasLayoutChanges;     // DetectorConstruction::GetLayoutChanges() of the cones
+    G4String        fBiasArrays;            // "all", "CLOVER" or "LaBr3Ce"
+    G4double        fBiasRadius_CLOVER;     // effective front-face radius defining the cone
+    G4double        fBiasRadius_LaBr3Ce;
+    G4double        fBiasIsotropicFraction;
+
+    void SetupBiasedDirectionSampler();
 
     
     G4double    mx;
@@ -102,26 +150,10 @@ private:
     
     G4ThreeVector ejectileDirection;
     G4ThreeVector recoilDirection;
-    
-    //------------------------------------------------
-    int nEnergies;
-    int nParticlesPerEnergy;
-
-    std::vector<G4double> initialKineticEnergies;
-
-    int GetParticleN();
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-inline int PrimaryGeneratorAction::GetParticleN() {
-    
-    std::lock_guard<std::mutex> lock(mutex_particleN);
-    return particleN++;
-}
-
-//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
-
 inline G4double PrimaryGeneratorAction::EvaluateAngDist_interpolated(G4double chosenTheta) {
 
     G4double result = 0.0;
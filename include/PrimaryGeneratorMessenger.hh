@@ -0,0 +1,79 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef PrimaryGeneratorMessenger_h
+#define PrimaryGeneratorMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class PrimaryGeneratorAction;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithABool;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+
+/// Messenger for the primary generator (/K600/generator/).
+///
+/// One instance lives alongside each (per-thread) PrimaryGeneratorAction;
+/// the commands are broadcast to every worker.
+
+class PrimaryGeneratorMessenger : public G4UImessenger
+{
+public:
+    PrimaryGeneratorMessenger(PrimaryGeneratorAction* primaryGeneratorAction);
+    virtual ~PrimaryGeneratorMessenger();
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+    PrimaryGeneratorAction*     fPrimaryGeneratorAction;
+
+    G4UIdirectory*              fGeneratorDirectory;
+    G4UIcmdWithAString*         fSourceCmd;
+    G4UIcmdWithAString*         fEventFileCmd;
+    G4UIcmdWithAString*         fCascadeFileCmd;
+
+    G4UIdirectory*              fBiasDirectory;
+    G4UIcmdWithABool*           fBiasEnableCmd;
+    G4UIcmdWithAString*         fBiasArraysCmd;
+    G4UIcmdWithADouble*         fBiasIsotropicFractionCmd;
+    G4UIcmdWithADoubleAndUnit*  fBiasRadiusCLOVERCmd;
+    G4UIcmdWithADoubleAndUnit*  fBiasRadiusLaBr3CeCmd;
+};
+
+#endif
@@ -39,6 +39,7 @@
 
 #include "G4UserRunAction.hh"
 #include "globals.hh"
+#include "G4Timer.hh"
 #include <vector>
 
 class G4Run;
@@ -58,7 +59,9 @@ class G4Run;
 /// accoring to a selected technology in B4Analysis.hh.
 ///
 /// In EndOfRunAction(), the accumulated statistic and computed
-/// dispersion is printed.
+/// dispersion is printed, and the master prints the throughput of the run
+/// (for comparing region cuts, limits and physics settings). At the first
+/// run, the master also prints the start-up time of the K600PhysicsList.
 ///
 
 class RunAction : public G4UserRunAction
@@ -125,7 +128,10 @@ public:
     void SetLaBr3Ce_xPos(std::vector<double> vec) {laBr3Ce_xPos = vec;};
     void SetLaBr3Ce_yPos(std::vector<double> vec) {laBr3Ce_yPos = vec;};
     void SetLaBr3Ce_zPos(std::vector<double> vec) {laBr3Ce_zPos = vec;};
-
+    
+private:
+    //  Wall time of the run (master)
+    G4Timer fRunTimer;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,76 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef SpectrometerFastSimModel_h
+#define SpectrometerFastSimModel_h 1
+
+#include "G4VFastSimulationModel.hh"
+#include "SpectrometerTransferMap.hh"
+
+/// Fast simulation of the ejectile transport through the K600 magnets.
+///
+/// Attached to the region of the spectrometer envelope. A charged track that
+/// enters the envelope through its entry plane is moved in one step to the
+/// exit plane, with the position, direction and path length given by the
+/// fitted SpectrometerTransferMap; time of flight and proper time follow from
+/// the path length. Tracks outside the fitted phase space, or predicted to
+/// leave outside the range of the fit samples, are tracked normally.
+///
+/// One instance is created per thread in DetectorConstruction::ConstructSDandField().
+/// It can be switched off and on with /param/InActivateModel and /param/ActivateModel.
+
+class SpectrometerFastSimModel : public G4VFastSimulationModel
+{
+public:
+    SpectrometerFastSimModel(const G4String& name, G4Region* envelope, const G4String& transferMapFile);
+    virtual ~SpectrometerFastSimModel();
+    
+    virtual G4bool  IsApplicable(const G4ParticleDefinition& particle);
+    virtual G4bool  ModelTrigger(const G4FastTrack& fastTrack);
+    virtual void    DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep);
+    
+    const SpectrometerTransferMap&  GetTransferMap() const      { return fTransferMap; }
+    
+private:
+    SpectrometerTransferMap     fTransferMap;
+    G4bool                      fTransferMapLoaded;
+    G4double                    fPlaneTolerance;
+    
+    ////    Result of the map for the track accepted by the last ModelTrigger()
+    G4double                    fExitCoordinates[SpectrometerTransferMap::kNumberOfCoordinates];
+};
+
+#endif
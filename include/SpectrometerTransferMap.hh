@@ -0,0 +1,140 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef SpectrometerTransferMap_h
+#define SpectrometerTransferMap_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <iosfwd>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//      Ion-optical transfer map of the K600 spectrometer
+////////////////////////////////////////////////////////////////////////////////
+//
+//      Maps the phase space of an ejectile on the entry plane of the
+//      spectrometer envelope to its phase space on the exit plane,
+//
+//          (x, a, y, b, delta)  ->  (x', a', y', b', l)
+//
+//      x, y:       position on the plane (mm)
+//      a, b:       slopes dx/dz, dy/dz relative to the plane normal z
+//      delta:      relative rigidity deviation (p/q)/(p0/q0) - 1
+//      l:          path length from the entry to the exit plane (mm)
+//
+//      Every output is a polynomial of total order <= N in the inputs, each
+//      scaled to [-1, 1] over the domain the map was fitted on. The planes
+//      are given in the coordinates of the envelope volume.
+//
+//      The map is fitted by least squares to samples recorded in full-tracking
+//      runs (SpectrometerTransferMapRecorder) with the TransferMapFitter tool.
+//
+
+////    A plane with its own frame; z is the normal, pointing downstream
+struct TransferMapPlane
+{
+    G4ThreeVector   origin;
+    G4ThreeVector   xAxis, yAxis, zAxis;
+    
+    ////    Phase-space coordinates of a position on the plane and a direction
+    void    ToPhaseSpace(const G4ThreeVector& position, const G4ThreeVector& direction,
+                         G4double& x, G4double& a, G4double& y, G4double& b) const;
+    void    FromPhaseSpace(G4double x, G4double a, G4double y, G4double b,
+                           G4ThreeVector& position, G4ThreeVector& direction) const;
+};
+
+////    in: x, a, y, b (entry plane) and rigidity p/q (MeV/c per unit charge)
+////    out: x, a, y, b (exit plane) and path length
+struct TransferMapSample
+{
+    G4double    in[5];
+    G4double    out[5];
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class SpectrometerTransferMap
+{
+public:
+    static const G4int kNumberOfCoordinates = 5;
+    static const G4int kMaxOrder = 7;
+    
+    SpectrometerTransferMap();
+    
+    ////    Text file written by TransferMapFitter
+    G4bool  Read(const G4String& filename);
+    G4bool  Write(const G4String& filename) const;
+    
+    ////    Least-squares fit of all terms up to order. Returns false if the samples do not determine them.
+    G4bool  Fit(const std::vector<TransferMapSample>& samples, G4int order, G4double referenceRigidity);
+    
+    ////    in: x, a, y, b, delta; out: x', a', y', b', l. Returns false outside the domain of
+    ////    the fit or if the exit position lies outside the range seen in the fit samples.
+    G4bool  Evaluate(const G4double* in, G4double* out) const;
+    
+    void    SetPlanes(const TransferMapPlane& entryPlane, const TransferMapPlane& exitPlane);
+    
+    const TransferMapPlane& GetEntryPlane() const       { return fEntryPlane; }
+    const TransferMapPlane& GetExitPlane() const        { return fExitPlane; }
+    G4double                GetReferenceRigidity() const { return fReferenceRigidity; }
+    G4int                   GetOrder() const            { return fOrder; }
+    G4int                   GetNumberOfTerms() const    { return G4int(fCoefficients.size())/kNumberOfCoordinates; }
+    
+    ////    Sample-file format shared by the recorder and the fitter
+    static void     WriteSampleHeader(std::ostream& file, const TransferMapPlane& entryPlane, const TransferMapPlane& exitPlane);
+    static void     WriteSample(std::ostream& file, const TransferMapSample& sample);
+    static G4bool   ReadSamples(const G4String& filename, std::vector<TransferMapSample>& samples,
+                                TransferMapPlane& entryPlane, TransferMapPlane& exitPlane);
+    
+private:
+    void    BuildExponents(G4int order);
+    
+    G4int                   fOrder;
+    G4double                fReferenceRigidity;
+    TransferMapPlane        fEntryPlane;
+    TransferMapPlane        fExitPlane;
+    
+    G4double                fCentre[kNumberOfCoordinates];      // of the fitted input domain
+    G4double                fHalfWidth[kNumberOfCoordinates];
+    G4double                fExitRange[4];                      // x'min, x'max, y'min, y'max
+    
+    std::vector<G4int>      fExponents;                         // per term, one per input
+    std::vector<G4double>   fCoefficients;                      // per term, one per output
+};
+
+#endif
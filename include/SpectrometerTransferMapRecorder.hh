@@ -0,0 +1,85 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#ifndef SpectrometerTransferMapRecorder_h
+#define SpectrometerTransferMapRecorder_h 1
+
+#include "globals.hh"
+#include "SpectrometerTransferMap.hh"
+
+#include <fstream>
+#include <map>
+
+class G4Step;
+class G4StepPoint;
+class G4VPhysicalVolume;
+
+/// Records transfer-map samples in full-tracking runs.
+///
+/// Called from SteppingAction for every step. Charged tracks entering the
+/// spectrometer envelope through its entry plane are remembered, and when
+/// they leave through the exit plane one TransferMapSample is written. Each
+/// thread writes its own file, <filename>.<threadID>, which the
+/// TransferMapFitter tool combines into a SpectrometerTransferMap.
+
+class SpectrometerTransferMapRecorder
+{
+public:
+    SpectrometerTransferMapRecorder(const G4VPhysicalVolume* envelope,
+                                    const TransferMapPlane& entryPlane, const TransferMapPlane& exitPlane,
+                                    const G4String& filename);
+    ~SpectrometerTransferMapRecorder();
+    
+    void    Record(const G4Step* step);
+    
+    G4long  GetNumberOfSamples() const      { return fNSamples; }
+    
+private:
+    G4bool  IsInsideEnvelope(const G4StepPoint* stepPoint) const;
+    
+    const G4VPhysicalVolume*    fEnvelope;
+    TransferMapPlane            fEntryPlane;
+    TransferMapPlane            fExitPlane;
+    G4double                    fPlaneTolerance;
+    
+    std::ofstream               fFile;
+    G4long                      fNSamples;
+    
+    ////    Entry coordinates of the tracks presently inside the envelope, by track ID
+    std::map<G4int, TransferMapSample>  fOpenSamples;
+};
+
+#endif
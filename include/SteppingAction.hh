@@ -43,6 +43,7 @@
 
 class DetectorConstruction;
 class EventAction;
+class SpectrometerTransferMapRecorder;
 
 /// Stepping action class.
 ///
@@ -70,6 +71,11 @@ private:
     G4ThreeVector worldPosition;
     G4ThreeVector localPosition;
     
+    ////    Transfer-map samples of the spectrometer, created at the first step
+    ////    (the geometry is not yet built when the action is)
+    SpectrometerTransferMapRecorder*    fTransferMapRecorder;
+    G4bool                              fTransferMapRecorderChecked;
+    
     
     ////    PADDLE DETECTOR - Plastic Scintillator
     G4double    edepPADDLE;
@@ -40,6 +40,7 @@
 #include "EventAction.hh"
 #include "SteppingAction.hh"
 #include "DetectorConstruction.hh"
+#include "EnergySweepScheduler.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -58,6 +59,9 @@ ActionInitialization::~ActionInitialization()
 
 void ActionInitialization::BuildForMaster() const
 {
+    ////    Creates the (master-only) /K600/sweep/ commands
+    EnergySweepScheduler::Instance();
+    
     SetUserAction(new RunAction);
 }
 
@@ -82,9 +86,12 @@ void ActionInitialization::Build() const
     SetUserAction(new SteppingAction(fDetConstruction,eventAction));
     */
     
+    ////    In sequential mode Build() is the only initialisation on the master
+    EnergySweepScheduler::Instance();
+    
     RunAction* runAction = new RunAction;
     EventAction* eventAction = new EventAction(runAction, fDetConstruction);
-    PrimaryGeneratorAction* primaryGeneratorAction = new PrimaryGeneratorAction(eventAction);
+    PrimaryGeneratorAction* primaryGeneratorAction = new PrimaryGeneratorAction(eventAction, fDetConstruction);
     
     SetUserAction(primaryGeneratorAction);
     SetUserAction(eventAction);
@@ -0,0 +1,131 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "BiasedDirectionSampler.hh"
+
+#include "G4PhysicalConstants.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+BiasedDirectionSampler::BiasedDirectionSampler()
+: fIsotropicFraction(0.1)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BiasedDirectionSampler::Clear()
+{
+    fAxes.clear();
+    fCosHalfAngles.clear();
+    fInvSolidAngles.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BiasedDirectionSampler::AddCone(const G4ThreeVector& direction, G4double halfAngle)
+{
+    if(direction.mag2()<=0.0 || halfAngle<=0.0) return;
+
+    const G4double cosHalfAngle = std::cos(std::min(halfAngle, pi));
+
+    fAxes.push_back(direction.unit());
+    fCosHalfAngles.push_back(cosHalfAngle);
+    fInvSolidAngles.push_back(1.0/(twopi*(1.0 - cosHalfAngle)));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BiasedDirectionSampler::SetIsotropicFraction(G4double fraction)
+{
+    ////    f = 0 would leave directions outside every cone with zero probability (infinite weight)
+    fIsotropicFraction = std::min(std::max(fraction, 1.0e-3), 1.0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double BiasedDirectionSampler::Sample(G4ThreeVector& direction) const
+{
+    const G4int nCones = G4int(fAxes.size());
+
+    if(nCones==0 || G4UniformRand()<fIsotropicFraction)
+    {
+        ////    Isotropic component
+        const G4double cosTheta = 1.0 - 2.0*G4UniformRand();
+        const G4double sinTheta = std::sqrt(std::max(0.0, 1.0 - cosTheta*cosTheta));
+        const G4double phi = twopi*G4UniformRand();
+
+        direction.set(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta);
+    }
+    else
+    {
+        ////    Uniform inside the cone of one detector
+        const G4int i = std::min(G4int(nCones*G4UniformRand()), nCones-1);
+
+        const G4double cosTheta = 1.0 - G4UniformRand()*(1.0 - fCosHalfAngles[i]);
+        const G4double sinTheta = std::sqrt(std::max(0.0, 1.0 - cosTheta*cosTheta));
+        const G4double phi = twopi*G4UniformRand();
+
+        direction.set(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta);
+        direction.rotateUz(fAxes[i]);
+    }
+
+    return (nCones==0) ? 1.0 : GetWeight(direction);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double BiasedDirectionSampler::GetWeight(const G4ThreeVector& direction) const
+{
+    const G4int nCones = G4int(fAxes.size());
+
+    if(nCones==0) return 1.0;
+
+    ////    Overlapping cones all contribute to the density
+    G4double coneDensity = 0.0;
+
+    for(G4int i=0; i<nCones; i++)
+    {
+        if(direction.dot(fAxes[i])>=fCosHalfAngles[i]) coneDensity += fInvSolidAngles[i];
+    }
+
+    const G4double density = fIsotropicFraction/(4.0*pi) + (1.0 - fIsotropicFraction)*coneDensity/nCones;
+
+    return 1.0/(4.0*pi*density);
+}
@@ -0,0 +1,280 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "BinaryReactionKinematics.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    ////    Same constants as BiRelKin
+    const double kc2 = 931.494;             // MeV/u, c^2
+    const double kc4 = kc2*kc2;
+    const double kDegToRad = 0.017453292;
+    const double kRadToDeg = 1.0/0.0174532925;
+
+    ////    Block length of the batch evaluation
+    const std::size_t kBlockSize = 64;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+BinaryReactionKinematics::BinaryReactionKinematics(const double* m, double T0, double T1, double Ex)
+: fT0(T0),
+fT1(T1),
+fEx(0.0)
+{
+    for(int i=0; i<4; i++) fM[i] = m[i];
+
+    fQ = (fM[2] + fM[3])*kc2 - (fM[0] + fM[1])*kc2; // MeV
+
+    fE0 = fT0 + fM[0]*kc2;
+    fE1 = fT1 + fM[1]*kc2;
+
+    fP0sq_c2 = (fE0*fE0) - (fM[0]*fM[0]*kc4);
+    fM2sq_c4 = fM[2]*fM[2]*kc4;
+    fM3sq_c4 = fM[3]*fM[3]*kc4;
+    fInvSqrtC2 = 1.0/std::sqrt(kc2);
+
+    SetExcitationEnergy(Ex);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BinaryReactionKinematics::SetExcitationEnergy(double Ex)
+{
+    fEx = Ex;
+    fEtotal = fE0 + fE1 + fQ - fEx;
+
+    const double Et = fEtotal;
+    const double Et2 = Et*Et;
+    const double P2 = fP0sq_c2;
+    const double M2 = fM2sq_c4;
+    const double M3 = fM3sq_c4;
+
+    ////    The BiRelKin quadratic, split into its constant and cos^2(theta) parts,
+    ////    with c(theta) folded into the discriminant (K = Et^2 - p0^2c^2 + m2^2c^4 - m3^2c^4)
+    const double K = Et2 - P2 + M2 - M3;
+
+    fA0 = -4.0*Et2;
+    fA1 = 4.0*P2;
+    fB = 4.0*Et*K;
+    fD0 = (K*K) - (4.0*M2*Et2);
+    fD1 = 4.0*M2*P2;
+    f4P0_c = 4.0*std::sqrt(P2);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool BinaryReactionKinematics::Matches(const double* m, double T0, double T1, double Ex) const
+{
+    return (m[0]==fM[0]) && (m[1]==fM[1]) && (m[2]==fM[2]) && (m[3]==fM[3])
+    && (T0==fT0) && (T1==fT1) && (Ex==fEx);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BinaryReactionKinematics::Evaluate(double thetaEjectile, BinaryReactionKinematicsResult& result) const
+{
+    const double theta = thetaEjectile*kDegToRad;
+    const double cosTheta = std::cos(theta);
+    const double cosSq = cosTheta*cosTheta;
+
+    const double a = fA0 + fA1*cosSq;
+    const double rootDiscriminant = f4P0_c*std::abs(cosTheta)*std::sqrt(std::max(fD0 + fD1*cosSq, 0.0));
+
+    result.E2 = (-fB - rootDiscriminant)/(2.0*a);
+    result.T2 = result.E2 - fM[2]*kc2;
+    result.p2 = fInvSqrtC2*std::sqrt((result.E2*result.E2) - fM2sq_c4);
+
+    result.E3 = fEtotal - result.E2;
+    result.T3 = result.E3 - fM[3]*kc2;
+    result.p3 = fInvSqrtC2*std::sqrt((result.E3*result.E3) - fM3sq_c4);
+
+    result.thetaRecoil = std::asin((result.p2/result.p3)*std::sin(theta))*kRadToDeg;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BinaryReactionKinematics::Evaluate(double thetaEjectile, double* T, double* E, double* p, double& thetaRecoil) const
+{
+    BinaryReactionKinematicsResult result;
+    Evaluate(thetaEjectile, result);
+
+    T[0] = fT0;
+    T[1] = fT1;
+    T[2] = result.T2;
+    T[3] = result.T3;
+
+    E[0] = fE0;
+    E[1] = fE1;
+    E[2] = result.E2;
+    E[3] = result.E3;
+
+    p[0] = fInvSqrtC2*std::sqrt(fP0sq_c2);
+    p[1] = fInvSqrtC2*std::sqrt((fE1*fE1) - (fM[1]*fM[1]*kc4));
+    p[2] = result.p2;
+    p[3] = result.p3;
+
+    thetaRecoil = result.thetaRecoil;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BinaryReactionKinematics::EvaluateBatch(const double* cosTheta, const double* sinTheta, std::size_t n,
+                                             double* T2, double* T3, double* cosThetaRecoil, double* sinThetaRecoil) const
+{
+    double E2[kBlockSize];
+    double sinRecoil[kBlockSize];
+
+    const double A0 = fA0, A1 = fA1, B = fB, D0 = fD0, D1 = fD1, P0_c4 = f4P0_c;
+    const double Et = fEtotal;
+    const double M2 = fM2sq_c4, M3 = fM3sq_c4;
+    const double restEnergy2 = fM[2]*kc2;
+    const double restEnergy3 = fM[3]*kc2;
+
+    for(std::size_t offset=0; offset<n; offset+=kBlockSize)
+    {
+        const std::size_t blockSize = std::min(kBlockSize, n - offset);
+        const double* __restrict c = cosTheta + offset;
+        const double* __restrict s = sinTheta + offset;
+
+        ////    Quadratic and recoil angle: p2/p3 = sqrt((E2^2 - m2^2c^4)/(E3^2 - m3^2c^4))
+        for(std::size_t i=0; i<blockSize; i++)
+        {
+            const double cosSq = c[i]*c[i];
+            const double a = A0 + A1*cosSq;
+            const double rootDiscriminant = P0_c4*std::abs(c[i])*std::sqrt(std::max(D0 + D1*cosSq, 0.0));
+            const double e2 = (-B - rootDiscriminant)/(2.0*a);
+            const double e3 = Et - e2;
+
+            E2[i] = e2;
+            sinRecoil[i] = std::sqrt(((e2*e2) - M2)/((e3*e3) - M3))*s[i];
+        }
+
+        if(T2)
+        {
+            double* __restrict out = T2 + offset;
+            for(std::size_t i=0; i<blockSize; i++) out[i] = E2[i] - restEnergy2;
+        }
+
+        if(T3)
+        {
+            double* __restrict out = T3 + offset;
+            for(std::size_t i=0; i<blockSize; i++) out[i] = Et - E2[i] - restEnergy3;
+        }
+
+        if(sinThetaRecoil)
+        {
+            double* __restrict out = sinThetaRecoil + offset;
+            for(std::size_t i=0; i<blockSize; i++) out[i] = sinRecoil[i];
+        }
+
+        ////    The recoil goes forward: asin() in Evaluate()
+        if(cosThetaRecoil)
+        {
+            double* __restrict out = cosThetaRecoil + offset;
+            for(std::size_t i=0; i<blockSize; i++) out[i] = std::sqrt(1.0 - sinRecoil[i]*sinRecoil[i]);
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+BinaryReactionKinematicsTable::BinaryReactionKinematicsTable(const BinaryReactionKinematics& kinematics,
+                                                             double thetaMin, double thetaMax, int nTheta,
+                                                             double ExMin, double ExMax, int nEx)
+: fThetaMin(thetaMin),
+fThetaMax(thetaMax),
+fExMin(ExMin),
+fExMax(ExMax),
+fNTheta(std::max(nTheta, 2)),
+fNEx(std::max(nEx, 1))
+{
+    fInvDTheta = (fNTheta-1)/(fThetaMax - fThetaMin);
+    fInvDEx = (fNEx>1) ? (fNEx-1)/(fExMax - fExMin) : 0.0;
+
+    fNodes.resize(fNTheta*fNEx);
+
+    BinaryReactionKinematics nodeKinematics(kinematics);
+
+    for(int j=0; j<fNEx; j++)
+    {
+        nodeKinematics.SetExcitationEnergy((fNEx>1) ? fExMin + j/fInvDEx : fExMin);
+
+        for(int i=0; i<fNTheta; i++)
+        {
+            nodeKinematics.Evaluate(fThetaMin + i/fInvDTheta, fNodes[j*fNTheta + i]);
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool BinaryReactionKinematicsTable::Interpolate(double thetaEjectile, double Ex, BinaryReactionKinematicsResult& result) const
+{
+    if(thetaEjectile<fThetaMin || thetaEjectile>fThetaMax || Ex<fExMin || Ex>fExMax) return false;
+
+    double u = (thetaEjectile - fThetaMin)*fInvDTheta;
+    int i = std::min((int) u, fNTheta-2);
+    u -= i;
+
+    double v = (Ex - fExMin)*fInvDEx;
+    int j = std::min((int) v, std::max(fNEx-2, 0));
+    v -= j;
+
+    const int jNext = (fNEx>1) ? j+1 : j;
+
+    const BinaryReactionKinematicsResult& n00 = fNodes[j*fNTheta + i];
+    const BinaryReactionKinematicsResult& n01 = fNodes[j*fNTheta + i+1];
+    const BinaryReactionKinematicsResult& n10 = fNodes[jNext*fNTheta + i];
+    const BinaryReactionKinematicsResult& n11 = fNodes[jNext*fNTheta + i+1];
+
+    const double w00 = (1.0-u)*(1.0-v);
+    const double w01 = u*(1.0-v);
+    const double w10 = (1.0-u)*v;
+    const double w11 = u*v;
+
+    result.T2 = w00*n00.T2 + w01*n01.T2 + w10*n10.T2 + w11*n11.T2;
+    result.E2 = w00*n00.E2 + w01*n01.E2 + w10*n10.E2 + w11*n11.E2;
+    result.p2 = w00*n00.p2 + w01*n01.p2 + w10*n10.p2 + w11*n11.p2;
+    result.T3 = w00*n00.T3 + w01*n01.T3 + w10*n10.T3 + w11*n11.T3;
+    result.E3 = w00*n00.E3 + w01*n01.E3 + w10*n10.E3 + w11*n11.E3;
+    result.p3 = w00*n00.p3 + w01*n01.p3 + w10*n10.p3 + w11*n11.p3;
+    result.thetaRecoil = w00*n00.thetaRecoil + w01*n01.thetaRecoil + w10*n10.thetaRecoil + w11*n11.thetaRecoil;
+
+    return true;
+}
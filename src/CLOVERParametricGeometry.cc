@@ -0,0 +1,248 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "CLOVERParametricGeometry.hh"
+
+#include "G4Polycone.hh"
+#include "G4Torus.hh"
+#include "G4Trap.hh"
+#include "G4GenericTrap.hh"
+#include "G4UnionSolid.hh"
+#include "G4IntersectionSolid.hh"
+#include "G4DisplacedSolid.hh"
+#include "G4RotationMatrix.hh"
+#include "G4Transform3D.hh"
+#include "G4TwoVector.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+    
+    ////    Position of the BGO segments of the meshes BGO-Crystal_Modified_1-16: side of the
+    ////    shield (quarter turns from the side at -y), corner or middle segment, and mirrored in x
+    struct ShieldSegment
+    {
+        G4int   side;
+        G4bool  corner;
+        G4bool  mirrored;
+    };
+    
+    const ShieldSegment kShieldSegments[CLOVERParametricGeometry::kNumberOfShieldCrystals] =
+    {
+        {0, false, false},  {3, true, false},   {1, true, false},   {0, false, true},
+        {1, false, true},   {0, true, true},    {1, true, true},    {2, true, true},
+        {3, true, true},    {3, false, true},   {2, false, true},   {2, true, false},
+        {0, true, false},   {1, false, false},  {2, false, false},  {3, false, false}
+    };
+    
+    ////    The meshes of the sides at +x, +y and -x are moved by up to 0.2 mm, clear of the shield body (mm)
+    const G4double kShieldSideShifts[4][2] = {{0., 0.}, {-0.1, -0.1}, {0., -0.2}, {0.1, -0.1}};
+    
+    ////    Cross-section of a segment of the side at -y, clockwise seen from the front (+z)
+    std::vector<G4TwoVector> ShieldCrossSection(const CLOVERShieldDimensions& d, G4bool corner, G4double depth)
+    {
+        const G4double taper = std::tan(d.taperAngle);
+        const G4double inner = d.innerDistance + taper*depth;
+        const G4double outer = (depth<d.kinkDepth)
+        ? d.outerDistance + (d.outerKinkDistance - d.outerDistance)*depth/d.kinkDepth
+        : d.outerKinkDistance + taper*(depth - d.kinkDepth);
+        const G4double boundary = d.segmentBoundary + taper*depth;
+        
+        std::vector<G4TwoVector> vertices;
+        if(corner)
+        {
+            ////    mitred along the diagonal, the gap measured along x
+            vertices.push_back(G4TwoVector(boundary + d.gap, -outer));
+            vertices.push_back(G4TwoVector(boundary + d.gap, -inner));
+            vertices.push_back(G4TwoVector(inner - 2.*d.gap, -inner));
+            vertices.push_back(G4TwoVector(outer - 2.*d.gap, -outer));
+        }
+        else
+        {
+            vertices.push_back(G4TwoVector(d.gap, -outer));
+            vertices.push_back(G4TwoVector(d.gap, -inner));
+            vertices.push_back(G4TwoVector(boundary - d.gap, -inner));
+            vertices.push_back(G4TwoVector(boundary - d.gap, -outer));
+        }
+        return vertices;
+    }
+    
+    ////    The cross-section of segment at depth, in its place on the shield (still clockwise)
+    std::vector<G4TwoVector> PlaceCrossSection(const CLOVERShieldDimensions& d, const ShieldSegment& segment, G4double depth)
+    {
+        std::vector<G4TwoVector> section = ShieldCrossSection(d, segment.corner, depth);
+        std::vector<G4TwoVector> placed;
+        
+        for(std::size_t i=0; i<section.size(); i++)
+        {
+            ////    a mirrored polygon runs anticlockwise: reverse it
+            G4TwoVector vertex = segment.mirrored ? section[section.size() - 1 - i] : section[i];
+            if(segment.mirrored) vertex.setX(-vertex.x());
+            
+            for(G4int turn=0; turn<segment.side; turn++) vertex = G4TwoVector(-vertex.y(), vertex.x());
+            placed.push_back(vertex + G4TwoVector(kShieldSideShifts[segment.side][0], kShieldSideShifts[segment.side][1])*mm);
+        }
+        return placed;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CLOVERCrystalDimensions::CLOVERCrystalDimensions()
+: radius(25.0*mm),
+length(70.0*mm),
+frontZ(-20.0*mm),
+axisOffset(20.5*mm),
+flatDistance(20.5*mm),
+taperAngle(7.1*deg),
+frontRounding(7.0*mm),
+boreholeRadius(5.0*mm),
+boreholeDepth(55.0*mm),
+contactThickness(0.5*mm),
+contactDepth(56.0*mm),
+contactGap(0.01*mm)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CLOVERShieldDimensions::CLOVERShieldDimensions()
+: frontZ(-42.01*mm),
+length(239.54*mm),
+kinkDepth(109.659*mm),
+innerDistance(41.416*mm),
+outerDistance(46.168*mm),
+outerKinkDistance(74.517*mm),
+segmentBoundary(15.741*mm),
+taperAngle(7.0*deg),
+gap(0.2*mm)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VSolid* CLOVERParametricGeometry::HPGeCrystal(const G4String& name, G4int crystal, const G4ThreeVector& offset,
+                                                const CLOVERCrystalDimensions& d)
+{
+    //------------------------------------------------
+    //      Cylinder with the borehole, and the rounded front edge
+    const G4double backZ = d.frontZ - d.length;
+    const G4double boreholeZ = backZ + d.boreholeDepth;
+    const G4double roundingZ = d.frontZ - d.frontRounding;
+    const G4double innerRadius = d.radius - d.frontRounding;
+    
+    const G4double zPlane[6] = {backZ, boreholeZ, boreholeZ, roundingZ, roundingZ, d.frontZ};
+    const G4double rInner[6] = {d.boreholeRadius, d.boreholeRadius, 0., 0., 0., 0.};
+    const G4double rOuter[6] = {d.radius, d.radius, d.radius, d.radius, innerRadius, innerRadius};
+    
+    G4Polycone* cylinder = new G4Polycone(name + "_Cylinder", 0., 360.*deg, 6, zPlane, rInner, rOuter);
+    G4Torus* frontEdge = new G4Torus(name + "_FrontEdge", 0., d.frontRounding, innerRadius, 0., 360.*deg);
+    G4VSolid* body = new G4UnionSolid(name + "_Body", cylinder, frontEdge, 0, G4ThreeVector(0., 0., roundingZ));
+    
+    //------------------------------------------------
+    //      Flat faces at +x and -y of the crystal axis, tapered faces at -x and +y.
+    //      The trapezoid overhangs the crystal by 1 mm at either end.
+    const G4double taper = std::tan(d.taperAngle);
+    const G4double margin = 1.0*mm;
+    const G4double halfLength = 0.5*d.length + margin;
+    const G4double backHalfWidth = d.flatDistance + 0.5*taper*(d.length + margin);
+    const G4double frontHalfWidth = d.flatDistance - 0.5*taper*margin;
+    
+    G4Trap* faces = new G4Trap(name + "_Faces", halfLength, std::atan(taper/std::sqrt(2.)), -45.*deg,
+                               backHalfWidth, backHalfWidth, backHalfWidth, 0.,
+                               frontHalfWidth, frontHalfWidth, frontHalfWidth, 0.);
+    const G4ThreeVector facesCentre(-0.25*taper*d.length, 0.25*taper*d.length, d.frontZ - 0.5*d.length);
+    
+    G4VSolid* shaped = new G4IntersectionSolid(name + "_Shaped", body, faces, 0, facesCentre);
+    
+    //------------------------------------------------
+    //      Crystal 1 at (-x, +y); the others follow it in quarter turns
+    G4RotationMatrix rotation;
+    rotation.rotateZ(crystal*90.*deg);
+    const G4ThreeVector axis = rotation*G4ThreeVector(-d.axisOffset, d.axisOffset, 0.);
+    
+    return new G4DisplacedSolid(name, shaped, G4Transform3D(rotation, axis + offset));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VSolid* CLOVERParametricGeometry::LithiumContact(const G4String& name, G4int crystal, const G4ThreeVector& offset,
+                                                   const CLOVERCrystalDimensions& d)
+{
+    const G4double backZ = d.frontZ - d.length;
+    const G4double innerZ = backZ + d.boreholeDepth + d.contactGap;
+    const G4double innerRadius = d.boreholeRadius + d.contactGap;
+    const G4double outerRadius = d.boreholeRadius + d.contactThickness;
+    
+    const G4double zPlane[4] = {backZ, innerZ, innerZ, backZ + d.contactDepth};
+    const G4double rInner[4] = {innerRadius, innerRadius, 0., 0.};
+    const G4double rOuter[4] = {outerRadius, outerRadius, outerRadius, outerRadius};
+    
+    G4Polycone* contact = new G4Polycone(name + "_Lining", 0., 360.*deg, 4, zPlane, rInner, rOuter);
+    
+    G4RotationMatrix rotation;
+    rotation.rotateZ(crystal*90.*deg);
+    const G4ThreeVector axis = rotation*G4ThreeVector(-d.axisOffset, d.axisOffset, 0.);
+    
+    return new G4DisplacedSolid(name, contact, G4Transform3D(rotation, axis + offset));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VSolid* CLOVERParametricGeometry::BGOCrystal(const G4String& name, G4int segment, const G4ThreeVector& offset,
+                                               const CLOVERShieldDimensions& d)
+{
+    const ShieldSegment& place = kShieldSegments[segment];
+    
+    ////    G4GenericTrap: the vertices at -halfZ (the deeper end) first
+    std::vector<G4TwoVector> front = PlaceCrossSection(d, place, d.kinkDepth);
+    std::vector<G4TwoVector> frontEnd = PlaceCrossSection(d, place, 0.);
+    front.insert(front.end(), frontEnd.begin(), frontEnd.end());
+    
+    std::vector<G4TwoVector> back = PlaceCrossSection(d, place, d.length);
+    back.insert(back.end(), front.begin(), front.begin() + 4);
+    
+    const G4double frontHalfLength = 0.5*d.kinkDepth;
+    const G4double backHalfLength = 0.5*(d.length - d.kinkDepth);
+    
+    G4GenericTrap* frontPart = new G4GenericTrap(name + "_Front", frontHalfLength, front);
+    G4GenericTrap* backPart = new G4GenericTrap(name + "_Back", backHalfLength, back);
+    
+    G4VSolid* crystal = new G4UnionSolid(name + "_Union", frontPart, backPart, 0,
+                                         G4ThreeVector(0., 0., -frontHalfLength - backHalfLength));
+    
+    return new G4DisplacedSolid(name, crystal, G4Transform3D(G4RotationMatrix(), offset + G4ThreeVector(0., 0., d.frontZ - frontHalfLength)));
+}
@@ -0,0 +1,552 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "CachedCADMesh.hh"
+#include "MeshConvexDecomposition.hh"
+
+#include "CADMesh.hh"
+
+#include "G4TessellatedSolid.hh"
+#include "G4TriangularFacet.hh"
+#include "G4MultiUnion.hh"
+#include "G4GeometryTolerance.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const char kMeshCacheMagic[8] = {'K','6','0','0','M','S','H','\0'};
+    const std::uint64_t kHashSeed = 14695981039346656037ULL;
+
+    ////    64-bit FNV-1a
+    std::uint64_t Hash(const void* data, std::size_t nBytes, std::uint64_t hash = kHashSeed)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for(std::size_t i=0; i<nBytes; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    G4bool HashFile(const G4String& filename, std::uint64_t& size, std::uint64_t& hash)
+    {
+        std::FILE* file = std::fopen(filename.c_str(), "rb");
+        if(!file) return false;
+
+        std::vector<char> buffer(1<<20);
+        size = 0;
+        hash = kHashSeed;
+        std::size_t nRead;
+        while((nRead = std::fread(&buffer[0], 1, buffer.size(), file))>0)
+        {
+            hash = Hash(&buffer[0], nRead, hash);
+            size += nRead;
+        }
+        const G4bool ok = !std::ferror(file);
+        std::fclose(file);
+        return ok;
+    }
+
+    ////    At most one background load per core
+    std::mutex mutex_loads;
+    std::condition_variable condition_loads;
+    unsigned int activeLoads = 0;
+
+    class LoadSlot
+    {
+    public:
+        LoadSlot()
+        {
+            const unsigned int maxLoads = std::max(1u, std::thread::hardware_concurrency());
+            std::unique_lock<std::mutex> lock(mutex_loads);
+            condition_loads.wait(lock, [maxLoads]{ return activeLoads<maxLoads; });
+            activeLoads++;
+        }
+        ~LoadSlot()
+        {
+            std::lock_guard<std::mutex> lock(mutex_loads);
+            activeLoads--;
+            condition_loads.notify_one();
+        }
+    };
+
+    ////    Settings per mesh name
+    struct MeshSettings
+    {
+        G4double    levelOfDetail;
+        G4int       maxVoxels;
+        G4bool      convexDecomposition;
+
+        MeshSettings() : levelOfDetail(0.), maxVoxels(0), convexDecomposition(false) {}
+    };
+
+    std::map<G4String, MeshSettings>& Settings()
+    {
+        static std::map<G4String, MeshSettings> settings;
+        return settings;
+    }
+
+    ////    "dir/Body.ply" -> "Body"
+    G4String MeshName(const G4String& meshPath)
+    {
+        const std::size_t slash = meshPath.find_last_of('/');
+        const G4String fileName = (slash==std::string::npos) ? meshPath : G4String(meshPath.substr(slash + 1));
+        return fileName.substr(0, fileName.find_last_of('.'));
+    }
+
+    const MeshSettings* FindSettings(const G4String& meshPath)
+    {
+        std::map<G4String, MeshSettings>::const_iterator found = Settings().find(MeshName(meshPath));
+        return (found==Settings().end()) ? 0 : &found->second;
+    }
+
+    ////    Mesh files looked for by the meshes constructed so far
+    std::set<G4String>& SourceFiles()
+    {
+        static std::set<G4String> sourceFiles;
+        return sourceFiles;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CachedCADMesh::CachedCADMesh(const char* meshPath, const char* meshType, G4double scale,
+                             const G4ThreeVector& offset, G4bool reverse)
+: fMeshPath(SelectLevelOfDetail(meshPath)),
+fDecompositionFile(SelectConvexDecomposition(meshPath)),
+fMaxVoxels(FindSettings(meshPath) ? FindSettings(meshPath)->maxVoxels : 0),
+fMeshType(meshType),
+fScale(scale),
+fOffset(offset),
+fReverse(reverse),
+fCacheFile(GetCacheFileName(fMeshPath, scale, offset, reverse)),
+fHaveSource(false),
+fSourceSize(0),
+fSourceHash(0)
+{
+    ////    The facets read the surface tolerance: create the singleton before the loaders do
+    G4GeometryTolerance::GetInstance();
+
+    const MeshSettings* settings = FindSettings(meshPath);
+    SourceFiles().insert(meshPath);
+    if(settings && settings->levelOfDetail>0.) SourceFiles().insert(MeshDecimation::GetLevelOfDetailFileName(meshPath, settings->levelOfDetail));
+    if(settings && settings->convexDecomposition) SourceFiles().insert(MeshConvexDecomposition::GetDecompositionFileName(meshPath));
+
+    fLoader = std::thread(&CachedCADMesh::Load, this);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CachedCADMesh::~CachedCADMesh()
+{
+    if(fLoader.joinable()) fLoader.join();
+
+    ////    Facets not handed over to a solid
+    for(std::size_t i=0; i<fFacets.size(); i++) delete fFacets[i];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String CachedCADMesh::GetCacheFileName(const G4String& meshPath, G4double scale,
+                                         const G4ThreeVector& offset, G4bool reverse)
+{
+    const double parameters[5] = {scale, offset.x(), offset.y(), offset.z(), reverse ? 1. : 0.};
+
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%08x.bin", (unsigned int) (Hash(parameters, sizeof(parameters)) & 0xffffffffu));
+    return meshPath + suffix;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CachedCADMesh::SetLevelOfDetail(const G4String& meshName, G4double tolerance)
+{
+    Settings()[meshName].levelOfDetail = std::max(0., tolerance);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CachedCADMesh::SetMaxVoxels(const G4String& meshName, G4int maxVoxels)
+{
+    Settings()[meshName].maxVoxels = std::max(0, maxVoxels);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CachedCADMesh::SetConvexDecomposition(const G4String& meshName, G4bool use)
+{
+    Settings()[meshName].convexDecomposition = use;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String CachedCADMesh::GetSettingsDescription()
+{
+    std::ostringstream description;
+    description.precision(17);
+    for(std::map<G4String, MeshSettings>::const_iterator it=Settings().begin(); it!=Settings().end(); ++it)
+    {
+        description << it->first << " " << it->second.levelOfDetail/mm << " " << it->second.maxVoxels
+        << " " << it->second.convexDecomposition << "\n";
+    }
+    return description.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<G4String> CachedCADMesh::GetSourceFiles()
+{
+    return std::vector<G4String>(SourceFiles().begin(), SourceFiles().end());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String CachedCADMesh::SelectLevelOfDetail(const G4String& meshPath)
+{
+    const MeshSettings* settings = FindSettings(meshPath);
+    if(!settings || settings->levelOfDetail<=0.) return meshPath;
+
+    const G4String lodPath = MeshDecimation::GetLevelOfDetailFileName(meshPath, settings->levelOfDetail);
+    struct stat status;
+    if(stat(lodPath.c_str(), &status)==0) return lodPath;
+
+    G4ExceptionDescription message;
+    message << "No " << settings->levelOfDetail/um << " um level of detail of " << meshPath << "\n"
+    << "(generate it with: MeshDecimator -tolerance " << settings->levelOfDetail/mm << " " << meshPath << ")\n"
+    << "The full mesh is used.";
+    G4Exception("CachedCADMesh::SelectLevelOfDetail()", "CachedCADMesh0001", JustWarning, message);
+    return meshPath;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String CachedCADMesh::SelectConvexDecomposition(const G4String& meshPath)
+{
+    const MeshSettings* settings = FindSettings(meshPath);
+    if(!settings || !settings->convexDecomposition) return "";
+
+    const G4String decompositionPath = MeshConvexDecomposition::GetDecompositionFileName(meshPath);
+    struct stat status;
+    if(stat(decompositionPath.c_str(), &status)==0) return decompositionPath;
+
+    G4ExceptionDescription message;
+    message << "No convex decomposition of " << meshPath << "\n"
+    << "(generate it with: MeshConvexDecomposer " << meshPath << ")\n"
+    << "The tessellated solid is used.";
+    G4Exception("CachedCADMesh::SelectConvexDecomposition()", "CachedCADMesh0002", JustWarning, message);
+    return "";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CachedCADMesh::Load()
+{
+    LoadSlot slot;
+
+    if(!fDecompositionFile.empty())
+    {
+        if(MeshConvexDecomposition::ReadPLY(fDecompositionFile, fPieces)) return;
+        fPieces.clear();
+    }
+
+    fHaveSource = HashFile(fMeshPath, fSourceSize, fSourceHash);
+
+    if(!ReadCache())
+    {
+        for(std::size_t i=0; i<fFacets.size(); i++) delete fFacets[i];
+        fFacets.clear();
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool CachedCADMesh::ReadCache()
+{
+    int fd = open(fCacheFile.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat fileStatus;
+    if(fstat(fd, &fileStatus)!=0 || fileStatus.st_size < (off_t) sizeof(CADMeshCacheHeader))
+    {
+        close(fd);
+        return false;
+    }
+
+    const std::size_t mappingSize = fileStatus.st_size;
+    void* mapping = mmap(0, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(mapping==MAP_FAILED) return false;
+
+    ////    The facets are read once, front to back
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+
+    //------------------------------------------------
+    //      Validate the header against this mesh and its source file
+    const CADMeshCacheHeader* header = static_cast<const CADMeshCacheHeader*>(mapping);
+
+    G4bool valid = (std::memcmp(header->magic, kMeshCacheMagic, sizeof(kMeshCacheMagic))==0)
+    && (header->version==kVersion)
+    && (header->headerSize==sizeof(CADMeshCacheHeader))
+    && (header->scale==fScale)
+    && (header->offset[0]==fOffset.x()) && (header->offset[1]==fOffset.y()) && (header->offset[2]==fOffset.z())
+    && ((header->reverse!=0)==fReverse)
+    && (header->nFacets>0)
+    && (header->nVertices<=0xffffffffu)
+    && (sizeof(CADMeshCacheHeader) + header->nVertices*3*sizeof(double) + header->nFacets*3*sizeof(std::uint32_t) <= mappingSize);
+
+    ////    Without the mesh itself, any valid cache of the same name is accepted
+    if(valid && fHaveSource)
+    {
+        valid = (header->sourceSize==fSourceSize) && (header->sourceHash==fSourceHash);
+    }
+
+    if(valid)
+    {
+        const double* vertices = reinterpret_cast<const double*>(static_cast<const char*>(mapping) + sizeof(CADMeshCacheHeader));
+        const std::uint32_t* indices = reinterpret_cast<const std::uint32_t*>(vertices + 3*header->nVertices);
+
+        fFacets.reserve(header->nFacets);
+
+        for(std::uint64_t i=0; i<header->nFacets && valid; i++)
+        {
+            G4ThreeVector corner[3];
+            for(int j=0; j<3 && valid; j++)
+            {
+                const std::uint32_t index = indices[3*i + j];
+                valid = (index < header->nVertices);
+                if(valid) corner[j] = G4ThreeVector(vertices[3*index], vertices[3*index + 1], vertices[3*index + 2]);
+            }
+            if(!valid) break;
+
+            G4TriangularFacet* facet = new G4TriangularFacet(corner[0], corner[1], corner[2], ABSOLUTE);
+            fFacets.push_back(facet);
+            valid = facet->IsDefined();
+        }
+    }
+
+    munmap(mapping, mappingSize);
+
+    return valid;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VSolid* CachedCADMesh::TessellatedMesh()
+{
+    if(fLoader.joinable()) fLoader.join();
+
+    if(!fPieces.empty()) return ConvexUnion();
+
+    //------------------------------------------------
+    //      From the cache
+    if(!fFacets.empty())
+    {
+        G4TessellatedSolid* solid = new G4TessellatedSolid(fMeshPath);
+        for(std::size_t i=0; i<fFacets.size(); i++) solid->AddFacet(fFacets[i]);
+
+        ////    The voxels are built when the solid is closed
+        if(fMaxVoxels>0) solid->SetMaxVoxels(fMaxVoxels);
+        solid->SetSolidClosed(true);
+
+        G4cout << "CachedCADMesh: " << fFacets.size() << " facets of " << fMeshPath << " from " << fCacheFile << G4endl;
+
+        fFacets.clear();
+        return solid;
+    }
+
+    //------------------------------------------------
+    //      Imported by CADMesh, as before (the CADMesh is kept, as it may own the imported scene)
+    std::vector<char> meshPath(fMeshPath.c_str(), fMeshPath.c_str() + fMeshPath.length() + 1);
+    std::vector<char> meshType(fMeshType.c_str(), fMeshType.c_str() + fMeshType.length() + 1);
+
+    CADMesh* mesh = new CADMesh(&meshPath[0], &meshType[0], fScale, fOffset, fReverse);
+    G4VSolid* solid = mesh->TessellatedMesh();
+
+    ////    A read-only directory only costs the import on the next start
+    const G4TessellatedSolid* tessellatedSolid = dynamic_cast<const G4TessellatedSolid*>(solid);
+    if(fHaveSource && tessellatedSolid && SaveCache(tessellatedSolid))
+    {
+        G4cout << "CachedCADMesh: wrote the mesh cache " << fCacheFile << G4endl;
+
+        ////    CADMesh has closed the solid with the default voxels: rebuild it from the new cache
+        if(fMaxVoxels>0 && ReadCache())
+        {
+            delete solid;
+            return TessellatedMesh();
+        }
+    }
+
+    return solid;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VSolid* CachedCADMesh::ConvexUnion()
+{
+    G4MultiUnion* solid = new G4MultiUnion(fMeshPath);
+    G4Transform3D placement;
+    std::size_t nFacets = 0;
+
+    for(std::size_t i=0; i<fPieces.size(); i++)
+    {
+        const TriangleMesh& piece = fPieces[i];
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "_convex%zu", i);
+        G4TessellatedSolid* part = new G4TessellatedSolid(fMeshPath + name);
+
+        ////    Scaled and offset as by CADMesh; the hulls are outward whatever the orientation of the mesh
+        for(std::size_t t=0; t<piece.GetNumberOfTriangles(); t++)
+        {
+            G4ThreeVector corner[3];
+            for(int j=0; j<3; j++)
+            {
+                const double* v = &piece.vertices[3*piece.triangles[3*t + j]];
+                corner[j] = G4ThreeVector(v[0], v[1], v[2])*fScale + fOffset;
+            }
+            G4TriangularFacet* facet = new G4TriangularFacet(corner[0], corner[1], corner[2], ABSOLUTE);
+            if(part->AddFacet(facet)) nFacets++;
+        }
+        part->SetSolidClosed(true);
+
+        solid->AddNode(*part, placement);
+    }
+    solid->Voxelize();
+
+    G4cout << "CachedCADMesh: " << fPieces.size() << " convex pieces (" << nFacets << " facets) of " << fMeshPath
+    << " from " << fDecompositionFile << G4endl;
+
+    fPieces.clear();
+    return solid;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool CachedCADMesh::SaveCache(const G4TessellatedSolid* solid) const
+{
+    ////    Shared vertices; facets with more than three vertices are split into triangles
+    std::map<std::vector<double>, std::uint32_t> vertexIndex;
+    std::vector<double> vertices;
+    std::vector<std::uint32_t> indices;
+
+    for(G4int i=0; i<solid->GetNumberOfFacets(); i++)
+    {
+        const G4VFacet* facet = solid->GetFacet(i);
+        const G4int nCorners = facet->GetNumberOfVertices();
+
+        std::vector<std::uint32_t> corners(nCorners);
+        for(G4int j=0; j<nCorners; j++)
+        {
+            const G4ThreeVector vertex = facet->GetVertex(j);
+            std::vector<double> key(3);
+            key[0] = vertex.x();
+            key[1] = vertex.y();
+            key[2] = vertex.z();
+
+            std::map<std::vector<double>, std::uint32_t>::const_iterator found = vertexIndex.find(key);
+            if(found==vertexIndex.end())
+            {
+                const std::uint32_t index = vertices.size()/3;
+                vertexIndex[key] = index;
+                vertices.insert(vertices.end(), key.begin(), key.end());
+                corners[j] = index;
+            }
+            else corners[j] = found->second;
+        }
+
+        for(G4int j=1; j+1<nCorners; j++)
+        {
+            indices.push_back(corners[0]);
+            indices.push_back(corners[j]);
+            indices.push_back(corners[j+1]);
+        }
+    }
+
+    if(indices.empty()) return false;
+
+    CADMeshCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMeshCacheMagic, sizeof(kMeshCacheMagic));
+    header.version = kVersion;
+    header.headerSize = sizeof(CADMeshCacheHeader);
+    header.nVertices = vertices.size()/3;
+    header.nFacets = indices.size()/3;
+    header.sourceSize = fSourceSize;
+    header.sourceHash = fSourceHash;
+    header.scale = fScale;
+    header.offset[0] = fOffset.x();
+    header.offset[1] = fOffset.y();
+    header.offset[2] = fOffset.z();
+    header.reverse = fReverse;
+
+    ////    Written under a temporary name and renamed, so that concurrent jobs never see a partial cache
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".tmp%ld", (long) getpid());
+    const G4String temporaryFile = fCacheFile + suffix;
+
+    std::FILE* file = std::fopen(temporaryFile.c_str(), "wb");
+    if(!file) return false;
+
+    G4bool written = (std::fwrite(&header, sizeof(header), 1, file)==1)
+    && (std::fwrite(&vertices[0], sizeof(double), vertices.size(), file)==vertices.size())
+    && (std::fwrite(&indices[0], sizeof(std::uint32_t), indices.size(), file)==indices.size());
+
+    written = (std::fclose(file)==0) && written;
+
+    if(!written || std::rename(temporaryFile.c_str(), fCacheFile.c_str())!=0)
+    {
+        std::remove(temporaryFile.c_str());
+        return false;
+    }
+
+    return true;
+}
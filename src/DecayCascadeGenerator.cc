@@ -0,0 +1,797 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "DecayCascadeGenerator.hh"
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4ParticleTable.hh"
+#include "G4IonTable.hh"
+#include "G4Gamma.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    ////    Same mass unit as BiRelKin / BinaryReactionKinematics
+    const double kc2 = 931.494;             // MeV/u
+
+    ////    Resolution of the tabulated angular samplers
+    const int kSamplerPoints = 721;
+
+    ////    Guards against decay schemes with loops
+    const int kMaxCascadeDepth = 32;
+
+    ////    Attempts at finding a kinematically allowed ejectile angle
+    const int kMaxReactionAttempts = 100;
+
+    ////    Relative weights of a cascade file must be explicit, positive numbers
+    bool ParseWeight(const std::string& token, double& weight)
+    {
+        if(token.empty() || token=="?") return false;
+
+        char* end = 0;
+        weight = std::strtod(token.c_str(), &end);
+
+        return *end=='\0' && weight>0.0;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+AngularDistributionSampler::AngularDistributionSampler()
+: fIsotropic(true)
+{
+    SetIsotropic();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AngularDistributionSampler::SetIsotropic()
+{
+    SetTable(0, 0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AngularDistributionSampler::SetTable(const double (*table)[2], int nPoints, double thetaMin, double thetaMax)
+{
+    fTheta.assign(kSamplerPoints, 0.0);
+    fCDF.assign(kSamplerPoints, 0.0);
+
+    ////    Without a table the density is flat in cos(theta) over the range
+    fIsotropic = (table==0 || nPoints<2);
+
+    const double dTheta = (thetaMax - thetaMin)/(kSamplerPoints-1);
+    double previousDensity = 0.0;
+
+    for(int i=0; i<kSamplerPoints; i++)
+    {
+        const double theta = thetaMin + i*dTheta;
+        double W = 1.0;
+
+        if(!fIsotropic)
+        {
+            ////    Linear interpolation in the (ascending) table, clamped at its ends
+            int j = 0;
+            while(j<nPoints-2 && theta>=table[j+1][0]) j++;
+
+            const double x1 = table[j][0], x2 = table[j+1][0];
+            const double y1 = table[j][1], y2 = table[j+1][1];
+            const double t = std::min(std::max((theta - x1)/(x2 - x1), 0.0), 1.0);
+
+            W = std::max(y1 + t*(y2 - y1), 0.0);
+        }
+
+        const double density = W*std::sin(theta*deg);
+
+        fTheta[i] = theta;
+        if(i>0) fCDF[i] = fCDF[i-1] + 0.5*(density + previousDensity)*dTheta;
+        previousDensity = density;
+    }
+
+    const double total = fCDF.back();
+
+    if(total>0.0)
+    {
+        for(int i=0; i<kSamplerPoints; i++) fCDF[i] /= total;
+    }
+    else
+    {
+        ////    Degenerate table (e.g. a single angle): fall back to a flat CDF
+        for(int i=0; i<kSamplerPoints; i++) fCDF[i] = double(i)/(kSamplerPoints-1);
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double AngularDistributionSampler::Sample() const
+{
+    const double u = G4UniformRand();
+
+    std::vector<double>::const_iterator it = std::upper_bound(fCDF.begin(), fCDF.end(), u);
+
+    if(it==fCDF.begin()) return fTheta.front();
+    if(it==fCDF.end()) return fTheta.back();
+
+    const int i = int(it - fCDF.begin());
+    const double t = (u - fCDF[i-1])/(fCDF[i] - fCDF[i-1]);
+
+    return fTheta[i-1] + t*(fTheta[i] - fTheta[i-1]);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DecayCascadeGenerator::DecayCascadeGenerator()
+: fProjectile(0),
+fTarget(0),
+fEjectile(0),
+fRecoilZ(0),
+fRecoilA(0),
+fBeamEnergy(0.0),
+fEjectileThetaMin(0.0),
+fEjectileThetaMax(180.0),
+fEjectileTable(0),
+fEjectileTableN(0),
+fEmitEjectile(false),
+fEmitResiduals(false),
+fInitialised(false),
+fLastExcitationEnergy(0.0),
+fLastEjectileTheta(0.0),
+fLastFirstProductEnergy(0.0),
+fLastFirstProductTheta(0.0),
+fLastFirstProductPhi(0.0),
+fFirstProductRecorded(false)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DecayCascadeGenerator::~DecayCascadeGenerator()
+{
+    for(size_t i=0; i<fReactionKinematics.size(); i++) delete fReactionKinematics[i];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecayCascadeGenerator::SetReaction(G4ParticleDefinition* projectile, G4ParticleDefinition* target,
+                                        G4ParticleDefinition* ejectile, G4int recoilZ, G4int recoilA)
+{
+    fProjectile = projectile;
+    fTarget = target;
+    fEjectile = ejectile;
+    fRecoilZ = recoilZ;
+    fRecoilA = recoilA;
+    fInitialised = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecayCascadeGenerator::SetBeamEnergy(G4double beamEnergy)
+{
+    fBeamEnergy = beamEnergy;
+    fInitialised = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecayCascadeGenerator::SetEjectileAngularRange(G4double thetaMin, G4double thetaMax)
+{
+    fEjectileThetaMin = thetaMin;
+    fEjectileThetaMax = thetaMax;
+    fEjectileTable = 0;
+    fEjectileTableN = 0;
+    fInitialised = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecayCascadeGenerator::SetEjectileAngularDistribution(const double (*table)[2], int nPoints, G4double thetaMin, G4double thetaMax)
+{
+    fEjectileThetaMin = thetaMin;
+    fEjectileThetaMax = thetaMax;
+    fEjectileTable = table;
+    fEjectileTableN = nPoints;
+    fInitialised = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int DecayCascadeGenerator::AddLevel(G4int Z, G4int A, G4double excitationEnergy)
+{
+    Level level;
+    level.Z = Z;
+    level.A = A;
+    level.excitationEnergy = excitationEnergy;
+    level.mass = 0.0;
+    level.ion = 0;
+
+    fLevels.push_back(level);
+    fInitialised = false;
+
+    return G4int(fLevels.size()) - 1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecayCascadeGenerator::AddPopulatedLevel(G4int level, G4double weight)
+{
+    fPopulatedLevels.push_back(level);
+    fPopulatedWeights.push_back(weight);
+    fInitialised = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int DecayCascadeGenerator::AddGammaTransition(const G4String& name, G4int initialLevel, G4int finalLevel, G4double branching,
+                                                const double (*angCor)[2], int nPoints)
+{
+    return AddTransition(name, initialLevel, finalLevel, G4Gamma::Definition(), branching, angCor, nPoints);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int DecayCascadeGenerator::AddParticleTransition(const G4String& name, G4int initialLevel, G4int finalLevel,
+                                                   G4ParticleDefinition* particle, G4double branching,
+                                                   const double (*angCor)[2], int nPoints)
+{
+    return AddTransition(name, initialLevel, finalLevel, particle, branching, angCor, nPoints);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int DecayCascadeGenerator::AddTransition(const G4String& name, G4int initialLevel, G4int finalLevel,
+                                           G4ParticleDefinition* particle, G4double branching,
+                                           const double (*angCor)[2], int nPoints)
+{
+    Transition transition;
+    transition.name = name;
+    transition.initialLevel = initialLevel;
+    transition.finalLevel = finalLevel;
+    transition.particle = particle;
+    transition.branching = branching;
+    transition.particleMass = 0.0;
+    transition.momentum = 0.0;
+    transition.particleEnergy = 0.0;
+    transition.angCor = angCor;
+    transition.nPoints = nPoints;
+
+    fTransitions.push_back(transition);
+    fInitialised = false;
+
+    return G4int(fTransitions.size()) - 1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecayCascadeGenerator::RegisterAngularTable(const G4String& name, const double (*table)[2], int nPoints)
+{
+    fAngularTables[name] = std::make_pair(table, nPoints);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool DecayCascadeGenerator::FindAngularTable(const G4String& name, const double (*&table)[2], int& nPoints)
+{
+    std::map<G4String, std::pair<const double (*)[2], int>>::const_iterator it = fAngularTables.find(name);
+
+    if(it!=fAngularTables.end())
+    {
+        table = it->second.first;
+        nPoints = it->second.second;
+        return true;
+    }
+
+    ////    Otherwise a two-column (theta/deg, W) text file, in ascending theta
+    std::ifstream file(name.c_str());
+    if(!file) return false;
+
+    std::vector<double> theta, W;
+    std::string line;
+
+    while(std::getline(file, line))
+    {
+        const std::string::size_type comment = line.find('#');
+        if(comment!=std::string::npos) line.erase(comment);
+
+        std::istringstream fields(line);
+        double x = 0.0, y = 0.0;
+        if(!(fields >> x >> y)) continue;
+
+        if(!theta.empty() && !(x>theta.back())) return false;
+
+        theta.push_back(x);
+        W.push_back(y);
+    }
+
+    if(theta.size()<2) return false;
+
+    nPoints = int(theta.size());
+
+    std::unique_ptr<double[][2]> fileTable(new double[nPoints][2]);
+    for(int i=0; i<nPoints; i++)
+    {
+        fileTable[i][0] = theta[i];
+        fileTable[i][1] = W[i];
+    }
+
+    table = fileTable.get();
+    fFileTables.push_back(std::move(fileTable));
+    RegisterAngularTable(name, table, nPoints);
+
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool DecayCascadeGenerator::ReadFile(const G4String& filename)
+{
+    std::ifstream file(filename.c_str());
+
+    if(!file)
+    {
+        G4ExceptionDescription msg;
+        msg << "The cascade file " << filename << " could not be opened.";
+        G4Exception("DecayCascadeGenerator::ReadFile()", "DecayCascade0008", JustWarning, msg);
+        return false;
+    }
+
+    G4ParticleTable* particleTable = G4ParticleTable::GetParticleTable();
+    G4IonTable* ionTable = G4IonTable::GetIonTable();
+
+    std::map<std::string, G4int> levels;
+    G4bool beamEnergyGiven = false;
+
+    std::string line, error;
+    G4int lineNumber = 0;
+
+    while(error.empty() && std::getline(file, line))
+    {
+        lineNumber++;
+
+        const std::string::size_type comment = line.find('#');
+        if(comment!=std::string::npos) line.erase(comment);
+
+        std::istringstream fields(line);
+        std::string key;
+        if(!(fields >> key)) continue;
+
+        if(key=="reaction")
+        {
+            std::string projectile, ejectile;
+            G4int targetZ = 0, targetA = 0, recoilZ = 0, recoilA = 0;
+
+            if(!(fields >> projectile >> targetZ >> targetA >> ejectile >> recoilZ >> recoilA))
+            {
+                error = "expected: reaction <projectile> <targetZ> <targetA> <ejectile> <recoilZ> <recoilA>";
+            }
+            else
+            {
+                G4ParticleDefinition* projectileDefinition = particleTable->FindParticle(projectile);
+                G4ParticleDefinition* ejectileDefinition = particleTable->FindParticle(ejectile);
+                G4ParticleDefinition* targetDefinition = ionTable->GetIon(targetZ, targetA, 0.0);
+
+                if(!projectileDefinition || !ejectileDefinition || !targetDefinition) error = "unknown projectile, target or ejectile";
+                else SetReaction(projectileDefinition, targetDefinition, ejectileDefinition, recoilZ, recoilA);
+            }
+        }
+        else if(key=="beamEnergy")
+        {
+            G4double beamEnergy = 0.0;
+
+            if(!(fields >> beamEnergy) || !(beamEnergy>0.0)) error = "expected: beamEnergy <T/MeV>, with T > 0";
+            else
+            {
+                SetBeamEnergy(beamEnergy*MeV);
+                beamEnergyGiven = true;
+            }
+        }
+        else if(key=="ejectileAngles")
+        {
+            G4double thetaMin = 0.0, thetaMax = 0.0;
+            std::string tableName;
+            const double (*table)[2] = 0;
+            int nPoints = 0;
+
+            if(!(fields >> thetaMin >> thetaMax) || thetaMin<0.0 || thetaMax>180.0 || !(thetaMin<thetaMax))
+            {
+                error = "expected: ejectileAngles <thetaMin/deg> <thetaMax/deg> [table], within [0, 180] deg";
+            }
+            else if(fields >> tableName)
+            {
+                if(!FindAngularTable(tableName, table, nPoints)) error = "unknown or unreadable angular table " + tableName;
+                else SetEjectileAngularDistribution(table, nPoints, thetaMin, thetaMax);
+            }
+            else SetEjectileAngularRange(thetaMin, thetaMax);
+        }
+        else if(key=="level")
+        {
+            std::string name;
+            G4int Z = 0, A = 0;
+            G4double excitationEnergy = 0.0;
+
+            if(!(fields >> name >> Z >> A >> excitationEnergy) || excitationEnergy<0.0) error = "expected: level <name> <Z> <A> <Ex/MeV>";
+            else if(levels.count(name)) error = "level " + name + " is defined twice";
+            else levels[name] = AddLevel(Z, A, excitationEnergy*MeV);
+        }
+        else if(key=="populate")
+        {
+            std::string name, weight;
+            G4double value = 0.0;
+
+            if(!(fields >> name >> weight)) error = "expected: populate <level> <weight>";
+            else if(!levels.count(name)) error = "undefined level " + name;
+            else if(!ParseWeight(weight, value)) error = "the population weight of " + name + " is not a positive number (placeholder?)";
+            else AddPopulatedLevel(levels[name], value);
+        }
+        else if(key=="transition")
+        {
+            std::string name, initialLevel, finalLevel, particle, branching, tableName;
+            G4double value = 0.0;
+            const double (*table)[2] = 0;
+            int nPoints = 0;
+
+            if(!(fields >> name >> initialLevel >> finalLevel >> particle >> branching))
+            {
+                error = "expected: transition <name> <initialLevel> <finalLevel> <particle|gamma> <branching> [table]";
+            }
+            else if(!levels.count(initialLevel) || !levels.count(finalLevel)) error = "transition " + name + " refers to an undefined level";
+            else if(!ParseWeight(branching, value)) error = "the branching ratio of " + name + " is not a positive number (placeholder?)";
+            else if((fields >> tableName) && !FindAngularTable(tableName, table, nPoints)) error = "unknown or unreadable angular table " + tableName;
+            else if(particle=="gamma") AddGammaTransition(name, levels[initialLevel], levels[finalLevel], value, table, nPoints);
+            else
+            {
+                G4ParticleDefinition* particleDefinition = particleTable->FindParticle(particle);
+
+                if(!particleDefinition) error = "unknown particle " + particle;
+                else AddParticleTransition(name, levels[initialLevel], levels[finalLevel], particleDefinition, value, table, nPoints);
+            }
+        }
+        else if(key=="emitEjectile" || key=="emitResiduals")
+        {
+            G4int emit = 0;
+
+            if(!(fields >> emit)) error = "expected: " + key + " <0|1>";
+            else if(key=="emitEjectile") SetEmitEjectile(emit!=0);
+            else SetEmitResiduals(emit!=0);
+        }
+        else error = "unknown keyword " + key;
+    }
+
+    if(error.empty() && (!fProjectile || !beamEnergyGiven || fPopulatedLevels.empty()))
+    {
+        error = "the reaction, the beam energy and at least one populated level are required";
+        lineNumber = 0;
+    }
+
+    if(!error.empty())
+    {
+        G4ExceptionDescription msg;
+        msg << filename;
+        if(lineNumber>0) msg << ", line " << lineNumber;
+        msg << ": " << error;
+        G4Exception("DecayCascadeGenerator::ReadFile()", "DecayCascade0009", JustWarning, msg);
+        return false;
+    }
+
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool DecayCascadeGenerator::Initialise()
+{
+    fInitialised = false;
+
+    if(!fProjectile || !fTarget || !fEjectile || fPopulatedLevels.empty())
+    {
+        G4Exception("DecayCascadeGenerator::Initialise()", "DecayCascade0001", JustWarning,
+                    "The reaction or the populated levels have not been defined.");
+        return false;
+    }
+
+    G4IonTable* ionTable = G4IonTable::GetIonTable();
+
+    //------------------------------------------------
+    //      Level masses and the ions emitted at the end of a cascade
+    for(size_t i=0; i<fLevels.size(); i++)
+    {
+        Level& level = fLevels[i];
+        level.mass = ionTable->GetIonMass(level.Z, level.A) + level.excitationEnergy;
+        level.ion = fEmitResiduals ? ionTable->GetIon(level.Z, level.A, level.excitationEnergy) : 0;
+        level.transitions.clear();
+        level.branchingCDF.clear();
+    }
+
+    //------------------------------------------------
+    //      Two-body decay momenta and angular samplers of the transitions
+    for(size_t t=0; t<fTransitions.size(); t++)
+    {
+        Transition& transition = fTransitions[t];
+
+        if(transition.initialLevel<0 || transition.initialLevel>=G4int(fLevels.size())
+           || transition.finalLevel<0 || transition.finalLevel>=G4int(fLevels.size()) || !transition.particle)
+        {
+            G4ExceptionDescription msg;
+            msg << "Transition " << transition.name << " refers to an undefined level or particle, it is ignored.";
+            G4Exception("DecayCascadeGenerator::Initialise()", "DecayCascade0002", JustWarning, msg);
+            continue;
+        }
+
+        const Level& parent = fLevels[transition.initialLevel];
+        const Level& daughter = fLevels[transition.finalLevel];
+
+        const G4double M = parent.mass;
+        const G4double m1 = transition.particle->GetPDGMass();
+        const G4double m2 = daughter.mass;
+
+        if(M <= m1 + m2)
+        {
+            G4ExceptionDescription msg;
+            msg << "Transition " << transition.name << " is not energetically allowed, it is ignored.";
+            G4Exception("DecayCascadeGenerator::Initialise()", "DecayCascade0003", JustWarning, msg);
+            continue;
+        }
+
+        transition.particleMass = m1;
+        transition.momentum = std::sqrt((M*M - (m1+m2)*(m1+m2))*(M*M - (m1-m2)*(m1-m2)))/(2.0*M);
+        transition.particleEnergy = std::sqrt(transition.momentum*transition.momentum + m1*m1);
+
+        if(transition.angCor) transition.sampler.SetTable(transition.angCor, transition.nPoints);
+        else transition.sampler.SetIsotropic();
+
+        fLevels[transition.initialLevel].transitions.push_back(G4int(t));
+    }
+
+    ////    Branching CDFs, normalised per level
+    for(size_t i=0; i<fLevels.size(); i++)
+    {
+        Level& level = fLevels[i];
+        G4double sum = 0.0;
+
+        for(size_t j=0; j<level.transitions.size(); j++)
+        {
+            sum += fTransitions[level.transitions[j]].branching;
+            level.branchingCDF.push_back(sum);
+        }
+
+        if(!level.transitions.empty() && !(sum>0.0))
+        {
+            G4ExceptionDescription msg;
+            msg << "The branching ratios of the level at " << level.excitationEnergy/MeV << " MeV (Z=" << level.Z
+            << ", A=" << level.A << ") do not sum to a positive value.";
+            G4Exception("DecayCascadeGenerator::Initialise()", "DecayCascade0006", JustWarning, msg);
+            return false;
+        }
+
+        for(size_t j=0; j<level.branchingCDF.size(); j++) level.branchingCDF[j] /= sum;
+    }
+
+    //------------------------------------------------
+    //      Reaction: one cached kinematics engine per populated level
+    for(size_t i=0; i<fReactionKinematics.size(); i++) delete fReactionKinematics[i];
+    fReactionKinematics.clear();
+    fPopulatedCDF.clear();
+
+    const G4double recoilGroundStateMass = ionTable->GetIonMass(fRecoilZ, fRecoilA);
+
+    double m[4];
+    m[0] = fProjectile->GetPDGMass()/kc2;
+    m[1] = fTarget->GetPDGMass()/kc2;
+    m[2] = fEjectile->GetPDGMass()/kc2;
+    m[3] = recoilGroundStateMass/kc2;
+
+    G4double sum = 0.0;
+
+    for(size_t i=0; i<fPopulatedLevels.size(); i++)
+    {
+        const G4int level = fPopulatedLevels[i];
+
+        if(level<0 || level>=G4int(fLevels.size()) || fLevels[level].Z!=fRecoilZ || fLevels[level].A!=fRecoilA)
+        {
+            G4Exception("DecayCascadeGenerator::Initialise()", "DecayCascade0004", JustWarning,
+                        "A populated level does not belong to the recoil nucleus.");
+            return false;
+        }
+
+        fReactionKinematics.push_back(new BinaryReactionKinematics(m, fBeamEnergy/MeV, 0.0, fLevels[level].excitationEnergy/MeV));
+
+        sum += fPopulatedWeights[i];
+        fPopulatedCDF.push_back(sum);
+    }
+
+    if(!(sum>0.0))
+    {
+        G4Exception("DecayCascadeGenerator::Initialise()", "DecayCascade0007", JustWarning,
+                    "The weights of the populated levels do not sum to a positive value.");
+        return false;
+    }
+
+    for(size_t i=0; i<fPopulatedCDF.size(); i++) fPopulatedCDF[i] /= sum;
+
+    if(fEjectileTable) fEjectileSampler.SetTable(fEjectileTable, fEjectileTableN, fEjectileThetaMin, fEjectileThetaMax);
+    else fEjectileSampler.SetTable(0, 0, fEjectileThetaMin, fEjectileThetaMax);
+
+    fInitialised = true;
+
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int DecayCascadeGenerator::SampleCDF(const std::vector<G4double>& cdf) const
+{
+    const G4double u = G4UniformRand();
+
+    ////    Decay schemes have a handful of branches per level: a linear scan is cheapest
+    for(size_t i=0; i<cdf.size(); i++)
+    {
+        if(u<cdf[i]) return G4int(i);
+    }
+
+    return G4int(cdf.size()) - 1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecayCascadeGenerator::GeneratePrimaries(G4Event* anEvent, const G4ThreeVector& position)
+{
+    if(!fInitialised && !Initialise()) return;
+
+    G4PrimaryVertex* vertex = new G4PrimaryVertex(position, 0.0*ns);
+
+    fLastDecayPath = "";
+    fFirstProductRecorded = false;
+
+    //------------------------------------------------
+    //      Reaction
+    const G4int populated = SampleCDF(fPopulatedCDF);
+    const G4int level = fPopulatedLevels[populated];
+    const BinaryReactionKinematics* kinematics = fReactionKinematics[populated];
+
+    BinaryReactionKinematicsResult result;
+    G4double thetaEjectile = 0.0;
+    G4bool allowed = false;
+
+    for(G4int attempt=0; attempt<kMaxReactionAttempts && !allowed; attempt++)
+    {
+        thetaEjectile = fEjectileSampler.Sample();
+        kinematics->Evaluate(thetaEjectile, result);
+        allowed = std::isfinite(result.T2) && std::isfinite(result.p3) && std::isfinite(result.thetaRecoil) && result.T2>0.0;
+    }
+
+    if(!allowed)
+    {
+        G4Exception("DecayCascadeGenerator::GeneratePrimaries()", "DecayCascade0005", EventMustBeAborted,
+                    "No kinematically allowed ejectile angle was found.");
+        delete vertex;
+        return;
+    }
+
+    const G4double phiEjectile = 360.0*G4UniformRand();
+
+    G4ThreeVector ejectileDirection;
+    ejectileDirection.setRThetaPhi(1.0, thetaEjectile*deg, phiEjectile*deg);
+
+    G4ThreeVector recoilDirection;
+    recoilDirection.setRThetaPhi(1.0, result.thetaRecoil*deg, (phiEjectile + 180.0)*deg);
+
+    if(fEmitEjectile)
+    {
+        const G4double ejectileMass = fEjectile->GetPDGMass();
+        const G4double ejectileMomentum = std::sqrt(result.T2*MeV*(result.T2*MeV + 2.0*ejectileMass));
+        AddPrimary(fEjectile, G4LorentzVector(ejectileMomentum*ejectileDirection, result.T2*MeV + ejectileMass), vertex);
+    }
+
+    ////    BiRelKin momenta are in units of MeV/sqrt(c^2)
+    const G4double recoilMomentum = result.p3*std::sqrt(kc2)*MeV;
+    const G4double recoilMass = fLevels[level].mass;
+
+    G4LorentzVector recoil(recoilMomentum*recoilDirection, std::sqrt(recoilMomentum*recoilMomentum + recoilMass*recoilMass));
+
+    fLastExcitationEnergy = fLevels[level].excitationEnergy;
+    fLastEjectileTheta = thetaEjectile;
+
+    //------------------------------------------------
+    //      Decay cascade
+    Decay(level, recoil, vertex);
+
+    anEvent->AddPrimaryVertex(vertex);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecayCascadeGenerator::Decay(G4int levelIndex, const G4LorentzVector& fourMomentum, G4PrimaryVertex* vertex)
+{
+    G4LorentzVector parent = fourMomentum;
+
+    for(G4int depth=0; depth<kMaxCascadeDepth; depth++)
+    {
+        const Level& level = fLevels[levelIndex];
+
+        if(level.transitions.empty()) break;
+
+        const Transition& transition = fTransitions[level.transitions[SampleCDF(level.branchingCDF)]];
+
+        ////    Emission about the direction of motion of the parent (beam axis if at rest)
+        G4ThreeVector axis = parent.vect();
+        axis = (axis.mag2()>0.0) ? axis.unit() : G4ThreeVector(0.0, 0.0, 1.0);
+
+        const G4double theta = transition.sampler.Sample()*deg;
+        const G4double phi = twopi*G4UniformRand();
+
+        G4ThreeVector direction(std::sin(theta)*std::cos(phi), std::sin(theta)*std::sin(phi), std::cos(theta));
+        direction.rotateUz(axis);
+
+        G4LorentzVector product(transition.momentum*direction, transition.particleEnergy);
+        product.boost(parent.boostVector());
+
+        G4PrimaryParticle* primary = AddPrimary(transition.particle, product, vertex);
+
+        if(!fFirstProductRecorded)
+        {
+            fLastFirstProductEnergy = primary->GetKineticEnergy();
+            fLastFirstProductTheta = product.vect().theta()/deg;
+            fLastFirstProductPhi = product.vect().phi()/deg;
+            fFirstProductRecorded = true;
+        }
+
+        if(fLastDecayPath.size()) fLastDecayPath += " ";
+        fLastDecayPath += transition.name;
+
+        parent -= product;
+        levelIndex = transition.finalLevel;
+    }
+
+    if(fEmitResiduals && fLevels[levelIndex].ion) AddPrimary(fLevels[levelIndex].ion, parent, vertex);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4PrimaryParticle* DecayCascadeGenerator::AddPrimary(G4ParticleDefinition* particle, const G4LorentzVector& fourMomentum, G4PrimaryVertex* vertex)
+{
+    G4PrimaryParticle* primary = new G4PrimaryParticle(particle, fourMomentum.px(), fourMomentum.py(), fourMomentum.pz());
+    vertex->SetPrimary(primary);
+
+    return primary;
+}
@@ -55,6 +55,7 @@
 #include "G4MaterialPropertiesTable.hh"
 #include "G4LogicalVolume.hh"
 #include "G4PVPlacement.hh"
+#include "G4PVParameterised.hh"
 #include "G4SDManager.hh"
 #include "G4GeometryTolerance.hh"
 #include "G4GeometryManager.hh"
@@ -88,42 +89,73 @@
 #include "G4Mag_UsualEqRhs.hh"
 #include "G4AutoDelete.hh"
 
-#include "CADMesh.hh"
+#include "CachedCADMesh.hh"
+#include "CLOVERParametricGeometry.hh"
+#include "DetectorParameterisations.hh"
+#include "GeometrySnapshot.hh"
 #include "MagneticFieldMapping.hh"
+#include "MultipoleFieldExpansion.hh"
+#include "K600FieldSetup.hh"
+#include "K600FieldMessenger.hh"
+#include "K600RegionMessenger.hh"
+#include "K600LayoutMessenger.hh"
+#include "SpectrometerFastSimModel.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4ProductionCuts.hh"
 //#include "G4BlineTracer.hh"
 
 #include "GeometryConstructionDANDELION3.hh"
 #include "GeoConstruct_22_03_18.hh"
 
+#include "K600GeometrySourceHash.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <sstream>
+
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 G4ThreadLocal G4GlobalMagFieldMessenger* DetectorConstruction::fMagFieldMessenger = 0;
 
-G4ThreadLocal G4QuadrupoleMagField* DetectorConstruction::MagneticField_K600_Q = 0;
-G4ThreadLocal G4UniformMagField* DetectorConstruction::MagneticField_K600_D1 = 0;
-G4ThreadLocal G4UniformMagField* DetectorConstruction::MagneticField_K600_D2 = 0;
-
-G4ThreadLocal G4FieldManager* DetectorConstruction::fieldManagerMagneticField_K600_Q = 0;
-G4ThreadLocal G4FieldManager* DetectorConstruction::fieldManagerMagneticField_K600_D1 = 0;
-G4ThreadLocal G4FieldManager* DetectorConstruction::fieldManagerMagneticField_K600_D2 = 0;
+G4ThreadLocal K600FieldMessenger* DetectorConstruction::fFieldMessenger = 0;
+G4ThreadLocal K600FieldSetup* DetectorConstruction::fFieldSetup_K600_Q = 0;
+G4ThreadLocal K600FieldSetup* DetectorConstruction::fFieldSetup_K600_D1 = 0;
+G4ThreadLocal K600FieldSetup* DetectorConstruction::fFieldSetup_K600_D2 = 0;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 DetectorConstruction::DetectorConstruction()
 : G4VUserDetectorConstruction(),
-fAbsorberPV(0), fGapPV(0), fCheckOverlaps(false), PhysiCLOVER_HPGeCrystal(0), PhysiCLOVER_Shield_BGOCrystal(0), PhysiCLOVER_Shield_PMT(0), PhysiCAKE_AA_RS(0), PhysiPADDLE(0), PhysiK600_Quadrupole(0), PhysiK600_Dipole1(0), PhysiK600_Dipole2(0), PhysiHAGAR_NaICrystal(0), PhysiHAGAR_Annulus(0), PhysiHAGAR_FrontDisc(0), Physical_LEPS_HPGeCrystal(0)
+fAbsorberPV(0), fGapPV(0), fCheckOverlaps(false), PhysiCLOVER_HPGeCrystal(0), PhysiCLOVER_Shield_BGOCrystal(0), PhysiCLOVER_Shield_PMT(0), PhysiCAKE_AA_RS(0), PhysiPADDLE(0), PhysiK600_Quadrupole(0), PhysiK600_Dipole1(0), PhysiK600_Dipole2(0), PhysiK600_Envelope(0), PhysiHAGAR_NaICrystal(0), PhysiHAGAR_Annulus(0), PhysiHAGAR_FrontDisc(0), Physical_LEPS_HPGeCrystal(0)
 {
     WorldSize = 15.*m;
     setPreconfiguredVersion = false;
     for(G4int i=0; i<numberOf_LaBr3Ce; i++)
     {
         LaBr3Ce_Presence[i] = false;
+        LaBr3Ce_Distance[i] = 0.0;
+        LaBr3Ce_theta[i] = 0.0;
+        LaBr3Ce_phi[i] = 0.0;
     }
+    LaBr3CeSetupVersion = 0;
+    LaBR3Ce_GlobalDistance = 0.0;
     LaBR3Ce_SetGlobalDistance = false;
     LaBR3Ce_automaticOrientation = false;
     configuration_truncatedIcosahedron_hexagons = false;
     SetupTruncatedIcosahedron();
+    BenchmarkLayout = "";
+    fRegionMessenger = 0;
+    for(G4int i=0; i<numberOf_LaBr3Ce; i++)
+    {
+        Layout_LaBr3Ce_PV[i] = 0;
+        Layout_LaBr3Ce_Offset[i] = 0.0;
+    }
+    Layout_LaBr3Ce_MinimumDistance = 0.0;
+    for(G4int i=0; i<numberOf_CLOVER; i++) Layout_CLOVER_MinimumDistance[i] = 0.0;
+    LayoutChanges = 0;
+    fLayoutMessenger = new K600LayoutMessenger(this);
 
 }
 
@@ -131,6 +163,8 @@ fAbsorberPV(0), fGapPV(0), fCheckOverlaps(false), PhysiCLOVER_HPGeCrystal(0), Ph
 
 DetectorConstruction::~DetectorConstruction()
 {
+    delete fRegionMessenger;
+    delete fLayoutMessenger;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -374,6 +408,49 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
         DefineHPGeCrystal_Walid_2();
     }
     
+    //--------------------------------
+    ////    Parametric (CSG) HPGe crystals, lithium contacts and BGO crystals in place of the meshes,
+    ////    see CLOVERParametricGeometry.hh. Validated against the meshes with tools/CLOVERParametricValidator.
+    useCLOVER_Parametric = false;
+    
+    //--------------------------------
+    ////    Levels of detail of the CADMesh volumes: decimated meshes written by tools/MeshDecimator
+    ////    (e.g. MeshDecimator -tolerance 0.1 Body_Modified2_tol_10um.ply) replace the full ones.
+    ////    Check the navigation speed and efficiency change with benchmarks/MeshNavigationBenchmark first.
+    //CachedCADMesh::SetLevelOfDetail("Body_Modified2_tol_10um", 0.1*mm);
+    //CachedCADMesh::SetLevelOfDetail("HEAVIMET_30mm", 0.1*mm);
+    //CachedCADMesh::SetLevelOfDetail("PMT-ConnecterArray", 0.2*mm);
+    
+    ////    Heavy tessellated volumes: a larger voxelisation, or a G4MultiUnion of the convex pieces written by
+    ////    tools/MeshConvexDecomposer (e.g. MeshConvexDecomposer -tolerance 0.5 HEAVIMET_30mm.ply), which suits compact
+    ////    solids but not thin shells. Check both with benchmarks/TessellatedSolidBenchmark first.
+    //CachedCADMesh::SetMaxVoxels("Body_Modified2_tol_10um", 100000);
+    //CachedCADMesh::SetConvexDecomposition("HEAVIMET_30mm");
+    
+    //--------------------------------
+    ////    Geometry snapshot (see GeometrySnapshot.hh): written after a full construction and read back in its
+    ////    place by later runs with the same configuration (ConfigurationDescription()), geometry sources and mesh files.
+    ////    Anything else added to the geometry configuration must be added to ConfigurationDescription() too.
+    GeometrySnapshot_File = "";
+    //GeometrySnapshot_File = "K600_Geometry.snapshot";
+    
+    //--------------------------------
+    ////    Production cuts of the regions (DefineVolumes); regions without an entry use the default cut of the
+    ////    physics list. Fine cuts in the HPGe, LaBr3Ce and silicon; in the thick passive material (chambers,
+    ////    shields, PMTs) a cut this long leaves no bremsstrahlung or delta rays to be produced.
+    ////    After /run/initialize, cuts and user limits (step, track length, time, kinetic energy) can be changed
+    ////    per region with /K600/regions/<region>/ (see regions.mac).
+    RegionProductionCuts.clear();
+    RegionProductionCuts["CLOVER"] = 0.1*mm;
+    RegionProductionCuts["LEPS"] = 0.1*mm;
+    RegionProductionCuts["LaBr3Ce"] = 0.1*mm;
+    RegionProductionCuts["Silicon"] = 0.01*mm;
+    RegionProductionCuts["Passive"] = 1.*m;
+    //RegionProductionCuts["CLOVER_Shield"] = 0.7*mm;
+    //RegionProductionCuts["HAGAR"] = 0.7*mm;
+    //RegionProductionCuts["PADDLE"] = 0.7*mm;
+    //RegionProductionCuts["VDC"] = 0.7*mm;
+    
     /*
     //  CLOVER 1
     CLOVER_Presence[0] = true;
@@ -917,8 +994,20 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
     K600_Quadrupole = false;
     Ideal_Quadrupole = false;
     Mapped_Quadrupole = true;
+    Fitted_Quadrupole = false;
     //K600_Q_gradient = 0.030*tesla/cm;  // gradient = dB/dr for Ideal Quadrupole
     K600_Q_gradient = 0.001*tesla/cm;  // gradient = dB/dr for Ideal Quadrupole
+    K600_Q_MagField_rotm = new G4RotationMatrix;
+    //K600_Q_MagField_rotm->rotateX(90.*deg);
+    K600_Q_FieldMapFile = "../K600-ALBA/MagneticFieldMaps/Quadrupole_MagneticFieldMap.TABLE";
+    K600_Q_FieldMapOffset = 4.4*mm + 100*cm;
+    ////    Finer maps can be stored folded (MagneticFieldMapOptions::Quadrupole()) and/or in single precision.
+    ////    The present 6x6x10 map is not centred in y and deviates from the ideal symmetry by ~6%, so it is used as measured.
+    K600_Q_FieldMapOptions = MagneticFieldMapOptions();
+    //K600_Q_FieldMapOptions = MagneticFieldMapOptions::Quadrupole();
+    //K600_Q_FieldMapOptions.singlePrecision = true;
+    ////    Analytic multipole/Enge expansion fitted to a map with tools/MultipoleFieldFitter (same offset as the map)
+    K600_Q_MultipoleFile = "../K600-ALBA/MagneticFieldMaps/Quadrupole_Multipoles.dat";
     K600_Quadrupole_CentrePosition = G4ThreeVector(0.*cm, 0.*cm,100.*cm);
     //K600_Quadrupole_rotm.rotateZ(90.*deg);
     //K600_Quadrupole_rotm.rotateY(90*deg);
@@ -940,10 +1029,57 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
     K600_Dipole2_rotm.rotateX(-90*deg);
     K600_Dipole2_rotm.rotateY(180.*deg);
     
-    if(Ideal_Quadrupole && Mapped_Quadrupole || (!Ideal_Quadrupole && !Mapped_Quadrupole))
+    ////    Measured/computed 3D maps of the dipoles (in world coordinates) replace the uniform
+    ////    fields when given. They are stored folded about the midplane and in Morton-ordered
+    ////    tiles, so that only the parts of the map the tracks pass through are paged in.
+    K600_Dipole1_FieldMapFile = "";
+    K600_Dipole2_FieldMapFile = "";
+    K600_Dipole_FieldMapOptions = MagneticFieldMapOptions::DipoleMidplane();
+    K600_Dipole_FieldMapOptions.tileSize = 8;
+    
+    //  K600 Spectrometer envelope
+    ////    Vacuum box around the three magnets, from the face of the scattering chamber (z = 100 cm) to
+    ////    beyond the exit of dipole 2. Needed for the transfer-map fast simulation and for recording its samples.
+    K600_Spectrometer_Envelope = false;
+    K600_Envelope_CentrePosition = G4ThreeVector(40.*cm, 0.*cm, 255.*cm);
+    K600_Envelope_HalfLengths = G4ThreeVector(120.*cm, 32.*cm, 155.*cm);
+    
+    ////    Entry plane: upstream face of the envelope, on the beam axis, with the world axes.
+    ////    Exit plane: the +x face of the envelope, z' along +x and x' along -z.
+    K600_TransferMap_EntryPlane.origin = G4ThreeVector(-K600_Envelope_CentrePosition.x(), 0., -K600_Envelope_HalfLengths.z());
+    K600_TransferMap_EntryPlane.xAxis = G4ThreeVector(1., 0., 0.);
+    K600_TransferMap_EntryPlane.yAxis = G4ThreeVector(0., 1., 0.);
+    K600_TransferMap_EntryPlane.zAxis = G4ThreeVector(0., 0., 1.);
+    K600_TransferMap_ExitPlane.origin = G4ThreeVector(K600_Envelope_HalfLengths.x(), 0., 0.);
+    K600_TransferMap_ExitPlane.xAxis = G4ThreeVector(0., 0., -1.);
+    K600_TransferMap_ExitPlane.yAxis = G4ThreeVector(0., 1., 0.);
+    K600_TransferMap_ExitPlane.zAxis = G4ThreeVector(1., 0., 0.);
+    
+    ////    Samples are recorded with full tracking (SteppingAction), then fitted with tools/TransferMapFitter
+    K600_TransferMap_File = "";
+    //K600_TransferMap_File = "../K600-ALBA/TransferMaps/K600_TransferMap.dat";
+    K600_TransferMap_SampleFile = "";
+    //K600_TransferMap_SampleFile = "TransferMapSamples.txt";
+    
+    ////    Samples of the map itself are of no use
+    if(!K600_TransferMap_File.empty()) K600_TransferMap_SampleFile = "";
+    
+    Logic_K600_Quadrupole = 0;
+    Logic_K600_Dipole1 = 0;
+    Logic_K600_Dipole2 = 0;
+    Logic_K600_Envelope = 0;
+    PhysiK600_Envelope = 0;
+    K600_Spectrometer_Region = 0;
+    minStepMagneticField = 0.0025*mm;
+    ////    Conservative defaults; steppers and tolerances can be changed per magnet
+    ////    with /K600/field/ (benchmarks/FieldTransportBenchmark compares the choices)
+    largestAcceptableStepMagneticField = 1*mm;
+    
+    if((G4int(Ideal_Quadrupole) + G4int(Mapped_Quadrupole) + G4int(Fitted_Quadrupole))!=1)
     {
         Ideal_Quadrupole = false;
         Mapped_Quadrupole = false;
+        Fitted_Quadrupole = false;
     }
     
     ////////////////////////////////////////////////////
@@ -986,11 +1122,573 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
     AFRODITE_MathisTC_Presence = false;
 
     
+    if(!BenchmarkLayout.empty()) ApplyBenchmarkLayout();
+    
+    ////    The configuration above, the mesh settings and the geometry sources of this build
+    const std::uint64_t configurationHash = GeometrySnapshot::ConfigurationHash(ConfigurationDescription());
+    
+    if(!GeometrySnapshot_File.empty())
+    {
+        G4VPhysicalVolume* snapshotWorld = GeometrySnapshot::Read(GeometrySnapshot_File, configurationHash);
+        if(snapshotWorld)
+        {
+            FindSnapshotVolumes();
+            FindLayoutVolumes();
+            AddRegionCommands();
+            return snapshotWorld;
+        }
+    }
+    
     // Define materials
     DefineMaterials();
     
     // Define volumes
-    return DefineVolumes();
+    G4VPhysicalVolume* world = DefineVolumes();
+    
+    if(!GeometrySnapshot_File.empty()) GeometrySnapshot::Write(GeometrySnapshot_File, world, configurationHash, CachedCADMesh::GetSourceFiles());
+    
+    FindLayoutVolumes();
+    AddRegionCommands();
+    
+    return world;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+    template <typename T> void DescribeArray(std::ostream& description, const char* name, const T* values, G4int n)
+    {
+        description << name;
+        for(G4int i=0; i<n; i++) description << " " << values[i];
+        description << "\n";
+    }
+}
+
+G4String DetectorConstruction::ConfigurationDescription() const
+{
+    std::ostringstream description;
+    description.precision(17);
+    
+    ////    The geometry sources of this build (cmake/GeometrySourceHash.cmake)
+    description << "Sources " << K600_GEOMETRY_SOURCE_HASH << "\n";
+    description << "WorldSize " << WorldSize << "\n";
+    description << "BenchmarkLayout " << BenchmarkLayout << "\n";
+    
+    description << "VDC " << VDC_AllPresent_Override << " " << VDC_AllAbsent_Override << "\n";
+    DescribeArray(description, "VDC_Presence", VDC_Presence, numberOf_VDC);
+    DescribeArray(description, "VDC_CentrePositionX", VDC_CentrePositionX, numberOf_VDC);
+    DescribeArray(description, "VDC_CentrePositionZ", VDC_CentrePositionZ, numberOf_VDC);
+    DescribeArray(description, "VDC_RotationY", VDC_RotationY, numberOf_VDC);
+    
+    description << "CAKE " << CAKE_AllPresent_Override << " " << CAKE_AllAbsent_Override << " " << offset_CAKE_BeamAxis << "\n";
+    DescribeArray(description, "CAKE_Presence", CAKE_Presence, numberOf_CAKE);
+    DescribeArray(description, "CAKE_AA_CentrePosition", CAKE_AA_CentrePosition, numberOf_CAKE);
+    
+    description << "W1 " << W1_AllPresent_Override << " " << W1_AllAbsent_Override << " " << offset_W1_BeamAxis << "\n";
+    DescribeArray(description, "W1_Presence", W1_Presence, numberOf_W1);
+    DescribeArray(description, "W1_AA_CentrePosition", W1_AA_CentrePosition, numberOf_W1);
+    
+    description << "PADDLE " << PADDLE_AllPresent_Override << " " << PADDLE_AllAbsent_Override << "\n";
+    DescribeArray(description, "PADDLE_Presence", PADDLE_Presence, numberOf_PADDLE);
+    DescribeArray(description, "PADDLE_CentrePositionX", PADDLE_CentrePositionX, numberOf_PADDLE);
+    DescribeArray(description, "PADDLE_CentrePositionZ", PADDLE_CentrePositionZ, numberOf_PADDLE);
+    DescribeArray(description, "PADDLE_RotationY", PADDLE_RotationY, numberOf_PADDLE);
+    
+    description << "HAGAR " << HAGAR_NaICrystal_Presence << " " << HAGAR_Annulus_Presence << " " << HAGAR_FrontDisc_Presence
+    << " " << HAGAR_NaICrystal_CentrePosition << " " << HAGAR_Annulus_CentrePosition << " " << HAGAR_FrontDisc_CentrePosition << "\n";
+    
+    description << "CLOVER " << CLOVER_AllPresent_Override << " " << CLOVER_AllAbsent_Override
+    << " " << useCLOVER_Walid << " " << useCLOVER_Parametric << "\n";
+    DescribeArray(description, "CLOVER_Presence", CLOVER_Presence, numberOf_CLOVER);
+    DescribeArray(description, "CLOVER_Distance", CLOVER_Distance, numberOf_CLOVER);
+    DescribeArray(description, "CLOVER_phi", CLOVER_phi, numberOf_CLOVER);
+    DescribeArray(description, "CLOVER_theta", CLOVER_theta, numberOf_CLOVER);
+    
+    description << "CLOVER_Shield " << CLOVER_Shield_AllPresent_Override << " " << CLOVER_Shield_AllAbsent_Override << "\n";
+    DescribeArray(description, "CLOVER_Shield_Presence", CLOVER_Shield_Presence, numberOf_CLOVER_Shields);
+    
+    description << "LEPS " << LEPS_AllPresent_Override << " " << LEPS_AllAbsent_Override << "\n";
+    DescribeArray(description, "LEPS_Presence", LEPS_Presence, numberOf_LEPS);
+    DescribeArray(description, "LEPS_Distance", LEPS_Distance, numberOf_LEPS);
+    DescribeArray(description, "LEPS_phi", LEPS_phi, numberOf_LEPS);
+    DescribeArray(description, "LEPS_theta", LEPS_theta, numberOf_LEPS);
+    
+    description << "LaBr3Ce " << LaBr3Ce_AllPresent_Override << " " << LaBr3Ce_AllAbsent_Override
+    << " " << setPreconfiguredVersion << " " << LaBr3CeSetupVersion << " " << LaBR3Ce_SetGlobalDistance
+    << " " << LaBR3Ce_GlobalDistance << " " << LaBR3Ce_automaticOrientation << " " << configuration_truncatedIcosahedron_hexagons << "\n";
+    DescribeArray(description, "LaBr3Ce_Presence", LaBr3Ce_Presence, numberOf_LaBr3Ce);
+    DescribeArray(description, "LaBr3Ce_Distance", LaBr3Ce_Distance, numberOf_LaBr3Ce);
+    DescribeArray(description, "LaBr3Ce_phi", LaBr3Ce_phi, numberOf_LaBr3Ce);
+    DescribeArray(description, "LaBr3Ce_theta", LaBr3Ce_theta, numberOf_LaBr3Ce);
+    
+    description << "K600 " << Ideal_Quadrupole << " " << Mapped_Quadrupole << " " << Fitted_Quadrupole
+    << " " << K600_Quadrupole << " " << K600_Quadrupole_CentrePosition
+    << " " << K600_Dipole1 << " " << K600_Dipole1_CentrePosition
+    << " " << K600_Dipole2 << " " << K600_Dipole2_CentrePosition
+    << " " << K600_Spectrometer_Envelope << " " << K600_Envelope_CentrePosition << " " << K600_Envelope_HalfLengths << "\n";
+    
+    description << "Chambers " << K600_BACTAR_sidesOn_Presence << " " << K600_BACTAR_sidesOff_Presence
+    << " " << K600_BACTAR_beamRightSideOff_Presence << " " << K600_BACTAR_beamLeftSideOff_Presence
+    << " " << K600_ALBA_TruncIcos_Shielding_Presence << " " << K600_Target_Presence << " " << K600_TargetBacking_Presence
+    << " " << AFRODITE_MathisTC_Presence << "\n";
+    
+    for(std::map<G4String, G4double>::const_iterator it=RegionProductionCuts.begin(); it!=RegionProductionCuts.end(); ++it)
+    {
+        description << "RegionProductionCut " << it->first << " " << it->second << "\n";
+    }
+    
+    description << CachedCADMesh::GetSettingsDescription();
+    
+    return description.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::FindSnapshotVolumes()
+{
+    ////    The volumes needed after construction (fields, fast simulation, SteppingAction), by name
+    G4LogicalVolumeStore* logicalVolumeStore = G4LogicalVolumeStore::GetInstance();
+    
+    if(K600_Quadrupole) Logic_K600_Quadrupole = logicalVolumeStore->GetVolume("Logic_K600_Quadrupole", false);
+    if(K600_Dipole1) Logic_K600_Dipole1 = logicalVolumeStore->GetVolume("Logic_K600_Dipole1", false);
+    if(K600_Dipole2) Logic_K600_Dipole2 = logicalVolumeStore->GetVolume("Logic_K600_Dipole2", false);
+    
+    Logic_K600_Envelope = logicalVolumeStore->GetVolume("Logic_K600_Envelope", false);
+    PhysiK600_Envelope = G4PhysicalVolumeStore::GetInstance()->GetVolume("K600_Envelope", false);
+    K600_Spectrometer_Region = G4RegionStore::GetInstance()->GetRegion("K600_Spectrometer", false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::ApplyBenchmarkLayout()
+{
+    const G4bool layoutCLOVER = (BenchmarkLayout=="CLOVER");
+    const G4bool layoutLaBr3Ce = (BenchmarkLayout=="ALBA_LaBr3Ce");
+    const G4bool layoutSpectrometer = (BenchmarkLayout=="Spectrometer");
+    
+    if(!layoutCLOVER && !layoutLaBr3Ce && !layoutSpectrometer)
+    {
+        G4ExceptionDescription description;
+        description << "Unknown benchmark layout \"" << BenchmarkLayout << "\" (CLOVER, ALBA_LaBr3Ce or Spectrometer): the geometry is built as configured.";
+        G4Exception("DetectorConstruction::ApplyBenchmarkLayout()", "DetectorConstruction0001", JustWarning, description);
+        BenchmarkLayout = "";
+        return;
+    }
+    
+    ////    Positions, distances and orientations are those configured above; only the presence changes.
+    ////    CLOVER: the 17 CLOVERs with their BGO shields
+    for(G4int i=0; i<numberOf_CLOVER; i++) CLOVER_Presence[i] = layoutCLOVER;
+    for(G4int i=0; i<numberOf_CLOVER_Shields; i++) CLOVER_Shield_Presence[i] = layoutCLOVER;
+    
+    ////    ALBA_LaBr3Ce: the 20 LaBr3Ce detectors on the faces of the truncated icosahedron
+    for(G4int i=0; i<numberOf_LaBr3Ce; i++) LaBr3Ce_Presence[i] = layoutLaBr3Ce;
+    
+    ////    Spectrometer: CAKE, VDC 1 and the magnets with their fields
+    for(G4int i=0; i<numberOf_CAKE; i++) CAKE_Presence[i] = layoutSpectrometer;
+    for(G4int i=0; i<numberOf_VDC; i++) VDC_Presence[i] = (layoutSpectrometer && i==0);
+    K600_Quadrupole = layoutSpectrometer;
+    K600_Dipole1 = layoutSpectrometer;
+    K600_Dipole2 = layoutSpectrometer;
+    
+    ////    Everything else is absent
+    for(G4int i=0; i<numberOf_W1; i++) W1_Presence[i] = false;
+    for(G4int i=0; i<numberOf_PADDLE; i++) PADDLE_Presence[i] = false;
+    for(G4int i=0; i<numberOf_LEPS; i++) LEPS_Presence[i] = false;
+    HAGAR_NaICrystal_Presence = false;
+    HAGAR_Annulus_Presence = false;
+    HAGAR_FrontDisc_Presence = false;
+    K600_Spectrometer_Envelope = false;
+    K600_BACTAR_sidesOn_Presence = false;
+    K600_BACTAR_sidesOff_Presence = false;
+    K600_BACTAR_beamRightSideOff_Presence = false;
+    K600_BACTAR_beamLeftSideOff_Presence = false;
+    K600_ALBA_TruncIcos_Shielding_Presence = false;
+    K600_Target_Presence = false;
+    K600_TargetBacking_Presence = false;
+    AFRODITE_MathisTC_Presence = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::AddToRegion(const G4String& regionName, G4LogicalVolume* logicalVolume)
+{
+    G4Region* region = G4RegionStore::GetInstance()->GetRegion(regionName, false);
+    
+    if(!region)
+    {
+        region = new G4Region(regionName);
+        
+        std::map<G4String, G4double>::const_iterator cut = RegionProductionCuts.find(regionName);
+        if(cut!=RegionProductionCuts.end() && cut->second>0.)
+        {
+            G4ProductionCuts* productionCuts = new G4ProductionCuts();
+            productionCuts->SetProductionCut(cut->second);
+            region->SetProductionCuts(productionCuts);
+        }
+    }
+    
+    ////    Volumes shared by several placements are added once
+    region->AddRootLogicalVolume(logicalVolume);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::AddRegionCommands()
+{
+    if(!fRegionMessenger) fRegionMessenger = new K600RegionMessenger();
+    
+    G4RegionStore* regionStore = G4RegionStore::GetInstance();
+    for(size_t i=0; i<regionStore->size(); i++)
+    {
+        const G4String& name = (*regionStore)[i]->GetName();
+        if(name=="DefaultRegionForTheWorld" || name=="DefaultRegionForParallelWorld") continue;
+        
+        fRegionMessenger->AddRegion(name);
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::FindLayoutVolumes()
+{
+    for(G4int i=0; i<numberOf_CLOVER; i++)
+    {
+        Layout_CLOVER_PV[i].clear();
+        Layout_CLOVER_MinimumDistance[i] = CLOVER_Distance[i];
+    }
+    for(G4int i=0; i<numberOf_LaBr3Ce; i++) Layout_LaBr3Ce_PV[i] = 0;
+    Layout_LaBr3Ce_MinimumDistance = DBL_MAX;
+    
+    G4LogicalVolume* vacuumChamber = G4LogicalVolumeStore::GetInstance()->GetVolume("VacuumChamber", false);
+    if(!vacuumChamber) return;
+    
+    for(std::size_t k=0; k<vacuumChamber->GetNoDaughters(); k++)
+    {
+        G4VPhysicalVolume* physical = vacuumChamber->GetDaughter(k);
+        const G4String& name = physical->GetName();
+        const G4int copyNo = physical->GetCopyNo();
+        
+        if(name=="LaBr3CeInternalVacuum")
+        {
+            if(copyNo<0 || copyNo>=numberOf_LaBr3Ce) continue;
+            
+            ////    The internal vacuum is centred behind the front face of the detector
+            Layout_LaBr3Ce_PV[copyNo] = physical;
+            Layout_LaBr3Ce_Offset[copyNo] = physical->GetTranslation().mag() - LaBr3Ce_Distance[copyNo];
+            Layout_LaBr3Ce_MinimumDistance = std::min(Layout_LaBr3Ce_MinimumDistance, LaBr3Ce_Distance[copyNo]);
+        }
+        else if(name.compare(0, 6, "CLOVER")==0)
+        {
+            ////    Crystals placed in the chamber (useCLOVER_Walid): 4 per CLOVER, shield BGOs and PMTs: 16 per shield
+            G4int detector = copyNo;
+            if(name=="CLOVER_HPGeCrystal") detector = copyNo/4;
+            else if(name=="CLOVER_Shield_BGOCrystal" || name=="CLOVER_Shield_PMT") detector = copyNo/16;
+            
+            if(detector>=0 && detector<numberOf_CLOVER) Layout_CLOVER_PV[detector].push_back(physical);
+        }
+    }
+    
+    if(Layout_LaBr3Ce_MinimumDistance==DBL_MAX) Layout_LaBr3Ce_MinimumDistance = 0.0;
+    
+    ////    A rebuilt geometry returns to the configuration of Construct()
+    LayoutChanges++;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetDistance_CLOVER(G4int i, G4double distance)
+{
+    if(i<-1 || i>=numberOf_CLOVER)
+    {
+        G4ExceptionDescription description;
+        description << "No CLOVER " << i << " (0 to " << numberOf_CLOVER-1 << ", or -1 for all): the layout is unchanged.";
+        G4Exception("DetectorConstruction::SetDistance_CLOVER()", "DetectorConstruction0002", JustWarning, description);
+        return;
+    }
+    
+    ////    The overlaps with the chamber and the neighbouring detectors were checked at the distance built
+    for(G4int j=0; j<numberOf_CLOVER; j++)
+    {
+        if((i>=0 && j!=i) || Layout_CLOVER_PV[j].empty()) continue;
+        
+        if(distance < Layout_CLOVER_MinimumDistance[j] - kCarTolerance)
+        {
+            G4ExceptionDescription description;
+            description << "CLOVER " << j << " was built at a distance of " << Layout_CLOVER_MinimumDistance[j]/cm
+                        << " cm and may overlap at " << distance/cm << " cm: the layout is unchanged." << G4endl
+                        << "Build the geometry at the smallest distance of the scan.";
+            G4Exception("DetectorConstruction::SetDistance_CLOVER()", "DetectorConstruction0004", JustWarning, description);
+            return;
+        }
+    }
+    
+    std::map<G4LogicalVolume*, G4VPhysicalVolume*> modifiedMothers;
+    
+    for(G4int j=0; j<numberOf_CLOVER; j++)
+    {
+        if((i>=0 && j!=i) || Layout_CLOVER_PV[j].empty()) continue;
+        
+        ////    All volumes of the CLOVER and its shield slide along the detector axis
+        G4ThreeVector direction(sin(CLOVER_theta[j]) * cos(CLOVER_phi[j]), sin(CLOVER_theta[j]) * sin(CLOVER_phi[j]), cos(CLOVER_theta[j]));
+        G4ThreeVector shift = (distance - CLOVER_Distance[j])*direction;
+        
+        for(std::size_t k=0; k<Layout_CLOVER_PV[j].size(); k++)
+        {
+            G4VPhysicalVolume* physical = Layout_CLOVER_PV[j][k];
+            physical->SetTranslation(physical->GetTranslation() + shift);
+            modifiedMothers[physical->GetMotherLogical()] = physical;
+            
+            if(fCheckOverlaps && physical->GetMotherLogical()->IsDaughter(physical)) physical->CheckOverlaps();
+        }
+        
+        CLOVER_Distance[j] = distance;
+        CLOVER_position[j] = distance*direction;
+        CLOVER_Shield_position[j] = distance*direction;
+    }
+    
+    ReoptimiseLayout(modifiedMothers);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetPresence_CLOVER(G4int i, G4bool presence)
+{
+    if(i<-1 || i>=numberOf_CLOVER)
+    {
+        G4ExceptionDescription description;
+        description << "No CLOVER " << i << " (0 to " << numberOf_CLOVER-1 << ", or -1 for all): the layout is unchanged.";
+        G4Exception("DetectorConstruction::SetPresence_CLOVER()", "DetectorConstruction0002", JustWarning, description);
+        return;
+    }
+    
+    if(i>=0 && Layout_CLOVER_PV[i].empty())
+    {
+        G4ExceptionDescription description;
+        description << "CLOVER " << i << " was not built: it can only be placed by a new geometry.";
+        G4Exception("DetectorConstruction::SetPresence_CLOVER()", "DetectorConstruction0003", JustWarning, description);
+        return;
+    }
+    
+    std::map<G4LogicalVolume*, G4VPhysicalVolume*> modifiedMothers;
+    
+    for(G4int j=0; j<numberOf_CLOVER; j++)
+    {
+        if((i>=0 && j!=i) || Layout_CLOVER_PV[j].empty()) continue;
+        
+        for(std::size_t k=0; k<Layout_CLOVER_PV[j].size(); k++) SetLayoutPresence(Layout_CLOVER_PV[j][k], presence, modifiedMothers);
+        CLOVER_Presence[j] = presence;
+    }
+    
+    ReoptimiseLayout(modifiedMothers);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetDistance_ALBA_LaBr3Ce(G4double distance)
+{
+    ////    The crystal tapering is built for the smallest distance: closer, neighbouring detectors overlap
+    if(distance < Layout_LaBr3Ce_MinimumDistance - kCarTolerance)
+    {
+        G4ExceptionDescription description;
+        description << "The LaBr3Ce detectors were built for a distance of at least " << Layout_LaBr3Ce_MinimumDistance/cm
+                    << " cm and would overlap at " << distance/cm << " cm: the layout is unchanged." << G4endl
+                    << "Build the geometry at the smallest distance of the scan.";
+        G4Exception("DetectorConstruction::SetDistance_ALBA_LaBr3Ce()", "DetectorConstruction0004", JustWarning, description);
+        return;
+    }
+    
+    std::map<G4LogicalVolume*, G4VPhysicalVolume*> modifiedMothers;
+    
+    LaBR3Ce_GlobalDistance = distance;
+    for(G4int i=0; i<numberOf_LaBr3Ce; i++)
+    {
+        LaBr3Ce_Distance[i] = distance;
+        PlaceLayout_ALBA_LaBr3Ce(i, modifiedMothers);
+    }
+    
+    ReoptimiseLayout(modifiedMothers);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetPreconfiguredVersion_ALBA_LaBr3Ce(G4int version)
+{
+    ////    Only the distance: the tapering of the crystals is the one built
+    SetDistance_ALBA_LaBr3Ce(PreconfiguredDistance_ALBA_LaBr3Ce(version));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetFaces_ALBA_LaBr3Ce(G4bool hexagons)
+{
+    ////    The crystals are tapered for their face when built: detectors 0 to 19 for the 20 hexagonal faces,
+    ////    detectors 20 to 31 for the 12 pentagonal ones. Each detector only goes back on its own face,
+    ////    and those of the other faces are removed.
+    const G4int firstDetector = hexagons ? 0 : G4int(vertex_hexagonFaces_truncatedIcosahedron.size());
+    const std::vector<G4ThreeVector>& faces = hexagons ? vertex_hexagonFaces_truncatedIcosahedron : vertex_pentagonFaces_truncatedIcosahedron;
+    const G4int lastDetector = std::min(numberOf_LaBr3Ce, firstDetector + G4int(faces.size()));
+    
+    G4int nBuilt = 0;
+    for(G4int i=firstDetector; i<lastDetector; i++) if(Layout_LaBr3Ce_PV[i]) nBuilt++;
+    
+    if(nBuilt==0)
+    {
+        G4ExceptionDescription description;
+        description << "No LaBr3Ce detector with crystals for the " << (hexagons ? "hexagonal" : "pentagonal")
+                    << " faces was built (detectors " << firstDetector << " to " << firstDetector + G4int(faces.size()) - 1
+                    << " of " << numberOf_LaBr3Ce << "): the layout is unchanged.";
+        G4Exception("DetectorConstruction::SetFaces_ALBA_LaBr3Ce()", "DetectorConstruction0005", JustWarning, description);
+        return;
+    }
+    
+    std::map<G4LogicalVolume*, G4VPhysicalVolume*> modifiedMothers;
+    
+    configuration_truncatedIcosahedron_hexagons = hexagons;
+    for(G4int i=0; i<numberOf_LaBr3Ce; i++)
+    {
+        LaBr3Ce_Presence[i] = (i>=firstDetector && i<lastDetector);
+        
+        if(LaBr3Ce_Presence[i])
+        {
+            LaBr3Ce_theta[i] = faces[i - firstDetector].theta();
+            LaBr3Ce_phi[i] = faces[i - firstDetector].phi();
+        }
+        
+        PlaceLayout_ALBA_LaBr3Ce(i, modifiedMothers);
+    }
+    
+    ReoptimiseLayout(modifiedMothers);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetPresence_ALBA_LaBr3Ce(G4int i, G4bool presence)
+{
+    if(i<-1 || i>=numberOf_LaBr3Ce)
+    {
+        G4ExceptionDescription description;
+        description << "No LaBr3Ce detector " << i << " (0 to " << numberOf_LaBr3Ce-1 << ", or -1 for all): the layout is unchanged.";
+        G4Exception("DetectorConstruction::SetPresence_ALBA_LaBr3Ce()", "DetectorConstruction0002", JustWarning, description);
+        return;
+    }
+    
+    if(i>=0 && !Layout_LaBr3Ce_PV[i])
+    {
+        G4ExceptionDescription description;
+        description << "LaBr3Ce detector " << i << " was not built: it can only be placed by a new geometry.";
+        G4Exception("DetectorConstruction::SetPresence_ALBA_LaBr3Ce()", "DetectorConstruction0003", JustWarning, description);
+        return;
+    }
+    
+    std::map<G4LogicalVolume*, G4VPhysicalVolume*> modifiedMothers;
+    
+    for(G4int j=0; j<numberOf_LaBr3Ce; j++)
+    {
+        if((i>=0 && j!=i) || !Layout_LaBr3Ce_PV[j]) continue;
+        
+        LaBr3Ce_Presence[j] = presence;
+        PlaceLayout_ALBA_LaBr3Ce(j, modifiedMothers);
+    }
+    
+    ReoptimiseLayout(modifiedMothers);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::PlaceLayout_ALBA_LaBr3Ce(G4int i, std::map<G4LogicalVolume*, G4VPhysicalVolume*>& modifiedMothers)
+{
+    G4VPhysicalVolume* physical = Layout_LaBr3Ce_PV[i];
+    if(!physical) return;
+    
+    G4ThreeVector direction(std::sin(LaBr3Ce_theta[i]) * std::cos(LaBr3Ce_phi[i]), std::sin(LaBr3Ce_theta[i]) * std::sin(LaBr3Ce_phi[i]), std::cos(LaBr3Ce_theta[i]));
+    
+    LaBr3Ce_InternalVacuum_position[i] = (LaBr3Ce_Distance[i] + Layout_LaBr3Ce_Offset[i])*direction;
+    LaBr3Ce_rotm[i] = Rotation_ALBA_LaBr3Ce(direction);
+    LaBr3Ce_InternalVacuum_transform[i] = G4Transform3D(LaBr3Ce_rotm[i],LaBr3Ce_InternalVacuum_position[i]);
+    
+    ////    Placements hold the inverse (frame) rotation, allocated unless it is the identity
+    const G4RotationMatrix frameRotation = LaBr3Ce_rotm[i].inverse();
+    if(physical->GetRotation())
+    {
+        *physical->GetRotation() = frameRotation;
+    }
+    else if(!frameRotation.isIdentity())
+    {
+        G4RotationMatrix* rotation = new G4RotationMatrix(frameRotation);
+        G4AutoDelete::Register(rotation);
+        physical->SetRotation(rotation);
+    }
+    physical->SetTranslation(LaBr3Ce_InternalVacuum_position[i]);
+    modifiedMothers[physical->GetMotherLogical()] = physical;
+    
+    SetLayoutPresence(physical, LaBr3Ce_Presence[i], modifiedMothers);
+    
+    if(fCheckOverlaps && LaBr3Ce_Presence[i]) physical->CheckOverlaps();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetLayoutPresence(G4VPhysicalVolume* physical, G4bool presence, std::map<G4LogicalVolume*, G4VPhysicalVolume*>& modifiedMothers)
+{
+    G4LogicalVolume* mother = physical->GetMotherLogical();
+    const G4bool placed = mother->IsDaughter(physical);
+    
+    ////    A removed volume keeps its mother pointer, so that it can be put back
+    if(presence && !placed) mother->AddDaughter(physical);
+    else if(!presence && placed) mother->RemoveDaughter(physical);
+    else return;
+    
+    modifiedMothers[mother] = physical;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::ReoptimiseLayout(const std::map<G4LogicalVolume*, G4VPhysicalVolume*>& modifiedMothers)
+{
+    ////    Before the first run, the geometry is closed (and fully optimised) by the run manager.
+    ////    Otherwise only the voxels of each modified mother are rebuilt, one mother at a time; there is no
+    ////    GeometryHasBeenModified(), which would re-optimise the whole geometry. The voxels are shared by the
+    ////    worker threads and every event locates its primaries from the world volume.
+    LayoutChanges++;
+    
+    G4GeometryManager* geometryManager = G4GeometryManager::GetInstance();
+    if(!geometryManager->IsGeometryClosed()) return;
+    
+    std::map<G4LogicalVolume*, G4VPhysicalVolume*>::const_iterator it;
+    for(it=modifiedMothers.begin(); it!=modifiedMothers.end(); ++it)
+    {
+        geometryManager->OpenGeometry(it->second);
+        geometryManager->CloseGeometry(true, false, it->second);
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::PrintLayout() const
+{
+    G4cout << "//----------------------------------------" << G4endl;
+    G4cout << "     Detector layout (/K600/layout/)" << G4endl;
+    
+    for(G4int i=0; i<numberOf_CLOVER; i++)
+    {
+        if(Layout_CLOVER_PV[i].empty()) continue;
+        
+        G4cout << "     CLOVER " << i << ": " << (CLOVER_Presence[i] ? "present" : "removed")
+               << ", distance " << CLOVER_Distance[i]/cm << " cm, theta " << CLOVER_theta[i]/deg << " deg, phi " << CLOVER_phi[i]/deg << " deg" << G4endl;
+    }
+    
+    G4cout << "     LaBr3Ce faces: " << (configuration_truncatedIcosahedron_hexagons ? "hexagons" : "pentagons")
+           << ", built for distances from " << Layout_LaBr3Ce_MinimumDistance/cm << " cm" << G4endl;
+    
+    for(G4int i=0; i<numberOf_LaBr3Ce; i++)
+    {
+        if(!Layout_LaBr3Ce_PV[i]) continue;
+        
+        G4cout << "     LaBr3Ce " << i << ": " << (LaBr3Ce_Presence[i] ? "present" : "removed")
+               << ", distance " << LaBr3Ce_Distance[i]/cm << " cm, theta " << LaBr3Ce_theta[i]/deg << " deg, phi " << LaBr3Ce_phi[i]/deg << " deg" << G4endl;
+    }
+    
+    G4cout << "//----------------------------------------" << G4endl;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -1218,7 +1916,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
     {
         G4ThreeVector offset_BACTAR = G4ThreeVector(0*cm, 0*cm, 0*cm);
         
-        CADMesh * mesh_BACTAR = new CADMesh(meshPath, meshType, mm, offset_BACTAR, false);
+        CachedCADMesh * mesh_BACTAR = new CachedCADMesh(meshPath, meshType, mm, offset_BACTAR, false);
         
         G4VSolid * SolidBACTAR = mesh_BACTAR->TessellatedMesh();
         
@@ -1233,6 +1931,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                           0,               // copy number
                           fCheckOverlaps); // checking overlaps
         
+        AddToRegion("Passive", LogicBACTAR);
         
         //  Visualisation
         G4VisAttributes* K600_BACTAR_TC_VisAtt = new G4VisAttributes(G4Colour(0.8,0.8,0.8));
@@ -1256,7 +1955,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
     {
         G4ThreeVector offset_ALBA_shield = G4ThreeVector(0*cm, 0*cm, 0*cm);
         
-        CADMesh * mesh_ALBA_shield = new CADMesh(meshPath, meshType, mm, offset_ALBA_shield, false);
+        CachedCADMesh * mesh_ALBA_shield = new CachedCADMesh(meshPath, meshType, mm, offset_ALBA_shield, false);
         
         G4VSolid * SolidALBA_shield = mesh_ALBA_shield->TessellatedMesh();
         
@@ -1271,6 +1970,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                           0,               // copy number
                           fCheckOverlaps); // checking overlaps
         
+        AddToRegion("Passive", LogicALBA_shield);
         
         //  Visualisation
         G4VisAttributes* K600_ALBA_shield_TruncIcos_VisAtt = new G4VisAttributes(G4Colour(0.8,0.8,0.8));
@@ -1287,7 +1987,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
     {
         G4ThreeVector offset_MathisTC = G4ThreeVector(0*cm, 0*cm, 0*cm);
         
-        CADMesh * mesh_MathisTC = new CADMesh("../K600-ALBA/Mesh-Models/STRUCTURES/MathisTC/MathisTC.ply", "PLY", mm, offset_MathisTC, false);
+        CachedCADMesh * mesh_MathisTC = new CachedCADMesh("../K600-ALBA/Mesh-Models/STRUCTURES/MathisTC/MathisTC.ply", "PLY", mm, offset_MathisTC, false);
         
         G4VSolid * SolidMathisTC = mesh_MathisTC->TessellatedMesh();
         
@@ -1322,6 +2022,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                           0,               // copy number
                           fCheckOverlaps); // checking overlaps
         
+        AddToRegion("Passive", LogicMathisTC);
         
         //  Visualisation
         G4VisAttributes* AFRODITE_MathisTC_VisAtt = new G4VisAttributes(G4Colour(0.8,0.8,0.8));
@@ -1560,7 +2261,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
     G4Tubs*             Solid_CAKE_RS_filled[16][8];
     G4VSolid*           Solid_CAKE_RS_shear[16][8];
     G4VSolid*           Solid_CAKE_RS[16][8];
-    G4LogicalVolume*    Logic_CAKE_AA_RS[16][8];
+    std::vector<G4VSolid*>  Solid_CAKE_AA_RS;   // copy-number order, sector + 8*ring
     
     G4ThreeVector position_CAKE_Sector_shear[8][2];
     G4RotationMatrix* rm_CAKE_Sector_shear[8][2];
@@ -1630,14 +2331,15 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
             
             Solid_CAKE_RS_shear[j][l] = new G4SubtractionSolid("CAKE_RS_shear", Solid_CAKE_RS_filled[j][l], CAKE_Sector_razor, rm_CAKE_Sector_shear[l][0], position_CAKE_Sector_shear[l][0]);
             
-            Solid_CAKE_RS[j][l] = new G4SubtractionSolid("CAKE_RS", Solid_CAKE_RS_shear[j][l], CAKE_Sector_razor, rm_CAKE_Sector_shear[l][1], position_CAKE_Sector_shear[l][1]);
-            
-            Logic_CAKE_AA_RS[j][l] = new G4LogicalVolume(Solid_CAKE_RS[j][l], G4_Si_Material, "Logic_CAKE_AA_RS", 0, 0, 0);
-            
+            Solid_CAKE_RS[j][l] = new ParameterisedSubtractionSolid("CAKE_RS", Solid_CAKE_RS_shear[j][l], CAKE_Sector_razor, rm_CAKE_Sector_shear[l][1], position_CAKE_Sector_shear[l][1]);
             
+            Solid_CAKE_AA_RS.push_back(Solid_CAKE_RS[j][l]);
         }
     }
     
+    ////    All the pixels of a wafer are one parameterised volume (DetectorParameterisations.hh)
+    G4LogicalVolume* Logic_CAKE_AA_RS = new G4LogicalVolume(Solid_CAKE_RS[0][0], G4_Si_Material, "Logic_CAKE_AA_RS", 0, 0, 0);
+    
     
     /////////////////////////////////////////////
     //          CAKE - Active Area Punch
@@ -1788,6 +2490,8 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
     
     CAKE_SiliconWafer_transform = G4Transform3D(CAKE_SiliconWafer_rotm, offset_CAKE_SiliconWafer);
     
+    CAKEPixelParameterisation* CAKE_AA_RS_parameterisation = new CAKEPixelParameterisation(Solid_CAKE_AA_RS, offset_CAKE_AA);
+    
     
     for(G4int i=0; i<numberOf_CAKE; i++)
     {
@@ -1799,22 +2503,14 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
             ///////////////////////////////////////
             //      CAKE AA - Rings and Sectors
             
-            for(G4int j=0; j<16; j++)
-            {
-                for(G4int l=0; l<8; l++)
-                {
-                    CAKE_AA_RS_transform[l] = G4Transform3D(CAKE_AA_RS_rotm[l], offset_CAKE_AA);
-                    
-                    PhysiCAKE_AA_RS = new G4PVPlacement(CAKE_AA_RS_transform[l],
-                                                         Logic_CAKE_AA_RS[j][l],
-                                                         "CAKE_AA_RS", // its name
-                                                         Logic_CAKE_SiliconWafer[i],
-                                                         false, // no boolean operations
-                                                         i*128 + l + j*8,  // copy number
-                                                         fCheckOverlaps); // checking overlaps
-                    
-                }
-            }
+            ////    Channel i*128 + l + j*8: see CAKEPixelParameterisation::GetChannel()
+            PhysiCAKE_AA_RS = new G4PVParameterised("CAKE_AA_RS", // its name
+                                                    Logic_CAKE_AA_RS,
+                                                    Logic_CAKE_SiliconWafer[i],
+                                                    kUndefined,
+                                                    CAKE_AA_RS_parameterisation->GetNumberOfPixels(),
+                                                    CAKE_AA_RS_parameterisation,
+                                                    fCheckOverlaps); // checking overlaps
             
             
             ////////////////////////////////
@@ -1898,6 +2594,8 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                               0,               // copy number
                               fCheckOverlaps); // checking overlaps
             
+            AddToRegion("Silicon", Logic_CAKE_Asm[i]);
+            
             
         }
     }
@@ -2078,6 +2776,8 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                               false,           // no boolean
                               0,               // copy number
                               fCheckOverlaps); // checking overlaps
+            
+            AddToRegion("Silicon", Logic_W1_Asm[i]);
 
             
             
@@ -2125,7 +2825,6 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
     ///////////////////////////////////////////////
     //      VDC - STESALIT STANDARD PCB FRAME
     G4Box* Solid_StesalitPCB_StdFrame = new G4Box("Solid_StesalitPCB_StdFrame", (936./2)*mm, (240./2)*mm, (5.5/2)*mm);
-    G4Box* Solid_Wire_subtraction = new G4Box("Solid_Wire_subtraction", (2000./2)*mm, (1000./2)*mm, (10./2)*mm);
     
     ///////////////////////////////////////////////
     //      VDC - PCB FRAME
@@ -2189,8 +2888,6 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
     
     G4VSolid* Solid_VDC_Stesalit_XU_Frame = new G4SubtractionSolid("Solid_VDC_Stesalit_XU_Frame", Solid_StesalitPCB_StdFrame, punch3, 0, position_punch[2]);
     
-    G4VSolid* Solid_Wire_subtraction2 = new G4SubtractionSolid("Solid_VDC_Stesalit_XU_Frame", Solid_Wire_subtraction, punch3, 0, position_punch[2]);
-    
     G4LogicalVolume* Logic_VDC_XU_Frame = new G4LogicalVolume(Solid_VDC_Stesalit_XU_Frame, G4_Al_Material, "Logic_VDC_XU_Frame",0,0,0);
     
     
@@ -2244,78 +2941,59 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
     
     
     ///////////////////////////////////////////////
-    //      VDC - X WIRES
-    G4Tubs* Solid_VDC_X_WIRE = new G4Tubs("Solid_VDC_X_WIRE", 0.*um, 20.*um, 100./2*mm, 0.*deg, 360.*deg);
+    //      VDC - WIRE PLANES
+    //      The sense, guard and thick guard wires of a plane are one parameterised volume
+    //      (DetectorParameterisations.hh), in a gas envelope that fills the 800 x 100 mm
+    //      window of the wire frames. Every wire is cut to the window.
+    G4Box* Solid_VDC_WirePlane = new G4Box("Solid_VDC_WirePlane", (800./2)*mm, (100./2)*mm, (400./2)*um);
     
-    G4LogicalVolume* Logic_VDC_X_WIRE = new G4LogicalVolume(Solid_VDC_X_WIRE, G4_W_Material, "Logic_VDC_X_WIRE",0,0,0);
+    G4LogicalVolume* Logic_VDC_X_WirePlane = new G4LogicalVolume(Solid_VDC_WirePlane, VDC_SR_Gas_Material, "Logic_VDC_X_WirePlane",0,0,0);
+    G4LogicalVolume* Logic_VDC_U_WirePlane = new G4LogicalVolume(Solid_VDC_WirePlane, VDC_SR_Gas_Material, "Logic_VDC_U_WirePlane",0,0,0);
     
     ///////////////////////////////////////////////
-    //      VDC - X GUARD WIRES
-    G4Tubs* Solid_VDC_X_GUARDWIRE = new G4Tubs("Solid_VDC_X_GUARDWIRE", 0.*um, 50.*um, 100./2*mm, 0.*deg, 360.*deg);
+    //      VDC - X WIRES, GUARD WIRES AND THICK GUARD WIRES
+    G4Tubs* Solid_VDC_X_WIRE = new G4Tubs("Solid_VDC_X_WIRE", 0.*um, 20.*um, 100./2*mm, 0.*deg, 360.*deg);
+    
+    G4LogicalVolume* Logic_VDC_X_WIRE = new G4LogicalVolume(Solid_VDC_X_WIRE, G4_W_Material, "Logic_VDC_X_WIRE",0,0,0);
     
-    G4LogicalVolume* Logic_VDC_X_GUARDWIRE = new G4LogicalVolume(Solid_VDC_X_GUARDWIRE, G4_W_Material, "Logic_VDC_X_GUARDWIRE",0,0,0);
+    VDCWireParameterisation* VDC_X_WIRE_parameterisation = new VDCWireParameterisation(0.*deg, (800./2)*mm, (100./2)*mm);
     
+    for(G4int k=0; k<198; k++)
+    {
+        VDC_X_WIRE_parameterisation->AddWire(((k*4.) - 394.)*mm, 20.*um);
+    }
     
-    ///////////////////////////////////////////////
-    //      VDC - X GUARD WIRES, THICK
-    G4Tubs* Solid_VDC_X_GUARDWIRE_THICK = new G4Tubs("Solid_VDC_X_GUARDWIRE_THICK", 0.*um, 100.*um, 100./2*mm, 0.*deg, 360.*deg);
+    for(G4int k=0; k<199; k++)
+    {
+        VDC_X_WIRE_parameterisation->AddWire(((k*4.) - 396.)*mm, 50.*um);
+    }
     
-    G4LogicalVolume* Logic_VDC_X_GUARDWIRE_Thick = new G4LogicalVolume(Solid_VDC_X_GUARDWIRE_THICK, G4_W_Material, "Logic_VDC_X_GUARDWIRE_Thick",0,0,0);
+    for(G4int k=0; k<2; k++)
+    {
+        VDC_X_WIRE_parameterisation->AddWire(((k*2.*398.) - 398.)*mm, 100.*um);
+    }
     
     ///////////////////////////////////////////////
-    //      VDC - U WIRES
-    G4Tubs* Solid_VDC_U_WIRE_Full = new G4Tubs("Solid_VDC_U_WIRE", 0.*um, 20.*um, 150./2*mm, 0.*deg, 360.*deg);
-    
-    G4RotationMatrix* rm_U_WIRE = new G4RotationMatrix();
-    rm_U_WIRE->rotateY(90.*deg);
-    rm_U_WIRE->rotateZ((90.-40.)*deg);
+    //      VDC - U WIRES, GUARD WIRES AND THICK GUARD WIRES
+    G4Tubs* Solid_VDC_U_WIRE = new G4Tubs("Solid_VDC_U_WIRE", 0.*um, 20.*um, 150./2*mm, 0.*deg, 360.*deg);
     
-    G4VSolid* Solid_VDC_U_WIRE;
-    G4ThreeVector   offset_VDC_U_WIRE_subtraction;
+    G4LogicalVolume* Logic_VDC_U_WIRE = new G4LogicalVolume(Solid_VDC_U_WIRE, G4_W_Material, "Logic_VDC_U_WIRE",0,0,0);
     
-    G4LogicalVolume* Logic_VDC_U_WIRE[143];
+    VDCWireParameterisation* VDC_U_WIRE_parameterisation = new VDCWireParameterisation(40.*deg, (800./2)*mm, (100./2)*mm);
     
     for(G4int k=0; k<143; k++)
     {
-        offset_VDC_U_WIRE_subtraction = G4ThreeVector(0.0*mm, (-k + 71)*4*mm, (k - 71)*(4/tan(50*deg))*mm);
-        
-        Solid_VDC_U_WIRE = new G4SubtractionSolid("Solid_VDC_U_WIRE", Solid_VDC_U_WIRE_Full, Solid_Wire_subtraction2, rm_U_WIRE, offset_VDC_U_WIRE_subtraction);
-        
-        Logic_VDC_U_WIRE[k] = new G4LogicalVolume(Solid_VDC_U_WIRE, G4_W_Material, "Logic_VDC_U_WIRE",0,0,0);
+        VDC_U_WIRE_parameterisation->AddWire((k - 71)*(4/sin(50.*deg))*mm, 20.*um);
     }
     
-    ///////////////////////////////////////////////
-    //      VDC - U GUARD WIRES
-    G4Tubs* Solid_VDC_U_GUARDWIRE_Full = new G4Tubs("Solid_VDC_U_GUARDWIRE", 0.*um, 50.*um, 150./2*mm, 0.*deg, 360.*deg);
-    
-    G4VSolid* Solid_VDC_U_GUARDWIRE;
-    G4LogicalVolume* Logic_VDC_U_GUARDWIRE[144];
-    
     for(G4int k=0; k<144; k++)
     {
-        offset_VDC_U_WIRE_subtraction = G4ThreeVector(0.0*mm, (-k + 71.5)*4*mm, (k - 71.5)*(4/tan(50*deg))*mm);
-        
-        Solid_VDC_U_GUARDWIRE = new G4SubtractionSolid("Solid_VDC_U_WIRE", Solid_VDC_U_GUARDWIRE_Full, Solid_Wire_subtraction2, rm_U_WIRE, offset_VDC_U_WIRE_subtraction);
-        
-        Logic_VDC_U_GUARDWIRE[k] = new G4LogicalVolume(Solid_VDC_U_GUARDWIRE, G4_W_Material, "Logic_VDC_U_GUARDWIRE",0,0,0);
-        
+        VDC_U_WIRE_parameterisation->AddWire((k - 71.5)*(4/sin(50.*deg))*mm, 50.*um);
     }
     
-    ////////////////////////////////////////////////
-    //      VDC - U GUARD WIRES, Thick
-    G4Tubs* Solid_VDC_U_GUARDWIRE_Thick_Full = new G4Tubs("Solid_VDC_U_GUARDWIRE_Thick", 0.*um, 100.*um, 150./2*mm, 0.*deg, 360.*deg);
-    
-    G4VSolid* Solid_VDC_U_GUARDWIRE_Thick;
-    
-    G4LogicalVolume*    Logic_VDC_U_GUARDWIRE_Thick[2];
-    
     for(G4int k=0; k<2; k++)
     {
-        offset_VDC_U_WIRE_subtraction = G4ThreeVector(0.0*mm, (-k*144. + 72.)*4*mm, (k*144. - 72.)*(4/tan(50*deg))*mm);
-        
-        Solid_VDC_U_GUARDWIRE_Thick = new G4SubtractionSolid("Solid_VDC_U_WIRE_Thick", Solid_VDC_U_GUARDWIRE_Thick_Full, Solid_Wire_subtraction2, rm_U_WIRE, offset_VDC_U_WIRE_subtraction);
-        
-        Logic_VDC_U_GUARDWIRE_Thick[k] = new G4LogicalVolume(Solid_VDC_U_GUARDWIRE_Thick, G4_W_Material, "Logic_VDC_U_GUARDWIRE_Thick",0,0,0);
+        VDC_U_WIRE_parameterisation->AddWire((k*144. - 72.)*(4/sin(50.*deg))*mm, 100.*um);
     }
     
     
@@ -2363,13 +3041,25 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
     
     G4int usds;
     
-    G4ThreeVector   offset_VDC_X_WIRE;
-    VDC_X_WIRE_rotm.rotateX(90.*deg);
+    ////    Wire planes, at the z of the wires in the sense regions
+    G4ThreeVector   offset_VDC_X_WirePlane = G4ThreeVector(0.0*mm, 0.0*mm, (4000. - 20./2)*um);
+    G4ThreeVector   offset_VDC_U_WirePlane = G4ThreeVector(0.0*mm, 0.0*mm, (-4000. - 20./2)*um);
     
-    G4ThreeVector   offset_VDC_U_WIRE;
-    VDC_U_WIRE_rotm.rotateX(-90.*deg);
-    VDC_U_WIRE_rotm.rotateY(-90.*deg);
-    VDC_U_WIRE_rotm.rotateZ(40.*deg);
+    PhysiVDC_X_WIRE = new G4PVParameterised("VDC_X_WIRE",
+                                            Logic_VDC_X_WIRE,
+                                            Logic_VDC_X_WirePlane,
+                                            kUndefined,
+                                            VDC_X_WIRE_parameterisation->GetNumberOfWires(),
+                                            VDC_X_WIRE_parameterisation,
+                                            fCheckOverlaps); // checking overlaps
+    
+    PhysiVDC_U_WIRE = new G4PVParameterised("VDC_U_WIRE",
+                                            Logic_VDC_U_WIRE,
+                                            Logic_VDC_U_WirePlane,
+                                            kUndefined,
+                                            VDC_U_WIRE_parameterisation->GetNumberOfWires(),
+                                            VDC_U_WIRE_parameterisation,
+                                            fCheckOverlaps); // checking overlaps
     
     
     for(G4int i=0; i<2; i++)
@@ -2462,111 +3152,29 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                 if(j==0)
                 {
                     //////////////////////////////////////////////
-                    //      VDC - U WIRES
-                    for(G4int k=0; k<143; k++)
-                    {
-                        //offset_VDC_U_WIRE = G4ThreeVector((k - 71)*4*tan(40*deg)*mm, 0.0*mm, (4000. - 20./2)*um);
-                        offset_VDC_U_WIRE = G4ThreeVector((k - 71)*(4/sin(50.*deg))*mm, 0.0*mm, (-4000. - 20./2)*um);
-                        
-                        VDC_U_WIRE_transform = G4Transform3D(VDC_U_WIRE_rotm, offset_VDC_U_WIRE);
-                        
-                        PhysiVDC_U_WIRE = new G4PVPlacement(VDC_U_WIRE_transform,
-                                                            Logic_VDC_U_WIRE[k],
-                                                            "VDC_U_WIRE",
-                                                            Logic_VDC_SenseRegion_USDS[i][j],
-                                                            false,    // no boolean operations
-                                                            i*143 + k,    // copy number
-                                                            fCheckOverlaps); // checking overlaps
-                        
-                    }
-                    
-                    //////////////////////////////////////////////
-                    //      VDC - U GUARD WIRES
-                    for(G4int k=0; k<144; k++)
-                    {
-                        offset_VDC_U_WIRE = G4ThreeVector((k - 71.5)*(4/sin(50.*deg))*mm, 0.0*mm, (-4000. - 20./2)*um);
-                        VDC_U_WIRE_transform = G4Transform3D(VDC_U_WIRE_rotm, offset_VDC_U_WIRE);
-                        
-                        new G4PVPlacement(VDC_U_WIRE_transform,
-                                          Logic_VDC_U_GUARDWIRE[k],
-                                          "VDC_U_GUARDWIRE",
-                                          Logic_VDC_SenseRegion_USDS[i][j],
-                                          false,    // no boolean operations
-                                          i*144 + k,    // copy number
-                                          fCheckOverlaps); // checking overlaps
-                        
-                    }
-                    
-                    //////////////////////////////////////////////
-                    //      VDC - U GUARD WIRES, Thick
-                    for(G4int k=0; k<2; k++)
-                    {
-                        offset_VDC_U_WIRE = G4ThreeVector((k*144. - 72.)*(4/sin(50.*deg))*mm, 0.0*mm, (-4000. - 20./2)*um);
-                        VDC_U_WIRE_transform = G4Transform3D(VDC_U_WIRE_rotm, offset_VDC_U_WIRE);
-                        
-                        new G4PVPlacement(VDC_U_WIRE_transform,
-                                          Logic_VDC_U_GUARDWIRE_Thick[k],
-                                          "VDC_U_GUARDWIRE_Thick",
-                                          Logic_VDC_SenseRegion_USDS[i][j],
-                                          false,    // no boolean operations
-                                          i*2 + k,    // copy number
-                                          fCheckOverlaps);
-                        
-                    }
+                    //      VDC - U WIRES, GUARD WIRES AND THICK GUARD WIRES
+                    new G4PVPlacement(0,    // no rotation
+                                      offset_VDC_U_WirePlane,
+                                      Logic_VDC_U_WirePlane,
+                                      "VDC_WirePlane",
+                                      Logic_VDC_SenseRegion_USDS[i][j],
+                                      false,    // no boolean operations
+                                      i*2 + j,    // copy number
+                                      fCheckOverlaps); // checking overlaps
                 }
                 
                 if(j==1)
                 {
                     //////////////////////////////////////////////
-                    //      VDC - X WIRES
-                    for(G4int k=0; k<198; k++)
-                    {
-                        offset_VDC_X_WIRE = G4ThreeVector(( (k*4.) - 394.)*mm, 0.0*mm, (4000. - 20./2)*um);
-                        VDC_X_WIRE_transform = G4Transform3D(VDC_X_WIRE_rotm, offset_VDC_X_WIRE);
-                        
-                        PhysiVDC_X_WIRE = new G4PVPlacement(VDC_X_WIRE_transform,
-                                                            Logic_VDC_X_WIRE,
-                                                            "VDC_X_WIRE",
-                                                            Logic_VDC_SenseRegion_USDS[i][j],
-                                                            false,    // no boolean operations
-                                                            i*198 + k,    // copy number
-                                                            fCheckOverlaps); // checking overlaps
-                        
-                    }
-                    
-                    //////////////////////////////////////////////
-                    //      VDC - X GUARD WIRES
-                    for(G4int k=0; k<199; k++)
-                    {
-                        offset_VDC_X_WIRE = G4ThreeVector(( (k*4.) - 396.)*mm, 0.0*mm, (4000. - 20./2)*um);
-                        VDC_X_WIRE_transform = G4Transform3D(VDC_X_WIRE_rotm, offset_VDC_X_WIRE);
-                        
-                        new G4PVPlacement(VDC_X_WIRE_transform,
-                                          Logic_VDC_X_GUARDWIRE,
-                                          "VDC_X_GUARDWIRE",
-                                          Logic_VDC_SenseRegion_USDS[i][j],
-                                          false,    // no boolean operations
-                                          i*199 + k,    // copy number
-                                          fCheckOverlaps); // checking overlaps
-                        
-                    }
-                    
-                    //////////////////////////////////////////////
-                    //      VDC - X GUARD WIRES, Thick
-                    for(G4int k=0; k<2; k++)
-                    {
-                        offset_VDC_X_WIRE = G4ThreeVector(( (k*2.*398.) - 398.)*mm, 0.0*mm, (4000. - 20./2)*um);
-                        VDC_X_WIRE_transform = G4Transform3D(VDC_X_WIRE_rotm, offset_VDC_X_WIRE);
-                        
-                        new G4PVPlacement(VDC_X_WIRE_transform,
-                                          Logic_VDC_X_GUARDWIRE_Thick,
-                                          "VDC_X_GUARDWIRE_Thick",
-                                          Logic_VDC_SenseRegion_USDS[i][j],
-                                          false,    // no boolean operations
-                                          i*2 + k,    // copy number
-                                          fCheckOverlaps);
-                        
-                    }
+                    //      VDC - X WIRES, GUARD WIRES AND THICK GUARD WIRES
+                    new G4PVPlacement(0,    // no rotation
+                                      offset_VDC_X_WirePlane,
+                                      Logic_VDC_X_WirePlane,
+                                      "VDC_WirePlane",
+                                      Logic_VDC_SenseRegion_USDS[i][j],
+                                      false,    // no boolean operations
+                                      i*2 + j,    // copy number
+                                      fCheckOverlaps); // checking overlaps
                 }
             }
         }
@@ -2631,6 +3239,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                                                       i,               // copy number
                                                       fCheckOverlaps); // checking overlaps
             
+            AddToRegion("VDC", Logic_VDC_Asm[i]);
         }
     }
     
@@ -2673,6 +3282,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                                             i,                  // copy number
                                             fCheckOverlaps);    // checking overlaps
             
+            AddToRegion("PADDLE", Logic_PADDLE[i]);
         }
     }
     
@@ -2720,6 +3330,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                                                   false,           // no boolean operations
                                                   0,               // copy number
                                                   fCheckOverlaps); // checking overlaps
+        AddToRegion("HAGAR", Logic_HAGAR_NaICrystal);
     }
     
     /////////////////////////////
@@ -2735,6 +3346,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                                                false,           // no boolean operations
                                                0,               // copy number
                                                fCheckOverlaps); // checking overlaps
+        AddToRegion("HAGAR", Logic_HAGAR_Annulus);
     }
     
     ///////////////////////////////
@@ -2750,6 +3362,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                                                  false,           // no boolean operations
                                                  0,               // copy number
                                                  fCheckOverlaps); // checking overlaps
+        AddToRegion("HAGAR", Logic_HAGAR_FrontDisc);
     }
     
     
@@ -2800,7 +3413,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
         //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/CLOVER-InternalVacuum/CloverInternalVacuum.ply");
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/CLOVER-InternalVacuum/CloverInternalVacuum_approx.ply");
 
-        CADMesh * mesh_CLOVERInternalVacuum = new CADMesh(meshPath, meshType, mm, offset_CLOVERInternalVacuum, false);
+        CachedCADMesh * mesh_CLOVERInternalVacuum = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVERInternalVacuum, false);
         
         G4VSolid * Solid_CLOVERInternalVacuum = mesh_CLOVERInternalVacuum->TessellatedMesh();
         
@@ -2820,7 +3433,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
         //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Clover-Encasement/CloverEncasement.ply");
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Clover-Encasement/CloverEncasement_new_approx.ply");
 
-        CADMesh * mesh_CLOVEREncasement = new CADMesh(meshPath, meshType, mm, offset_CLOVEREncasement, false);
+        CachedCADMesh * mesh_CLOVEREncasement = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVEREncasement, false);
         
         G4VSolid * Solid_CLOVEREncasement = mesh_CLOVEREncasement->TessellatedMesh();
         
@@ -2832,33 +3445,48 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
 
         
         //////////////////////////////////////////////////////////
-        //              CLOVER HPGeCrystals - CADMesh
-        
-        //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-Crystal1.ply");
-        //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-RoundedCrystal1_10um.ply");
-        //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-RoundedCrystal1_10um_invertedNormals.ply");
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_RoundedCrystal1_10um.ply");
-        CADMesh * mesh_CLOVERHPGeCrystal1 = new CADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal1, false);
-        
-        //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-Crystal2.ply");
-        //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-RoundedCrystal2_10um.ply");
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_RoundedCrystal2_10um.ply");
-        CADMesh * mesh_CLOVERHPGeCrystal2 = new CADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal2, false);
-        
-        //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-Crystal3.ply");
-        //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-RoundedCrystal3_10um.ply");
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_RoundedCrystal3_10um.ply");
-        CADMesh * mesh_CLOVERHPGeCrystal3 = new CADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal3, false);
-        
-        //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-Crystal4.ply");
-        //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-RoundedCrystal4_10um.ply");
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_RoundedCrystal4_10um.ply");
-        CADMesh * mesh_CLOVERHPGeCrystal4 = new CADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal4, false);
-        
-        G4VSolid * Solid_HPGeCrystal1 = mesh_CLOVERHPGeCrystal1->TessellatedMesh();
-        G4VSolid * Solid_HPGeCrystal2 = mesh_CLOVERHPGeCrystal2->TessellatedMesh();
-        G4VSolid * Solid_HPGeCrystal3 = mesh_CLOVERHPGeCrystal3->TessellatedMesh();
-        G4VSolid * Solid_HPGeCrystal4 = mesh_CLOVERHPGeCrystal4->TessellatedMesh();
+        //              CLOVER HPGeCrystals - CADMesh or parametric
+        
+        G4VSolid * Solid_HPGeCrystal1;
+        G4VSolid * Solid_HPGeCrystal2;
+        G4VSolid * Solid_HPGeCrystal3;
+        G4VSolid * Solid_HPGeCrystal4;
+        
+        if(useCLOVER_Parametric)
+        {
+            Solid_HPGeCrystal1 = CLOVERParametricGeometry::HPGeCrystal("CLOVER_HPGeCrystal1", 0, offset_CLOVERHPGeCrystal1);
+            Solid_HPGeCrystal2 = CLOVERParametricGeometry::HPGeCrystal("CLOVER_HPGeCrystal2", 1, offset_CLOVERHPGeCrystal2);
+            Solid_HPGeCrystal3 = CLOVERParametricGeometry::HPGeCrystal("CLOVER_HPGeCrystal3", 2, offset_CLOVERHPGeCrystal3);
+            Solid_HPGeCrystal4 = CLOVERParametricGeometry::HPGeCrystal("CLOVER_HPGeCrystal4", 3, offset_CLOVERHPGeCrystal4);
+        }
+        else
+        {
+            //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-Crystal1.ply");
+            //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-RoundedCrystal1_10um.ply");
+            //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-RoundedCrystal1_10um_invertedNormals.ply");
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_RoundedCrystal1_10um.ply");
+            CachedCADMesh * mesh_CLOVERHPGeCrystal1 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal1, false);
+        
+            //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-Crystal2.ply");
+            //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-RoundedCrystal2_10um.ply");
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_RoundedCrystal2_10um.ply");
+            CachedCADMesh * mesh_CLOVERHPGeCrystal2 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal2, false);
+        
+            //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-Crystal3.ply");
+            //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-RoundedCrystal3_10um.ply");
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_RoundedCrystal3_10um.ply");
+            CachedCADMesh * mesh_CLOVERHPGeCrystal3 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal3, false);
+        
+            //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-Crystal4.ply");
+            //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe-RoundedCrystal4_10um.ply");
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_RoundedCrystal4_10um.ply");
+            CachedCADMesh * mesh_CLOVERHPGeCrystal4 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal4, false);
+
+            Solid_HPGeCrystal1 = mesh_CLOVERHPGeCrystal1->TessellatedMesh();
+            Solid_HPGeCrystal2 = mesh_CLOVERHPGeCrystal2->TessellatedMesh();
+            Solid_HPGeCrystal3 = mesh_CLOVERHPGeCrystal3->TessellatedMesh();
+            Solid_HPGeCrystal4 = mesh_CLOVERHPGeCrystal4->TessellatedMesh();
+        }
         
         Logic_CLOVER_HPGeCrystal[0] = new G4LogicalVolume(Solid_HPGeCrystal1, G4_Ge_Material,"LogicCLOVERHPGeCrystal",0,0,0);
         Logic_CLOVER_HPGeCrystal[1] = new G4LogicalVolume(Solid_HPGeCrystal2, G4_Ge_Material,"LogicCLOVERHPGeCrystal",0,0,0);
@@ -2874,24 +3502,39 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
         Logic_CLOVER_HPGeCrystal[3]->SetVisAttributes(CLOVER_HPGeCrystals_VisAtt);
         
         //////////////////////////////////////////////////////////////////////
-        //              CLOVER HPGeCrystals - Lithium contacts - CADMesh
+        //              CLOVER HPGeCrystals - Lithium contacts - CADMesh or parametric
 
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_LithiumContact1_10um.ply");
-        CADMesh * mesh_CLOVERHPGeCrystal1_LithiumContact = new CADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal1, false);
+        G4VSolid * Solid_HPGeCrystal1_LithiumContact;
+        G4VSolid * Solid_HPGeCrystal2_LithiumContact;
+        G4VSolid * Solid_HPGeCrystal3_LithiumContact;
+        G4VSolid * Solid_HPGeCrystal4_LithiumContact;
+        
+        if(useCLOVER_Parametric)
+        {
+            Solid_HPGeCrystal1_LithiumContact = CLOVERParametricGeometry::LithiumContact("CLOVER_HPGeCrystal1_LithiumContact", 0, offset_CLOVERHPGeCrystal1);
+            Solid_HPGeCrystal2_LithiumContact = CLOVERParametricGeometry::LithiumContact("CLOVER_HPGeCrystal2_LithiumContact", 1, offset_CLOVERHPGeCrystal2);
+            Solid_HPGeCrystal3_LithiumContact = CLOVERParametricGeometry::LithiumContact("CLOVER_HPGeCrystal3_LithiumContact", 2, offset_CLOVERHPGeCrystal3);
+            Solid_HPGeCrystal4_LithiumContact = CLOVERParametricGeometry::LithiumContact("CLOVER_HPGeCrystal4_LithiumContact", 3, offset_CLOVERHPGeCrystal4);
+        }
+        else
+        {
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_LithiumContact1_10um.ply");
+            CachedCADMesh * mesh_CLOVERHPGeCrystal1_LithiumContact = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal1, false);
 
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_LithiumContact2_10um.ply");
-        CADMesh * mesh_CLOVERHPGeCrystal2_LithiumContact = new CADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal2, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_LithiumContact2_10um.ply");
+            CachedCADMesh * mesh_CLOVERHPGeCrystal2_LithiumContact = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal2, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_LithiumContact3_10um.ply");
-        CADMesh * mesh_CLOVERHPGeCrystal3_LithiumContact = new CADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal3, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_LithiumContact3_10um.ply");
+            CachedCADMesh * mesh_CLOVERHPGeCrystal3_LithiumContact = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal3, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_LithiumContact4_10um.ply");
-        CADMesh * mesh_CLOVERHPGeCrystal4_LithiumContact = new CADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal4, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/HPGe-Crystals/HPGe_pureCylindricalBorehole_LithiumContact4_10um.ply");
+            CachedCADMesh * mesh_CLOVERHPGeCrystal4_LithiumContact = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVERHPGeCrystal4, false);
 
-        G4VSolid * Solid_HPGeCrystal1_LithiumContact = mesh_CLOVERHPGeCrystal1_LithiumContact->TessellatedMesh();
-        G4VSolid * Solid_HPGeCrystal2_LithiumContact = mesh_CLOVERHPGeCrystal2_LithiumContact->TessellatedMesh();
-        G4VSolid * Solid_HPGeCrystal3_LithiumContact = mesh_CLOVERHPGeCrystal3_LithiumContact->TessellatedMesh();
-        G4VSolid * Solid_HPGeCrystal4_LithiumContact = mesh_CLOVERHPGeCrystal4_LithiumContact->TessellatedMesh();
+            Solid_HPGeCrystal1_LithiumContact = mesh_CLOVERHPGeCrystal1_LithiumContact->TessellatedMesh();
+            Solid_HPGeCrystal2_LithiumContact = mesh_CLOVERHPGeCrystal2_LithiumContact->TessellatedMesh();
+            Solid_HPGeCrystal3_LithiumContact = mesh_CLOVERHPGeCrystal3_LithiumContact->TessellatedMesh();
+            Solid_HPGeCrystal4_LithiumContact = mesh_CLOVERHPGeCrystal4_LithiumContact->TessellatedMesh();
+        }
 
         Logic_CLOVER_HPGeCrystal_LithiumContact[0] = new G4LogicalVolume(Solid_HPGeCrystal1_LithiumContact, G4_Li_Material,"LogicCLOVERHPGeCrystal_LithiumContact",0,0,0);
         Logic_CLOVER_HPGeCrystal_LithiumContact[1] = new G4LogicalVolume(Solid_HPGeCrystal2_LithiumContact, G4_Li_Material,"LogicCLOVERHPGeCrystal_LithiumContact",0,0,0);
@@ -3050,7 +3693,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
         //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/Body/Body_Modified3_tol_10um.ply");
         //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/Body/Body_Modified4_tol_10um.ply");
         
-        CADMesh * mesh_CLOVER_Shield_Body = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_Body, false);
+        CachedCADMesh * mesh_CLOVER_Shield_Body = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_Body, false);
         
         G4VSolid * Solid_CLOVER_Shield_Body = mesh_CLOVER_Shield_Body->TessellatedMesh();
         
@@ -3088,7 +3731,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
         //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/Heavimet-Shield/HEAVIMET_47_5mm.ply");
         //sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/Heavimet-Shield/HEAVIMET_50mm.ply");
         
-        CADMesh * mesh_CLOVER_Shield_Heavimet = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_Heavimet, false);
+        CachedCADMesh * mesh_CLOVER_Shield_Heavimet = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_Heavimet, false);
         
         G4VSolid * Solid_CLOVER_Shield_Heavimet = mesh_CLOVER_Shield_Heavimet->TessellatedMesh();
         
@@ -3104,7 +3747,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
         
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMT-Connectors/PMT-ConnecterArray.ply");
-        CADMesh * mesh_CLOVER_Shield_PMTConArray = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMTConArray, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMTConArray = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMTConArray, false);
         
         G4VSolid * Solid_CLOVER_Shield_PMTConArray = mesh_CLOVER_Shield_PMTConArray->TessellatedMesh();
         
@@ -3112,126 +3755,136 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
         
         
         ///////////////////////////////////////////////////////
-        //      CLOVER Shield BGO Crystals - CADMesh
+        //      CLOVER Shield BGO Crystals - CADMesh or parametric
         ///////////////////////////////////////////////////////
         
-        /*
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal1.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal1 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+        G4VSolid * Solid_CLOVER_Shield_BGOCrystal[16];
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal2.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal2 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+        if(useCLOVER_Parametric)
+        {
+            for(G4int k=0; k<16; k++)
+            {
+                sprintf(meshPath, "CLOVER_Shield_BGOCrystal%d", k+1);
+                Solid_CLOVER_Shield_BGOCrystal[k] = CLOVERParametricGeometry::BGOCrystal(meshPath, k, offset_CLOVER_Shield_BGOCrystals);
+            }
+        }
+        else
+        {
+            /*
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal1.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal1 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal3.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal3 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal2.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal2 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal4.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal4 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal3.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal3 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal5.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal5 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal4.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal4 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal6.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal6 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal5.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal5 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal7.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal7 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal6.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal6 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal8.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal8 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal7.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal7 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal9.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal9 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal8.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal8 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal10.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal10 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal9.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal9 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal11.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal11 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal10.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal10 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal12.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal12 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal11.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal11 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal13.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal13 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal12.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal12 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal14.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal14 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal13.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal13 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal15.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal15 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal14.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal14 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal16.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal16 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
-        */
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal15.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal15 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_1.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal1 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal16.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal16 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            */
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_2.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal2 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_1.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal1 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_3.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal3 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_2.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal2 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_4.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal4 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_3.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal3 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_5.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal5 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_4.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal4 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_6.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal6 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_5.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal5 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_7.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal7 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_6.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal6 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_8.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal8 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_7.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal7 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_9.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal9 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_8.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal8 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_10.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal10 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_9.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal9 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_11.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal11 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_10.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal10 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_12.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal12 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_11.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal11 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_13.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal13 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_12.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal12 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_14.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal14 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_13.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal13 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_15.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal15 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_14.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal14 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_16.ply");
-        CADMesh * mesh_CLOVER_Shield_BGOCrystal16 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
-
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_15.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal15 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        G4VSolid * Solid_CLOVER_Shield_BGOCrystal[16];
+            sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/BGO-Crystals/BGO-Crystal_Modified_16.ply");
+            CachedCADMesh * mesh_CLOVER_Shield_BGOCrystal16 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_BGOCrystals, false);
         
-        Solid_CLOVER_Shield_BGOCrystal[0] = mesh_CLOVER_Shield_BGOCrystal1->TessellatedMesh();
-        Solid_CLOVER_Shield_BGOCrystal[1] = mesh_CLOVER_Shield_BGOCrystal2->TessellatedMesh();
-        Solid_CLOVER_Shield_BGOCrystal[2] = mesh_CLOVER_Shield_BGOCrystal3->TessellatedMesh();
-        Solid_CLOVER_Shield_BGOCrystal[3] = mesh_CLOVER_Shield_BGOCrystal4->TessellatedMesh();
-        Solid_CLOVER_Shield_BGOCrystal[4] = mesh_CLOVER_Shield_BGOCrystal5->TessellatedMesh();
-        Solid_CLOVER_Shield_BGOCrystal[5] = mesh_CLOVER_Shield_BGOCrystal6->TessellatedMesh();
-        Solid_CLOVER_Shield_BGOCrystal[6] = mesh_CLOVER_Shield_BGOCrystal7->TessellatedMesh();
-        Solid_CLOVER_Shield_BGOCrystal[7] = mesh_CLOVER_Shield_BGOCrystal8->TessellatedMesh();
-        Solid_CLOVER_Shield_BGOCrystal[8] = mesh_CLOVER_Shield_BGOCrystal9->TessellatedMesh();
-        Solid_CLOVER_Shield_BGOCrystal[9] = mesh_CLOVER_Shield_BGOCrystal10->TessellatedMesh();
-        Solid_CLOVER_Shield_BGOCrystal[10] = mesh_CLOVER_Shield_BGOCrystal11->TessellatedMesh();
-        Solid_CLOVER_Shield_BGOCrystal[11] = mesh_CLOVER_Shield_BGOCrystal12->TessellatedMesh();
-        Solid_CLOVER_Shield_BGOCrystal[12] = mesh_CLOVER_Shield_BGOCrystal13->TessellatedMesh();
-        Solid_CLOVER_Shield_BGOCrystal[13] = mesh_CLOVER_Shield_BGOCrystal14->TessellatedMesh();
-        Solid_CLOVER_Shield_BGOCrystal[14] = mesh_CLOVER_Shield_BGOCrystal15->TessellatedMesh();
-        Solid_CLOVER_Shield_BGOCrystal[15] = mesh_CLOVER_Shield_BGOCrystal16->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[0] = mesh_CLOVER_Shield_BGOCrystal1->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[1] = mesh_CLOVER_Shield_BGOCrystal2->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[2] = mesh_CLOVER_Shield_BGOCrystal3->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[3] = mesh_CLOVER_Shield_BGOCrystal4->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[4] = mesh_CLOVER_Shield_BGOCrystal5->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[5] = mesh_CLOVER_Shield_BGOCrystal6->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[6] = mesh_CLOVER_Shield_BGOCrystal7->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[7] = mesh_CLOVER_Shield_BGOCrystal8->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[8] = mesh_CLOVER_Shield_BGOCrystal9->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[9] = mesh_CLOVER_Shield_BGOCrystal10->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[10] = mesh_CLOVER_Shield_BGOCrystal11->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[11] = mesh_CLOVER_Shield_BGOCrystal12->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[12] = mesh_CLOVER_Shield_BGOCrystal13->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[13] = mesh_CLOVER_Shield_BGOCrystal14->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[14] = mesh_CLOVER_Shield_BGOCrystal15->TessellatedMesh();
+            Solid_CLOVER_Shield_BGOCrystal[15] = mesh_CLOVER_Shield_BGOCrystal16->TessellatedMesh();
+        }
         
         
         for(G4int k=0; k<16; k++)
@@ -3244,52 +3897,52 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
         ////////////////////////////////////
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT1.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT1 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT1 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT2.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT2 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT2 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT3.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT3 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT3 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT4.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT4 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT4 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT5.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT5 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT5 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT6.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT6 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT6 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT7.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT7 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT7 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT8.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT8 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT8 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT9.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT9 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT9 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT10.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT10 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT10 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT11.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT11 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT11 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT12.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT12 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT12 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT13.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT13 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT13 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT14.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT14 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT14 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT15.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT15 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT15 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         sprintf(meshPath, "../K600-ALBA/Mesh-Models/DETECTORS/CLOVER/Shield/PMTs/PMT16.ply");
-        CADMesh * mesh_CLOVER_Shield_PMT16 = new CADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
+        CachedCADMesh * mesh_CLOVER_Shield_PMT16 = new CachedCADMesh(meshPath, meshType, mm, offset_CLOVER_Shield_PMT, false);
         
         
         G4VSolid * Solid_CLOVER_Shield_PMT[16];
@@ -3720,6 +4373,8 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                               i,               // copy number
                               fCheckOverlaps); // checking overlaps
             
+            AddToRegion("CLOVER", Logic_CLOVER_Encasement);
+            AddToRegion("CLOVER", Logic_CLOVER_InternalVacuum[i]);
         }
         
         /*
@@ -3785,6 +4440,8 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                                                            i*16 + j,  // copy number
                                                            fCheckOverlaps); // checking overlaps
                 
+                AddToRegion("CLOVER_Shield", Logic_CLOVER_Shield_BGOCrystal[j]);
+                AddToRegion("Passive", Logic_CLOVER_Shield_PMT[j]);
             }
             
             /*
@@ -3808,6 +4465,8 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                               i,               // copy number
                               fCheckOverlaps); // checking overlaps
             
+            AddToRegion("Passive", Logic_CLOVER_Shield_Body);
+            AddToRegion("Passive", Logic_CLOVER_Shield_Heavimet);
             
         }
     }
@@ -3925,6 +4584,9 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                               i,               // copy number
                               fCheckOverlaps); // checking overlaps
             
+            AddToRegion("LEPS", Logic_LEPS_Encasement);
+            AddToRegion("LEPS", Logic_LEPS_Window);
+            AddToRegion("LEPS", Logic_LEPS_InternalVacuum[i]);
             
         }
         
@@ -4254,17 +4916,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
             LaBr3Ce_InternalVacuum_position[i] = (pentagonalDistance + ((LaBr3Ce_crystal_axialLength+LaBr3Ce_window_axialLength)/2.0)*mm)*vertex_pentagonFaces_truncatedIcosahedron[pentIndex].unit();
         }
         
-        G4ThreeVector positionVector = LaBr3Ce_InternalVacuum_position[i].unit();
-        
-        G4ThreeVector positionVector_z = positionVector.unit();
-        G4ThreeVector positionVector_y = (positionVector.orthogonal()).unit();
-        G4ThreeVector positionVector_x = (positionVector_y.cross(positionVector_z)).unit();
-        positionVector_z = -positionVector_z;
-        positionVector_y = -positionVector_y;
-        
-        G4RotationMatrix rotmPrime(positionVector_x, positionVector_y, positionVector_z);
-        
-        LaBr3Ce_rotm[i] = rotmPrime;
+        LaBr3Ce_rotm[i] = Rotation_ALBA_LaBr3Ce(LaBr3Ce_InternalVacuum_position[i]);
         
         LaBr3Ce_InternalVacuum_transform[i] = G4Transform3D(LaBr3Ce_rotm[i],LaBr3Ce_InternalVacuum_position[i]);
 
@@ -4342,6 +4994,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
                               i,               // copy number
                               fCheckOverlaps); // checking overlaps
             
+            AddToRegion("LaBr3Ce", Logic_LaBr3Ce_InternalVacuum[i]);
         }
     }
 
@@ -4425,12 +5078,43 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
     //////////////////////////////////////////////////
     
     
-    // A field object is held by a field manager
-    // Find the global Field Manager
-    G4TransportationManager* tmanagerMagneticField = G4TransportationManager::GetTransportationManager();
-    tmanagerMagneticField->GetPropagatorInField()->SetLargestAcceptableStep(1*mm);
-    G4double minStepMagneticField = 0.0025*mm ;
+    ////    The magnetic fields themselves are set up per thread in ConstructSDandField()
+    
     
+    //////////////////////////////////////////////////////
+    //              K600 - SPECTROMETER ENVELOPE
+    //////////////////////////////////////////////////////
+    
+    ////    Mother volume of the magnets and the transform from the world to it
+    G4LogicalVolume*    LogicK600_MagnetMother = LogicWorld;
+    G4Transform3D       K600_MagnetMother_transform;
+    
+    if(K600_Spectrometer_Envelope && (K600_Quadrupole || K600_Dipole1 || K600_Dipole2))
+    {
+        G4Box* Solid_K600_Envelope = new G4Box("Solid_K600_Envelope", K600_Envelope_HalfLengths.x(), K600_Envelope_HalfLengths.y(), K600_Envelope_HalfLengths.z());
+        
+        Logic_K600_Envelope = new G4LogicalVolume(Solid_K600_Envelope, G4_Galactic_Material,"Logic_K600_Envelope",0,0,0);
+        
+        PhysiK600_Envelope = new G4PVPlacement(0,               // no rotation
+                                               K600_Envelope_CentrePosition,
+                                               Logic_K600_Envelope,       // its logical volume
+                                               "K600_Envelope",       // its name
+                                               LogicWorld,         // its mother  volume
+                                               false,           // no boolean operations
+                                               0,               // copy number
+                                               fCheckOverlaps); // checking overlaps
+        
+        G4VisAttributes* K600_Envelope_VisAtt = new G4VisAttributes(G4Colour(1.0, 1.0, 1.0));
+        K600_Envelope_VisAtt->SetVisibility(false);
+        Logic_K600_Envelope->SetVisAttributes(K600_Envelope_VisAtt);
+        
+        ////    Fast simulation models are attached to the region per thread (ConstructSDandField)
+        K600_Spectrometer_Region = new G4Region("K600_Spectrometer");
+        K600_Spectrometer_Region->AddRootLogicalVolume(Logic_K600_Envelope);
+        
+        LogicK600_MagnetMother = Logic_K600_Envelope;
+        K600_MagnetMother_transform = G4Translate3D(-K600_Envelope_CentrePosition);
+    }
     
     //////////////////////////////////////////////////////
     //              K600 - QUADRUPOLE
@@ -4439,62 +5123,30 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
     if(K600_Quadrupole)
     {
         
-        G4RotationMatrix* K600_Q_MagField_rotm = new G4RotationMatrix;
-        //K600_Q_MagField_rotm->rotateX(90.*deg);
-        
         K600_Quadrupole_transform = G4Transform3D(K600_Quadrupole_rotm, K600_Quadrupole_CentrePosition);
         
-        G4Box* Solid_K600_Quadrupole = new G4Box("Solid_K600_Quadrupole", (50./2)*cm, (50./2)*cm, (30./2)*cm);
-        
-        G4LogicalVolume* Logic_K600_Quadrupole = new G4LogicalVolume(Solid_K600_Quadrupole, G4_Galactic_Material,"Logic_K600_Quadrupole",0,0,0);
+        G4double K600_Quadrupole_HalfLengthZ = (30./2)*cm;
+        G4Transform3D K600_Quadrupole_placement = K600_Quadrupole_transform;
         
-        ////    IDEAL MAGNETIC FIELD for QUADRUPOLE
-        if(Ideal_Quadrupole)
+        if(Logic_K600_Envelope)
         {
-            MagneticField_K600_Q = new G4QuadrupoleMagField(K600_Q_gradient, K600_Quadrupole_CentrePosition, K600_Q_MagField_rotm);
-            fEquationMagneticField_K600_Q = new G4Mag_UsualEqRhs(MagneticField_K600_Q);
-            
-            fieldManagerMagneticField_K600_Q = new G4FieldManager(MagneticField_K600_Q);
-            
-            stepperMagneticField_K600_Q = new G4ClassicalRK4( fEquationMagneticField_K600_Q );
-            fieldManagerMagneticField_K600_Q -> SetDetectorField(MagneticField_K600_Q);
-            
-            fChordFinder_K600_Q = new G4ChordFinder( MagneticField_K600_Q, minStepMagneticField, stepperMagneticField_K600_Q);
+            ////    The upstream part of the quadrupole lies inside the scattering chamber, where tracks from the
+            ////    target never see it. Only the part downstream of the face of the envelope is kept.
+            G4double zStart = std::max(K600_Quadrupole_CentrePosition.z() - K600_Quadrupole_HalfLengthZ, K600_Envelope_CentrePosition.z() - K600_Envelope_HalfLengths.z());
+            G4double zEnd = K600_Quadrupole_CentrePosition.z() + K600_Quadrupole_HalfLengthZ;
+            K600_Quadrupole_HalfLengthZ = (zEnd - zStart)/2;
             
-            Logic_K600_Quadrupole -> SetFieldManager(fieldManagerMagneticField_K600_Q, true) ;
-            
-            
-            //G4BlineTracer* theBlineTool = new G4BlineTracer();
-            //theBlineTool->ComputeBlines();
+            K600_Quadrupole_placement = K600_MagnetMother_transform*G4Transform3D(K600_Quadrupole_rotm, G4ThreeVector(K600_Quadrupole_CentrePosition.x(), K600_Quadrupole_CentrePosition.y(), (zStart + zEnd)/2));
         }
         
-        ////    MAPPED MAGNETIC FIELD for QUADRUPOLE
-        if(Mapped_Quadrupole)
-        {
-            
-            G4double z_Q_Offset = 4.4*mm+ 100*cm;
-            
-            G4MagneticField* PurgMagField = new MagneticFieldMapping("../K600-ALBA/MagneticFieldMaps/Quadrupole_MagneticFieldMap.TABLE", z_Q_Offset);
-            fEquationMagneticField_K600_Q = new G4Mag_UsualEqRhs(PurgMagField);
-            
-            fieldManagerMagneticField_K600_Q = new G4FieldManager(PurgMagField);
-            
-            stepperMagneticField_K600_Q = new G4ClassicalRK4( fEquationMagneticField_K600_Q );
-            fieldManagerMagneticField_K600_Q -> SetDetectorField(PurgMagField);
-            
-            fChordFinder_K600_Q = new G4ChordFinder( PurgMagField, minStepMagneticField, stepperMagneticField_K600_Q);
-            
-            Logic_K600_Quadrupole -> SetFieldManager(fieldManagerMagneticField_K600_Q, true) ;
-            
-            
-            //G4BlineTracer* theBlineTool = new G4BlineTracer();
-            
-        }
+        G4Box* Solid_K600_Quadrupole = new G4Box("Solid_K600_Quadrupole", (50./2)*cm, (50./2)*cm, K600_Quadrupole_HalfLengthZ);
         
-        PhysiK600_Quadrupole = new G4PVPlacement(K600_Quadrupole_transform,
+        Logic_K600_Quadrupole = new G4LogicalVolume(Solid_K600_Quadrupole, G4_Galactic_Material,"Logic_K600_Quadrupole",0,0,0);
+        
+        PhysiK600_Quadrupole = new G4PVPlacement(K600_Quadrupole_placement,
                                                  Logic_K600_Quadrupole,       // its logical volume
                                                  "K600_Quadrupole",       // its name
-                                                 LogicWorld,         // its mother  volume
+                                                 LogicK600_MagnetMother,         // its mother  volume
                                                  false,           // no boolean operations
                                                  0,               // copy number
                                                  fCheckOverlaps); // checking overlaps
@@ -4516,37 +5168,18 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
     
     if(K600_Dipole1)
     {
-        ////    MAGNETIC FIELD for DIPOLE 1
-        MagneticField_K600_D1 = new G4UniformMagField(G4ThreeVector(0., K600_Dipole1_BZ, 0.));
-        fEquationMagneticField_K600_D1 = new G4Mag_UsualEqRhs(MagneticField_K600_D1);
-        
-        fieldManagerMagneticField_K600_D1 = new G4FieldManager(MagneticField_K600_D1);
-        
-        stepperMagneticField_K600_D1 = new G4ClassicalRK4( fEquationMagneticField_K600_D1 );
-        fieldManagerMagneticField_K600_D1 -> SetDetectorField(MagneticField_K600_D1);
-        
-        fChordFinder_K600_D1 = new G4ChordFinder( MagneticField_K600_D1, minStepMagneticField, stepperMagneticField_K600_D1);
-        
-        
-        /////////////////////////////////////////////
-        
         K600_Dipole1_transform = G4Transform3D(K600_Dipole1_rotm, K600_Dipole1_CentrePosition);
         
         //G4Box* Solid_K600_Dipole1 = new G4Box("Solid_K600_Dipole1", (50./2)*cm, (50./2)*cm, (30./2)*cm);
         //G4Tubs* Solid_K600_Dipole1 = new G4Tubs("Solid_K600_Dipole1", 50.*cm, 100.0*cm, 30.*cm, 0.*deg, 40.*deg);
         G4Tubs* Solid_K600_Dipole1 = new G4Tubs("Solid_K600_Dipole1", 30.*cm, 150.0*cm, 30.*cm, 0.*deg, 40.*deg);
         
-        G4LogicalVolume* Logic_K600_Dipole1 = new G4LogicalVolume(Solid_K600_Dipole1, G4_Galactic_Material,"Logic_K600_Dipole1",0,0,0);
-        Logic_K600_Dipole1 -> SetFieldManager(fieldManagerMagneticField_K600_D1, true) ;
+        Logic_K600_Dipole1 = new G4LogicalVolume(Solid_K600_Dipole1, G4_Galactic_Material,"Logic_K600_Dipole1",0,0,0);
         
-        // Register the field and its manager for deleting
-        //G4AutoDelete::Register(MagneticField_K600_D1);
-        //G4AutoDelete::Register(fieldManagerMagneticField_K600_D1);
-        
-        PhysiK600_Dipole1 = new G4PVPlacement(K600_Dipole1_transform,
+        PhysiK600_Dipole1 = new G4PVPlacement(K600_MagnetMother_transform*K600_Dipole1_transform,
                                               Logic_K600_Dipole1,       // its logical volume
                                               "K600_Dipole1",       // its name
-                                              LogicWorld,         // its mother  volume
+                                              LogicK600_MagnetMother,         // its mother  volume
                                               false,           // no boolean operations
                                               0,               // copy number
                                               fCheckOverlaps); // checking overlaps
@@ -4561,34 +5194,17 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
     
     if(K600_Dipole2)
     {
-        
-        ////    MAGNETIC FIELD for DIPOLE 2
-        MagneticField_K600_D2 = new G4UniformMagField(G4ThreeVector(0., K600_Dipole2_BZ, 0.));
-        fEquationMagneticField_K600_D2 = new G4Mag_UsualEqRhs(MagneticField_K600_D2);
-        
-        fieldManagerMagneticField_K600_D2 = new G4FieldManager(MagneticField_K600_D2);
-        
-        stepperMagneticField_K600_D2 = new G4ClassicalRK4( fEquationMagneticField_K600_D2 );
-        fieldManagerMagneticField_K600_D2 -> SetDetectorField(MagneticField_K600_D2);
-        
-        fChordFinder_K600_D2 = new G4ChordFinder( MagneticField_K600_D2, minStepMagneticField, stepperMagneticField_K600_D2);
-        
-        
-        /////////////////////////////////////////////
-        
         K600_Dipole2_transform = G4Transform3D(K600_Dipole2_rotm, K600_Dipole2_CentrePosition);
         
         //G4Tubs* Solid_K600_Dipole2 = new G4Tubs("Solid_K600_Dipole2", 50.*cm, 100.0*cm, 30.*cm, 50.*deg, 70.*deg);
         G4Tubs* Solid_K600_Dipole2 = new G4Tubs("Solid_K600_Dipole2", 30.*cm, 150.0*cm, 30.*cm, 50.*deg, 70.*deg);
         
+        Logic_K600_Dipole2 = new G4LogicalVolume(Solid_K600_Dipole2, G4_Galactic_Material,"Logic_K600_Dipole2",0,0,0);
         
-        G4LogicalVolume* Logic_K600_Dipole2 = new G4LogicalVolume(Solid_K600_Dipole2, G4_Galactic_Material,"Logic_K600_Dipole2",0,0,0);
-        Logic_K600_Dipole2 -> SetFieldManager(fieldManagerMagneticField_K600_D2, true) ;
-        
-        PhysiK600_Dipole2 = new G4PVPlacement(K600_Dipole2_transform,
+        PhysiK600_Dipole2 = new G4PVPlacement(K600_MagnetMother_transform*K600_Dipole2_transform,
                                               Logic_K600_Dipole2,       // its logical volume
                                               "K600_Dipole2",       // its name
-                                              LogicWorld,         // its mother  volume
+                                              LogicK600_MagnetMother,         // its mother  volume
                                               false,           // no boolean operations
                                               0,               // copy number
                                               fCheckOverlaps); // checking overlaps
@@ -4668,43 +5284,23 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
     G4VisAttributes* VDC_X_WIRE_VisAtt = new G4VisAttributes(G4Colour(0., 0.7, 0.7));
     VDC_X_WIRE_VisAtt->SetForceSolid(true);
     
-    //  VDC - X GUARD WIRES
-    G4VisAttributes* VDC_X_GUARDWIRE_VisAtt = new G4VisAttributes(G4Colour(1.0, 1.0, 1.0));
-    VDC_X_GUARDWIRE_VisAtt->SetVisibility(false);
-    VDC_X_GUARDWIRE_VisAtt->SetForceSolid(true);
-    
     //  VDC - U WIRES
     G4VisAttributes* VDC_U_WIRE_VisAtt = new G4VisAttributes(G4Colour(1.0, 1.0, 0.));
     VDC_U_WIRE_VisAtt->SetForceSolid(true);
     
-    //  VDC - U GUARD WIRES
-    G4VisAttributes* VDC_U_GUARDWIRE_VisAtt = new G4VisAttributes(G4Colour(1.0, 1.0, 1.0));
-    VDC_U_GUARDWIRE_VisAtt->SetVisibility(false);
-    VDC_U_GUARDWIRE_VisAtt->SetForceSolid(true);
+    //  VDC - WIRE PLANES
+    G4VisAttributes* VDC_WirePlane_VisAtt = new G4VisAttributes(G4Colour(1.0, 1.0, 1.0));
+    VDC_WirePlane_VisAtt->SetVisibility(false);
     
     Logic_VDC_GasFrame->SetVisAttributes(VDC_GasFrame_VisAtt);
     Logic_VDC_XU_Frame->SetVisAttributes(VDC_XU_Frame_VisAtt);
     Logic_VDC_XU_PCBFrame->SetVisAttributes(VDC_XU_PCBFrame_VisAtt);
     Logic_VDC_Al_Frame->SetVisAttributes(VDC_Al_Frame_VisAtt);
     Logic_VDC_MYLAR_Plane->SetVisAttributes(VDC_MYLAR_Plane_VisAtt);
+    Logic_VDC_X_WirePlane->SetVisAttributes(VDC_WirePlane_VisAtt);
+    Logic_VDC_U_WirePlane->SetVisAttributes(VDC_WirePlane_VisAtt);
     Logic_VDC_X_WIRE->SetVisAttributes(VDC_X_WIRE_VisAtt);
-    Logic_VDC_X_GUARDWIRE->SetVisAttributes(VDC_X_GUARDWIRE_VisAtt);
-    Logic_VDC_X_GUARDWIRE_Thick->SetVisAttributes(VDC_X_GUARDWIRE_VisAtt);
-    
-    for(G4int k=0; k<143; k++)
-    {
-        Logic_VDC_U_WIRE[k]->SetVisAttributes(VDC_U_WIRE_VisAtt);
-    }
-    
-    for(G4int k=0; k<144; k++)
-    {
-        Logic_VDC_U_GUARDWIRE[k]->SetVisAttributes(VDC_U_GUARDWIRE_VisAtt);
-    }
-    
-    for(G4int k=0; k<2; k++)
-    {
-        Logic_VDC_U_GUARDWIRE_Thick[k]->SetVisAttributes(VDC_U_GUARDWIRE_VisAtt);
-    }
+    Logic_VDC_U_WIRE->SetVisAttributes(VDC_U_WIRE_VisAtt);
     
     for(G4int k=0; k<3; k++)
     {
@@ -4807,11 +5403,12 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
         
     }
     
+    Logic_CAKE_AA_RS->SetVisAttributes(CAKE_AA_RS_VisAtt);
+    
     for(G4int j=0; j<16; j++)
     {
         for(G4int l=0; l<8; l++)
         {
-            Logic_CAKE_AA_RS[j][l]->SetVisAttributes(CAKE_AA_RS_VisAtt);
             Logic_CAKE_RS_punch[j][l]->SetVisAttributes(CAKE_AA_RS_VisAtt);
             
         }
@@ -5136,11 +5733,103 @@ void DetectorConstruction::SetupTruncatedIcosahedron()
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void DetectorConstruction::ConstructSDandField()
+{
+    ////    Called on every worker thread (and on the master in sequential mode).
+    ////    Steppers, chord finders and field managers hold tracking state and are
+    ////    therefore created per thread; the field map data is shared read-only.
+    
+    ConstructField();
+    
+    G4TransportationManager* tmanagerMagneticField = G4TransportationManager::GetTransportationManager();
+    tmanagerMagneticField->GetPropagatorInField()->SetLargestAcceptableStep(largestAcceptableStepMagneticField);
+    
+    if(!fFieldMessenger)
+    {
+        fFieldMessenger = new K600FieldMessenger();
+        G4AutoDelete::Register(fFieldMessenger);
+    }
+    
+    //////////////////////////////////////////////////////
+    //              K600 - QUADRUPOLE
+    if(K600_Quadrupole && Logic_K600_Quadrupole)
+    {
+        G4MagneticField* magneticField_K600_Q = 0;
+        
+        ////    IDEAL MAGNETIC FIELD for QUADRUPOLE
+        if(Ideal_Quadrupole) magneticField_K600_Q = new G4QuadrupoleMagField(K600_Q_gradient, K600_Quadrupole_CentrePosition, K600_Q_MagField_rotm);
+        
+        ////    MAPPED MAGNETIC FIELD for QUADRUPOLE
+        if(Mapped_Quadrupole) magneticField_K600_Q = new MagneticFieldMapping(K600_Q_FieldMapFile.c_str(), K600_Q_FieldMapOffset, K600_Q_FieldMapOptions);
+        
+        ////    FITTED MULTIPOLE EXPANSION for QUADRUPOLE
+        if(Fitted_Quadrupole) magneticField_K600_Q = new MultipoleFieldExpansion(K600_Q_MultipoleFile, K600_Q_FieldMapOffset);
+        
+        if(magneticField_K600_Q)
+        {
+            fFieldSetup_K600_Q = new K600FieldSetup(magneticField_K600_Q, minStepMagneticField);
+            G4AutoDelete::Register(fFieldSetup_K600_Q);
+            fFieldMessenger->AddMagnet("quadrupole", fFieldSetup_K600_Q);
+            
+            Logic_K600_Quadrupole -> SetFieldManager(fFieldSetup_K600_Q->GetFieldManager(), true) ;
+        }
+        
+        //G4BlineTracer* theBlineTool = new G4BlineTracer();
+    }
+    
+    //////////////////////////////////////////////////////
+    //              K600 - DIPOLE 1
+    if(K600_Dipole1 && Logic_K600_Dipole1)
+    {
+        G4MagneticField* magneticField_K600_D1 = 0;
+        
+        if(K600_Dipole1_FieldMapFile.empty()) magneticField_K600_D1 = new G4UniformMagField(G4ThreeVector(0., K600_Dipole1_BZ, 0.));
+        else magneticField_K600_D1 = new MagneticFieldMapping(K600_Dipole1_FieldMapFile.c_str(), 0., K600_Dipole_FieldMapOptions);
+        
+        fFieldSetup_K600_D1 = new K600FieldSetup(magneticField_K600_D1, minStepMagneticField);
+        G4AutoDelete::Register(fFieldSetup_K600_D1);
+        fFieldMessenger->AddMagnet("dipole1", fFieldSetup_K600_D1);
+        
+        Logic_K600_Dipole1 -> SetFieldManager(fFieldSetup_K600_D1->GetFieldManager(), true) ;
+    }
+    
+    //////////////////////////////////////////////////////
+    //              K600 - DIPOLE 2
+    if(K600_Dipole2 && Logic_K600_Dipole2)
+    {
+        G4MagneticField* magneticField_K600_D2 = 0;
+        
+        if(K600_Dipole2_FieldMapFile.empty()) magneticField_K600_D2 = new G4UniformMagField(G4ThreeVector(0., K600_Dipole2_BZ, 0.));
+        else magneticField_K600_D2 = new MagneticFieldMapping(K600_Dipole2_FieldMapFile.c_str(), 0., K600_Dipole_FieldMapOptions);
+        
+        fFieldSetup_K600_D2 = new K600FieldSetup(magneticField_K600_D2, minStepMagneticField);
+        G4AutoDelete::Register(fFieldSetup_K600_D2);
+        fFieldMessenger->AddMagnet("dipole2", fFieldSetup_K600_D2);
+        
+        Logic_K600_Dipole2 -> SetFieldManager(fFieldSetup_K600_D2->GetFieldManager(), true) ;
+    }
+    
+    //////////////////////////////////////////////////////
+    //              K600 - TRANSFER-MAP FAST SIMULATION
+    ////    Replaces the tracking through the magnets where the map is valid
+    ////    (requires G4FastSimulationPhysics, see K600.cc)
+    if(K600_Spectrometer_Region && !K600_TransferMap_File.empty())
+    {
+        SpectrometerFastSimModel* transferMapModel = new SpectrometerFastSimModel("K600_TransferMap", K600_Spectrometer_Region, K600_TransferMap_File);
+        G4AutoDelete::Register(transferMapModel);
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void DetectorConstruction::ConstructField()
 {
-    // Create global magnetic field messenger.
+    // Create global magnetic field messenger, once per thread
+    // (ConstructSDandField is called again when the geometry is rebuilt).
     // Uniform magnetic field is then created automatically if
     // the field value is not zero.
+    if(fMagFieldMessenger) return;
+    
     G4ThreeVector fieldValue = G4ThreeVector();
     //G4ThreeVector fieldValue = G4ThreeVector(0., 5*tesla, 0.);
     
@@ -5165,56 +5854,82 @@ void DetectorConstruction::SetupPreconfiguredVersion(int a)
     LaBR3Ce_automaticOrientation = true;
     configuration_truncatedIcosahedron_hexagons = true;
 
-    if(LaBr3CeSetupVersion==-1)
+    //      -1: Work for Christiaan/Mathis/Katarzyna (distances set per detector)
+    if(LaBr3CeSetupVersion>=0)
     {
-        //--------------------------------
-        //      Work for Christiaan/Mathis/Katarzyna
+        LaBR3Ce_GlobalDistance = PreconfiguredDistance_ALBA_LaBr3Ce(LaBr3CeSetupVersion);
     }
-    else if(LaBr3CeSetupVersion==0)
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double DetectorConstruction::PreconfiguredDistance_ALBA_LaBr3Ce(int a) const
+{
+    G4double distance = 0.0;
+    
+    if(a==0)
     {
         //  Full cylindrical crystal (untapered)
-        LaBR3Ce_GlobalDistance = 13.2*cm;
+        distance = 13.2*cm;
     }
-    else if(LaBr3CeSetupVersion==1)
+    else if(a==1)
     {
-        LaBR3Ce_GlobalDistance = 12.0*cm;
+        distance = 12.0*cm;
     }
-    else if(LaBr3CeSetupVersion==2)
+    else if(a==2)
     {
-        LaBR3Ce_GlobalDistance = 11.0*cm;
+        distance = 11.0*cm;
     }
-    else if(LaBr3CeSetupVersion==3)
+    else if(a==3)
     {
-        LaBR3Ce_GlobalDistance = 10.0*cm;
+        distance = 10.0*cm;
     }
-    else if(LaBr3CeSetupVersion==4)
+    else if(a==4)
     {
-        LaBR3Ce_GlobalDistance = 9.0*cm;
+        distance = 9.0*cm;
     }
-    else if(LaBr3CeSetupVersion==5)
+    else if(a==5)
     {
-        LaBR3Ce_GlobalDistance = 8.0*cm;
+        distance = 8.0*cm;
     }
-    else if(LaBr3CeSetupVersion==6)
+    else if(a==6)
     {
-        LaBR3Ce_GlobalDistance = 7.0*cm;
+        distance = 7.0*cm;
     }
-    else if(LaBr3CeSetupVersion==7)
+    else if(a==7)
     {
-        LaBR3Ce_GlobalDistance = 6.0*cm;
+        distance = 6.0*cm;
     }
-    else if(LaBr3CeSetupVersion==8)
+    else if(a==8)
     {
-        LaBR3Ce_GlobalDistance = 8.9632*cm;
+        distance = 8.9632*cm;
     }
-    else if(LaBr3CeSetupVersion==9)
+    else if(a==9)
     {
-        LaBR3Ce_GlobalDistance = 10.0*cm;
+        distance = 10.0*cm;
     }
-    else if(LaBr3CeSetupVersion==10)
+    else if(a==10)
     {
-        LaBR3Ce_GlobalDistance = 12.0*cm;
+        distance = 12.0*cm;
     }
+    
+    return distance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4RotationMatrix DetectorConstruction::Rotation_ALBA_LaBr3Ce(const G4ThreeVector& direction) const
+{
+    ////    Detector axis along the direction, facing the target
+    G4ThreeVector positionVector = direction.unit();
+    
+    G4ThreeVector positionVector_z = positionVector.unit();
+    G4ThreeVector positionVector_y = (positionVector.orthogonal()).unit();
+    G4ThreeVector positionVector_x = (positionVector_y.cross(positionVector_z)).unit();
+    positionVector_z = -positionVector_z;
+    positionVector_y = -positionVector_y;
+    
+    return G4RotationMatrix(positionVector_x, positionVector_y, positionVector_z);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
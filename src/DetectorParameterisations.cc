@@ -0,0 +1,190 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "DetectorParameterisations.hh"
+
+#include "G4Tubs.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VTouchable.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ParameterisedSubtractionSolid::ParameterisedSubtractionSolid(const G4String& name,
+                                                             G4VSolid* solidA,
+                                                             G4VSolid* solidB,
+                                                             G4RotationMatrix* rotMatrix,
+                                                             const G4ThreeVector& transVector)
+: G4SubtractionSolid(name, solidA, solidB, rotMatrix, transVector)
+{
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ParameterisedSubtractionSolid::ParameterisedSubtractionSolid(const G4String& name,
+                                                             G4VSolid* solidA,
+                                                             G4VSolid* solidB)
+: G4SubtractionSolid(name, solidA, solidB)
+{
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ParameterisedSubtractionSolid::ComputeDimensions(G4VPVParameterisation*, const G4int, const G4VPhysicalVolume*)
+{
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CAKEPixelParameterisation::CAKEPixelParameterisation(const std::vector<G4VSolid*>& solids, const G4ThreeVector& offset)
+: G4VPVParameterisation(),
+fSolids(solids),
+fOffset(offset)
+{
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CAKEPixelParameterisation::~CAKEPixelParameterisation()
+{
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CAKEPixelParameterisation::ComputeTransformation(const G4int, G4VPhysicalVolume* physVol) const
+{
+    physVol->SetTranslation(fOffset);
+    physVol->SetRotation(0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VSolid* CAKEPixelParameterisation::ComputeSolid(const G4int copyNo, G4VPhysicalVolume*)
+{
+    return fSolids[copyNo];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int CAKEPixelParameterisation::GetChannel(const G4VTouchable* touchable)
+{
+    return 128*touchable->GetCopyNumber(1) + touchable->GetReplicaNumber(0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+VDCWireParameterisation::VDCWireParameterisation(G4double angle, G4double halfWidth, G4double halfHeight)
+: G4VPVParameterisation(),
+fRotation(new G4RotationMatrix()),
+fDirection(-std::sin(angle), std::cos(angle), 0.),
+fHalfWidth(halfWidth),
+fHalfHeight(halfHeight)
+{
+    ////    The G4Tubs axis (z) onto the wire direction; SetRotation() takes the inverse (frame) rotation
+    G4RotationMatrix wireRotation;
+    wireRotation.rotateX(-90.*deg);
+    wireRotation.rotateZ(angle);
+    
+    *fRotation = wireRotation.inverse();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+VDCWireParameterisation::~VDCWireParameterisation()
+{
+    delete fRotation;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int VDCWireParameterisation::AddWire(G4double x, G4double radius)
+{
+    const G4double dx = fDirection.x();
+    const G4double dy = fDirection.y();
+    
+    ////    Path length s along the wire from (x, 0), clipped to the window
+    G4double sMin = -DBL_MAX, sMax = DBL_MAX;
+    G4double trimMin = 0., trimMax = 0.;
+    
+    if(std::fabs(dx) > 0.)
+    {
+        G4double s1 = (-fHalfWidth - x)/dx, s2 = (fHalfWidth - x)/dx;
+        
+        ////    At the x edges, the end faces reach r|dy|/|dx| further in x than the axis
+        if(std::min(s1, s2) > sMin) {sMin = std::min(s1, s2); trimMin = radius*std::fabs(dy/dx);}
+        if(std::max(s1, s2) < sMax) {sMax = std::max(s1, s2); trimMax = radius*std::fabs(dy/dx);}
+    }
+    
+    if(std::fabs(dy) > 0.)
+    {
+        G4double s1 = -fHalfHeight/dy, s2 = fHalfHeight/dy;
+        
+        if(std::min(s1, s2) > sMin) {sMin = std::min(s1, s2); trimMin = radius*std::fabs(dx/dy);}
+        if(std::max(s1, s2) < sMax) {sMax = std::max(s1, s2); trimMax = radius*std::fabs(dx/dy);}
+    }
+    
+    sMin += trimMin;
+    sMax -= trimMax;
+    
+    Wire wire;
+    wire.centre = G4ThreeVector(x, 0., 0.) + 0.5*(sMin + sMax)*fDirection;
+    wire.radius = radius;
+    wire.halfLength = 0.5*(sMax - sMin);
+    
+    fWires.push_back(wire);
+    
+    return G4int(fWires.size()) - 1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void VDCWireParameterisation::ComputeTransformation(const G4int copyNo, G4VPhysicalVolume* physVol) const
+{
+    physVol->SetTranslation(fWires[copyNo].centre);
+    physVol->SetRotation(fRotation);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void VDCWireParameterisation::ComputeDimensions(G4Tubs& wire, const G4int copyNo, const G4VPhysicalVolume*) const
+{
+    wire.SetOuterRadius(fWires[copyNo].radius);
+    wire.SetZHalfLength(fWires[copyNo].halfLength);
+}
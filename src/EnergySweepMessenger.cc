@@ -0,0 +1,252 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "EnergySweepMessenger.hh"
+#include "EnergySweepScheduler.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4UnitsTable.hh"
+
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+namespace {
+    ////    True for a defined unit of the Energy category, otherwise a warning
+    G4bool IsEnergyUnit(const G4String& unit, const char* command)
+    {
+        if(G4UnitDefinition::IsUnitDefined(unit) && G4UnitDefinition::GetCategory(unit)=="Energy") return true;
+        
+        G4ExceptionDescription msg;
+        msg << "\"" << unit << "\" is not an energy unit, " << command << " is ignored.";
+        G4Exception("EnergySweepMessenger::SetNewValue()", "EnergySweep0003", JustWarning, msg);
+        
+        return false;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EnergySweepMessenger::EnergySweepMessenger(EnergySweepScheduler* scheduler)
+: G4UImessenger(),
+fScheduler(scheduler)
+{
+    fSweepDirectory = new G4UIdirectory("/K600/sweep/");
+    fSweepDirectory->SetGuidance("Sweep of the particle gun over a list of energies (efficiency curves).");
+    
+    fEnergiesCmd = new G4UIcmdWithAString("/K600/sweep/energies", this);
+    fEnergiesCmd->SetGuidance("Replace the energy list, e.g. \"100 133.2 200 keV\" (the unit defaults to MeV).");
+    fEnergiesCmd->SetParameterName("energies", false);
+    
+    fAddEnergyCmd = new G4UIcmdWithADoubleAndUnit("/K600/sweep/addEnergy", this);
+    fAddEnergyCmd->SetGuidance("Append one energy to the list.");
+    fAddEnergyCmd->SetParameterName("energy", false);
+    fAddEnergyCmd->SetRange("energy>0.");
+    fAddEnergyCmd->SetUnitCategory("Energy");
+    
+    fRangeCmd = new G4UIcommand("/K600/sweep/range", this);
+    fRangeCmd->SetGuidance("Append n equally spaced energies from Emin to Emax (inclusive).");
+    G4UIparameter* eMin = new G4UIparameter("Emin", 'd', false);
+    G4UIparameter* eMax = new G4UIparameter("Emax", 'd', false);
+    G4UIparameter* n = new G4UIparameter("n", 'i', false);
+    G4UIparameter* unit = new G4UIparameter("unit", 's', true);
+    n->SetParameterRange("n>0");
+    unit->SetDefaultValue("MeV");
+    fRangeCmd->SetParameter(eMin);
+    fRangeCmd->SetParameter(eMax);
+    fRangeCmd->SetParameter(n);
+    fRangeCmd->SetParameter(unit);
+    
+    fClearCmd = new G4UIcmdWithoutParameter("/K600/sweep/clear", this);
+    fClearCmd->SetGuidance("Clear the energy list.");
+    
+    fEventsPerEnergyCmd = new G4UIcmdWithAnInteger("/K600/sweep/eventsPerEnergy", this);
+    fEventsPerEnergyCmd->SetGuidance("Maximum number of events simulated per energy.");
+    fEventsPerEnergyCmd->SetParameterName("n", false);
+    fEventsPerEnergyCmd->SetRange("n>0");
+    
+    fChunkSizeCmd = new G4UIcmdWithAnInteger("/K600/sweep/chunkSize", this);
+    fChunkSizeCmd->SetGuidance("Number of events per work unit handed out to a thread.");
+    fChunkSizeCmd->SetParameterName("n", false);
+    fChunkSizeCmd->SetRange("n>0");
+    
+    fPrecisionCmd = new G4UIcmdWithADouble("/K600/sweep/precision", this);
+    fPrecisionCmd->SetGuidance("Relative statistical uncertainty of the full-energy efficiency at which an energy is stopped.");
+    fPrecisionCmd->SetGuidance("0 disables the target and always simulates eventsPerEnergy events.");
+    fPrecisionCmd->SetParameterName("relError", false);
+    fPrecisionCmd->SetRange("relError>=0.");
+    
+    fFullEnergyWindowCmd = new G4UIcmdWithADoubleAndUnit("/K600/sweep/fullEnergyWindow", this);
+    fFullEnergyWindowCmd->SetGuidance("Half-width of the window around the gun energy counted as a full-energy event.");
+    fFullEnergyWindowCmd->SetParameterName("window", false);
+    fFullEnergyWindowCmd->SetRange("window>0.");
+    fFullEnergyWindowCmd->SetUnitCategory("Energy");
+    
+    fOutputPrefixCmd = new G4UIcmdWithAString("/K600/sweep/outputPrefix", this);
+    fOutputPrefixCmd->SetGuidance("Prefix of the per-energy output and summary files.");
+    fOutputPrefixCmd->SetParameterName("prefix", false);
+    
+    fResumeCmd = new G4UIcmdWithABool("/K600/sweep/resume", this);
+    fResumeCmd->SetGuidance("Skip energies whose summary file already exists.");
+    fResumeCmd->SetParameterName("resume", true);
+    fResumeCmd->SetDefaultValue(true);
+    
+    fBeamOnCmd = new G4UIcmdWithoutParameter("/K600/sweep/beamOn", this);
+    fBeamOnCmd->SetGuidance("Run the sweep: one run per energy.");
+    fBeamOnCmd->AvailableForStates(G4State_Idle);
+    
+    ////    Configuration and execution belong to the master only
+    fEnergiesCmd->SetToBeBroadcasted(false);
+    fAddEnergyCmd->SetToBeBroadcasted(false);
+    fRangeCmd->SetToBeBroadcasted(false);
+    fClearCmd->SetToBeBroadcasted(false);
+    fEventsPerEnergyCmd->SetToBeBroadcasted(false);
+    fChunkSizeCmd->SetToBeBroadcasted(false);
+    fPrecisionCmd->SetToBeBroadcasted(false);
+    fFullEnergyWindowCmd->SetToBeBroadcasted(false);
+    fOutputPrefixCmd->SetToBeBroadcasted(false);
+    fResumeCmd->SetToBeBroadcasted(false);
+    fBeamOnCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EnergySweepMessenger::~EnergySweepMessenger()
+{
+    delete fEnergiesCmd;
+    delete fAddEnergyCmd;
+    delete fRangeCmd;
+    delete fClearCmd;
+    delete fEventsPerEnergyCmd;
+    delete fChunkSizeCmd;
+    delete fPrecisionCmd;
+    delete fFullEnergyWindowCmd;
+    delete fOutputPrefixCmd;
+    delete fResumeCmd;
+    delete fBeamOnCmd;
+    delete fSweepDirectory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EnergySweepMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fEnergiesCmd)
+    {
+        ////    Numbers followed by an optional unit
+        std::istringstream input(newValue);
+        std::vector<G4double> values;
+        G4String token;
+        G4double unit = G4UIcommand::ValueOf("MeV");
+        
+        while(input >> token)
+        {
+            char* end = 0;
+            const G4double value = std::strtod(token.c_str(), &end);
+            
+            if(end!=token.c_str() && *end=='\0') values.push_back(value);
+            else if(IsEnergyUnit(token, "/K600/sweep/energies")) unit = G4UIcommand::ValueOf(token);
+            else return;
+        }
+        
+        fScheduler->ClearEnergies();
+        for(size_t i=0; i<values.size(); i++) fScheduler->AddEnergy(values[i]*unit);
+    }
+    else if(command==fAddEnergyCmd)
+    {
+        fScheduler->AddEnergy(fAddEnergyCmd->GetNewDoubleValue(newValue));
+    }
+    else if(command==fRangeCmd)
+    {
+        std::istringstream input(newValue);
+        G4double eMin, eMax;
+        G4int n;
+        G4String unit;
+        input >> eMin >> eMax >> n >> unit;
+        
+        if(!IsEnergyUnit(unit, "/K600/sweep/range")) return;
+        
+        const G4double scale = G4UIcommand::ValueOf(unit);
+        
+        for(G4int i=0; i<n; i++)
+        {
+            const G4double energy = (n>1) ? eMin + i*(eMax - eMin)/(n-1) : eMin;
+            fScheduler->AddEnergy(energy*scale);
+        }
+    }
+    else if(command==fClearCmd)
+    {
+        fScheduler->ClearEnergies();
+    }
+    else if(command==fEventsPerEnergyCmd)
+    {
+        fScheduler->SetEventsPerEnergy(fEventsPerEnergyCmd->GetNewIntValue(newValue));
+    }
+    else if(command==fChunkSizeCmd)
+    {
+        fScheduler->SetChunkSize(fChunkSizeCmd->GetNewIntValue(newValue));
+    }
+    else if(command==fPrecisionCmd)
+    {
+        fScheduler->SetPrecisionTarget(fPrecisionCmd->GetNewDoubleValue(newValue));
+    }
+    else if(command==fFullEnergyWindowCmd)
+    {
+        fScheduler->SetFullEnergyWindow(fFullEnergyWindowCmd->GetNewDoubleValue(newValue));
+    }
+    else if(command==fOutputPrefixCmd)
+    {
+        fScheduler->SetOutputPrefix(newValue);
+    }
+    else if(command==fResumeCmd)
+    {
+        fScheduler->SetResume(fResumeCmd->GetNewBoolValue(newValue));
+    }
+    else if(command==fBeamOnCmd)
+    {
+        fScheduler->RunSweep();
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,377 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "EnergySweepScheduler.hh"
+#include "EnergySweepMessenger.hh"
+
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace {
+    ////    Minimum number of full-energy events before the precision target is trusted
+    const G4long kMinimumFullEnergyCounts = 100;
+    
+    ////    The work unit of one thread (kept POD for G4ThreadLocal)
+    struct SweepWorkUnit
+    {
+        G4int       runSerial;
+        G4long      next, end;
+        G4bool      pending;            // an event has been reserved and not yet recorded
+        G4long      nEvents;
+        G4double    sumW, sumW2;
+        G4double    sumWFull, sumW2Full;
+        G4long      nFull;
+    };
+    
+    G4ThreadLocal SweepWorkUnit tlWorkUnit = {-1, 0, 0, false, 0, 0., 0., 0., 0., 0};
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EnergySweepScheduler* EnergySweepScheduler::Instance()
+{
+    static EnergySweepScheduler instance;
+    return &instance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EnergySweepScheduler::EnergySweepScheduler()
+: fEventsPerEnergy(1000000),
+fChunkSize(1000),
+fPrecisionTarget(0.0),
+fFullEnergyWindow(5.0*keV),
+fOutputPrefix("K600Output"),
+fResume(false),
+fActive(false),
+fCurrentEnergy(-1),
+fRunSerial(0),
+fNextEvent(0),
+fEnergyComplete(false),
+fMessenger(0)
+{
+    fTally = Tally();
+    fMessenger = new EnergySweepMessenger(this);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EnergySweepScheduler::~EnergySweepScheduler()
+{
+    delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EnergySweepScheduler::RunSweep()
+{
+    if(fEnergies.empty() || fEventsPerEnergy<=0)
+    {
+        G4Exception("EnergySweepScheduler::RunSweep()", "EnergySweep0001", JustWarning,
+                    "No energies or no events per energy are defined, nothing to do.");
+        return;
+    }
+    
+    ////    One BeamOn per energy, whose event count is a G4int
+    if(fEventsPerEnergy>std::numeric_limits<G4int>::max())
+    {
+        G4ExceptionDescription msg;
+        msg << fEventsPerEnergy << " events per energy exceed the " << std::numeric_limits<G4int>::max()
+        << " events of a single run, the sweep is not started.";
+        G4Exception("EnergySweepScheduler::RunSweep()", "EnergySweep0002", JustWarning, msg);
+        return;
+    }
+    
+    G4RunManager* runManager = G4RunManager::GetRunManager();
+    std::vector<EnergySweepResult> results;
+    
+    for(G4int i=0; i<(G4int) fEnergies.size(); i++)
+    {
+        EnergySweepResult result;
+        
+        if(fResume && ReadSummary(fEnergies[i], result))
+        {
+            G4cout << "EnergySweepScheduler: " << fEnergies[i]/keV << " keV already simulated, skipping" << G4endl;
+            results.push_back(result);
+            continue;
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fCurrentEnergy = i;
+            fRunSerial++;
+            fNextEvent = 0;
+            fEnergyComplete = false;
+            fTally = Tally();
+            fActive = true;
+        }
+        
+        G4cout << "EnergySweepScheduler: energy " << i+1 << "/" << fEnergies.size()
+        << " (" << fEnergies[i]/keV << " keV), up to " << fEventsPerEnergy << " events" << G4endl;
+        
+        runManager->BeamOn((G4int) fEventsPerEnergy);
+        
+        result = GetResult();
+        WriteSummary(result);
+        results.push_back(result);
+        
+        G4cout << "EnergySweepScheduler: " << result.energy/keV << " keV, " << result.nEvents << " events, "
+        << "full-energy efficiency " << result.fullEnergyEfficiency << " +/- " << result.fullEnergyEfficiencyError << G4endl;
+    }
+    
+    fActive = false;
+    fCurrentEnergy = -1;
+    
+    WriteSweepTable(results);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String EnergySweepScheduler::GetOutputFileName() const
+{
+    if(!fActive || fCurrentEnergy<0) return fOutputPrefix;
+    
+    return GetFileStem(fEnergies[fCurrentEnergy]);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool EnergySweepScheduler::NextEvent(G4double& energy)
+{
+    SweepWorkUnit& unit = tlWorkUnit;
+    
+    if(unit.runSerial!=fRunSerial)
+    {
+        ////    First event of this thread in a new run
+        unit = SweepWorkUnit();
+        unit.runSerial = fRunSerial;
+    }
+    
+    unit.pending = false;
+    
+    if(unit.next>=unit.end)
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        
+        Tally local = {unit.nEvents, unit.sumW, unit.sumW2, unit.sumWFull, unit.sumW2Full, unit.nFull};
+        MergeTally(local);
+        unit.nEvents = 0; unit.sumW = 0.; unit.sumW2 = 0.; unit.sumWFull = 0.; unit.sumW2Full = 0.; unit.nFull = 0;
+        
+        if(!fEnergyComplete && PrecisionReached()) fEnergyComplete = true;
+        if(fEnergyComplete || fNextEvent>=fEventsPerEnergy) return false;
+        
+        unit.next = fNextEvent;
+        unit.end = std::min(fNextEvent + std::max(fChunkSize, 1), fEventsPerEnergy);
+        fNextEvent = unit.end;
+    }
+    
+    unit.next++;
+    unit.pending = true;
+    energy = fEnergies[fCurrentEnergy];
+    
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EnergySweepScheduler::RecordEvent(G4double weight, G4bool detected, G4bool fullEnergy)
+{
+    SweepWorkUnit& unit = tlWorkUnit;
+    
+    if(!unit.pending || unit.runSerial!=fRunSerial) return;
+    
+    unit.pending = false;
+    unit.nEvents++;
+    
+    if(detected)
+    {
+        unit.sumW += weight;
+        unit.sumW2 += weight*weight;
+    }
+    
+    if(fullEnergy)
+    {
+        unit.sumWFull += weight;
+        unit.sumW2Full += weight*weight;
+        unit.nFull++;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EnergySweepScheduler::FlushThread()
+{
+    SweepWorkUnit& unit = tlWorkUnit;
+    
+    if(unit.runSerial!=fRunSerial) return;
+    
+    std::lock_guard<std::mutex> lock(fMutex);
+    
+    Tally local = {unit.nEvents, unit.sumW, unit.sumW2, unit.sumWFull, unit.sumW2Full, unit.nFull};
+    MergeTally(local);
+    
+    unit = SweepWorkUnit();
+    unit.runSerial = -1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EnergySweepScheduler::MergeTally(Tally& local)
+{
+    fTally.nEvents += local.nEvents;
+    fTally.sumW += local.sumW;
+    fTally.sumW2 += local.sumW2;
+    fTally.sumWFull += local.sumWFull;
+    fTally.sumW2Full += local.sumW2Full;
+    fTally.nFull += local.nFull;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool EnergySweepScheduler::PrecisionReached() const
+{
+    if(fPrecisionTarget<=0.0 || fTally.nFull<kMinimumFullEnergyCounts) return false;
+    
+    const G4double n = (G4double) fTally.nEvents;
+    const G4double efficiency = fTally.sumWFull/n;
+    const G4double variance = std::max(0.0, (fTally.sumW2Full/n - efficiency*efficiency)/n);
+    
+    return std::sqrt(variance) <= fPrecisionTarget*efficiency;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EnergySweepResult EnergySweepScheduler::GetResult() const
+{
+    std::lock_guard<std::mutex> lock(fMutex);
+    
+    EnergySweepResult result;
+    result.energy = fEnergies[fCurrentEnergy];
+    result.nEvents = fTally.nEvents;
+    result.precisionReached = fEnergyComplete;
+    
+    ////    Weighted efficiency estimates: eff = sum(w)/N, var = (sum(w^2)/N - eff^2)/N
+    const G4double n = std::max((G4double) fTally.nEvents, 1.0);
+    
+    result.efficiency = fTally.sumW/n;
+    result.efficiencyError = std::sqrt(std::max(0.0, (fTally.sumW2/n - result.efficiency*result.efficiency)/n));
+    result.fullEnergyEfficiency = fTally.sumWFull/n;
+    result.fullEnergyEfficiencyError = std::sqrt(std::max(0.0, (fTally.sumW2Full/n - result.fullEnergyEfficiency*result.fullEnergyEfficiency)/n));
+    
+    return result;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String EnergySweepScheduler::GetFileStem(G4double energy) const
+{
+    std::ostringstream stem;
+    stem << fOutputPrefix << "_E" << energy/keV << "keV";
+    
+    return stem.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool EnergySweepScheduler::ReadSummary(G4double energy, EnergySweepResult& result) const
+{
+    std::ifstream file((GetFileStem(energy) + ".sweep").c_str());
+    if(!file) return false;
+    
+    result = EnergySweepResult();
+    result.energy = energy;
+    
+    G4bool complete = false;
+    std::string line, key;
+    
+    while(std::getline(file, line))
+    {
+        if(line.empty() || line[0]=='#') continue;
+        
+        std::istringstream fields(line);
+        fields >> key;
+        
+        if(key=="events")                   fields >> result.nEvents;
+        else if(key=="efficiency")          fields >> result.efficiency >> result.efficiencyError;
+        else if(key=="fullEnergyEfficiency")
+        {
+            fields >> result.fullEnergyEfficiency >> result.fullEnergyEfficiencyError;
+            complete = true;
+        }
+        else if(key=="precisionReached")    fields >> result.precisionReached;
+    }
+    
+    return complete;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EnergySweepScheduler::WriteSummary(const EnergySweepResult& result) const
+{
+    std::ofstream file((GetFileStem(result.energy) + ".sweep").c_str());
+    
+    file << "# K600 energy sweep summary" << std::endl;
+    file << "energy_keV " << result.energy/keV << std::endl;
+    file << "events " << result.nEvents << std::endl;
+    file << "efficiency " << result.efficiency << " " << result.efficiencyError << std::endl;
+    file << "fullEnergyEfficiency " << result.fullEnergyEfficiency << " " << result.fullEnergyEfficiencyError << std::endl;
+    file << "fullEnergyWindow_keV " << fFullEnergyWindow/keV << std::endl;
+    file << "precisionReached " << result.precisionReached << std::endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EnergySweepScheduler::WriteSweepTable(const std::vector<EnergySweepResult>& results) const
+{
+    std::ofstream file((fOutputPrefix + "_sweep.dat").c_str());
+    
+    file << "# energy_keV  events  efficiency  error  fullEnergyEfficiency  error" << std::endl;
+    
+    for(size_t i=0; i<results.size(); i++)
+    {
+        file << results[i].energy/keV << "  " << results[i].nEvents << "  "
+        << results[i].efficiency << "  " << results[i].efficiencyError << "  "
+        << results[i].fullEnergyEfficiency << "  " << results[i].fullEnergyEfficiencyError << std::endl;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
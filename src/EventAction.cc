@@ -37,6 +37,7 @@
 #include "DetectorConstruction.hh"
 #include "EventAction.hh"
 #include "Analysis.hh"
+#include "EnergySweepScheduler.hh"
 
 #include "G4RunManager.hh"
 #include "G4Event.hh"
@@ -44,6 +45,7 @@
 
 #include "Randomize.hh"
 #include <iomanip>
+#include <cmath>
 
 #include <fstream>
 #include <string>
@@ -69,6 +71,10 @@ OffsetPADDLE(0),
 GainLEPS(1.0),
 OffsetLEPS(0.0)
 {    
+    eventWeight = 1.0;
+    
+    fDetectorConstruction = detectorConstruction;
+    fLayoutChanges = detectorConstruction->GetLayoutChanges();
     angles_CLOVER = detectorConstruction->GetAngles_CLOVER();
     angles_ALBA_LaBr3Ce = detectorConstruction->GetAngles_ALBA_LaBr3Ce();
 }
@@ -90,6 +96,13 @@ void EventAction::BeginOfEventAction(const G4Event* evt)
     
     evtNb = evt->GetEventID();
     
+    if(fLayoutChanges!=fDetectorConstruction->GetLayoutChanges())
+    {
+        fLayoutChanges = fDetectorConstruction->GetLayoutChanges();
+        angles_CLOVER = fDetectorConstruction->GetAngles_CLOVER();
+        angles_ALBA_LaBr3Ce = fDetectorConstruction->GetAngles_ALBA_LaBr3Ce();
+    }
+    
     GA_LineOfSight = true;
     
     if(GA_MODE)
@@ -260,6 +273,9 @@ void EventAction::BeginOfEventAction(const G4Event* evt)
 
 void EventAction::EndOfEventAction(const G4Event* event)
 {
+    ////    Events aborted by the primary generator (e.g. an exhausted energy sweep) carry no primaries
+    if(event->IsAborted()) return;
+    
     // Accumulate statistics
     //
     
@@ -399,6 +415,8 @@ void EventAction::EndOfEventAction(const G4Event* event)
 
     analysisManager->FillNtupleDColumn(0, 2, initialParticleTheta);
     analysisManager->FillNtupleDColumn(0, 3, initialParticlePhi);
+    
+    analysisManager->FillNtupleDColumn(0, 27, eventWeight);
 
     ////////////////////////////////////////////////////////
     //
@@ -724,6 +742,28 @@ void EventAction::EndOfEventAction(const G4Event* event)
         fRunAction->SetLaBr3Ce_zPos(LaBr3Ce_zPos_vec);
     }
     
+    //--------------------------------------------------------------------------------
+    //      Energy sweep tallies (detection and full-energy efficiencies)
+    
+    EnergySweepScheduler* energySweep = EnergySweepScheduler::Instance();
+    
+    if(energySweep->IsActive())
+    {
+        G4bool fullEnergy = false;
+        
+        for(size_t i=0; i<CLOVER_Energy_vec.size() && !fullEnergy; i++)
+        {
+            if(std::abs(CLOVER_Energy_vec[i]*keV - initialParticleKineticEnergy) <= energySweep->GetFullEnergyWindow()) fullEnergy = true;
+        }
+        
+        for(size_t i=0; i<LaBr3Ce_Energy_vec.size() && !fullEnergy; i++)
+        {
+            if(std::abs(LaBr3Ce_Energy_vec[i]*keV - initialParticleKineticEnergy) <= energySweep->GetFullEnergyWindow()) fullEnergy = true;
+        }
+        
+        energySweep->RecordEvent(eventWeight, (eventN_LaBr3Ce>0 || eventN_CLOVER>0), fullEnergy);
+    }
+    
     //--------------------------------------------------------------------------------
     //      Combined data taking for both the LaBr3Ce and CLOVER detectors
     
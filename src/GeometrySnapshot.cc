@@ -0,0 +1,1404 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "GeometrySnapshot.hh"
+#include "DetectorParameterisations.hh"
+
+#include "G4Isotope.hh"
+#include "G4Element.hh"
+#include "G4Material.hh"
+#include "G4NistManager.hh"
+
+#include "G4Box.hh"
+#include "G4Tubs.hh"
+#include "G4Cons.hh"
+#include "G4Torus.hh"
+#include "G4Trap.hh"
+#include "G4GenericTrap.hh"
+#include "G4Polycone.hh"
+#include "G4TessellatedSolid.hh"
+#include "G4TriangularFacet.hh"
+#include "G4QuadrangularFacet.hh"
+#include "G4MultiUnion.hh"
+#include "G4DisplacedSolid.hh"
+#include "G4UnionSolid.hh"
+#include "G4IntersectionSolid.hh"
+#include "G4SubtractionSolid.hh"
+#include "G4AffineTransform.hh"
+
+#include "G4LogicalVolume.hh"
+#include "G4PVPlacement.hh"
+#include "G4PVParameterised.hh"
+#include "G4VPVParameterisation.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4ProductionCuts.hh"
+#include "G4VisAttributes.hh"
+#include "G4Version.hh"
+#include "G4ios.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const char kSnapshotMagic[8] = {'K','6','0','0','G','E','O','\0'};
+    const std::uint64_t kHashSeed = 14695981039346656037ULL;
+    
+    ////    64-bit FNV-1a
+    std::uint64_t Hash(const void* data, std::size_t nBytes, std::uint64_t hash = kHashSeed)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for(std::size_t i=0; i<nBytes; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+    
+    //------------------------------------------------------------------
+    ////    Records of the snapshot, shared by the writer and the reader.
+    ////    Indices refer to earlier records of the same table (or of the table before).
+    
+    enum SolidType
+    {
+        kBox = 0,
+        kTubs,                      // rmin, rmax, dz, sphi, dphi
+        kCons,                      // rmin1, rmax1, rmin2, rmax2, dz, sphi, dphi
+        kTorus,                     // rmin, rmax, rtor, sphi, dphi
+        kTrap,                      // dz, theta, phi, dy1, dx1, dx2, alpha1, dy2, dx3, dx4, alpha2
+        kGenericTrap,               // dz, 8 x (x, y)
+        kPolycone,                  // [nz]; sphi, dphi, z[nz], rmin[nz], rmax[nz]
+        kTessellated,               // [maxVoxels, nFacets, (nCorners, corners)...]; reduction ratio, vertices
+        kMultiUnion,                // [solids]; per solid rotation (9) and translation (3)
+        kDisplaced,                 // [solid]; rotation and translation of the direct transform
+        kUnion,                     // [solidA, solidB]
+        kIntersection,              // [solidA, solidB]
+        kSubtraction,               // [solidA, solidB]
+        kParameterisedSubtraction,  // [solidA, solidB]
+        kNumberOfSolidTypes
+    };
+    
+    struct IsotopeRecord
+    {
+        G4String                name;
+        G4int                   Z;
+        G4int                   N;
+        G4double                A;
+    };
+    
+    struct ElementRecord
+    {
+        G4String                name;
+        G4String                symbol;
+        G4double                Z;
+        G4double                A;
+        std::vector<G4int>      isotopes;
+        std::vector<G4double>   abundances;
+    };
+    
+    struct MaterialRecord
+    {
+        G4String                name;
+        G4double                density;
+        G4int                   state;
+        G4double                temperature;
+        G4double                pressure;
+        std::vector<G4int>      elements;
+        std::vector<G4double>   fractions;      // by mass
+    };
+    
+    struct SolidRecord
+    {
+        G4int                   type;
+        G4String                name;
+        std::vector<G4int>      ints;
+        std::vector<G4double>   values;
+    };
+    
+    struct LogicalRecord
+    {
+        G4String                name;
+        G4int                   solid;
+        G4int                   material;
+        G4int                   visFlags;       // -1: no vis attributes
+        G4int                   forcedStyle;    // -1: none
+        std::vector<G4double>   colour;         // r, g, b, a
+    };
+    
+    struct CopyRecord
+    {
+        G4int                   solid;          // parameterised copies only
+        G4int                   material;       // parameterised copies only, -1: that of the logical volume
+        G4int                   rotated;
+        std::vector<G4double>   transform;      // rotation (9), translation (3)
+    };
+    
+    struct PhysicalRecord
+    {
+        G4String                name;
+        G4int                   logical;
+        G4int                   mother;         // -1: the world
+        G4int                   copyNo;         // 0 for a parameterised volume
+        G4int                   parameterised;
+        std::vector<CopyRecord> copies;
+    };
+    
+    struct RegionRecord
+    {
+        G4String                name;
+        std::vector<G4int>      roots;
+        std::vector<G4double>   cuts;           // gamma, e-, e+, proton; empty: those of the world
+    };
+    
+    ////    A file the geometry was built from (mesh, level of detail, convex decomposition), as it was then
+    struct SourceFileRecord
+    {
+        G4String                name;
+        G4int                   exists;
+        std::int64_t            size;
+        std::int64_t            modificationTime;
+    };
+    
+    SourceFileRecord StatSourceFile(const G4String& name)
+    {
+        SourceFileRecord record;
+        record.name = name;
+        struct stat status;
+        record.exists = (stat(name.c_str(), &status)==0) ? 1 : 0;
+        record.size = record.exists ? std::int64_t(status.st_size) : 0;
+        record.modificationTime = record.exists ? std::int64_t(status.st_mtime) : 0;
+        return record;
+    }
+    
+    struct SnapshotRecords
+    {
+        std::vector<IsotopeRecord>  isotopes;
+        std::vector<ElementRecord>  elements;
+        std::vector<MaterialRecord> materials;
+        std::vector<SolidRecord>    solids;
+        std::vector<LogicalRecord>  logicals;
+        std::vector<PhysicalRecord> physicals;
+        std::vector<RegionRecord>   regions;
+    };
+    
+    const G4int kVisible = 1;
+    const G4int kDaughtersInvisible = 2;
+    
+    void AppendRotation(std::vector<G4double>& values, const G4RotationMatrix& rotation)
+    {
+        const G4double elements[9] = {rotation.xx(), rotation.xy(), rotation.xz(),
+                                      rotation.yx(), rotation.yy(), rotation.yz(),
+                                      rotation.zx(), rotation.zy(), rotation.zz()};
+        values.insert(values.end(), elements, elements + 9);
+    }
+    
+    void AppendVector(std::vector<G4double>& values, const G4ThreeVector& vector)
+    {
+        values.push_back(vector.x());
+        values.push_back(vector.y());
+        values.push_back(vector.z());
+    }
+    
+    G4RotationMatrix Rotation(const G4double* values)
+    {
+        return G4RotationMatrix(CLHEP::HepRep3x3(values[0], values[1], values[2],
+                                                 values[3], values[4], values[5],
+                                                 values[6], values[7], values[8]));
+    }
+    
+    G4ThreeVector Vector(const G4double* values)
+    {
+        return G4ThreeVector(values[0], values[1], values[2]);
+    }
+    
+    //------------------------------------------------------------------
+    ////    Byte streams
+    
+    class OutputStream
+    {
+    public:
+        template <typename T> void Put(const T& value)
+        {
+            fData.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+        
+        void PutInt(G4int value)                    {Put(std::int32_t(value));}
+        void PutString(const G4String& value)
+        {
+            PutInt(G4int(value.size()));
+            fData.append(value);
+        }
+        template <typename T> void PutVector(const std::vector<T>& values)
+        {
+            PutInt(G4int(values.size()));
+            if(!values.empty()) fData.append(reinterpret_cast<const char*>(&values[0]), values.size()*sizeof(T));
+        }
+        
+        const std::string&  Data() const    {return fData;}
+        
+    private:
+        std::string fData;
+    };
+    
+    ////    Bounds-checked: a truncated or inconsistent stream clears Good() and yields zeros
+    class InputStream
+    {
+    public:
+        InputStream(const char* data, std::size_t size) : fPosition(data), fEnd(data + size), fGood(true) {}
+        
+        template <typename T> T Get()
+        {
+            T value = T();
+            if(!fGood || std::size_t(fEnd - fPosition)<sizeof(T)) {fGood = false; return value;}
+            std::memcpy(&value, fPosition, sizeof(T));
+            fPosition += sizeof(T);
+            return value;
+        }
+        
+        G4int GetInt()                              {return Get<std::int32_t>();}
+        G4int GetCount()
+        {
+            const G4int count = GetInt();
+            if(count<0 || std::size_t(count)>std::size_t(fEnd - fPosition)) {fGood = false; return 0;}
+            return count;
+        }
+        G4String GetString()
+        {
+            const G4int size = GetCount();
+            if(!fGood) return "";
+            const G4String value(fPosition, size);
+            fPosition += size;
+            return value;
+        }
+        template <typename T> std::vector<T> GetVector()
+        {
+            const G4int size = GetCount();
+            std::vector<T> values;
+            if(!fGood || std::size_t(fEnd - fPosition)<size*sizeof(T)) {fGood = false; return values;}
+            values.resize(size);
+            if(size>0) std::memcpy(&values[0], fPosition, size*sizeof(T));
+            fPosition += size*sizeof(T);
+            return values;
+        }
+        
+        ////    Index into a table of size entries (or -1 if allowed)
+        G4int GetIndex(std::size_t size, G4bool allowNone = false)
+        {
+            const G4int index = GetInt();
+            if(index<(allowNone ? -1 : 0) || index>=G4int(size)) fGood = false;
+            return index;
+        }
+        
+        G4bool  Good() const    {return fGood;}
+        G4bool  AtEnd() const   {return fPosition==fEnd;}
+        void    Fail()          {fGood = false;}
+        
+    private:
+        const char* fPosition;
+        const char* fEnd;
+        G4bool      fGood;
+    };
+    
+    std::vector<G4int> Ints(const std::vector<std::int32_t>& values)
+    {
+        return std::vector<G4int>(values.begin(), values.end());
+    }
+    
+    std::vector<std::int32_t> Int32s(const std::vector<G4int>& values)
+    {
+        return std::vector<std::int32_t>(values.begin(), values.end());
+    }
+    
+    //------------------------------------------------------------------
+    ////    Serialisation of the records
+    
+    void SerialiseSourceFiles(const std::vector<SourceFileRecord>& sourceFiles, OutputStream& out)
+    {
+        out.PutInt(G4int(sourceFiles.size()));
+        for(std::size_t i=0; i<sourceFiles.size(); i++)
+        {
+            out.PutString(sourceFiles[i].name);
+            out.PutInt(sourceFiles[i].exists);
+            out.Put(sourceFiles[i].size);
+            out.Put(sourceFiles[i].modificationTime);
+        }
+    }
+    
+    G4bool DeserialiseSourceFiles(InputStream& in, std::vector<SourceFileRecord>& sourceFiles)
+    {
+        sourceFiles.resize(in.GetCount());
+        for(std::size_t i=0; i<sourceFiles.size() && in.Good(); i++)
+        {
+            sourceFiles[i].name = in.GetString();
+            sourceFiles[i].exists = in.GetInt();
+            sourceFiles[i].size = in.Get<std::int64_t>();
+            sourceFiles[i].modificationTime = in.Get<std::int64_t>();
+        }
+        return in.Good();
+    }
+    
+    void Serialise(const SnapshotRecords& records, OutputStream& out)
+    {
+        out.PutInt(G4int(records.isotopes.size()));
+        for(std::size_t i=0; i<records.isotopes.size(); i++)
+        {
+            const IsotopeRecord& isotope = records.isotopes[i];
+            out.PutString(isotope.name);
+            out.PutInt(isotope.Z);
+            out.PutInt(isotope.N);
+            out.Put(isotope.A);
+        }
+        
+        out.PutInt(G4int(records.elements.size()));
+        for(std::size_t i=0; i<records.elements.size(); i++)
+        {
+            const ElementRecord& element = records.elements[i];
+            out.PutString(element.name);
+            out.PutString(element.symbol);
+            out.Put(element.Z);
+            out.Put(element.A);
+            out.PutVector(Int32s(element.isotopes));
+            out.PutVector(element.abundances);
+        }
+        
+        out.PutInt(G4int(records.materials.size()));
+        for(std::size_t i=0; i<records.materials.size(); i++)
+        {
+            const MaterialRecord& material = records.materials[i];
+            out.PutString(material.name);
+            out.Put(material.density);
+            out.PutInt(material.state);
+            out.Put(material.temperature);
+            out.Put(material.pressure);
+            out.PutVector(Int32s(material.elements));
+            out.PutVector(material.fractions);
+        }
+        
+        out.PutInt(G4int(records.solids.size()));
+        for(std::size_t i=0; i<records.solids.size(); i++)
+        {
+            const SolidRecord& solid = records.solids[i];
+            out.PutInt(solid.type);
+            out.PutString(solid.name);
+            out.PutVector(Int32s(solid.ints));
+            out.PutVector(solid.values);
+        }
+        
+        out.PutInt(G4int(records.logicals.size()));
+        for(std::size_t i=0; i<records.logicals.size(); i++)
+        {
+            const LogicalRecord& logical = records.logicals[i];
+            out.PutString(logical.name);
+            out.PutInt(logical.solid);
+            out.PutInt(logical.material);
+            out.PutInt(logical.visFlags);
+            out.PutInt(logical.forcedStyle);
+            out.PutVector(logical.colour);
+        }
+        
+        out.PutInt(G4int(records.physicals.size()));
+        for(std::size_t i=0; i<records.physicals.size(); i++)
+        {
+            const PhysicalRecord& physical = records.physicals[i];
+            out.PutString(physical.name);
+            out.PutInt(physical.logical);
+            out.PutInt(physical.mother);
+            out.PutInt(physical.copyNo);
+            out.PutInt(physical.parameterised);
+            out.PutInt(G4int(physical.copies.size()));
+            for(std::size_t j=0; j<physical.copies.size(); j++)
+            {
+                const CopyRecord& copy = physical.copies[j];
+                out.PutInt(copy.solid);
+                out.PutInt(copy.material);
+                out.PutInt(copy.rotated);
+                out.PutVector(copy.transform);
+            }
+        }
+        
+        out.PutInt(G4int(records.regions.size()));
+        for(std::size_t i=0; i<records.regions.size(); i++)
+        {
+            const RegionRecord& region = records.regions[i];
+            out.PutString(region.name);
+            out.PutVector(Int32s(region.roots));
+            out.PutVector(region.cuts);
+        }
+    }
+    
+    ////    Number of values (and ints) of each solid type, -1: variable
+    G4bool CheckSolid(const SolidRecord& solid, G4int index)
+    {
+        static const G4int nValues[kNumberOfSolidTypes] = {3, 5, 7, 5, 11, 17, -1, -1, -1, 12, 0, 0, 0, 0};
+        static const G4int nInts[kNumberOfSolidTypes]   = {0, 0, 0, 0, 0, 0, 1, -1, -1, 1, 2, 2, 2, 2};
+        
+        if(solid.type<0 || solid.type>=kNumberOfSolidTypes) return false;
+        if(nValues[solid.type]>=0 && G4int(solid.values.size())!=nValues[solid.type]) return false;
+        if(nInts[solid.type]>=0 && G4int(solid.ints.size())!=nInts[solid.type]) return false;
+        
+        switch(solid.type)
+        {
+            case kPolycone:
+                return solid.ints[0]>=2 && solid.values.size()==std::size_t(2 + 3*solid.ints[0]);
+                
+            case kTessellated:
+            {
+                if(solid.ints.size()<2 || solid.values.size()<3 || (solid.values.size() - 3)%3!=0) return false;
+                const G4int nVertices = G4int(solid.values.size() - 3)/3;
+                std::size_t position = 2;
+                for(G4int i=0; i<solid.ints[1]; i++)
+                {
+                    if(position>=solid.ints.size()) return false;
+                    const G4int nCorners = solid.ints[position++];
+                    if((nCorners!=3 && nCorners!=4) || position + nCorners>solid.ints.size()) return false;
+                    for(G4int j=0; j<nCorners; j++)
+                    {
+                        const G4int corner = solid.ints[position++];
+                        if(corner<0 || corner>=nVertices) return false;
+                    }
+                }
+                return solid.ints[1]>0 && position==solid.ints.size();
+            }
+                
+            case kMultiUnion:
+                if(solid.ints.empty() || solid.values.size()!=12*solid.ints.size()) return false;
+                break;
+                
+            default:
+                break;
+        }
+        
+        ////    Constituents are earlier solids
+        if(solid.type==kMultiUnion || solid.type>=kDisplaced)
+        {
+            for(std::size_t i=0; i<solid.ints.size(); i++)
+            {
+                if(solid.ints[i]<0 || solid.ints[i]>=index) return false;
+            }
+        }
+        
+        return true;
+    }
+    
+    G4bool Deserialise(InputStream& in, SnapshotRecords& records)
+    {
+        records.isotopes.resize(in.GetCount());
+        for(std::size_t i=0; i<records.isotopes.size() && in.Good(); i++)
+        {
+            IsotopeRecord& isotope = records.isotopes[i];
+            isotope.name = in.GetString();
+            isotope.Z = in.GetInt();
+            isotope.N = in.GetInt();
+            isotope.A = in.Get<G4double>();
+        }
+        
+        records.elements.resize(in.GetCount());
+        for(std::size_t i=0; i<records.elements.size() && in.Good(); i++)
+        {
+            ElementRecord& element = records.elements[i];
+            element.name = in.GetString();
+            element.symbol = in.GetString();
+            element.Z = in.Get<G4double>();
+            element.A = in.Get<G4double>();
+            element.isotopes = Ints(in.GetVector<std::int32_t>());
+            element.abundances = in.GetVector<G4double>();
+            
+            if(element.abundances.size()!=element.isotopes.size()) in.Fail();
+            for(std::size_t j=0; j<element.isotopes.size(); j++)
+            {
+                if(element.isotopes[j]<0 || element.isotopes[j]>=G4int(records.isotopes.size())) in.Fail();
+            }
+        }
+        
+        records.materials.resize(in.GetCount());
+        for(std::size_t i=0; i<records.materials.size() && in.Good(); i++)
+        {
+            MaterialRecord& material = records.materials[i];
+            material.name = in.GetString();
+            material.density = in.Get<G4double>();
+            material.state = in.GetInt();
+            material.temperature = in.Get<G4double>();
+            material.pressure = in.Get<G4double>();
+            material.elements = Ints(in.GetVector<std::int32_t>());
+            material.fractions = in.GetVector<G4double>();
+            
+            if(material.elements.empty() || material.fractions.size()!=material.elements.size()) in.Fail();
+            for(std::size_t j=0; j<material.elements.size(); j++)
+            {
+                if(material.elements[j]<0 || material.elements[j]>=G4int(records.elements.size())) in.Fail();
+            }
+        }
+        
+        records.solids.resize(in.GetCount());
+        for(std::size_t i=0; i<records.solids.size() && in.Good(); i++)
+        {
+            SolidRecord& solid = records.solids[i];
+            solid.type = in.GetInt();
+            solid.name = in.GetString();
+            solid.ints = Ints(in.GetVector<std::int32_t>());
+            solid.values = in.GetVector<G4double>();
+            
+            if(in.Good() && !CheckSolid(solid, G4int(i))) in.Fail();
+        }
+        
+        records.logicals.resize(in.GetCount());
+        for(std::size_t i=0; i<records.logicals.size() && in.Good(); i++)
+        {
+            LogicalRecord& logical = records.logicals[i];
+            logical.name = in.GetString();
+            logical.solid = in.GetIndex(records.solids.size());
+            logical.material = in.GetIndex(records.materials.size());
+            logical.visFlags = in.GetInt();
+            logical.forcedStyle = in.GetInt();
+            logical.colour = in.GetVector<G4double>();
+            
+            if(logical.colour.size()!=4) in.Fail();
+        }
+        
+        G4int nWorlds = 0;
+        records.physicals.resize(in.GetCount());
+        for(std::size_t i=0; i<records.physicals.size() && in.Good(); i++)
+        {
+            PhysicalRecord& physical = records.physicals[i];
+            physical.name = in.GetString();
+            physical.logical = in.GetIndex(records.logicals.size());
+            physical.mother = in.GetIndex(records.logicals.size(), true);
+            physical.copyNo = in.GetInt();
+            physical.parameterised = in.GetInt();
+            physical.copies.resize(in.GetCount());
+            for(std::size_t j=0; j<physical.copies.size() && in.Good(); j++)
+            {
+                CopyRecord& copy = physical.copies[j];
+                copy.solid = in.GetIndex(records.solids.size(), true);
+                copy.material = in.GetIndex(records.materials.size(), true);
+                copy.rotated = in.GetInt();
+                copy.transform = in.GetVector<G4double>();
+                
+                if(copy.transform.size()!=12 || (physical.parameterised && copy.solid<0)) in.Fail();
+            }
+            
+            if(physical.mother<0) nWorlds++;
+            if(physical.copies.empty() || (!physical.parameterised && physical.copies.size()!=1)) in.Fail();
+            if(physical.parameterised && physical.mother<0) in.Fail();
+        }
+        
+        records.regions.resize(in.GetCount());
+        for(std::size_t i=0; i<records.regions.size() && in.Good(); i++)
+        {
+            RegionRecord& region = records.regions[i];
+            region.name = in.GetString();
+            region.roots = Ints(in.GetVector<std::int32_t>());
+            region.cuts = in.GetVector<G4double>();
+            
+            if(!region.cuts.empty() && region.cuts.size()!=std::size_t(NumberOfG4CutIndex)) in.Fail();
+            for(std::size_t j=0; j<region.roots.size(); j++)
+            {
+                if(region.roots[j]<0 || region.roots[j]>=G4int(records.logicals.size())) in.Fail();
+            }
+        }
+        
+        return in.Good() && in.AtEnd() && nWorlds==1;
+    }
+    
+    //------------------------------------------------------------------
+    ////    Writer: records of the tree under the world
+    
+    class SnapshotWriter
+    {
+    public:
+        SnapshotWriter() : fGood(true) {}
+        
+        G4bool  Collect(G4VPhysicalVolume* world);
+        
+        const SnapshotRecords&  Records() const {return fRecords;}
+        
+    private:
+        G4int   AddIsotope(const G4Isotope* isotope);
+        G4int   AddElement(const G4Element* element);
+        G4int   AddMaterial(const G4Material* material);
+        ////    byValue: a new record of the current dimensions (parameterised copies)
+        G4int   AddSolid(G4VSolid* solid, G4bool byValue = false);
+        G4int   AddLogical(G4LogicalVolume* logical);
+        void    AddPhysical(G4VPhysicalVolume* physical, G4int mother);
+        void    AddRegions();
+        
+        void    Refuse(const G4String& what);
+        
+        SnapshotRecords                             fRecords;
+        G4bool                                      fGood;
+        
+        std::map<const G4Isotope*, G4int>           fIsotopes;
+        std::map<const G4Element*, G4int>           fElements;
+        std::map<const G4Material*, G4int>          fMaterials;
+        std::map<const G4VSolid*, G4int>            fSolids;
+        std::map<const G4LogicalVolume*, G4int>     fLogicals;
+    };
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    void SnapshotWriter::Refuse(const G4String& what)
+    {
+        if(fGood)
+        {
+            G4ExceptionDescription message;
+            message << "The geometry holds " << what << ", which a snapshot does not support.\n"
+            << "No snapshot is written; the geometry is constructed in full on every run.";
+            G4Exception("GeometrySnapshot::Write()", "GeometrySnapshot0001", JustWarning, message);
+        }
+        fGood = false;
+    }
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    G4bool SnapshotWriter::Collect(G4VPhysicalVolume* world)
+    {
+        AddPhysical(world, -1);
+        AddRegions();
+        return fGood;
+    }
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    G4int SnapshotWriter::AddIsotope(const G4Isotope* isotope)
+    {
+        std::map<const G4Isotope*, G4int>::const_iterator found = fIsotopes.find(isotope);
+        if(found!=fIsotopes.end()) return found->second;
+        
+        IsotopeRecord record;
+        record.name = isotope->GetName();
+        record.Z = isotope->GetZ();
+        record.N = isotope->GetN();
+        record.A = isotope->GetA();
+        
+        fRecords.isotopes.push_back(record);
+        return fIsotopes[isotope] = G4int(fRecords.isotopes.size()) - 1;
+    }
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    G4int SnapshotWriter::AddElement(const G4Element* element)
+    {
+        std::map<const G4Element*, G4int>::const_iterator found = fElements.find(element);
+        if(found!=fElements.end()) return found->second;
+        
+        ElementRecord record;
+        record.name = element->GetName();
+        record.symbol = element->GetSymbol();
+        record.Z = element->GetZ();
+        record.A = element->GetA();
+        for(std::size_t i=0; i<element->GetNumberOfIsotopes(); i++)
+        {
+            record.isotopes.push_back(AddIsotope(element->GetIsotope(G4int(i))));
+            record.abundances.push_back(element->GetRelativeAbundanceVector()[i]);
+        }
+        
+        fRecords.elements.push_back(record);
+        return fElements[element] = G4int(fRecords.elements.size()) - 1;
+    }
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    G4int SnapshotWriter::AddMaterial(const G4Material* material)
+    {
+        std::map<const G4Material*, G4int>::const_iterator found = fMaterials.find(material);
+        if(found!=fMaterials.end()) return found->second;
+        
+        if(material->GetMaterialPropertiesTable()) Refuse("the optical properties of " + material->GetName());
+        if(material->GetBaseMaterial()) Refuse("the derived material " + material->GetName());
+        
+        MaterialRecord record;
+        record.name = material->GetName();
+        record.density = material->GetDensity();
+        record.state = G4int(material->GetState());
+        record.temperature = material->GetTemperature();
+        record.pressure = material->GetPressure();
+        for(std::size_t i=0; i<material->GetNumberOfElements(); i++)
+        {
+            record.elements.push_back(AddElement(material->GetElement(G4int(i))));
+            record.fractions.push_back(material->GetFractionVector()[i]);
+        }
+        
+        fRecords.materials.push_back(record);
+        return fMaterials[material] = G4int(fRecords.materials.size()) - 1;
+    }
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    G4int SnapshotWriter::AddSolid(G4VSolid* solid, G4bool byValue)
+    {
+        if(!byValue)
+        {
+            std::map<const G4VSolid*, G4int>::const_iterator found = fSolids.find(solid);
+            if(found!=fSolids.end()) return found->second;
+        }
+        
+        SolidRecord record;
+        record.name = solid->GetName();
+        
+        const G4String type = solid->GetEntityType();
+        
+        if(dynamic_cast<ParameterisedSubtractionSolid*>(solid) || type=="G4UnionSolid" || type=="G4IntersectionSolid" || type=="G4SubtractionSolid")
+        {
+            const G4BooleanSolid* boolean = static_cast<const G4BooleanSolid*>(solid);
+            record.type = dynamic_cast<ParameterisedSubtractionSolid*>(solid) ? kParameterisedSubtraction
+            : (type=="G4UnionSolid" ? kUnion : (type=="G4IntersectionSolid" ? kIntersection : kSubtraction));
+            record.ints.push_back(AddSolid(const_cast<G4VSolid*>(boolean->GetConstituentSolid(0))));
+            record.ints.push_back(AddSolid(const_cast<G4VSolid*>(boolean->GetConstituentSolid(1))));
+        }
+        else if(type=="G4DisplacedSolid")
+        {
+            const G4DisplacedSolid* displaced = static_cast<const G4DisplacedSolid*>(solid);
+            const G4AffineTransform transform = displaced->GetDirectTransform();
+            record.type = kDisplaced;
+            record.ints.push_back(AddSolid(displaced->GetConstituentMovedSolid()));
+            AppendRotation(record.values, transform.NetRotation());
+            AppendVector(record.values, transform.NetTranslation());
+        }
+        else if(type=="G4MultiUnion")
+        {
+            G4MultiUnion* multiUnion = static_cast<G4MultiUnion*>(solid);
+            record.type = kMultiUnion;
+            for(G4int i=0; i<multiUnion->GetNumberOfSolids(); i++)
+            {
+                const G4Transform3D& placement = multiUnion->GetTransformation(i);
+                record.ints.push_back(AddSolid(multiUnion->GetSolid(i)));
+                AppendRotation(record.values, placement.getRotation());
+                AppendVector(record.values, placement.getTranslation());
+            }
+        }
+        else if(type=="G4Box")
+        {
+            const G4Box* box = static_cast<const G4Box*>(solid);
+            record.type = kBox;
+            AppendVector(record.values, G4ThreeVector(box->GetXHalfLength(), box->GetYHalfLength(), box->GetZHalfLength()));
+        }
+        else if(type=="G4Tubs")
+        {
+            const G4Tubs* tubs = static_cast<const G4Tubs*>(solid);
+            const G4double values[5] = {tubs->GetInnerRadius(), tubs->GetOuterRadius(), tubs->GetZHalfLength(),
+                                        tubs->GetStartPhiAngle(), tubs->GetDeltaPhiAngle()};
+            record.type = kTubs;
+            record.values.assign(values, values + 5);
+        }
+        else if(type=="G4Cons")
+        {
+            const G4Cons* cons = static_cast<const G4Cons*>(solid);
+            const G4double values[7] = {cons->GetInnerRadiusMinusZ(), cons->GetOuterRadiusMinusZ(),
+                                        cons->GetInnerRadiusPlusZ(), cons->GetOuterRadiusPlusZ(), cons->GetZHalfLength(),
+                                        cons->GetStartPhiAngle(), cons->GetDeltaPhiAngle()};
+            record.type = kCons;
+            record.values.assign(values, values + 7);
+        }
+        else if(type=="G4Torus")
+        {
+            const G4Torus* torus = static_cast<const G4Torus*>(solid);
+            const G4double values[5] = {torus->GetRmin(), torus->GetRmax(), torus->GetRtor(), torus->GetSPhi(), torus->GetDPhi()};
+            record.type = kTorus;
+            record.values.assign(values, values + 5);
+        }
+        else if(type=="G4Trap")
+        {
+            const G4Trap* trap = static_cast<const G4Trap*>(solid);
+            const G4ThreeVector axis = trap->GetSymAxis();
+            const G4double values[11] = {trap->GetZHalfLength(), std::acos(axis.z()), std::atan2(axis.y(), axis.x()),
+                                         trap->GetYHalfLength1(), trap->GetXHalfLength1(), trap->GetXHalfLength2(), std::atan(trap->GetTanAlpha1()),
+                                         trap->GetYHalfLength2(), trap->GetXHalfLength3(), trap->GetXHalfLength4(), std::atan(trap->GetTanAlpha2())};
+            record.type = kTrap;
+            record.values.assign(values, values + 11);
+        }
+        else if(type=="G4GenericTrap")
+        {
+            const G4GenericTrap* trap = static_cast<const G4GenericTrap*>(solid);
+            const std::vector<G4TwoVector>& vertices = trap->GetVertices();
+            record.type = kGenericTrap;
+            record.values.push_back(trap->GetZHalfLength());
+            for(std::size_t i=0; i<vertices.size(); i++)
+            {
+                record.values.push_back(vertices[i].x());
+                record.values.push_back(vertices[i].y());
+            }
+        }
+        else if(type=="G4Polycone")
+        {
+            const G4PolyconeHistorical* parameters = static_cast<const G4Polycone*>(solid)->GetOriginalParameters();
+            const G4int nz = parameters->Num_z_planes;
+            record.type = kPolycone;
+            record.ints.push_back(nz);
+            record.values.push_back(parameters->Start_angle);
+            record.values.push_back(parameters->Opening_angle);
+            record.values.insert(record.values.end(), parameters->Z_values, parameters->Z_values + nz);
+            record.values.insert(record.values.end(), parameters->Rmin, parameters->Rmin + nz);
+            record.values.insert(record.values.end(), parameters->Rmax, parameters->Rmax + nz);
+        }
+        else if(type=="G4TessellatedSolid")
+        {
+            ////    Shared vertices, as in the mesh cache of CachedCADMesh
+            G4TessellatedSolid* tessellated = static_cast<G4TessellatedSolid*>(solid);
+            G4ThreeVector reductionRatio;
+            record.type = kTessellated;
+            record.ints.push_back(tessellated->GetVoxels().GetMaxVoxels(reductionRatio));
+            record.ints.push_back(tessellated->GetNumberOfFacets());
+            AppendVector(record.values, reductionRatio);
+            
+            std::map<std::vector<G4double>, G4int> vertexIndex;
+            for(G4int i=0; i<tessellated->GetNumberOfFacets(); i++)
+            {
+                const G4VFacet* facet = tessellated->GetFacet(i);
+                record.ints.push_back(facet->GetNumberOfVertices());
+                for(G4int j=0; j<facet->GetNumberOfVertices(); j++)
+                {
+                    std::vector<G4double> key;
+                    AppendVector(key, facet->GetVertex(j));
+                    
+                    std::map<std::vector<G4double>, G4int>::const_iterator found = vertexIndex.find(key);
+                    if(found==vertexIndex.end())
+                    {
+                        const G4int index = G4int(record.values.size() - 3)/3;
+                        vertexIndex[key] = index;
+                        record.values.insert(record.values.end(), key.begin(), key.end());
+                        record.ints.push_back(index);
+                    }
+                    else record.ints.push_back(found->second);
+                }
+            }
+        }
+        else
+        {
+            Refuse("the solid " + solid->GetName() + " of type " + type);
+            return -1;
+        }
+        
+        fRecords.solids.push_back(record);
+        const G4int index = G4int(fRecords.solids.size()) - 1;
+        if(!byValue) fSolids[solid] = index;
+        return index;
+    }
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    G4int SnapshotWriter::AddLogical(G4LogicalVolume* logical)
+    {
+        std::map<const G4LogicalVolume*, G4int>::const_iterator found = fLogicals.find(logical);
+        if(found!=fLogicals.end()) return found->second;
+        
+        if(logical->GetUserLimits()) Refuse("the user limits of " + logical->GetName());
+        
+        LogicalRecord record;
+        record.name = logical->GetName();
+        record.solid = AddSolid(logical->GetSolid());
+        record.material = AddMaterial(logical->GetMaterial());
+        record.visFlags = -1;
+        record.forcedStyle = -1;
+        record.colour.assign(4, 1.);
+        
+        const G4VisAttributes* visAttributes = logical->GetVisAttributes();
+        if(visAttributes)
+        {
+            const G4Colour& colour = visAttributes->GetColour();
+            record.visFlags = (visAttributes->IsVisible() ? kVisible : 0) | (visAttributes->IsDaughtersInvisible() ? kDaughtersInvisible : 0);
+            if(visAttributes->IsForceDrawingStyle()) record.forcedStyle = G4int(visAttributes->GetForcedDrawingStyle());
+            record.colour[0] = colour.GetRed();
+            record.colour[1] = colour.GetGreen();
+            record.colour[2] = colour.GetBlue();
+            record.colour[3] = colour.GetAlpha();
+        }
+        
+        fRecords.logicals.push_back(record);
+        const G4int index = G4int(fRecords.logicals.size()) - 1;
+        fLogicals[logical] = index;
+        
+        ////    Daughters once per logical volume, in order
+        for(std::size_t i=0; i<logical->GetNoDaughters(); i++)
+        {
+            AddPhysical(logical->GetDaughter(G4int(i)), index);
+        }
+        
+        return index;
+    }
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    void SnapshotWriter::AddPhysical(G4VPhysicalVolume* physical, G4int mother)
+    {
+        PhysicalRecord record;
+        record.name = physical->GetName();
+        record.logical = AddLogical(physical->GetLogicalVolume());
+        record.mother = mother;
+        record.copyNo = physical->GetCopyNo();
+        record.parameterised = physical->IsParameterised();
+        
+        if(physical->IsReplicated() && !physical->IsParameterised())
+        {
+            Refuse("the replica " + physical->GetName());
+            return;
+        }
+        
+        if(physical->IsParameterised())
+        {
+            ////    Every copy as the navigator computes it: solid, dimensions, transformation, material
+            G4VPVParameterisation* parameterisation = physical->GetParameterisation();
+            record.copyNo = 0;
+            
+            for(G4int i=0; i<physical->GetMultiplicity(); i++)
+            {
+                physical->SetCopyNo(i);
+                G4VSolid* solid = parameterisation->ComputeSolid(i, physical);
+                solid->ComputeDimensions(parameterisation, i, physical);
+                parameterisation->ComputeTransformation(i, physical);
+                const G4Material* material = parameterisation->ComputeMaterial(i, physical);
+                
+                CopyRecord copy;
+                ////    Primitives are resized in place by the parameterisation; booleans are not
+                copy.solid = AddSolid(solid, !dynamic_cast<ParameterisedSubtractionSolid*>(solid));
+                copy.material = material ? AddMaterial(material) : -1;
+                copy.rotated = physical->GetRotation()!=0;
+                AppendRotation(copy.transform, physical->GetRotation() ? *physical->GetRotation() : G4RotationMatrix());
+                AppendVector(copy.transform, physical->GetTranslation());
+                record.copies.push_back(copy);
+            }
+        }
+        else
+        {
+            CopyRecord copy;
+            copy.solid = -1;
+            copy.material = -1;
+            copy.rotated = physical->GetRotation()!=0;
+            AppendRotation(copy.transform, physical->GetRotation() ? *physical->GetRotation() : G4RotationMatrix());
+            AppendVector(copy.transform, physical->GetTranslation());
+            record.copies.push_back(copy);
+        }
+        
+        fRecords.physicals.push_back(record);
+    }
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    void SnapshotWriter::AddRegions()
+    {
+        G4RegionStore* regionStore = G4RegionStore::GetInstance();
+        for(std::size_t i=0; i<regionStore->size(); i++)
+        {
+            G4Region* region = (*regionStore)[i];
+            if(region->GetName()=="DefaultRegionForTheWorld" || region->GetName()=="DefaultRegionForParallelWorld") continue;
+            
+            RegionRecord record;
+            record.name = region->GetName();
+            
+            std::vector<G4LogicalVolume*>::iterator root = region->GetRootLogicalVolumeIterator();
+            for(std::size_t j=0; j<region->GetNumberOfRootVolumes(); j++, root++)
+            {
+                std::map<const G4LogicalVolume*, G4int>::const_iterator found = fLogicals.find(*root);
+                if(found!=fLogicals.end()) record.roots.push_back(found->second);
+            }
+            if(record.roots.empty()) continue;
+            
+            if(region->GetUserLimits()) Refuse("the user limits of the region " + region->GetName());
+            
+            const G4ProductionCuts* cuts = region->GetProductionCuts();
+            if(cuts)
+            {
+                for(G4int j=0; j<NumberOfG4CutIndex; j++) record.cuts.push_back(cuts->GetProductionCut(j));
+            }
+            
+            fRecords.regions.push_back(record);
+        }
+    }
+    
+    //------------------------------------------------------------------
+    ////    Reader: the parameterised volumes, copy by copy as written
+    
+    class TabulatedParameterisation : public G4VPVParameterisation
+    {
+    public:
+        TabulatedParameterisation() {}
+        virtual ~TabulatedParameterisation()
+        {
+            for(std::size_t i=0; i<fRotations.size(); i++) delete fRotations[i];
+        }
+        
+        void AddCopy(G4VSolid* solid, G4Material* material, G4RotationMatrix* rotation, const G4ThreeVector& translation)
+        {
+            fSolids.push_back(solid);
+            fMaterials.push_back(material);
+            fRotations.push_back(rotation);
+            fTranslations.push_back(translation);
+        }
+        
+        void ComputeTransformation(const G4int copyNo, G4VPhysicalVolume* physVol) const
+        {
+            physVol->SetTranslation(fTranslations[copyNo]);
+            physVol->SetRotation(fRotations[copyNo]);
+        }
+        
+        G4VSolid* ComputeSolid(const G4int copyNo, G4VPhysicalVolume*)
+        {
+            return fSolids[copyNo];
+        }
+        
+        G4Material* ComputeMaterial(const G4int copyNo, G4VPhysicalVolume* physVol, const G4VTouchable*)
+        {
+            return fMaterials[copyNo] ? fMaterials[copyNo] : physVol->GetLogicalVolume()->GetMaterial();
+        }
+        
+    private:
+        std::vector<G4VSolid*>          fSolids;
+        std::vector<G4Material*>        fMaterials;
+        std::vector<G4RotationMatrix*>  fRotations;
+        std::vector<G4ThreeVector>      fTranslations;
+    };
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    G4VSolid* BuildSolid(const SolidRecord& record, const std::vector<G4VSolid*>& solids)
+    {
+        const std::vector<G4double>& p = record.values;
+        
+        switch(record.type)
+        {
+            case kBox:
+                return new G4Box(record.name, p[0], p[1], p[2]);
+            case kTubs:
+                return new G4Tubs(record.name, p[0], p[1], p[2], p[3], p[4]);
+            case kCons:
+                return new G4Cons(record.name, p[0], p[1], p[2], p[3], p[4], p[5], p[6]);
+            case kTorus:
+                return new G4Torus(record.name, p[0], p[1], p[2], p[3], p[4]);
+            case kTrap:
+                return new G4Trap(record.name, p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], p[8], p[9], p[10]);
+            case kGenericTrap:
+            {
+                std::vector<G4TwoVector> vertices;
+                for(G4int i=0; i<8; i++) vertices.push_back(G4TwoVector(p[1 + 2*i], p[2 + 2*i]));
+                return new G4GenericTrap(record.name, p[0], vertices);
+            }
+            case kPolycone:
+            {
+                const G4int nz = record.ints[0];
+                return new G4Polycone(record.name, p[0], p[1], nz, &p[2], &p[2 + nz], &p[2 + 2*nz]);
+            }
+            case kTessellated:
+            {
+                G4TessellatedSolid* solid = new G4TessellatedSolid(record.name);
+                std::size_t position = 2;
+                for(G4int i=0; i<record.ints[1]; i++)
+                {
+                    const G4int nCorners = record.ints[position++];
+                    G4ThreeVector corners[4];
+                    for(G4int j=0; j<nCorners; j++) corners[j] = Vector(&p[3 + 3*record.ints[position++]]);
+                    
+                    if(nCorners==3) solid->AddFacet(new G4TriangularFacet(corners[0], corners[1], corners[2], ABSOLUTE));
+                    else solid->AddFacet(new G4QuadrangularFacet(corners[0], corners[1], corners[2], corners[3], ABSOLUTE));
+                }
+                if(record.ints[0]<0) solid->SetMaxVoxels(Vector(&p[0]));
+                else solid->SetMaxVoxels(record.ints[0]);
+                solid->SetSolidClosed(true);
+                return solid;
+            }
+            case kMultiUnion:
+            {
+                G4MultiUnion* solid = new G4MultiUnion(record.name);
+                for(std::size_t i=0; i<record.ints.size(); i++)
+                {
+                    G4Transform3D placement(Rotation(&p[12*i]), Vector(&p[12*i + 9]));
+                    solid->AddNode(*solids[record.ints[i]], placement);
+                }
+                solid->Voxelize();
+                return solid;
+            }
+            case kDisplaced:
+                return new G4DisplacedSolid(record.name, solids[record.ints[0]], G4AffineTransform(Rotation(&p[0]), Vector(&p[9])));
+            case kUnion:
+                return new G4UnionSolid(record.name, solids[record.ints[0]], solids[record.ints[1]]);
+            case kIntersection:
+                return new G4IntersectionSolid(record.name, solids[record.ints[0]], solids[record.ints[1]]);
+            case kSubtraction:
+                return new G4SubtractionSolid(record.name, solids[record.ints[0]], solids[record.ints[1]]);
+            case kParameterisedSubtraction:
+                return new ParameterisedSubtractionSolid(record.name, solids[record.ints[0]], solids[record.ints[1]]);
+        }
+        
+        return 0;
+    }
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    ////    Materials, elements and isotopes already defined (e.g. by another detector construction) are reused
+    void BuildMaterials(const SnapshotRecords& records, std::vector<G4Material*>& materials)
+    {
+        G4NistManager* nistManager = G4NistManager::Instance();
+        
+        std::vector<G4Isotope*> isotopes;
+        for(std::size_t i=0; i<records.isotopes.size(); i++)
+        {
+            const IsotopeRecord& record = records.isotopes[i];
+            G4Isotope* isotope = G4Isotope::GetIsotope(record.name, false);
+            if(!isotope) isotope = new G4Isotope(record.name, record.Z, record.N, record.A);
+            isotopes.push_back(isotope);
+        }
+        
+        std::vector<G4Element*> elements;
+        for(std::size_t i=0; i<records.elements.size(); i++)
+        {
+            const ElementRecord& record = records.elements[i];
+            G4Element* element = G4Element::GetElement(record.name, false);
+            if(!element && record.name==record.symbol) element = nistManager->FindOrBuildElement(record.symbol);
+            if(!element && record.isotopes.empty()) element = new G4Element(record.name, record.symbol, record.Z, record.A);
+            if(!element)
+            {
+                element = new G4Element(record.name, record.symbol, G4int(record.isotopes.size()));
+                for(std::size_t j=0; j<record.isotopes.size(); j++) element->AddIsotope(isotopes[record.isotopes[j]], record.abundances[j]);
+            }
+            elements.push_back(element);
+        }
+        
+        for(std::size_t i=0; i<records.materials.size(); i++)
+        {
+            const MaterialRecord& record = records.materials[i];
+            G4Material* material = G4Material::GetMaterial(record.name, false);
+            if(!material && record.name.substr(0, 3)=="G4_") material = nistManager->FindOrBuildMaterial(record.name);
+            if(!material)
+            {
+                material = new G4Material(record.name, record.density, G4int(record.elements.size()),
+                                          G4State(record.state), record.temperature, record.pressure);
+                for(std::size_t j=0; j<record.elements.size(); j++) material->AddElement(elements[record.elements[j]], record.fractions[j]);
+            }
+            materials.push_back(material);
+        }
+    }
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    G4VPhysicalVolume* Build(const SnapshotRecords& records)
+    {
+        std::vector<G4Material*> materials;
+        BuildMaterials(records, materials);
+        
+        std::vector<G4VSolid*> solids;
+        for(std::size_t i=0; i<records.solids.size(); i++) solids.push_back(BuildSolid(records.solids[i], solids));
+        
+        std::vector<G4LogicalVolume*> logicals;
+        for(std::size_t i=0; i<records.logicals.size(); i++)
+        {
+            const LogicalRecord& record = records.logicals[i];
+            G4LogicalVolume* logical = new G4LogicalVolume(solids[record.solid], materials[record.material], record.name);
+            
+            if(record.visFlags>=0)
+            {
+                G4VisAttributes* visAttributes = new G4VisAttributes(G4Colour(record.colour[0], record.colour[1], record.colour[2], record.colour[3]));
+                visAttributes->SetVisibility((record.visFlags & kVisible)!=0);
+                visAttributes->SetDaughtersInvisible((record.visFlags & kDaughtersInvisible)!=0);
+                if(record.forcedStyle==G4VisAttributes::wireframe) visAttributes->SetForceWireframe(true);
+                if(record.forcedStyle==G4VisAttributes::solid) visAttributes->SetForceSolid(true);
+                logical->SetVisAttributes(visAttributes);
+            }
+            logicals.push_back(logical);
+        }
+        
+        G4VPhysicalVolume* world = 0;
+        for(std::size_t i=0; i<records.physicals.size(); i++)
+        {
+            const PhysicalRecord& record = records.physicals[i];
+            G4LogicalVolume* mother = record.mother<0 ? 0 : logicals[record.mother];
+            
+            if(record.parameterised)
+            {
+                TabulatedParameterisation* parameterisation = new TabulatedParameterisation();
+                for(std::size_t j=0; j<record.copies.size(); j++)
+                {
+                    const CopyRecord& copy = record.copies[j];
+                    parameterisation->AddCopy(solids[copy.solid], copy.material<0 ? 0 : materials[copy.material],
+                                              copy.rotated ? new G4RotationMatrix(Rotation(&copy.transform[0])) : 0, Vector(&copy.transform[9]));
+                }
+                new G4PVParameterised(record.name, logicals[record.logical], mother, kUndefined, G4int(record.copies.size()), parameterisation);
+            }
+            else
+            {
+                const CopyRecord& copy = record.copies[0];
+                G4VPhysicalVolume* physical = new G4PVPlacement(copy.rotated ? new G4RotationMatrix(Rotation(&copy.transform[0])) : 0,
+                                                                Vector(&copy.transform[9]),
+                                                                logicals[record.logical],
+                                                                record.name,
+                                                                mother,
+                                                                false,
+                                                                record.copyNo);
+                if(!mother) world = physical;
+            }
+        }
+        
+        G4RegionStore* regionStore = G4RegionStore::GetInstance();
+        for(std::size_t i=0; i<records.regions.size(); i++)
+        {
+            const RegionRecord& record = records.regions[i];
+            G4Region* region = regionStore->GetRegion(record.name, false);
+            if(!region) region = new G4Region(record.name);
+            
+            for(std::size_t j=0; j<record.roots.size(); j++) region->AddRootLogicalVolume(logicals[record.roots[j]]);
+            
+            if(!record.cuts.empty())
+            {
+                G4ProductionCuts* cuts = new G4ProductionCuts();
+                for(G4int j=0; j<NumberOfG4CutIndex; j++) cuts->SetProductionCut(record.cuts[j], j);
+                region->SetProductionCuts(cuts);
+            }
+        }
+        
+        return world;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::uint64_t GeometrySnapshot::ConfigurationHash(const G4String& configuration)
+{
+    return Hash(configuration.data(), configuration.size());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool GeometrySnapshot::Write(const G4String& fileName, const G4VPhysicalVolume* world, std::uint64_t configurationHash,
+                               const std::vector<G4String>& sourceFiles)
+{
+    ////    The parameterisations are evaluated copy by copy, which changes the current copy only
+    SnapshotWriter writer;
+    if(!world || !writer.Collect(const_cast<G4VPhysicalVolume*>(world))) return false;
+    
+    std::vector<SourceFileRecord> sourceFileRecords;
+    for(std::size_t i=0; i<sourceFiles.size(); i++) sourceFileRecords.push_back(StatSourceFile(sourceFiles[i]));
+    
+    OutputStream payload;
+    SerialiseSourceFiles(sourceFileRecords, payload);
+    Serialise(writer.Records(), payload);
+    
+    GeometrySnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.version = kVersion;
+    header.headerSize = sizeof(GeometrySnapshotHeader);
+    header.configurationHash = configurationHash;
+    header.geant4Version = G4VERSION_NUMBER;
+    header.payloadSize = payload.Data().size();
+    header.payloadHash = Hash(payload.Data().data(), payload.Data().size());
+    
+    ////    Written under a temporary name and renamed, so that concurrent jobs never see a partial snapshot
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".tmp%ld", (long) getpid());
+    const G4String temporaryFile = fileName + suffix;
+    
+    std::FILE* file = std::fopen(temporaryFile.c_str(), "wb");
+    if(!file) return false;
+    
+    G4bool written = (std::fwrite(&header, sizeof(header), 1, file)==1)
+    && (std::fwrite(payload.Data().data(), 1, payload.Data().size(), file)==payload.Data().size());
+    
+    written = (std::fclose(file)==0) && written;
+    
+    if(!written || std::rename(temporaryFile.c_str(), fileName.c_str())!=0)
+    {
+        std::remove(temporaryFile.c_str());
+        return false;
+    }
+    
+    G4cout << "GeometrySnapshot: wrote " << writer.Records().physicals.size() << " physical volumes ("
+    << writer.Records().solids.size() << " solids) to " << fileName << G4endl;
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VPhysicalVolume* GeometrySnapshot::Read(const G4String& fileName, std::uint64_t configurationHash)
+{
+    std::FILE* file = std::fopen(fileName.c_str(), "rb");
+    if(!file) return 0;
+    
+    GeometrySnapshotHeader header;
+    std::vector<char> payload;
+    G4bool valid = std::fread(&header, sizeof(header), 1, file)==1
+    && std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic))==0
+    && header.version==kVersion
+    && header.headerSize==sizeof(GeometrySnapshotHeader)
+    && header.configurationHash==configurationHash
+    && header.geant4Version==G4VERSION_NUMBER;
+    
+    if(valid)
+    {
+        payload.resize(header.payloadSize);
+        valid = !payload.empty() && std::fread(&payload[0], 1, payload.size(), file)==payload.size()
+        && std::fgetc(file)==EOF
+        && Hash(&payload[0], payload.size())==header.payloadHash;
+    }
+    std::fclose(file);
+    
+    ////    Everything is checked before the first volume is built, so that a rejected snapshot leaves no trace
+    std::vector<SourceFileRecord> sourceFiles;
+    SnapshotRecords records;
+    if(valid)
+    {
+        InputStream in(&payload[0], payload.size());
+        valid = DeserialiseSourceFiles(in, sourceFiles) && Deserialise(in, records);
+    }
+    
+    ////    A mesh file changed, generated or removed since the snapshot was written
+    for(std::size_t i=0; i<sourceFiles.size() && valid; i++)
+    {
+        const SourceFileRecord current = StatSourceFile(sourceFiles[i].name);
+        if(current.exists!=sourceFiles[i].exists || current.size!=sourceFiles[i].size
+           || current.modificationTime!=sourceFiles[i].modificationTime)
+        {
+            G4cout << "GeometrySnapshot: " << sourceFiles[i].name << " has changed since " << fileName << " was written" << G4endl;
+            valid = false;
+        }
+    }
+    
+    if(!valid)
+    {
+        G4cout << "GeometrySnapshot: " << fileName << " does not match this configuration, the geometry is constructed" << G4endl;
+        return 0;
+    }
+    
+    G4VPhysicalVolume* world = Build(records);
+    
+    G4cout << "GeometrySnapshot: " << records.physicals.size() << " physical volumes (" << records.solids.size()
+    << " solids) from " << fileName << G4endl;
+    return world;
+}
@@ -0,0 +1,239 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "K600FieldMessenger.hh"
+#include "K600FieldSetup.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4TransportationManager.hh"
+#include "G4PropagatorInField.hh"
+#include "G4SystemOfUnits.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+K600FieldMessenger::K600FieldMessenger()
+: G4UImessenger()
+{
+    fFieldDirectory = new G4UIdirectory("/K600/field/");
+    fFieldDirectory->SetGuidance("Field transport (integration and accuracy) of the K600 magnets.");
+    
+    fLargestAcceptableStepCmd = new G4UIcmdWithADoubleAndUnit("/K600/field/largestAcceptableStep", this);
+    fLargestAcceptableStepCmd->SetGuidance("Largest step taken in one go in any field volume.");
+    fLargestAcceptableStepCmd->SetParameterName("step", false);
+    fLargestAcceptableStepCmd->SetRange("step>0.");
+    fLargestAcceptableStepCmd->SetUnitCategory("Length");
+    fLargestAcceptableStepCmd->AvailableForStates(G4State_Idle);
+    
+    fPrintCmd = new G4UIcmdWithoutParameter("/K600/field/print", this);
+    fPrintCmd->SetGuidance("Print the transport settings of all magnets.");
+    fPrintCmd->AvailableForStates(G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+K600FieldMessenger::~K600FieldMessenger()
+{
+    for(size_t i=0; i<fMagnets.size(); i++)
+    {
+        delete fMagnets[i].stepperCmd;
+        delete fMagnets[i].driverCmd;
+        delete fMagnets[i].minStepCmd;
+        delete fMagnets[i].deltaChordCmd;
+        delete fMagnets[i].deltaOneStepCmd;
+        delete fMagnets[i].deltaIntersectionCmd;
+        delete fMagnets[i].epsilonMinCmd;
+        delete fMagnets[i].epsilonMaxCmd;
+        delete fMagnets[i].printCmd;
+        delete fMagnets[i].directory;
+    }
+    
+    delete fLargestAcceptableStepCmd;
+    delete fPrintCmd;
+    delete fFieldDirectory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600FieldMessenger::AddMagnet(const G4String& name, K600FieldSetup* fieldSetup)
+{
+    for(size_t i=0; i<fMagnets.size(); i++)
+    {
+        if(fMagnets[i].name==name)
+        {
+            fMagnets[i].fieldSetup = fieldSetup;
+            return;
+        }
+    }
+    
+    const G4String path = "/K600/field/" + name + "/";
+    
+    MagnetCommands magnet;
+    magnet.name = name;
+    magnet.fieldSetup = fieldSetup;
+    
+    magnet.directory = new G4UIdirectory(path.c_str());
+    magnet.directory->SetGuidance(("Field transport of " + name + ".").c_str());
+    
+    magnet.stepperCmd = new G4UIcmdWithAString((path + "stepper").c_str(), this);
+    magnet.stepperCmd->SetGuidance("Select the integration stepper.");
+    magnet.stepperCmd->SetGuidance("ExactHelix is only accepted in a uniform field.");
+    magnet.stepperCmd->SetParameterName("stepper", false);
+    magnet.stepperCmd->SetCandidates("ClassicalRK4 CashKarpRKF45 BogackiShampine23 BogackiShampine45 DormandPrince745 ExactHelix");
+    magnet.stepperCmd->AvailableForStates(G4State_Idle);
+    
+    magnet.driverCmd = new G4UIcmdWithAString((path + "driver").c_str(), this);
+    magnet.driverCmd->SetGuidance("Select the integration driver:");
+    magnet.driverCmd->SetGuidance("  standard      - G4MagInt_Driver, any stepper");
+    magnet.driverCmd->SetGuidance("  interpolating - FSAL dense output, DormandPrince745 only (Geant4 >= 10.7)");
+    magnet.driverCmd->SetParameterName("driver", false);
+    magnet.driverCmd->SetCandidates("standard interpolating");
+    magnet.driverCmd->AvailableForStates(G4State_Idle);
+    
+    magnet.minStepCmd = new G4UIcmdWithADoubleAndUnit((path + "minStep").c_str(), this);
+    magnet.minStepCmd->SetGuidance("Minimum step of the integration driver.");
+    magnet.minStepCmd->SetParameterName("minStep", false);
+    magnet.minStepCmd->SetRange("minStep>0.");
+    magnet.minStepCmd->SetUnitCategory("Length");
+    magnet.minStepCmd->AvailableForStates(G4State_Idle);
+    
+    magnet.deltaChordCmd = new G4UIcmdWithADoubleAndUnit((path + "deltaChord").c_str(), this);
+    magnet.deltaChordCmd->SetGuidance("Maximum sagitta between a chord and the true trajectory.");
+    magnet.deltaChordCmd->SetParameterName("deltaChord", false);
+    magnet.deltaChordCmd->SetRange("deltaChord>0.");
+    magnet.deltaChordCmd->SetUnitCategory("Length");
+    magnet.deltaChordCmd->AvailableForStates(G4State_Idle);
+    
+    magnet.deltaOneStepCmd = new G4UIcmdWithADoubleAndUnit((path + "deltaOneStep").c_str(), this);
+    magnet.deltaOneStepCmd->SetGuidance("Position accuracy of a step that does not cross a boundary.");
+    magnet.deltaOneStepCmd->SetParameterName("deltaOneStep", false);
+    magnet.deltaOneStepCmd->SetRange("deltaOneStep>0.");
+    magnet.deltaOneStepCmd->SetUnitCategory("Length");
+    magnet.deltaOneStepCmd->AvailableForStates(G4State_Idle);
+    
+    magnet.deltaIntersectionCmd = new G4UIcmdWithADoubleAndUnit((path + "deltaIntersection").c_str(), this);
+    magnet.deltaIntersectionCmd->SetGuidance("Position accuracy of boundary intersections.");
+    magnet.deltaIntersectionCmd->SetParameterName("deltaIntersection", false);
+    magnet.deltaIntersectionCmd->SetRange("deltaIntersection>0.");
+    magnet.deltaIntersectionCmd->SetUnitCategory("Length");
+    magnet.deltaIntersectionCmd->AvailableForStates(G4State_Idle);
+    
+    magnet.epsilonMinCmd = new G4UIcmdWithADouble((path + "epsilonMin").c_str(), this);
+    magnet.epsilonMinCmd->SetGuidance("Lower bound of the relative integration accuracy (used for long steps).");
+    magnet.epsilonMinCmd->SetParameterName("epsilonMin", false);
+    magnet.epsilonMinCmd->SetRange("epsilonMin>0. && epsilonMin<1.");
+    magnet.epsilonMinCmd->AvailableForStates(G4State_Idle);
+    
+    magnet.epsilonMaxCmd = new G4UIcmdWithADouble((path + "epsilonMax").c_str(), this);
+    magnet.epsilonMaxCmd->SetGuidance("Upper bound of the relative integration accuracy (used for short steps).");
+    magnet.epsilonMaxCmd->SetParameterName("epsilonMax", false);
+    magnet.epsilonMaxCmd->SetRange("epsilonMax>0. && epsilonMax<1.");
+    magnet.epsilonMaxCmd->AvailableForStates(G4State_Idle);
+    
+    magnet.printCmd = new G4UIcmdWithoutParameter((path + "print").c_str(), this);
+    magnet.printCmd->SetGuidance("Print the transport settings of this magnet.");
+    magnet.printCmd->AvailableForStates(G4State_Idle);
+    
+    fMagnets.push_back(magnet);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600FieldMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    G4PropagatorInField* propagator = G4TransportationManager::GetTransportationManager()->GetPropagatorInField();
+    
+    if(command==fLargestAcceptableStepCmd)
+    {
+        propagator->SetLargestAcceptableStep(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue));
+        return;
+    }
+    
+    if(command==fPrintCmd)
+    {
+        G4cout << "\n  Largest acceptable step: " << propagator->GetLargestAcceptableStep()/mm << " mm" << G4endl;
+        for(size_t i=0; i<fMagnets.size(); i++) fMagnets[i].fieldSetup->Print(fMagnets[i].name);
+        return;
+    }
+    
+    for(size_t i=0; i<fMagnets.size(); i++)
+    {
+        K600FieldSetup* fieldSetup = fMagnets[i].fieldSetup;
+        
+        if(command==fMagnets[i].stepperCmd)
+        {
+            fieldSetup->SetStepper(newValue);
+        }
+        else if(command==fMagnets[i].driverCmd)
+        {
+            fieldSetup->SetDriver(newValue);
+        }
+        else if(command==fMagnets[i].minStepCmd)
+        {
+            fieldSetup->SetMinStep(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue));
+        }
+        else if(command==fMagnets[i].deltaChordCmd)
+        {
+            fieldSetup->SetDeltaChord(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue));
+        }
+        else if(command==fMagnets[i].deltaOneStepCmd)
+        {
+            fieldSetup->SetDeltaOneStep(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue));
+        }
+        else if(command==fMagnets[i].deltaIntersectionCmd)
+        {
+            fieldSetup->SetDeltaIntersection(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue));
+        }
+        else if(command==fMagnets[i].epsilonMinCmd)
+        {
+            fieldSetup->SetEpsilonMin(G4UIcmdWithADouble::GetNewDoubleValue(newValue));
+        }
+        else if(command==fMagnets[i].epsilonMaxCmd)
+        {
+            fieldSetup->SetEpsilonMax(G4UIcmdWithADouble::GetNewDoubleValue(newValue));
+        }
+        else if(command==fMagnets[i].printCmd)
+        {
+            fieldSetup->Print(fMagnets[i].name);
+        }
+        else continue;
+        
+        return;
+    }
+}
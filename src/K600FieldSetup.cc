@@ -0,0 +1,267 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "K600FieldSetup.hh"
+
+#include "G4MagneticField.hh"
+#include "G4UniformMagField.hh"
+#include "G4Mag_UsualEqRhs.hh"
+#include "G4ClassicalRK4.hh"
+#include "G4CashKarpRKF45.hh"
+#include "G4BogackiShampine23.hh"
+#include "G4BogackiShampine45.hh"
+#include "G4DormandPrince745.hh"
+#include "G4ExactHelixStepper.hh"
+#include "G4MagIntegratorDriver.hh"
+#include "G4ChordFinder.hh"
+#include "G4FieldManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Version.hh"
+
+#if G4VERSION_NUMBER >= 1070
+#include "G4InterpolationDriver.hh"
+#endif
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+K600FieldSetup::K600FieldSetup(G4MagneticField* field, G4double minStep)
+: fField(field),
+fEquation(0),
+fStepper(0),
+fChordFinder(0),
+fFieldManager(0),
+fStepperName("ClassicalRK4"),
+fDriverName("standard"),
+fMinStep(minStep)
+{
+    fEquation = new G4Mag_UsualEqRhs(fField);
+    SetIntegrator(fStepperName, fDriverName);
+    
+    ////    The chord finder is handed to the field manager (which does not delete it)
+    fFieldManager = new G4FieldManager(fField, fChordFinder);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+K600FieldSetup::~K600FieldSetup()
+{
+    delete fFieldManager;
+    delete fChordFinder;
+    delete fStepper;
+    delete fEquation;
+    delete fField;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4MagIntegratorStepper* K600FieldSetup::CreateStepper(const G4String& stepperName) const
+{
+    if(stepperName=="ClassicalRK4") return new G4ClassicalRK4(fEquation);
+    if(stepperName=="CashKarpRKF45") return new G4CashKarpRKF45(fEquation);
+    if(stepperName=="BogackiShampine23") return new G4BogackiShampine23(fEquation);
+    if(stepperName=="BogackiShampine45") return new G4BogackiShampine45(fEquation);
+    if(stepperName=="DormandPrince745") return new G4DormandPrince745(fEquation);
+    
+    if(stepperName=="ExactHelix")
+    {
+        if(!dynamic_cast<G4UniformMagField*>(fField))
+        {
+            G4ExceptionDescription description;
+            description << "The exact helix stepper is only valid in a uniform field." << G4endl;
+            G4Exception("K600FieldSetup::CreateStepper()", "K600FieldSetup0001", JustWarning, description);
+            return 0;
+        }
+        
+        return new G4ExactHelixStepper(fEquation);
+    }
+    
+    G4ExceptionDescription description;
+    description << "Unknown stepper \"" << stepperName << "\"." << G4endl;
+    G4Exception("K600FieldSetup::CreateStepper()", "K600FieldSetup0002", JustWarning, description);
+    
+    return 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool K600FieldSetup::SetIntegrator(const G4String& stepperName, const G4String& driverName)
+{
+    if(driverName!="standard" && driverName!="interpolating")
+    {
+        G4ExceptionDescription description;
+        description << "Unknown integration driver \"" << driverName << "\"." << G4endl;
+        G4Exception("K600FieldSetup::SetIntegrator()", "K600FieldSetup0003", JustWarning, description);
+        return false;
+    }
+    
+    if(driverName=="interpolating")
+    {
+#if G4VERSION_NUMBER >= 1070
+        if(stepperName!="DormandPrince745")
+        {
+            G4ExceptionDescription description;
+            description << "The interpolating driver requires the DormandPrince745 stepper." << G4endl;
+            G4Exception("K600FieldSetup::SetIntegrator()", "K600FieldSetup0004", JustWarning, description);
+            return false;
+        }
+#else
+        G4ExceptionDescription description;
+        description << "The interpolating driver requires Geant4 10.7 or later." << G4endl;
+        G4Exception("K600FieldSetup::SetIntegrator()", "K600FieldSetup0004", JustWarning, description);
+        return false;
+#endif
+    }
+    
+    G4MagIntegratorStepper* stepper = CreateStepper(stepperName);
+    if(!stepper) return false;
+    
+    G4ChordFinder* chordFinder = 0;
+    
+#if G4VERSION_NUMBER >= 1070
+    if(driverName=="interpolating")
+    {
+        ////    Dense output of the FSAL Dormand-Prince stepper: the chord and intersection
+        ////    searches interpolate within an accepted step instead of re-integrating
+        G4DormandPrince745* dormandPrince = static_cast<G4DormandPrince745*>(stepper);
+        G4VIntegrationDriver* driver = new G4InterpolationDriver<G4DormandPrince745>(fMinStep, dormandPrince, dormandPrince->GetNumberOfVariables());
+        chordFinder = new G4ChordFinder(driver);
+    }
+#endif
+    
+    if(!chordFinder)
+    {
+        G4MagInt_Driver* driver = new G4MagInt_Driver(fMinStep, stepper, stepper->GetNumberOfVariables());
+        chordFinder = new G4ChordFinder(driver);
+    }
+    
+    ////    Carry the accuracy settings over to the new chord finder
+    if(fChordFinder) chordFinder->SetDeltaChord(fChordFinder->GetDeltaChord());
+    if(fFieldManager) fFieldManager->SetChordFinder(chordFinder);
+    
+    delete fChordFinder;
+    delete fStepper;
+    
+    fChordFinder = chordFinder;
+    fStepper = stepper;
+    fStepperName = stepperName;
+    fDriverName = driverName;
+    
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool K600FieldSetup::SetStepper(const G4String& stepperName)
+{
+    return SetIntegrator(stepperName, fDriverName);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool K600FieldSetup::SetDriver(const G4String& driverName)
+{
+    return SetIntegrator(fStepperName, driverName);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600FieldSetup::SetMinStep(G4double minStep)
+{
+    const G4double previousMinStep = fMinStep;
+    fMinStep = minStep;
+    
+    if(!SetIntegrator(fStepperName, fDriverName)) fMinStep = previousMinStep;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600FieldSetup::SetDeltaChord(G4double deltaChord)
+{
+    fChordFinder->SetDeltaChord(deltaChord);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600FieldSetup::SetDeltaOneStep(G4double deltaOneStep)
+{
+    fFieldManager->SetDeltaOneStep(deltaOneStep);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600FieldSetup::SetDeltaIntersection(G4double deltaIntersection)
+{
+    fFieldManager->SetDeltaIntersection(deltaIntersection);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600FieldSetup::SetEpsilonMin(G4double epsilonMin)
+{
+    fFieldManager->SetMinimumEpsilonStep(epsilonMin);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600FieldSetup::SetEpsilonMax(G4double epsilonMax)
+{
+    fFieldManager->SetMaximumEpsilonStep(epsilonMax);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double K600FieldSetup::GetDeltaChord() const          { return fChordFinder->GetDeltaChord(); }
+G4double K600FieldSetup::GetDeltaOneStep() const        { return fFieldManager->GetDeltaOneStep(); }
+G4double K600FieldSetup::GetDeltaIntersection() const   { return fFieldManager->GetDeltaIntersection(); }
+G4double K600FieldSetup::GetEpsilonMin() const          { return fFieldManager->GetMinimumEpsilonStep(); }
+G4double K600FieldSetup::GetEpsilonMax() const          { return fFieldManager->GetMaximumEpsilonStep(); }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600FieldSetup::Print(const G4String& name) const
+{
+    G4cout << "\n------------------------------------------------------------"
+    << "\n  Field transport: " << name
+    << "\n    stepper:              " << fStepperName
+    << "\n    driver:               " << fDriverName
+    << "\n    minStep:              " << fMinStep/mm << " mm"
+    << "\n    deltaChord:           " << GetDeltaChord()/mm << " mm"
+    << "\n    deltaOneStep:         " << GetDeltaOneStep()/mm << " mm"
+    << "\n    deltaIntersection:    " << GetDeltaIntersection()/mm << " mm"
+    << "\n    epsilonMin:           " << GetEpsilonMin()
+    << "\n    epsilonMax:           " << GetEpsilonMax()
+    << "\n------------------------------------------------------------" << G4endl;
+}
@@ -0,0 +1,194 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "K600LayoutMessenger.hh"
+#include "DetectorConstruction.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+K600LayoutMessenger::K600LayoutMessenger(DetectorConstruction* detectorConstruction)
+: G4UImessenger(),
+fDetectorConstruction(detectorConstruction)
+{
+    fLayoutDirectory = new G4UIdirectory("/K600/layout/");
+    fLayoutDirectory->SetGuidance("Layout changes of the detector arrays between runs, without rebuilding the geometry.");
+    fLayoutDirectory->SetGuidance("Only detectors present in the built geometry can be moved, removed and put back.");
+    
+    fCLOVERDirectory = new G4UIdirectory("/K600/layout/CLOVER/");
+    fCLOVERDirectory->SetGuidance("CLOVER detectors, moved and removed with their BGO shields.");
+    
+    fCLOVERDistanceCmd = new G4UIcommand("/K600/layout/CLOVER/distance", this);
+    fCLOVERDistanceCmd->SetGuidance("Distance of a CLOVER from the target, along its axis (detector -1: all).");
+    G4UIparameter* detector = new G4UIparameter("detector", 'i', false);
+    G4UIparameter* distance = new G4UIparameter("distance", 'd', false);
+    G4UIparameter* unit = new G4UIparameter("unit", 's', true);
+    distance->SetParameterRange("distance>=0.");
+    unit->SetDefaultValue("cm");
+    fCLOVERDistanceCmd->SetParameter(detector);
+    fCLOVERDistanceCmd->SetParameter(distance);
+    fCLOVERDistanceCmd->SetParameter(unit);
+    
+    fCLOVERPresenceCmd = new G4UIcommand("/K600/layout/CLOVER/presence", this);
+    fCLOVERPresenceCmd->SetGuidance("Remove or put back a CLOVER and its shield (detector -1: all).");
+    detector = new G4UIparameter("detector", 'i', false);
+    G4UIparameter* presence = new G4UIparameter("presence", 'b', true);
+    presence->SetDefaultValue("true");
+    fCLOVERPresenceCmd->SetParameter(detector);
+    fCLOVERPresenceCmd->SetParameter(presence);
+    
+    fLaBr3CeDirectory = new G4UIdirectory("/K600/layout/ALBA_LaBr3Ce/");
+    fLaBr3CeDirectory->SetGuidance("LaBr3Ce detectors on the faces of the truncated icosahedron.");
+    
+    fLaBr3CeDistanceCmd = new G4UIcmdWithADoubleAndUnit("/K600/layout/ALBA_LaBr3Ce/distance", this);
+    fLaBr3CeDistanceCmd->SetGuidance("Distance of all LaBr3Ce detectors from the target.");
+    fLaBr3CeDistanceCmd->SetGuidance("The crystal tapering is the one built: distances below the built one are refused.");
+    fLaBr3CeDistanceCmd->SetParameterName("distance", false);
+    fLaBr3CeDistanceCmd->SetRange("distance>0.");
+    fLaBr3CeDistanceCmd->SetUnitCategory("Length");
+    fLaBr3CeDistanceCmd->SetDefaultUnit("cm");
+    
+    fLaBr3CePreconfiguredVersionCmd = new G4UIcmdWithAnInteger("/K600/layout/ALBA_LaBr3Ce/preconfiguredVersion", this);
+    fLaBr3CePreconfiguredVersionCmd->SetGuidance("Distance of the preconfigured version (see SetupPreconfiguredVersion()).");
+    fLaBr3CePreconfiguredVersionCmd->SetGuidance("The crystal tapering is the one built: build the version with the smallest distance of a scan.");
+    fLaBr3CePreconfiguredVersionCmd->SetParameterName("version", false);
+    fLaBr3CePreconfiguredVersionCmd->SetRange("version>=0 && version<=10");
+    
+    fLaBr3CeFacesCmd = new G4UIcmdWithAString("/K600/layout/ALBA_LaBr3Ce/faces", this);
+    fLaBr3CeFacesCmd->SetGuidance("hexagons: detectors 0 to 19 on the 20 hexagonal faces, the others removed.");
+    fLaBr3CeFacesCmd->SetGuidance("pentagons: detectors 20 to 31 on the 12 pentagonal faces, the others removed.");
+    fLaBr3CeFacesCmd->SetGuidance("The crystals are tapered for their face: only the detectors built for it are placed.");
+    fLaBr3CeFacesCmd->SetGuidance("Either resets the presence of the detectors.");
+    fLaBr3CeFacesCmd->SetParameterName("faces", false);
+    fLaBr3CeFacesCmd->SetCandidates("hexagons pentagons");
+    
+    fLaBr3CePresenceCmd = new G4UIcommand("/K600/layout/ALBA_LaBr3Ce/presence", this);
+    fLaBr3CePresenceCmd->SetGuidance("Remove or put back a LaBr3Ce detector (detector -1: all).");
+    detector = new G4UIparameter("detector", 'i', false);
+    presence = new G4UIparameter("presence", 'b', true);
+    presence->SetDefaultValue("true");
+    fLaBr3CePresenceCmd->SetParameter(detector);
+    fLaBr3CePresenceCmd->SetParameter(presence);
+    
+    fPrintCmd = new G4UIcmdWithoutParameter("/K600/layout/print", this);
+    fPrintCmd->SetGuidance("Print the presence, distance and angles of the CLOVER and LaBr3Ce detectors built.");
+    
+    ////    The geometry is shared: changes are made by the master, between runs
+    fCLOVERDistanceCmd->AvailableForStates(G4State_Idle);
+    fCLOVERPresenceCmd->AvailableForStates(G4State_Idle);
+    fLaBr3CeDistanceCmd->AvailableForStates(G4State_Idle);
+    fLaBr3CePreconfiguredVersionCmd->AvailableForStates(G4State_Idle);
+    fLaBr3CeFacesCmd->AvailableForStates(G4State_Idle);
+    fLaBr3CePresenceCmd->AvailableForStates(G4State_Idle);
+    fPrintCmd->AvailableForStates(G4State_Idle);
+    
+    fCLOVERDistanceCmd->SetToBeBroadcasted(false);
+    fCLOVERPresenceCmd->SetToBeBroadcasted(false);
+    fLaBr3CeDistanceCmd->SetToBeBroadcasted(false);
+    fLaBr3CePreconfiguredVersionCmd->SetToBeBroadcasted(false);
+    fLaBr3CeFacesCmd->SetToBeBroadcasted(false);
+    fLaBr3CePresenceCmd->SetToBeBroadcasted(false);
+    fPrintCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+K600LayoutMessenger::~K600LayoutMessenger()
+{
+    delete fCLOVERDistanceCmd;
+    delete fCLOVERPresenceCmd;
+    delete fLaBr3CeDistanceCmd;
+    delete fLaBr3CePreconfiguredVersionCmd;
+    delete fLaBr3CeFacesCmd;
+    delete fLaBr3CePresenceCmd;
+    delete fPrintCmd;
+    delete fCLOVERDirectory;
+    delete fLaBr3CeDirectory;
+    delete fLayoutDirectory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600LayoutMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fCLOVERDistanceCmd)
+    {
+        std::istringstream input(newValue);
+        G4int detector;
+        G4double distance;
+        G4String unit;
+        input >> detector >> distance >> unit;
+        
+        fDetectorConstruction->SetDistance_CLOVER(detector, distance*G4UIcommand::ValueOf(unit));
+    }
+    else if(command==fCLOVERPresenceCmd || command==fLaBr3CePresenceCmd)
+    {
+        std::istringstream input(newValue);
+        G4int detector;
+        G4String presence;
+        input >> detector >> presence;
+        
+        if(command==fCLOVERPresenceCmd) fDetectorConstruction->SetPresence_CLOVER(detector, G4UIcommand::ConvertToBool(presence));
+        else fDetectorConstruction->SetPresence_ALBA_LaBr3Ce(detector, G4UIcommand::ConvertToBool(presence));
+    }
+    else if(command==fLaBr3CeDistanceCmd)
+    {
+        fDetectorConstruction->SetDistance_ALBA_LaBr3Ce(fLaBr3CeDistanceCmd->GetNewDoubleValue(newValue));
+    }
+    else if(command==fLaBr3CePreconfiguredVersionCmd)
+    {
+        fDetectorConstruction->SetPreconfiguredVersion_ALBA_LaBr3Ce(fLaBr3CePreconfiguredVersionCmd->GetNewIntValue(newValue));
+    }
+    else if(command==fLaBr3CeFacesCmd)
+    {
+        fDetectorConstruction->SetFaces_ALBA_LaBr3Ce(newValue=="hexagons");
+    }
+    else if(command==fPrintCmd)
+    {
+        fDetectorConstruction->PrintLayout();
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,213 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "K600PhysicsList.hh"
+#include "K600PhysicsListMessenger.hh"
+
+#include "G4EmStandardPhysics.hh"
+#include "G4EmStandardPhysics_option4.hh"
+#include "G4EmLivermorePhysics.hh"
+#include "G4EmExtraPhysics.hh"
+#include "G4DecayPhysics.hh"
+#include "G4RadioactiveDecayPhysics.hh"
+#include "G4HadronElasticPhysics.hh"
+#include "G4HadronPhysicsQGSP_BERT.hh"
+#include "G4StoppingPhysics.hh"
+#include "G4IonPhysics.hh"
+#include "G4NeutronTrackingCut.hh"
+#include "G4StepLimiterPhysics.hh"
+#include "G4FastSimulationPhysics.hh"
+
+#include "G4BosonConstructor.hh"
+#include "G4LeptonConstructor.hh"
+#include "G4MesonConstructor.hh"
+#include "G4BaryonConstructor.hh"
+#include "G4IonConstructor.hh"
+#include "G4ShortLivedConstructor.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+K600PhysicsList::K600PhysicsList(const G4String& configuration)
+: G4VModularPhysicsList(),
+fConfiguration(""),
+fInitialisationTimerStarted(false),
+fInitialisationTime(-1.)
+{
+    ////    As the reference physics lists
+    SetDefaultCutValue(0.7*mm);
+    
+    fMessenger = new K600PhysicsListMessenger(this);
+    
+    ////    Step, track length, time and energy limits of the regions (/K600/regions/)
+    fStepLimiterPhysics = new G4StepLimiterPhysics();
+    
+    ////    Fast simulation (transfer map of the K600 magnets) for the ejectiles,
+    ////    only active where a model is attached to a region (see DetectorConstruction)
+    fFastSimulationPhysics = new G4FastSimulationPhysics();
+    fFastSimulationPhysics->ActivateFastSimulation("proton");
+    fFastSimulationPhysics->ActivateFastSimulation("deuteron");
+    fFastSimulationPhysics->ActivateFastSimulation("triton");
+    fFastSimulationPhysics->ActivateFastSimulation("He3");
+    fFastSimulationPhysics->ActivateFastSimulation("alpha");
+    
+    if(!SelectConfiguration(configuration)) SelectConfiguration("full");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+K600PhysicsList::~K600PhysicsList()
+{
+    delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600PhysicsList::ConstructParticle()
+{
+    ////    The particles are constructed when the list is handed to the run manager, before a
+    ////    configuration selected in a macro: all of them, for every configuration
+    G4BosonConstructor bosonConstructor;
+    bosonConstructor.ConstructParticle();
+    
+    G4LeptonConstructor leptonConstructor;
+    leptonConstructor.ConstructParticle();
+    
+    G4MesonConstructor mesonConstructor;
+    mesonConstructor.ConstructParticle();
+    
+    G4BaryonConstructor baryonConstructor;
+    baryonConstructor.ConstructParticle();
+    
+    G4IonConstructor ionConstructor;
+    ionConstructor.ConstructParticle();
+    
+    G4ShortLivedConstructor shortLivedConstructor;
+    shortLivedConstructor.ConstructParticle();
+    
+    G4VModularPhysicsList::ConstructParticle();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600PhysicsList::ConstructProcess()
+{
+    ////    /run/initialize of the master; the workers construct their processes later, from the same list
+    if(G4Threading::IsMasterThread() && !fInitialisationTimerStarted)
+    {
+        fInitialisationTimer.Start();
+        fInitialisationTimerStarted = true;
+    }
+    
+    G4VModularPhysicsList::ConstructProcess();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool K600PhysicsList::SelectConfiguration(const G4String& configuration)
+{
+    if(configuration==fConfiguration) return true;
+    
+    std::vector<G4VPhysicsConstructor*> physics;
+    
+    if(configuration=="full")
+    {
+        ////    The constructors of QGSP_BERT
+        physics.push_back(new G4EmStandardPhysics());
+        physics.push_back(new G4EmExtraPhysics());
+        physics.push_back(new G4DecayPhysics());
+        physics.push_back(new G4HadronElasticPhysics());
+        physics.push_back(new G4HadronPhysicsQGSP_BERT());
+        physics.push_back(new G4StoppingPhysics());
+        physics.push_back(new G4IonPhysics());
+        physics.push_back(new G4NeutronTrackingCut());
+        physics.push_back(new G4RadioactiveDecayPhysics());
+    }
+    else if(configuration=="em_decay")
+    {
+        physics.push_back(new G4EmStandardPhysics_option4());
+        physics.push_back(new G4DecayPhysics());
+        physics.push_back(new G4RadioactiveDecayPhysics());
+    }
+    else if(configuration=="emstandard_opt4")
+    {
+        physics.push_back(new G4EmStandardPhysics_option4());
+    }
+    else if(configuration=="emlivermore")
+    {
+        physics.push_back(new G4EmLivermorePhysics());
+    }
+    else
+    {
+        G4ExceptionDescription description;
+        description << "Unknown physics configuration \"" << configuration << "\" (full, em_decay, emstandard_opt4 or emlivermore)";
+        if(!fConfiguration.empty()) description << ": \"" << fConfiguration << "\" is kept.";
+        G4Exception("K600PhysicsList::SelectConfiguration()", "K600PhysicsList0001", JustWarning, description);
+        return false;
+    }
+    
+    for(size_t i=0; i<fConfigurationPhysics.size(); i++)
+    {
+        RemovePhysics(fConfigurationPhysics[i]);
+        delete fConfigurationPhysics[i];
+    }
+    RemovePhysics(fStepLimiterPhysics);
+    RemovePhysics(fFastSimulationPhysics);
+    
+    fConfigurationPhysics = physics;
+    for(size_t i=0; i<fConfigurationPhysics.size(); i++) RegisterPhysics(fConfigurationPhysics[i]);
+    RegisterPhysics(fStepLimiterPhysics);
+    RegisterPhysics(fFastSimulationPhysics);
+    
+    fConfiguration = configuration;
+    G4cout << "K600PhysicsList: " << fConfiguration << " physics" << G4endl;
+    
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600PhysicsList::StopInitialisationTimer()
+{
+    if(!fInitialisationTimerStarted || fInitialisationTime>=0.) return;
+    
+    fInitialisationTimer.Stop();
+    fInitialisationTime = fInitialisationTimer.GetRealElapsed();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
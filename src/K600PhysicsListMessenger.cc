@@ -0,0 +1,81 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "K600PhysicsListMessenger.hh"
+#include "K600PhysicsList.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+K600PhysicsListMessenger::K600PhysicsListMessenger(K600PhysicsList* physicsList)
+: G4UImessenger(),
+fPhysicsList(physicsList)
+{
+    fPhysicsDirectory = new G4UIdirectory("/K600/physics/");
+    fPhysicsDirectory->SetGuidance("Physics configuration, before /run/initialize.");
+    
+    fListCmd = new G4UIcmdWithAString("/K600/physics/list", this);
+    fListCmd->SetGuidance("full: QGSP_BERT with radioactive decay (default).");
+    fListCmd->SetGuidance("em_decay: electromagnetic option 4, decay and radioactive decay.");
+    fListCmd->SetGuidance("emstandard_opt4: electromagnetic option 4 only.");
+    fListCmd->SetGuidance("emlivermore: Livermore electromagnetic physics only.");
+    fListCmd->SetParameterName("configuration", false);
+    fListCmd->SetCandidates("full em_decay emstandard_opt4 emlivermore");
+    fListCmd->AvailableForStates(G4State_PreInit);
+    fListCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+K600PhysicsListMessenger::~K600PhysicsListMessenger()
+{
+    delete fListCmd;
+    delete fPhysicsDirectory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600PhysicsListMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fListCmd)
+    {
+        fPhysicsList->SelectConfiguration(newValue);
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,278 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "K600RegionMessenger.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4ProductionCuts.hh"
+#include "G4UserLimits.hh"
+#include "G4Track.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cfloat>
+
+namespace {
+    void PrintUpperLimit(const char* label, G4double value, G4double unit, const char* unitName)
+    {
+        G4cout << label;
+        if(value<DBL_MAX) G4cout << value/unit << " " << unitName;
+        else G4cout << "none";
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+K600RegionMessenger::K600RegionMessenger()
+: G4UImessenger()
+{
+    fRegionsDirectory = new G4UIdirectory("/K600/regions/");
+    fRegionsDirectory->SetGuidance("Production cuts and user limits of the detector and passive-material regions.");
+    
+    fPrintCmd = new G4UIcmdWithoutParameter("/K600/regions/print", this);
+    fPrintCmd->SetGuidance("Print the cuts and limits of all regions.");
+    fPrintCmd->AvailableForStates(G4State_Idle);
+    fPrintCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+K600RegionMessenger::~K600RegionMessenger()
+{
+    for(size_t i=0; i<fRegions.size(); i++)
+    {
+        delete fRegions[i].cutCmd;
+        delete fRegions[i].gammaCutCmd;
+        delete fRegions[i].electronCutCmd;
+        delete fRegions[i].positronCutCmd;
+        delete fRegions[i].protonCutCmd;
+        delete fRegions[i].maxStepCmd;
+        delete fRegions[i].maxTrackLengthCmd;
+        delete fRegions[i].maxTimeCmd;
+        delete fRegions[i].minKineticEnergyCmd;
+        delete fRegions[i].minRangeCmd;
+        delete fRegions[i].clearLimitsCmd;
+        delete fRegions[i].printCmd;
+        delete fRegions[i].directory;
+    }
+    
+    delete fPrintCmd;
+    delete fRegionsDirectory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4UIcmdWithADoubleAndUnit* K600RegionMessenger::MakeCommand(const G4String& path, const char* guidance, const char* unitCategory)
+{
+    G4UIcmdWithADoubleAndUnit* command = new G4UIcmdWithADoubleAndUnit(path.c_str(), this);
+    command->SetGuidance(guidance);
+    command->SetParameterName("value", false);
+    command->SetRange("value>=0.");
+    command->SetUnitCategory(unitCategory);
+    command->AvailableForStates(G4State_Idle);
+    command->SetToBeBroadcasted(false);
+    return command;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600RegionMessenger::AddRegion(const G4String& name)
+{
+    for(size_t i=0; i<fRegions.size(); i++)
+    {
+        if(fRegions[i].name==name) return;
+    }
+    
+    const G4String path = "/K600/regions/" + name + "/";
+    
+    RegionCommands region;
+    region.name = name;
+    
+    region.directory = new G4UIdirectory(path.c_str());
+    region.directory->SetGuidance(("Production cuts and user limits of the region " + name + ".").c_str());
+    
+    region.cutCmd = MakeCommand(path + "cut", "Range cut of gammas, electrons, positrons and protons.", "Length");
+    region.gammaCutCmd = MakeCommand(path + "gammaCut", "Range cut of gammas.", "Length");
+    region.electronCutCmd = MakeCommand(path + "electronCut", "Range cut of electrons.", "Length");
+    region.positronCutCmd = MakeCommand(path + "positronCut", "Range cut of positrons.", "Length");
+    region.protonCutCmd = MakeCommand(path + "protonCut", "Range cut of protons (nuclear recoils).", "Length");
+    
+    region.maxStepCmd = MakeCommand(path + "maxStep", "Largest step of any particle (0: none).", "Length");
+    region.maxTrackLengthCmd = MakeCommand(path + "maxTrackLength", "Tracks are killed beyond this total length (0: none).", "Length");
+    region.maxTimeCmd = MakeCommand(path + "maxTime", "Tracks are killed beyond this global time (0: none).", "Time");
+    region.minKineticEnergyCmd = MakeCommand(path + "minKineticEnergy", "Tracks are killed below this kinetic energy.", "Energy");
+    region.minRangeCmd = MakeCommand(path + "minRange", "Charged tracks are killed below this remaining range.", "Length");
+    
+    region.clearLimitsCmd = new G4UIcmdWithoutParameter((path + "clearLimits").c_str(), this);
+    region.clearLimitsCmd->SetGuidance("Remove the user limits of this region.");
+    region.clearLimitsCmd->AvailableForStates(G4State_Idle);
+    region.clearLimitsCmd->SetToBeBroadcasted(false);
+    
+    region.printCmd = new G4UIcmdWithoutParameter((path + "print").c_str(), this);
+    region.printCmd->SetGuidance("Print the cuts and limits of this region.");
+    region.printCmd->AvailableForStates(G4State_Idle);
+    region.printCmd->SetToBeBroadcasted(false);
+    
+    fRegions.push_back(region);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600RegionMessenger::SetProductionCut(const G4String& name, G4double cut, const G4String& particle)
+{
+    G4Region* region = G4RegionStore::GetInstance()->GetRegion(name, false);
+    if(!region) return;
+    
+    ////    Regions without cuts of their own are given those of the default region at initialisation
+    const G4Region* defaultRegion = G4RegionStore::GetInstance()->GetRegion("DefaultRegionForTheWorld", false);
+    G4ProductionCuts* cuts = region->GetProductionCuts();
+    
+    if(!cuts || (defaultRegion && cuts==defaultRegion->GetProductionCuts()))
+    {
+        cuts = cuts ? new G4ProductionCuts(*cuts) : new G4ProductionCuts();
+        region->SetProductionCuts(cuts);
+    }
+    
+    if(particle.empty()) cuts->SetProductionCut(cut);
+    else cuts->SetProductionCut(cut, particle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600RegionMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fPrintCmd)
+    {
+        for(size_t i=0; i<fRegions.size(); i++) Print(fRegions[i].name);
+        return;
+    }
+    
+    for(size_t i=0; i<fRegions.size(); i++)
+    {
+        const RegionCommands& commands = fRegions[i];
+        
+        if(command==commands.printCmd)
+        {
+            Print(commands.name);
+            return;
+        }
+        
+        G4Region* region = G4RegionStore::GetInstance()->GetRegion(commands.name, false);
+        if(!region) continue;
+        
+        if(command==commands.clearLimitsCmd)
+        {
+            delete region->GetUserLimits();
+            region->SetUserLimits(0);
+            return;
+        }
+        
+        if(command==commands.cutCmd)                SetProductionCut(commands.name, G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue), "");
+        else if(command==commands.gammaCutCmd)      SetProductionCut(commands.name, G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue), "gamma");
+        else if(command==commands.electronCutCmd)   SetProductionCut(commands.name, G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue), "e-");
+        else if(command==commands.positronCutCmd)   SetProductionCut(commands.name, G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue), "e+");
+        else if(command==commands.protonCutCmd)     SetProductionCut(commands.name, G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue), "proton");
+        else if(command==commands.maxStepCmd || command==commands.maxTrackLengthCmd || command==commands.maxTimeCmd
+                || command==commands.minKineticEnergyCmd || command==commands.minRangeCmd)
+        {
+            const G4double value = G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue);
+            
+            G4UserLimits* limits = region->GetUserLimits();
+            if(!limits)
+            {
+                limits = new G4UserLimits();
+                region->SetUserLimits(limits);
+            }
+            
+            ////    Zero removes an upper limit
+            if(command==commands.maxStepCmd)                    limits->SetMaxAllowedStep(value>0. ? value : DBL_MAX);
+            else if(command==commands.maxTrackLengthCmd)        limits->SetUserMaxTrackLength(value>0. ? value : DBL_MAX);
+            else if(command==commands.maxTimeCmd)               limits->SetUserMaxTime(value>0. ? value : DBL_MAX);
+            else if(command==commands.minKineticEnergyCmd)      limits->SetUserMinEkine(value);
+            else                                                limits->SetUserMinRange(value);
+        }
+        else continue;
+        
+        return;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void K600RegionMessenger::Print(const G4String& name) const
+{
+    const G4Region* region = G4RegionStore::GetInstance()->GetRegion(name, false);
+    if(!region) return;
+    
+    G4cout << "\n------------------------------------------------------------"
+    << "\n  Region: " << name << " (" << region->GetNumberOfRootVolumes() << " root volumes)";
+    
+    const G4ProductionCuts* cuts = region->GetProductionCuts();
+    const G4Region* defaultRegion = G4RegionStore::GetInstance()->GetRegion("DefaultRegionForTheWorld", false);
+    
+    if(!cuts || (defaultRegion && region!=defaultRegion && cuts==defaultRegion->GetProductionCuts()))
+    {
+        G4cout << "\n    production cuts:      default";
+    }
+    else
+    {
+        G4cout << "\n    gamma cut:            " << cuts->GetProductionCut("gamma")/mm << " mm"
+        << "\n    e- cut:               " << cuts->GetProductionCut("e-")/mm << " mm"
+        << "\n    e+ cut:               " << cuts->GetProductionCut("e+")/mm << " mm"
+        << "\n    proton cut:           " << cuts->GetProductionCut("proton")/mm << " mm";
+    }
+    
+    ////    G4UserLimits is queried per track; the plain G4UserLimits ignores it
+    G4UserLimits* userLimits = region->GetUserLimits();
+    if(!userLimits)
+    {
+        G4cout << "\n    user limits:          none";
+    }
+    else
+    {
+        G4Track track;
+        PrintUpperLimit("\n    maxStep:              ", userLimits->GetMaxAllowedStep(track), mm, "mm");
+        PrintUpperLimit("\n    maxTrackLength:       ", userLimits->GetUserMaxTrackLength(track), mm, "mm");
+        PrintUpperLimit("\n    maxTime:              ", userLimits->GetUserMaxTime(track), ns, "ns");
+        G4cout << "\n    minKineticEnergy:     " << userLimits->GetUserMinEkine(track)/keV << " keV"
+        << "\n    minRange:             " << userLimits->GetUserMinRange(track)/mm << " mm";
+    }
+    
+    G4cout << "\n------------------------------------------------------------" << G4endl;
+}
@@ -0,0 +1,832 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "MagneticFieldMapData.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const char kFieldMapCacheMagic[8] = {'K','6','0','0','F','L','D','\0'};
+    const std::uintptr_t kAlignment = 32;
+
+    ////    Maps already loaded by this process, shared between the worker threads
+    std::mutex mutex_fieldMaps;
+    std::map<G4String, std::weak_ptr<const MagneticFieldMapData>> fieldMaps;
+
+    ////    Tolerance (in grid spacings) on the grid positions of the mirror planes
+    const double kGridTolerance = 0.01;
+
+    ////    log2 of a tile edge of at least tileSize cells
+    int TileShift(int tileSize)
+    {
+        if(tileSize<=0) return MagneticFieldMapData::kUntiled;
+
+        int shift = 1;
+        while((1<<shift)<tileSize && shift<10) shift++;
+        return shift;
+    }
+
+    ////    Interleaves the bits of the three tile indices
+    std::uint64_t MortonCode(std::uint64_t x, std::uint64_t y, std::uint64_t z)
+    {
+        std::uint64_t code = 0;
+        for(int bit=0; bit<21; bit++)
+        {
+            code |= ((x>>bit) & 1) << (3*bit + 2);
+            code |= ((y>>bit) & 1) << (3*bit + 1);
+            code |= ((z>>bit) & 1) << (3*bit);
+        }
+        return code;
+    }
+
+    G4bool GetSourceStamp(const G4String& filename, std::uint64_t& size, std::int64_t& modificationTime)
+    {
+        struct stat fileStatus;
+        if(stat(filename.c_str(), &fileStatus)!=0) return false;
+
+        size = fileStatus.st_size;
+        modificationTime = fileStatus.st_mtime;
+        return true;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MagneticFieldMapOptions::MagneticFieldMapOptions()
+: singlePrecision(false),
+tileSize(0)
+{
+    for(int a=0; a<3; a++)
+    {
+        mirror[a] = false;
+        for(int k=0; k<3; k++) parity[a][k] = 1;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MagneticFieldMapOptions::SetMirror(int axis, int parityBx, int parityBy, int parityBz)
+{
+    mirror[axis] = true;
+    parity[axis][0] = (parityBx<0) ? -1 : 1;
+    parity[axis][1] = (parityBy<0) ? -1 : 1;
+    parity[axis][2] = (parityBz<0) ? -1 : 1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MagneticFieldMapOptions MagneticFieldMapOptions::Quadrupole()
+{
+    MagneticFieldMapOptions options;
+    options.SetMirror(0, +1, -1, -1);
+    options.SetMirror(1, -1, +1, -1);
+    return options;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MagneticFieldMapOptions MagneticFieldMapOptions::DipoleMidplane()
+{
+    MagneticFieldMapOptions options;
+    options.SetMirror(1, -1, +1, -1);
+    return options;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String MagneticFieldMapOptions::GetCacheSuffix() const
+{
+    G4String suffix;
+
+    if(IsFolded())
+    {
+        suffix += ".";
+        for(int a=0; a<3; a++)
+        {
+            if(!mirror[a]) continue;
+            suffix += "xyz"[a];
+            for(int k=0; k<3; k++) suffix += (parity[a][k]<0) ? '-' : '+';
+        }
+    }
+
+    if(singlePrecision) suffix += ".f32";
+
+    if(tileSize>0)
+    {
+        char tiles[16];
+        std::snprintf(tiles, sizeof(tiles), ".t%d", 1<<TileShift(tileSize));
+        suffix += tiles;
+    }
+
+    return suffix;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MagneticFieldMapData::MagneticFieldMapData()
+: fMapping(0),
+fMappingSize(0),
+fCells(0),
+fSinglePrecision(false),
+fNx(0),
+fNy(0),
+fNz(0),
+fStrideX(0),
+fStrideY(0),
+fStrideZ(0),
+fTileShift(kUntiled),
+fTileValues(0),
+fMinX(0.), fMaxX(0.), fMinY(0.), fMaxY(0.), fMinZ(0.), fMaxZ(0.),
+fInvertX(false),
+fInvertY(false),
+fInvertZ(false)
+{
+    for(int a=0; a<3; a++)
+    {
+        fNTiles[a] = 1;
+        fMirror[a] = false;
+        for(int k=0; k<3; k++) fParity[a][k] = 1;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MagneticFieldMapData::~MagneticFieldMapData()
+{
+    if(fMapping) munmap(fMapping, fMappingSize);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::shared_ptr<const MagneticFieldMapData> MagneticFieldMapData::Load(const G4String& filename, const MagneticFieldMapOptions& options)
+{
+    std::lock_guard<std::mutex> lock(mutex_fieldMaps);
+
+    const G4String key = filename + options.GetCacheSuffix();
+
+    std::shared_ptr<const MagneticFieldMapData> fieldMap = fieldMaps[key].lock();
+    if(fieldMap) return fieldMap;
+
+    std::shared_ptr<MagneticFieldMapData> newFieldMap(new MagneticFieldMapData());
+
+    const G4String cacheFile = GetCacheFileName(filename, options);
+    std::uint64_t sourceSize = 0;
+    std::int64_t sourceModificationTime = 0;
+    const G4bool haveSource = GetSourceStamp(filename, sourceSize, sourceModificationTime);
+
+    ////    Without the table itself, any valid cache of the same name is accepted
+    if(newFieldMap->MapCache(cacheFile, sourceSize, haveSource ? sourceModificationTime : -1))
+    {
+        G4cout << "MagneticFieldMapData: mapped " << newFieldMap->fNx << " x " << newFieldMap->fNy << " x "
+        << newFieldMap->fNz << " field map from " << cacheFile << G4endl;
+    }
+    else
+    {
+        newFieldMap.reset(new MagneticFieldMapData());
+
+        if(!haveSource || !newFieldMap->ReadTable(filename))
+        {
+            G4ExceptionDescription msg;
+            msg << "Cannot read the field map " << filename << G4endl;
+            G4Exception("MagneticFieldMapData::Load()", "MagneticFieldMapData0001", FatalException, msg);
+            return std::shared_ptr<const MagneticFieldMapData>();
+        }
+
+        if(options.IsFolded()) newFieldMap->Fold(options);
+        if(options.singlePrecision) newFieldMap->ConvertToSinglePrecision();
+        if(options.tileSize>0) newFieldMap->Tile(TileShift(options.tileSize));
+
+        ////    A read-only directory only costs the parse on the next start
+        if(newFieldMap->SaveCache(cacheFile, sourceSize, sourceModificationTime))
+        {
+            G4cout << "MagneticFieldMapData: wrote the binary cache " << cacheFile << G4endl;
+        }
+    }
+
+    G4cout << "MagneticFieldMapData: " << newFieldMap->GetMemorySize()/1024. << " kB of "
+    << (newFieldMap->fSinglePrecision ? "single" : "double") << " precision cells" << G4endl;
+
+    fieldMap = newFieldMap;
+    fieldMaps[key] = fieldMap;
+
+    return fieldMap;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool MagneticFieldMapData::WriteCache(const G4String& tableFile, const G4String& cacheFile, const MagneticFieldMapOptions& options)
+{
+    std::uint64_t sourceSize = 0;
+    std::int64_t sourceModificationTime = 0;
+
+    MagneticFieldMapData fieldMap;
+
+    if(!GetSourceStamp(tableFile, sourceSize, sourceModificationTime) || !fieldMap.ReadTable(tableFile)) return false;
+
+    if(options.IsFolded()) fieldMap.Fold(options);
+    if(options.singlePrecision) fieldMap.ConvertToSinglePrecision();
+    if(options.tileSize>0) fieldMap.Tile(TileShift(options.tileSize));
+
+    return fieldMap.SaveCache(cacheFile, sourceSize, sourceModificationTime);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool MagneticFieldMapData::ReadTable(const G4String& filename)
+{
+    ////    The text format of the Purging Magnet example (see MagneticFieldMapping)
+    double lenUnit= meter;
+    double fieldUnit= tesla;
+
+    G4cout << "\n ---> " "Reading the field grid from " << filename << " ... " << G4endl;
+    std::ifstream file(filename.c_str());
+    if(!file) return false;
+
+    // Ignore first blank line
+    char buffer[256];
+    file.getline(buffer,256);
+
+    // Read table dimensions
+    file >> fNx >> fNy >> fNz; // Note dodgy order
+    if(!file || fNx<1 || fNy<1 || fNz<1) return false;
+
+    G4cout << "  [ Number of values x,y,z: " << fNx << " " << fNy << " " << fNz << " ] " << G4endl;
+
+    // Set up storage space for table: one aligned block of interleaved cells
+    SetStrides();
+
+    double* cells = static_cast<double*>(AllocateCells(std::size_t(fNx)*fNy*fNz*kCellSize*sizeof(double)));
+    fCells = cells;
+    fSinglePrecision = false;
+
+    // Ignore other header information
+    // The first line whose second character is '0' is considered to
+    // be the last line of the header.
+    do {
+        file.getline(buffer,256);
+    } while(file && buffer[1]!='0');
+
+    // Read in the data
+    double xval=0.,yval=0.,zval=0.,bx,by,bz;
+    double permeability; // Not used
+    for(int ix=0; ix<fNx; ix++)
+    {
+        for(int iy=0; iy<fNy; iy++)
+        {
+            for(int iz=0; iz<fNz; iz++)
+            {
+                file >> xval >> yval >> zval >> bx >> by >> bz >> permeability;
+                if(ix==0 && iy==0 && iz==0)
+                {
+                    fMinX = xval * lenUnit;
+                    fMinY = yval * lenUnit;
+                    fMinZ = zval * lenUnit;
+                }
+                double* cell = cells + (std::size_t(ix)*fNy*fNz + std::size_t(iy)*fNz + iz)*kCellSize;
+                cell[0] = bx * fieldUnit;
+                cell[1] = by * fieldUnit;
+                cell[2] = bz * fieldUnit;
+            }
+        }
+    }
+
+    if(!file) return false;
+
+    fMaxX = xval * lenUnit;
+    fMaxY = yval * lenUnit;
+    fMaxZ = zval * lenUnit;
+
+    // Should really check that the limits are not the wrong way around.
+    if(fMaxX < fMinX) {std::swap(fMaxX,fMinX); fInvertX = true;}
+    if(fMaxY < fMinY) {std::swap(fMaxY,fMinY); fInvertY = true;}
+    if(fMaxZ < fMinZ) {std::swap(fMaxZ,fMinZ); fInvertZ = true;}
+
+    G4cout << " ---> ... done reading "
+    << "\n ---> Min values x,y,z: " << fMinX/cm << " " << fMinY/cm << " " << fMinZ/cm << " cm "
+    << "\n ---> Max values x,y,z: " << fMaxX/cm << " " << fMaxY/cm << " " << fMaxZ/cm << " cm " << G4endl;
+
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool MagneticFieldMapData::MapCache(const G4String& cacheFile, std::uint64_t sourceSize, std::int64_t sourceModificationTime)
+{
+    int fd = open(cacheFile.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat fileStatus;
+    if(fstat(fd, &fileStatus)!=0 || fileStatus.st_size < (off_t) sizeof(MagneticFieldMapCacheHeader))
+    {
+        close(fd);
+        return false;
+    }
+
+    fMappingSize = fileStatus.st_size;
+    void* mapping = mmap(0, fMappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(mapping==MAP_FAILED) return false;
+
+    fMapping = mapping;
+
+    //------------------------------------------------
+    //      Validate the header against this build and the source table
+    const MagneticFieldMapCacheHeader* header = static_cast<const MagneticFieldMapCacheHeader*>(fMapping);
+
+    G4bool valid = (std::memcmp(header->magic, kFieldMapCacheMagic, sizeof(kFieldMapCacheMagic))==0)
+    && (header->version==kVersion)
+    && (header->headerSize==sizeof(MagneticFieldMapCacheHeader))
+    && (header->cellSize==(std::uint32_t) kCellSize)
+    && (header->valueSize==sizeof(double) || header->valueSize==sizeof(float))
+    && (header->tileShift<=10)
+    && (header->nx>0) && (header->ny>0) && (header->nz>0);
+
+    if(valid && sourceModificationTime>=0)
+    {
+        valid = (header->sourceSize==sourceSize) && (header->sourceModificationTime==sourceModificationTime);
+    }
+
+    if(valid)
+    {
+        fNx = header->nx;
+        fNy = header->ny;
+        fNz = header->nz;
+        fSinglePrecision = (header->valueSize==sizeof(float));
+        fTileShift = (header->tileShift>0) ? int(header->tileShift) : int(kUntiled);
+        SetStrides();
+
+        valid = (sizeof(MagneticFieldMapCacheHeader) + GetMemorySize() <= fMappingSize);
+    }
+
+    if(!valid)
+    {
+        munmap(fMapping, fMappingSize);
+        fMapping = 0;
+        fMappingSize = 0;
+        return false;
+    }
+
+    ////    Tracks touch a few tiles at a time, read-ahead of the neighbouring file pages would mostly be wasted
+    if(IsTiled()) madvise(fMapping, fMappingSize, MADV_RANDOM);
+
+    fNy = header->ny;
+    fNz = header->nz;
+    fMinX = header->minx; fMaxX = header->maxx;
+    fMinY = header->miny; fMaxY = header->maxy;
+    fMinZ = header->minz; fMaxZ = header->maxz;
+    fInvertX = header->invertX!=0;
+    fInvertY = header->invertY!=0;
+    fInvertZ = header->invertZ!=0;
+
+    for(int a=0; a<3; a++)
+    {
+        fMirror[a] = header->mirror[a]!=0;
+        for(int k=0; k<3; k++) fParity[a][k] = (header->parity[a][k]<0) ? -1 : 1;
+    }
+
+    ////    The mapping is page aligned, and so is the first cell after the 128-byte header
+    fCells = static_cast<const char*>(fMapping) + sizeof(MagneticFieldMapCacheHeader);
+
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool MagneticFieldMapData::SaveCache(const G4String& cacheFile, std::uint64_t sourceSize, std::int64_t sourceModificationTime) const
+{
+    MagneticFieldMapCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kFieldMapCacheMagic, sizeof(kFieldMapCacheMagic));
+    header.version = kVersion;
+    header.headerSize = sizeof(MagneticFieldMapCacheHeader);
+    header.nx = fNx;
+    header.ny = fNy;
+    header.nz = fNz;
+    header.cellSize = kCellSize;
+    header.minx = fMinX; header.maxx = fMaxX;
+    header.miny = fMinY; header.maxy = fMaxY;
+    header.minz = fMinZ; header.maxz = fMaxZ;
+    header.invertX = fInvertX;
+    header.invertY = fInvertY;
+    header.invertZ = fInvertZ;
+    header.valueSize = fSinglePrecision ? sizeof(float) : sizeof(double);
+    header.tileShift = IsTiled() ? fTileShift : 0;
+    header.sourceSize = sourceSize;
+
+    for(int a=0; a<3; a++)
+    {
+        header.mirror[a] = fMirror[a];
+        for(int k=0; k<3; k++) header.parity[a][k] = fParity[a][k];
+    }
+    header.sourceModificationTime = sourceModificationTime;
+
+    ////    Written under a temporary name and renamed, so that concurrent jobs never see a partial cache
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".tmp%ld", (long) getpid());
+    const G4String temporaryFile = cacheFile + suffix;
+
+    std::FILE* file = std::fopen(temporaryFile.c_str(), "wb");
+    if(!file) return false;
+
+    const std::size_t nValues = GetMemorySize()/header.valueSize;
+
+    G4bool written = (std::fwrite(&header, sizeof(header), 1, file)==1)
+    && (std::fwrite(fCells, header.valueSize, nValues, file)==nValues);
+
+    written = (std::fclose(file)==0) && written;
+
+    if(!written || std::rename(temporaryFile.c_str(), cacheFile.c_str())!=0)
+    {
+        std::remove(temporaryFile.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MagneticFieldMapData::SetStrides()
+{
+    const int n[3] = {fNx, fNy, fNz};
+    long points[3];
+
+    ////    Points per tile and axis, including the plane shared with the next tile
+    for(int a=0; a<3; a++)
+    {
+        if(fTileShift==kUntiled || n[a]<2)
+        {
+            points[a] = n[a];
+            fNTiles[a] = 1;
+        }
+        else
+        {
+            points[a] = (1L<<fTileShift) + 1;
+            fNTiles[a] = ((n[a]-2)>>fTileShift) + 1;
+        }
+    }
+
+    fStrideZ = (points[2]>1) ? kCellSize : 0;
+    fStrideY = (points[1]>1) ? long(kCellSize)*points[2] : 0;
+    fStrideX = (points[0]>1) ? long(kCellSize)*points[2]*points[1] : 0;
+    fTileValues = long(kCellSize)*points[0]*points[1]*points[2];
+
+    //------------------------------------------------
+    //      Tiles in Morton order of their indices
+    const int nTiles = fNTiles[0]*fNTiles[1]*fNTiles[2];
+    std::vector<std::pair<std::uint64_t, int>> order(nTiles);
+
+    for(int tx=0; tx<fNTiles[0]; tx++)
+    {
+        for(int ty=0; ty<fNTiles[1]; ty++)
+        {
+            for(int tz=0; tz<fNTiles[2]; tz++)
+            {
+                const int tile = (tx*fNTiles[1] + ty)*fNTiles[2] + tz;
+                order[tile] = std::make_pair(MortonCode(tx, ty, tz), tile);
+            }
+        }
+    }
+
+    std::sort(order.begin(), order.end());
+
+    fTileOffsets.assign(nTiles, 0);
+    for(int slot=0; slot<nTiles; slot++) fTileOffsets[order[slot].second] = slot*fTileValues;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MagneticFieldMapData::Fold(const MagneticFieldMapOptions& options)
+{
+    const int n[3] = {fNx, fNy, fNz};
+    const long stride[3] = {fStrideX, fStrideY, fStrideZ};
+    double minimum[3] = {fMinX, fMinY, fMinZ};
+    double maximum[3] = {fMaxX, fMaxY, fMaxZ};
+    bool invert[3] = {fInvertX, fInvertY, fInvertZ};
+
+    ////    Per axis, the source index of every stored grid point and of its mirror image (or -1)
+    std::vector<int> sourceIndex[3], mirrorIndex[3];
+    int foldedN[3];
+
+    for(int a=0; a<3; a++)
+    {
+        foldedN[a] = n[a];
+
+        const double spacing = (n[a]>1) ? (maximum[a] - minimum[a])/(n[a]-1) : 0.;
+        G4bool folded = options.mirror[a] && spacing>0.;
+
+        ////    The plane must lie on a grid point, or halfway between two
+        double start = 0.;
+        if(folded)
+        {
+            const double t0 = -minimum[a]/spacing;
+            const double fraction = t0 - std::floor(t0);
+
+            if(fraction<kGridTolerance || fraction>1.-kGridTolerance) start = 0.;
+            else if(std::abs(fraction - 0.5)<kGridTolerance) start = -0.5*spacing;
+            else folded = false;
+        }
+
+        if(folded)
+        {
+            const double extent = std::max(maximum[a], -minimum[a]);
+            foldedN[a] = int(std::floor((extent - start)/spacing + 0.5)) + 1;
+
+            for(int j=0; j<foldedN[a] && folded; j++)
+            {
+                const double position = start + j*spacing;
+                int index[2];
+
+                for(int side=0; side<2; side++)
+                {
+                    const double c = side ? -position : position;
+                    const double t = invert[a] ? (maximum[a] - c)/spacing : (c - minimum[a])/spacing;
+                    const int i = int(std::floor(t + 0.5));
+                    index[side] = (i>=0 && i<n[a] && std::abs(t - i)<kGridTolerance) ? i : -1;
+                }
+
+                ////    The point on the plane is its own mirror image
+                if(index[1]==index[0]) index[1] = -1;
+                if(index[0]<0 && index[1]<0) folded = false;
+
+                sourceIndex[a].push_back(index[0]);
+                mirrorIndex[a].push_back(index[1]);
+            }
+
+            if(folded)
+            {
+                minimum[a] = start;
+                maximum[a] = start + (foldedN[a]-1)*spacing;
+                invert[a] = false;
+            }
+        }
+
+        if(options.mirror[a] && !folded)
+        {
+            G4ExceptionDescription msg;
+            msg << "The grid of the field map does not allow the mirror plane " << "xyz"[a]
+            << " = 0, the axis is kept unfolded" << G4endl;
+            G4Exception("MagneticFieldMapData::Fold()", "MagneticFieldMapData0002", JustWarning, msg);
+        }
+
+        if(!folded)
+        {
+            foldedN[a] = n[a];
+            sourceIndex[a].resize(n[a]);
+            mirrorIndex[a].assign(n[a], -1);
+            for(int i=0; i<n[a]; i++) sourceIndex[a][i] = i;
+        }
+
+        fMirror[a] = folded;
+        for(int k=0; k<3; k++) fParity[a][k] = folded ? options.parity[a][k] : 1;
+    }
+
+    //------------------------------------------------
+    //      Average every stored point over its (up to 8) mirror images
+    const std::vector<double> source(static_cast<const double*>(fCells),
+                                     static_cast<const double*>(fCells) + std::size_t(fNx)*fNy*fNz*kCellSize);
+
+    fNx = foldedN[0];
+    fNy = foldedN[1];
+    fNz = foldedN[2];
+    SetStrides();
+
+    double* cells = static_cast<double*>(AllocateCells(std::size_t(fNx)*fNy*fNz*kCellSize*sizeof(double)));
+    fCells = cells;
+
+    double largestField = 0., largestAsymmetry = 0.;
+    int j[3];
+
+    for(j[0]=0; j[0]<fNx; j[0]++)
+    {
+        for(j[1]=0; j[1]<fNy; j[1]++)
+        {
+            for(j[2]=0; j[2]<fNz; j[2]++)
+            {
+                double sum[3] = {0., 0., 0.}, first[3] = {0., 0., 0.};
+                int nImages = 0;
+
+                for(int image=0; image<8; image++)
+                {
+                    long offset = 0;
+                    double sign[3] = {1., 1., 1.};
+                    G4bool present = true;
+
+                    for(int a=0; a<3 && present; a++)
+                    {
+                        const G4bool mirrored = (image>>a) & 1;
+                        const int i = mirrored ? mirrorIndex[a][j[a]] : sourceIndex[a][j[a]];
+
+                        if(i<0) present = false;
+                        else
+                        {
+                            offset += i*stride[a];
+                            if(mirrored) for(int k=0; k<3; k++) sign[k] *= fParity[a][k];
+                        }
+                    }
+
+                    if(!present) continue;
+
+                    for(int k=0; k<3; k++)
+                    {
+                        const double value = sign[k]*source[offset + k];
+
+                        if(nImages==0) first[k] = value;
+                        largestField = std::max(largestField, std::abs(value));
+                        largestAsymmetry = std::max(largestAsymmetry, std::abs(value - first[k]));
+                        sum[k] += value;
+                    }
+                    nImages++;
+                }
+
+                double* cell = cells + j[0]*fStrideX + j[1]*fStrideY + j[2]*fStrideZ;
+                for(int k=0; k<3; k++) cell[k] = sum[k]/nImages;
+            }
+        }
+    }
+
+    fMinX = minimum[0]; fMaxX = maximum[0];
+    fMinY = minimum[1]; fMaxY = maximum[1];
+    fMinZ = minimum[2]; fMaxZ = maximum[2];
+    fInvertX = invert[0];
+    fInvertY = invert[1];
+    fInvertZ = invert[2];
+
+    G4cout << " ---> Folded to " << fNx << " x " << fNy << " x " << fNz << " stored points, "
+    << "largest deviation from the declared symmetry: "
+    << ((largestField>0.) ? 100.*largestAsymmetry/largestField : 0.) << " % of the largest |B_k|" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MagneticFieldMapData::ConvertToSinglePrecision()
+{
+    if(fSinglePrecision) return;
+
+    const std::size_t nValues = GetMemorySize()/sizeof(double);
+    const std::vector<double> source(static_cast<const double*>(fCells), static_cast<const double*>(fCells) + nValues);
+
+    float* cells = static_cast<float*>(AllocateCells(nValues*sizeof(float)));
+    for(std::size_t i=0; i<nValues; i++) cells[i] = float(source[i]);
+
+    fCells = cells;
+    fSinglePrecision = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void* MagneticFieldMapData::AllocateCells(std::size_t nBytes)
+{
+    fStorage.assign(nBytes + kAlignment, 0);
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(&fStorage[0]);
+    return reinterpret_cast<void*>((address + kAlignment - 1) & ~(kAlignment - 1));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::size_t MagneticFieldMapData::GetMemorySize() const
+{
+    return std::size_t(fTileValues)*fTileOffsets.size()*(fSinglePrecision ? sizeof(float) : sizeof(double));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MagneticFieldMapData::GetCellField(int ix, int iy, int iz, double* B) const
+{
+    const long offset = GetPointOffset(ix, iy, iz);
+
+    for(int k=0; k<3; k++)
+    {
+        B[k] = fSinglePrecision ? static_cast<const float*>(fCells)[offset + k] : static_cast<const double*>(fCells)[offset + k];
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MagneticFieldMapData::Tile(int tileShift)
+{
+    if(IsTiled()) return;
+
+    const std::size_t valueSize = fSinglePrecision ? sizeof(float) : sizeof(double);
+    const std::size_t cellBytes = kCellSize*valueSize;
+    const long sourceStride[3] = {fStrideX, fStrideY, fStrideZ};
+    const int n[3] = {fNx, fNy, fNz};
+
+    const std::vector<char> source(static_cast<const char*>(fCells), static_cast<const char*>(fCells) + GetMemorySize());
+
+    fTileShift = tileShift;
+    SetStrides();
+
+    char* cells = static_cast<char*>(AllocateCells(GetMemorySize()));
+    fCells = cells;
+
+    const long stride[3] = {fStrideX, fStrideY, fStrideZ};
+    int points[3];
+    for(int a=0; a<3; a++) points[a] = (n[a]>1) ? (1<<fTileShift) + 1 : 1;
+
+    int t[3], l[3];
+    for(t[0]=0; t[0]<fNTiles[0]; t[0]++)
+    {
+        for(t[1]=0; t[1]<fNTiles[1]; t[1]++)
+        {
+            for(t[2]=0; t[2]<fNTiles[2]; t[2]++)
+            {
+                const long tileOffset = fTileOffsets[(t[0]*fNTiles[1] + t[1])*fNTiles[2] + t[2]];
+
+                for(l[0]=0; l[0]<points[0]; l[0]++)
+                {
+                    for(l[1]=0; l[1]<points[1]; l[1]++)
+                    {
+                        for(l[2]=0; l[2]<points[2]; l[2]++)
+                        {
+                            long sourceOffset = 0, offset = tileOffset;
+                            G4bool inside = true;
+
+                            for(int a=0; a<3; a++)
+                            {
+                                const int i = (t[a]<<fTileShift) + l[a];
+                                inside = inside && (i<n[a]);
+                                sourceOffset += i*sourceStride[a];
+                                offset += l[a]*stride[a];
+                            }
+
+                            ////    Points past the end of the grid are never interpolated, and stay zero
+                            if(inside) std::memcpy(cells + offset*valueSize, &source[sourceOffset*valueSize], cellBytes);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+long MagneticFieldMapData::GetPointOffset(int ix, int iy, int iz) const
+{
+    const int index[3] = {ix, iy, iz};
+    const int n[3] = {fNx, fNy, fNz};
+    const long stride[3] = {fStrideX, fStrideY, fStrideZ};
+
+    ////    The last point plane belongs to the tile of the last cell
+    int tile[3];
+    long offset = 0;
+
+    for(int a=0; a<3; a++)
+    {
+        tile[a] = std::max(0, std::min(index[a], n[a]-2)) >> fTileShift;
+        offset += (index[a] - (long(tile[a])<<fTileShift))*stride[a];
+    }
+
+    return offset + fTileOffsets[(tile[0]*fNTiles[1] + tile[1])*fNTiles[2] + tile[2]];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -39,184 +39,258 @@
 #include "MagneticFieldMapping.hh"
 #include "G4SystemOfUnits.hh"
 
-MagneticFieldMapping::MagneticFieldMapping( const char* filename, double zOffset )
-  :fZoffset(zOffset),invertX(false),invertY(false),invertZ(false)
-{    
- 
-  double lenUnit= meter;
-  double fieldUnit= tesla;
-  G4cout << "\n-----------------------------------------------------------"
-	 << "\n      Magnetic field"
-	 << "\n-----------------------------------------------------------";
-    
-  G4cout << "\n ---> " "Reading the field grid from " << filename << " ... " << endl; 
-  ifstream file( filename ); // Open the file for reading.
-  
-  // Ignore first blank line
-  char buffer[256];
-  file.getline(buffer,256);
-  
-  // Read table dimensions 
-  file >> nx >> ny >> nz; // Note dodgy order
-
-  G4cout << "  [ Number of values x,y,z: " 
-	 << nx << " " << ny << " " << nz << " ] "
-	 << endl;
-
-  // Set up storage space for table
-  xField.resize( nx );
-  yField.resize( nx );
-  zField.resize( nx );
-  int ix, iy, iz;
-  for (ix=0; ix<nx; ix++) {
-    xField[ix].resize(ny);
-    yField[ix].resize(ny);
-    zField[ix].resize(ny);
-    for (iy=0; iy<ny; iy++) {
-      xField[ix][iy].resize(nz);
-      yField[ix][iy].resize(nz);
-      zField[ix][iy].resize(nz);
+#include <algorithm>
+
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+namespace {
+  // Index of the lower grid point along one axis and the position within the cell.
+  // Points on the upper edge fall into the last cell (local = 1).
+  inline int LowerIndex(double t, int n, double& local)
+  {
+    int i = static_cast<int>(t);
+    i = std::max(0, std::min(i, n-2));
+    local = t - i;
+    return i;
+  }
+
+  // Coefficients of the trilinear polynomial of the cell from its corners
+  // (000, 001, 010, 011, 100, 101, 110, 111), for all (Bx, By, Bz, pad)
+#ifdef __AVX__
+  inline __m256d LoadCell(const double* cell) { return _mm256_load_pd(cell); }
+  inline __m256d LoadCell(const float* cell)  { return _mm256_cvtps_pd(_mm_load_ps(cell)); }
+#endif
+
+  template <class T>
+  inline void CellCoefficients(const T* c000, const long offset[8],
+                               double a[8][MagneticFieldMapData::kCellSize])
+  {
+#ifdef __AVX__
+    __m256d c[8];
+    for (int i=0; i<8; i++) c[i] = LoadCell(c000 + offset[i]);
+    const __m256d dx = _mm256_sub_pd(c[4], c[0]);
+    const __m256d dxy = _mm256_sub_pd(c[6], c[2]);
+    const __m256d dxz = _mm256_sub_pd(c[5], c[1]);
+    const __m256d dxyz = _mm256_sub_pd(c[7], c[3]);
+    _mm256_storeu_pd(a[0], c[0]);
+    _mm256_storeu_pd(a[1], dx);
+    _mm256_storeu_pd(a[2], _mm256_sub_pd(c[2], c[0]));
+    _mm256_storeu_pd(a[3], _mm256_sub_pd(c[1], c[0]));
+    _mm256_storeu_pd(a[4], _mm256_sub_pd(dxy, dx));
+    _mm256_storeu_pd(a[5], _mm256_sub_pd(dxz, dx));
+    _mm256_storeu_pd(a[6], _mm256_sub_pd(_mm256_sub_pd(c[3], c[2]), _mm256_sub_pd(c[1], c[0])));
+    _mm256_storeu_pd(a[7], _mm256_sub_pd(_mm256_sub_pd(dxyz, dxz), _mm256_sub_pd(dxy, dx)));
+#else
+    for (int k=0; k<MagneticFieldMapData::kCellSize; k++) {
+      const double c000k = c000[offset[0]+k], c001 = c000[offset[1]+k], c010 = c000[offset[2]+k], c011 = c000[offset[3]+k];
+      const double c100 = c000[offset[4]+k], c101 = c000[offset[5]+k], c110 = c000[offset[6]+k], c111 = c000[offset[7]+k];
+      a[0][k] = c000k;
+      a[1][k] = c100 - c000k;
+      a[2][k] = c010 - c000k;
+      a[3][k] = c001 - c000k;
+      a[4][k] = (c110 - c010) - (c100 - c000k);
+      a[5][k] = (c101 - c001) - (c100 - c000k);
+      a[6][k] = (c011 - c010) - (c001 - c000k);
+      a[7][k] = ((c111 - c011) - (c101 - c001)) - ((c110 - c010) - (c100 - c000k));
     }
+#endif
   }
-  
-  // Ignore other header information    
-  // The first line whose second character is '0' is considered to
-  // be the last line of the header.
-  do {
-    file.getline(buffer,256);
-  } while ( buffer[1]!='0');
-  
-  // Read in the data
-  double xval,yval,zval,bx,by,bz;
-  double permeability; // Not used in this example.
-  for (ix=0; ix<nx; ix++) {
-    for (iy=0; iy<ny; iy++) {
-      for (iz=0; iz<nz; iz++) {
-        file >> xval >> yval >> zval >> bx >> by >> bz >> permeability;
-        if ( ix==0 && iy==0 && iz==0 ) {
-          minx = xval * lenUnit;
-          miny = yval * lenUnit;
-          minz = zval * lenUnit;
-        }
-        xField[ix][iy][iz] = bx * fieldUnit;
-        yField[ix][iy][iz] = by * fieldUnit;
-        zField[ix][iy][iz] = bz * fieldUnit;
-      }
+
+  // Value of the cached trilinear polynomial at (u, v, w) for all (Bx, By, Bz, pad):
+  // B = (a0 + w a_z) + v (a_y + w a_yz) + u [(a_x + w a_xz) + v (a_xy + w a_xyz)]
+#ifdef __AVX__
+  inline __m256d MultiplyAdd(__m256d a, __m256d b, __m256d c)
+  {
+#ifdef __FMA__
+    return _mm256_fmadd_pd(a, b, c);
+#else
+    return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+#endif
+  }
+#endif
+
+  inline void Blend(const double a[8][MagneticFieldMapData::kCellSize], double u, double v, double w,
+                    double result[MagneticFieldMapData::kCellSize])
+  {
+#ifdef __AVX__
+    const __m256d U = _mm256_set1_pd(u), V = _mm256_set1_pd(v), W = _mm256_set1_pd(w);
+    __m256d f0  = MultiplyAdd(W, _mm256_loadu_pd(a[3]), _mm256_loadu_pd(a[0]));
+    __m256d fy  = MultiplyAdd(W, _mm256_loadu_pd(a[6]), _mm256_loadu_pd(a[2]));
+    __m256d fx  = MultiplyAdd(W, _mm256_loadu_pd(a[5]), _mm256_loadu_pd(a[1]));
+    __m256d fxy = MultiplyAdd(W, _mm256_loadu_pd(a[7]), _mm256_loadu_pd(a[4]));
+    fx = MultiplyAdd(V, fxy, fx);
+    f0 = MultiplyAdd(V, fy, f0);
+    _mm256_storeu_pd(result, MultiplyAdd(U, fx, f0));
+#else
+    for (int k=0; k<MagneticFieldMapData::kCellSize; k++) {
+      result[k] = (a[0][k] + w*a[3][k]) + v*(a[2][k] + w*a[6][k])
+                + u*((a[1][k] + w*a[5][k]) + v*(a[4][k] + w*a[7][k]));
     }
+#endif
   }
-  file.close();
+}
 
-  maxx = xval * lenUnit;
-  maxy = yval * lenUnit;
-  maxz = zval * lenUnit;
+MagneticFieldMapping::MagneticFieldMapping( const char* filename, double zOffset,
+                                            const MagneticFieldMapOptions& options )
+  :fMap(MagneticFieldMapData::Load(filename, options)),fZoffset(zOffset)
+{    
+  G4cout << "\n-----------------------------------------------------------"
+	 << "\n      Magnetic field"
+	 << "\n-----------------------------------------------------------"
+	 << "\n ---> " "Field grid from " << filename << endl; 
+
+  SetupGrid();
+}
+
+MagneticFieldMapping::MagneticFieldMapping( std::shared_ptr<const MagneticFieldMapData> map, double zOffset )
+  :fMap(map),fZoffset(zOffset)
+{
+  SetupGrid();
+}
+
+void MagneticFieldMapping::SetupGrid()
+{
+  fCells = fMap->GetCells();
+  fSinglePrecisionCells = fMap->GetSinglePrecisionCells();
+  strideX = fMap->GetStrideX();
+  strideY = fMap->GetStrideY();
+  strideZ = fMap->GetStrideZ();
 
-  G4cout << "\n ---> ... done reading " << endl;
+  tileShift = fMap->GetTileShift();
+  nTilesY = fMap->GetNumberOfTiles(1);
+  nTilesZ = fMap->GetNumberOfTiles(2);
+  tileOffsets = fMap->GetTileOffsets();
 
-  // G4cout << " Read values of field from file " << filename << endl; 
-  G4cout << " ---> assumed the order:  x, y, z, Bx, By, Bz "
-	 << "\n ---> Min values x,y,z: " 
+  nx = fMap->GetNx();
+  ny = fMap->GetNy();
+  nz = fMap->GetNz();
+
+  minx = fMap->GetMinX(); maxx = fMap->GetMaxX();
+  miny = fMap->GetMinY(); maxy = fMap->GetMaxY();
+  minz = fMap->GetMinZ(); maxz = fMap->GetMaxZ();
+
+  invertX = fMap->GetInvertX();
+  invertY = fMap->GetInvertY();
+  invertZ = fMap->GetInvertZ();
+
+  mirrorX = fMap->GetMirror(0);
+  mirrorY = fMap->GetMirror(1);
+  mirrorZ = fMap->GetMirror(2);
+  for (int k=0; k<3; k++) {
+    parityX[k] = fMap->GetParity(0, k);
+    parityY[k] = fMap->GetParity(1, k);
+    parityZ[k] = fMap->GetParity(2, k);
+  }
+
+  double dx = maxx - minx;
+  double dy = maxy - miny;
+  double dz = maxz - minz;
+
+  // Precomputed inverse spacings replace the per-call division and modf
+  invSpacingX = (nx>1 && dx>0.) ? (nx-1)/dx : 0.;
+  invSpacingY = (ny>1 && dy>0.) ? (ny-1)/dy : 0.;
+  invSpacingZ = (nz>1 && dz>0.) ? (nz-1)/dz : 0.;
+
+  // No cell cached yet: grid positions are never negative
+  fCache.x0 = fCache.y0 = fCache.z0 = -2.;
+
+  G4cout << " ---> Min values x,y,z: " 
 	 << minx/cm << " " << miny/cm << " " << minz/cm << " cm "
 	 << "\n ---> Max values x,y,z: " 
 	 << maxx/cm << " " << maxy/cm << " " << maxz/cm << " cm "
-	 << "\n ---> The field will be offset by " << zOffset/cm << " cm " << endl;
-
-  // Should really check that the limits are not the wrong way around.
-  if (maxx < minx) {swap(maxx,minx); invertX = true;} 
-  if (maxy < miny) {swap(maxy,miny); invertY = true;} 
-  if (maxz < minz) {swap(maxz,minz); invertZ = true;} 
-  G4cout << "\nAfter reordering if neccesary"  
-	 << "\n ---> Min values x,y,z: " 
-	 << minx/cm << " " << miny/cm << " " << minz/cm << " cm "
-	 << " \n ---> Max values x,y,z: " 
-	 << maxx/cm << " " << maxy/cm << " " << maxz/cm << " cm ";
-
-  dx = maxx - minx;
-  dy = maxy - miny;
-  dz = maxz - minz;
-  G4cout << "\n ---> Dif values x,y,z (range): " 
-	 << dx/cm << " " << dy/cm << " " << dz/cm << " cm in z "
+	 << "\n ---> The field will be offset by " << fZoffset/cm << " cm "
+	 << "\n ---> Mirror planes x,y,z: " << mirrorX << " " << mirrorY << " " << mirrorZ
+	 << ", " << (fSinglePrecisionCells ? "single" : "double") << " precision"
+	 << (fMap->IsTiled() ? ", tiled" : "")
 	 << "\n-----------------------------------------------------------" << endl;
 }
 
-void MagneticFieldMapping::GetFieldValue(const double point[4],
-				      double *Bfield ) const
+bool MagneticFieldMapping::ToGrid(const double point[4], double& xt, double& yt, double& zt,
+                                  double sign[3], double derivativeSign[3]) const
 {
-
   double x = point[0];
   double y = point[1];
   double z = point[2] + fZoffset;
 
+  // Reflect onto the stored half of a folded map
+  for (int k=0; k<3; k++) { sign[k] = 1.; derivativeSign[k] = 1.; }
+  if (mirrorX && x<0.) { x = -x; for (int k=0; k<3; k++) sign[k] *= parityX[k]; derivativeSign[0] = -1.; }
+  if (mirrorY && y<0.) { y = -y; for (int k=0; k<3; k++) sign[k] *= parityY[k]; derivativeSign[1] = -1.; }
+  if (mirrorZ && z<0.) { z = -z; for (int k=0; k<3; k++) sign[k] *= parityZ[k]; derivativeSign[2] = -1.; }
+
   // Check that the point is within the defined region 
-  if ( x>=minx && x<=maxx &&
-       y>=miny && y<=maxy && 
-       z>=minz && z<=maxz ) {
-    
-    // Position of given point within region, normalized to the range
-    // [0,1]
-    double xfraction = (x - minx) / dx;
-    double yfraction = (y - miny) / dy; 
-    double zfraction = (z - minz) / dz;
-
-    if (invertX) { xfraction = 1 - xfraction;}
-    if (invertY) { yfraction = 1 - yfraction;}
-    if (invertZ) { zfraction = 1 - zfraction;}
-
-    // Need addresses of these to pass to modf below.
-    // modf uses its second argument as an OUTPUT argument.
-    double xdindex, ydindex, zdindex;
-    
-    // Position of the point within the cuboid defined by the
-    // nearest surrounding tabulated points
-    double xlocal = ( std::modf(xfraction*(nx-1), &xdindex));
-    double ylocal = ( std::modf(yfraction*(ny-1), &ydindex));
-    double zlocal = ( std::modf(zfraction*(nz-1), &zdindex));
-    
-    // The indices of the nearest tabulated point whose coordinates
-    // are all less than those of the given point
-    int xindex = static_cast<int>(xdindex);
-    int yindex = static_cast<int>(ydindex);
-    int zindex = static_cast<int>(zdindex);
-    
-
-#ifdef DEBUG_INTERPOLATING_FIELD
-    G4cout << "Local x,y,z: " << xlocal << " " << ylocal << " " << zlocal << endl;
-    G4cout << "Index x,y,z: " << xindex << " " << yindex << " " << zindex << endl;
-    double valx0z0, mulx0z0, valx1z0, mulx1z0;
-    double valx0z1, mulx0z1, valx1z1, mulx1z1;
-    valx0z0= table[xindex  ][0][zindex];  mulx0z0=  (1-xlocal) * (1-zlocal);
-    valx1z0= table[xindex+1][0][zindex];  mulx1z0=   xlocal    * (1-zlocal);
-    valx0z1= table[xindex  ][0][zindex+1]; mulx0z1= (1-xlocal) * zlocal;
-    valx1z1= table[xindex+1][0][zindex+1]; mulx1z1=  xlocal    * zlocal;
-#endif
+  if ( !(x>=minx && x<=maxx &&
+         y>=miny && y<=maxy &&
+         z>=minz && z<=maxz) ) return false;
 
-        // Full 3-dimensional version
-    Bfield[0] =
-      xField[xindex  ][yindex  ][zindex  ] * (1-xlocal) * (1-ylocal) * (1-zlocal) +
-      xField[xindex  ][yindex  ][zindex+1] * (1-xlocal) * (1-ylocal) *    zlocal  +
-      xField[xindex  ][yindex+1][zindex  ] * (1-xlocal) *    ylocal  * (1-zlocal) +
-      xField[xindex  ][yindex+1][zindex+1] * (1-xlocal) *    ylocal  *    zlocal  +
-      xField[xindex+1][yindex  ][zindex  ] *    xlocal  * (1-ylocal) * (1-zlocal) +
-      xField[xindex+1][yindex  ][zindex+1] *    xlocal  * (1-ylocal) *    zlocal  +
-      xField[xindex+1][yindex+1][zindex  ] *    xlocal  *    ylocal  * (1-zlocal) +
-      xField[xindex+1][yindex+1][zindex+1] *    xlocal  *    ylocal  *    zlocal ;
-    Bfield[1] =
-      yField[xindex  ][yindex  ][zindex  ] * (1-xlocal) * (1-ylocal) * (1-zlocal) +
-      yField[xindex  ][yindex  ][zindex+1] * (1-xlocal) * (1-ylocal) *    zlocal  +
-      yField[xindex  ][yindex+1][zindex  ] * (1-xlocal) *    ylocal  * (1-zlocal) +
-      yField[xindex  ][yindex+1][zindex+1] * (1-xlocal) *    ylocal  *    zlocal  +
-      yField[xindex+1][yindex  ][zindex  ] *    xlocal  * (1-ylocal) * (1-zlocal) +
-      yField[xindex+1][yindex  ][zindex+1] *    xlocal  * (1-ylocal) *    zlocal  +
-      yField[xindex+1][yindex+1][zindex  ] *    xlocal  *    ylocal  * (1-zlocal) +
-      yField[xindex+1][yindex+1][zindex+1] *    xlocal  *    ylocal  *    zlocal ;
-    Bfield[2] =
-      zField[xindex  ][yindex  ][zindex  ] * (1-xlocal) * (1-ylocal) * (1-zlocal) +
-      zField[xindex  ][yindex  ][zindex+1] * (1-xlocal) * (1-ylocal) *    zlocal  +
-      zField[xindex  ][yindex+1][zindex  ] * (1-xlocal) *    ylocal  * (1-zlocal) +
-      zField[xindex  ][yindex+1][zindex+1] * (1-xlocal) *    ylocal  *    zlocal  +
-      zField[xindex+1][yindex  ][zindex  ] *    xlocal  * (1-ylocal) * (1-zlocal) +
-      zField[xindex+1][yindex  ][zindex+1] *    xlocal  * (1-ylocal) *    zlocal  +
-      zField[xindex+1][yindex+1][zindex  ] *    xlocal  *    ylocal  * (1-zlocal) +
-      zField[xindex+1][yindex+1][zindex+1] *    xlocal  *    ylocal  *    zlocal ;
+  // Position of given point in units of the grid spacing
+  xt = (x - minx) * invSpacingX;
+  yt = (y - miny) * invSpacingY;
+  zt = (z - minz) * invSpacingZ;
+
+  if (invertX) { xt = (nx-1) - xt; derivativeSign[0] = -derivativeSign[0]; }
+  if (invertY) { yt = (ny-1) - yt; derivativeSign[1] = -derivativeSign[1]; }
+  if (invertZ) { zt = (nz-1) - zt; derivativeSign[2] = -derivativeSign[2]; }
+
+  return true;
+}
+
+void MagneticFieldMapping::LocateCell(double xt, double yt, double zt,
+                                      double& u, double& v, double& w) const
+{
+  u = xt - fCache.x0;
+  v = yt - fCache.y0;
+  w = zt - fCache.z0;
+  if (u>=0. && u<=1. && v>=0. && v<=1. && w>=0. && w<=1.) return;
+
+  // The indices of the nearest tabulated point whose coordinates
+  // are all less than those of the given point, and the position of
+  // the point within the cuboid defined by the surrounding points
+  int xindex = LowerIndex(xt, nx, u);
+  int yindex = LowerIndex(yt, ny, v);
+  int zindex = LowerIndex(zt, nz, w);
+
+  // The tile of the cell, and the cell within the tile
+  const int xtile = xindex >> tileShift;
+  const int ytile = yindex >> tileShift;
+  const int ztile = zindex >> tileShift;
+
+  const long base = tileOffsets[(xtile*nTilesY + ytile)*nTilesZ + ztile]
+                  + (xindex - (xtile << tileShift))*strideX
+                  + (yindex - (ytile << tileShift))*strideY
+                  + (zindex - (ztile << tileShift))*strideZ;
+
+  const long offset[8] = { 0,                 strideZ,
+                           strideY,           strideY+strideZ,
+                           strideX,           strideX+strideZ,
+                           strideX+strideY,   strideX+strideY+strideZ };
+
+  if (fSinglePrecisionCells) CellCoefficients(fSinglePrecisionCells + base, offset, fCache.coefficients);
+  else                       CellCoefficients(fCells + base, offset, fCache.coefficients);
+
+  fCache.x0 = xindex;
+  fCache.y0 = yindex;
+  fCache.z0 = zindex;
+}
+
+void MagneticFieldMapping::GetFieldValue(const double point[4],
+				      double *Bfield ) const
+{
+  double xt, yt, zt, sign[3], derivativeSign[3];
+
+  if ( ToGrid(point, xt, yt, zt, sign, derivativeSign) ) {
+
+    double u, v, w;
+    LocateCell(xt, yt, zt, u, v, w);
+
+    double result[MagneticFieldMapData::kCellSize];
+    Blend(fCache.coefficients, u, v, w, result);
+
+    Bfield[0] = result[0] * sign[0];
+    Bfield[1] = result[1] * sign[1];
+    Bfield[2] = result[2] * sign[2];
 
   } else {
     Bfield[0] = 0.0;
@@ -225,3 +299,38 @@ void MagneticFieldMapping::GetFieldValue(const double point[4],
   }
 }
 
+void MagneticFieldMapping::GetFieldValueAndGradient(const double point[4],
+                                                    double *Bfield, double *gradient ) const
+{
+  double xt, yt, zt, sign[3], derivativeSign[3];
+
+  if ( ToGrid(point, xt, yt, zt, sign, derivativeSign) ) {
+
+    double u, v, w;
+    LocateCell(xt, yt, zt, u, v, w);
+
+    double result[MagneticFieldMapData::kCellSize];
+    const double (*a)[MagneticFieldMapData::kCellSize] = fCache.coefficients;
+    Blend(a, u, v, w, result);
+
+    // d(grid position)/dx_j, including the reflections
+    const double scale[3] = { derivativeSign[0]*invSpacingX,
+                              derivativeSign[1]*invSpacingY,
+                              derivativeSign[2]*invSpacingZ };
+
+    for (int i=0; i<3; i++) {
+      Bfield[i] = result[i] * sign[i];
+
+      const double dBdu = a[1][i] + v*a[4][i] + w*(a[5][i] + v*a[7][i]);
+      const double dBdv = a[2][i] + u*a[4][i] + w*(a[6][i] + u*a[7][i]);
+      const double dBdw = a[3][i] + u*a[5][i] + v*(a[6][i] + u*a[7][i]);
+      gradient[3*i  ] = sign[i] * scale[0] * dBdu;
+      gradient[3*i+1] = sign[i] * scale[1] * dBdv;
+      gradient[3*i+2] = sign[i] * scale[2] * dBdw;
+    }
+
+  } else {
+    for (int i=0; i<3; i++) Bfield[i] = 0.0;
+    for (int i=0; i<9; i++) gradient[i] = 0.0;
+  }
+}
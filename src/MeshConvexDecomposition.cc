@@ -0,0 +1,829 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "MeshConvexDecomposition.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <unordered_map>
+
+namespace {
+
+    struct Vector3
+    {
+        double x, y, z;
+        Vector3() : x(0.), y(0.), z(0.) {}
+        Vector3(double a, double b, double c) : x(a), y(b), z(c) {}
+        Vector3 operator+(const Vector3& o) const  { return Vector3(x+o.x, y+o.y, z+o.z); }
+        Vector3 operator-(const Vector3& o) const  { return Vector3(x-o.x, y-o.y, z-o.z); }
+        Vector3 operator*(double s) const          { return Vector3(x*s, y*s, z*s); }
+        double  Dot(const Vector3& o) const        { return x*o.x + y*o.y + z*o.z; }
+        Vector3 Cross(const Vector3& o) const      { return Vector3(y*o.z - z*o.y, z*o.x - x*o.z, x*o.y - y*o.x); }
+        double  Mag2() const                       { return Dot(*this); }
+        double  Component(int axis) const          { return axis==0 ? x : (axis==1 ? y : z); }
+    };
+
+    Vector3 GetVertex(const TriangleMesh& mesh, std::uint32_t i)
+    {
+        return Vector3(mesh.vertices[3*i], mesh.vertices[3*i + 1], mesh.vertices[3*i + 2]);
+    }
+
+    std::uint64_t EdgeKey(std::uint32_t a, std::uint32_t b)
+    {
+        return (std::uint64_t(a)<<32) | b;
+    }
+
+    //------------------------------------------------------------------
+    //      Quickhull
+
+    struct HullFace
+    {
+        std::uint32_t               v[3];
+        Vector3                     normal;
+        double                      offset;
+        std::vector<std::uint32_t>  outside;    // points beyond the face, by more than the tolerance
+        bool                        alive;
+    };
+
+    class HullBuilder
+    {
+    public:
+        ////    Points flagged exact are kept even within the tolerance
+        HullBuilder(const std::vector<Vector3>& points, double tolerance, const std::vector<bool>* exact = 0)
+        : fPoints(points),
+        fTolerance(tolerance),
+        fEpsilon(0.),
+        fExact(exact)
+        {}
+
+        bool            Build();
+        TriangleMesh    GetMesh() const;
+
+    private:
+        double Distance(const HullFace& face, std::uint32_t p) const   { return face.normal.Dot(fPoints[p]) - face.offset; }
+
+        std::uint32_t AddFace(std::uint32_t a, std::uint32_t b, std::uint32_t c)
+        {
+            HullFace face;
+            face.v[0] = a;
+            face.v[1] = b;
+            face.v[2] = c;
+            face.normal = (fPoints[b] - fPoints[a]).Cross(fPoints[c] - fPoints[a]);
+            const double length = std::sqrt(face.normal.Mag2());
+            if(length>0.) face.normal = face.normal*(1./length);
+            face.offset = face.normal.Dot(fPoints[a]);
+            face.alive = true;
+
+            const std::uint32_t id = fFaces.size();
+            fFaces.push_back(face);
+            for(int j=0; j<3; j++) fEdgeFace[EdgeKey(face.v[j], face.v[(j+1)%3])] = id;
+            return id;
+        }
+
+        ////    Each point goes to the first face it is beyond; points within the tolerance of all faces are dropped
+        void AssignPoints(const std::vector<std::uint32_t>& points, std::uint32_t firstFace)
+        {
+            for(std::size_t i=0; i<points.size(); i++)
+            {
+                const double tolerance = (fExact && (*fExact)[points[i]]) ? fEpsilon : fTolerance;
+                for(std::uint32_t f=firstFace; f<fFaces.size(); f++)
+                {
+                    if(fFaces[f].alive && Distance(fFaces[f], points[i]) > tolerance)
+                    {
+                        fFaces[f].outside.push_back(points[i]);
+                        break;
+                    }
+                }
+            }
+        }
+
+        const std::vector<Vector3>&                         fPoints;
+        double                                              fTolerance;
+        double                                              fEpsilon;
+        const std::vector<bool>*                            fExact;
+        std::vector<HullFace>                               fFaces;
+        std::unordered_map<std::uint64_t, std::uint32_t>    fEdgeFace;
+    };
+
+    bool HullBuilder::Build()
+    {
+        const std::uint32_t n = fPoints.size();
+        if(n<4) return false;
+
+        //------------------------------------------------
+        //      Initial tetrahedron from the extreme points
+        std::uint32_t extreme[6] = {0, 0, 0, 0, 0, 0};
+        for(std::uint32_t i=1; i<n; i++)
+        {
+            for(int axis=0; axis<3; axis++)
+            {
+                if(fPoints[i].Component(axis) < fPoints[extreme[2*axis]].Component(axis)) extreme[2*axis] = i;
+                if(fPoints[i].Component(axis) > fPoints[extreme[2*axis + 1]].Component(axis)) extreme[2*axis + 1] = i;
+            }
+        }
+
+        std::uint32_t a = 0, b = 0;
+        double maxDistance2 = -1.;
+        for(int i=0; i<6; i++)
+        {
+            for(int j=i+1; j<6; j++)
+            {
+                const double distance2 = (fPoints[extreme[i]] - fPoints[extreme[j]]).Mag2();
+                if(distance2 > maxDistance2) { maxDistance2 = distance2; a = extreme[i]; b = extreme[j]; }
+            }
+        }
+
+        const double scale = std::sqrt(maxDistance2);
+        fEpsilon = 1e-10*scale;
+        if(!(scale > 0.)) return false;
+
+        const Vector3 axis = (fPoints[b] - fPoints[a])*(1./scale);
+        std::uint32_t c = a;
+        maxDistance2 = 0.;
+        for(std::uint32_t i=0; i<n; i++)
+        {
+            const double distance2 = (fPoints[i] - fPoints[a]).Cross(axis).Mag2();
+            if(distance2 > maxDistance2) { maxDistance2 = distance2; c = i; }
+        }
+        if(maxDistance2 <= (1e-9*scale)*(1e-9*scale)) return false;
+
+        Vector3 normal = (fPoints[b] - fPoints[a]).Cross(fPoints[c] - fPoints[a]);
+        normal = normal*(1./std::sqrt(normal.Mag2()));
+        std::uint32_t d = a;
+        double maxDistance = 0.;
+        for(std::uint32_t i=0; i<n; i++)
+        {
+            const double distance = std::abs(normal.Dot(fPoints[i] - fPoints[a]));
+            if(distance > maxDistance) { maxDistance = distance; d = i; }
+        }
+        if(maxDistance <= 1e-9*scale) return false;
+
+        if(normal.Dot(fPoints[d] - fPoints[a]) > 0.) std::swap(b, c);
+        AddFace(a, b, c);
+        AddFace(a, d, b);
+        AddFace(b, d, c);
+        AddFace(c, d, a);
+
+        std::vector<std::uint32_t> points;
+        points.reserve(n);
+        for(std::uint32_t i=0; i<n; i++) if(i!=a && i!=b && i!=c && i!=d) points.push_back(i);
+        AssignPoints(points, 0);
+
+        //------------------------------------------------
+        //      Add the farthest outside point of each face until none is left
+        std::vector<std::uint32_t> mark;
+        std::vector<std::uint32_t> visible, stack, orphans;
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> horizon;
+        std::uint32_t stamp = 0;
+
+        for(std::uint32_t f=0; f<fFaces.size(); f++)
+        {
+            if(!fFaces[f].alive || fFaces[f].outside.empty()) continue;
+
+            std::uint32_t p = fFaces[f].outside[0];
+            double farthest = Distance(fFaces[f], p);
+            for(std::size_t i=1; i<fFaces[f].outside.size(); i++)
+            {
+                const double distance = Distance(fFaces[f], fFaces[f].outside[i]);
+                if(distance > farthest) { farthest = distance; p = fFaces[f].outside[i]; }
+            }
+
+            ////    Faces seen from p, connected to f, and the edges of their horizon
+            mark.resize(fFaces.size(), 0);
+            stamp += 2;
+            const std::uint32_t isVisible = stamp, isHidden = stamp + 1;
+
+            visible.clear();
+            horizon.clear();
+            stack.assign(1, f);
+            mark[f] = isVisible;
+            while(!stack.empty())
+            {
+                const std::uint32_t g = stack.back();
+                stack.pop_back();
+                visible.push_back(g);
+
+                for(int j=0; j<3; j++)
+                {
+                    const std::uint32_t u = fFaces[g].v[j], v = fFaces[g].v[(j+1)%3];
+                    const std::uint32_t h = fEdgeFace[EdgeKey(v, u)];
+
+                    if(mark[h]!=isVisible && mark[h]!=isHidden)
+                    {
+                        if(Distance(fFaces[h], p) > fEpsilon)
+                        {
+                            mark[h] = isVisible;
+                            stack.push_back(h);
+                            continue;
+                        }
+                        mark[h] = isHidden;
+                    }
+                    if(mark[h]==isHidden) horizon.push_back(std::make_pair(u, v));
+                }
+            }
+
+            orphans.clear();
+            for(std::size_t i=0; i<visible.size(); i++)
+            {
+                HullFace& face = fFaces[visible[i]];
+                for(std::size_t k=0; k<face.outside.size(); k++) if(face.outside[k]!=p) orphans.push_back(face.outside[k]);
+                std::vector<std::uint32_t>().swap(face.outside);
+                face.alive = false;
+                for(int j=0; j<3; j++) fEdgeFace.erase(EdgeKey(face.v[j], face.v[(j+1)%3]));
+            }
+
+            const std::uint32_t firstNew = fFaces.size();
+            for(std::size_t i=0; i<horizon.size(); i++) AddFace(horizon[i].first, horizon[i].second, p);
+            AssignPoints(orphans, firstNew);
+        }
+
+        return true;
+    }
+
+    TriangleMesh HullBuilder::GetMesh() const
+    {
+        TriangleMesh mesh;
+        std::unordered_map<std::uint32_t, std::uint32_t> index;
+        for(std::size_t f=0; f<fFaces.size(); f++)
+        {
+            if(!fFaces[f].alive) continue;
+            for(int j=0; j<3; j++)
+            {
+                const std::uint32_t v = fFaces[f].v[j];
+                std::unordered_map<std::uint32_t, std::uint32_t>::const_iterator found = index.find(v);
+                if(found==index.end())
+                {
+                    found = index.insert(std::make_pair(v, std::uint32_t(mesh.vertices.size()/3))).first;
+                    mesh.vertices.push_back(fPoints[v].x);
+                    mesh.vertices.push_back(fPoints[v].y);
+                    mesh.vertices.push_back(fPoints[v].z);
+                }
+                mesh.triangles.push_back(found->second);
+            }
+        }
+        return mesh;
+    }
+
+    //------------------------------------------------------------------
+    //      Plane cuts
+
+    ////    The facets of surface below (k = 0) and above (k = 1) the plane x[axis] = offset,
+    ////    clipped. New vertices are keyed by the cut edge, so that neighbouring facets share them.
+    void Split(const TriangleMesh& surface, int axis, double offset, double epsilon, TriangleMesh parts[2])
+    {
+        const std::size_t nVertices = surface.GetNumberOfVertices();
+        std::vector<double> side(nVertices);
+        for(std::size_t i=0; i<nVertices; i++)
+        {
+            side[i] = surface.vertices[3*i + axis] - offset;
+            if(std::abs(side[i]) <= epsilon) side[i] = 0.;
+        }
+
+        std::unordered_map<std::uint64_t, std::uint32_t> index[2];
+        auto Vertex = [&](int k, std::uint64_t key, const Vector3& p)
+        {
+            std::unordered_map<std::uint64_t, std::uint32_t>::const_iterator found = index[k].find(key);
+            if(found!=index[k].end()) return found->second;
+
+            const std::uint32_t i = parts[k].vertices.size()/3;
+            index[k][key] = i;
+            parts[k].vertices.push_back(p.x);
+            parts[k].vertices.push_back(p.y);
+            parts[k].vertices.push_back(p.z);
+            return i;
+        };
+
+        for(std::size_t t=0; t<surface.GetNumberOfTriangles(); t++)
+        {
+            const std::uint32_t* v = &surface.triangles[3*t];
+            const double s[3] = {side[v[0]], side[v[1]], side[v[2]]};
+            const bool hasBelow = (s[0]<0. || s[1]<0. || s[2]<0.);
+            const bool hasAbove = (s[0]>0. || s[1]>0. || s[2]>0.);
+
+            for(int k=0; k<2; k++)
+            {
+                const double sign = (k==0) ? -1. : 1.;
+                if(k==0 && !hasBelow && hasAbove) continue;
+                if(k==1 && !hasAbove && hasBelow) continue;
+
+                ////    Facets in the plane belong to the side they face away from
+                if(!hasBelow && !hasAbove)
+                {
+                    const Vector3 p0 = GetVertex(surface, v[0]);
+                    const double facing = (GetVertex(surface, v[1]) - p0).Cross(GetVertex(surface, v[2]) - p0).Component(axis);
+                    if((facing > 0.)!=(k==0)) continue;
+                }
+
+                std::uint32_t polygon[4];
+                int m = 0;
+                for(int j=0; j<3; j++)
+                {
+                    const std::uint32_t a = v[j], b = v[(j+1)%3];
+                    const double sa = s[j], sb = s[(j+1)%3];
+                    if(sa*sign >= 0.) polygon[m++] = Vertex(k, EdgeKey(a, a), GetVertex(surface, a));
+                    if(sa*sb < 0.)
+                    {
+                        const std::uint32_t lo = std::min(a, b), hi = std::max(a, b);
+                        const Vector3 plo = GetVertex(surface, lo);
+                        const Vector3 p = plo + (GetVertex(surface, hi) - plo)*(side[lo]/(side[lo] - side[hi]));
+                        polygon[m++] = Vertex(k, EdgeKey(lo, hi), p);
+                    }
+                }
+
+                for(int j=1; j+1<m; j++)
+                {
+                    parts[k].triangles.push_back(polygon[0]);
+                    parts[k].triangles.push_back(polygon[j]);
+                    parts[k].triangles.push_back(polygon[j+1]);
+                }
+            }
+        }
+    }
+
+    //------------------------------------------------------------------
+    //      Inside test of a closed mesh: parity of the crossings of a ray along +x,
+    //      with the facets binned in y and z
+
+    class MeshInsideTest
+    {
+    public:
+        MeshInsideTest(const TriangleMesh& mesh) : fMesh(mesh)
+        {
+            fLower[0] = fLower[1] = std::numeric_limits<double>::max();
+            double upper[2] = {-fLower[0], -fLower[1]};
+            for(std::size_t i=0; i<mesh.GetNumberOfVertices(); i++)
+            {
+                for(int k=0; k<2; k++)
+                {
+                    fLower[k] = std::min(fLower[k], mesh.vertices[3*i + 1 + k]);
+                    upper[k] = std::max(upper[k], mesh.vertices[3*i + 1 + k]);
+                }
+            }
+
+            fN = std::max(1, std::min(1024, int(std::sqrt(mesh.GetNumberOfTriangles()/4.))));
+            for(int k=0; k<2; k++) fCellSize[k] = std::max(upper[k] - fLower[k], 1e-9)/fN;
+            fCells.resize(fN*fN);
+
+            for(std::size_t t=0; t<mesh.GetNumberOfTriangles(); t++)
+            {
+                int lower[2] = {fN, fN}, higher[2] = {-1, -1};
+                for(int j=0; j<3; j++)
+                {
+                    const std::uint32_t v = mesh.triangles[3*t + j];
+                    for(int k=0; k<2; k++)
+                    {
+                        const int cell = Cell(mesh.vertices[3*v + 1 + k], k);
+                        lower[k] = std::min(lower[k], cell);
+                        higher[k] = std::max(higher[k], cell);
+                    }
+                }
+                for(int i=lower[0]; i<=higher[0]; i++)
+                    for(int j=lower[1]; j<=higher[1]; j++) fCells[i*fN + j].push_back(t);
+            }
+        }
+
+        bool Inside(const Vector3& p) const
+        {
+            if(p.y < fLower[0] || p.z < fLower[1] || p.y > fLower[0] + fN*fCellSize[0] || p.z > fLower[1] + fN*fCellSize[1]) return false;
+
+            const std::vector<std::uint32_t>& cell = fCells[Cell(p.y, 0)*fN + Cell(p.z, 1)];
+            int nCrossings = 0;
+            for(std::size_t n=0; n<cell.size(); n++)
+            {
+                const std::uint32_t* v = &fMesh.triangles[3*cell[n]];
+                const Vector3 a = GetVertex(fMesh, v[0]), b = GetVertex(fMesh, v[1]), c = GetVertex(fMesh, v[2]);
+
+                const double w0 = (b.y - p.y)*(c.z - p.z) - (b.z - p.z)*(c.y - p.y);
+                const double w1 = (c.y - p.y)*(a.z - p.z) - (c.z - p.z)*(a.y - p.y);
+                const double w2 = (a.y - p.y)*(b.z - p.z) - (a.z - p.z)*(b.y - p.y);
+                if(!((w0>=0. && w1>=0. && w2>=0.) || (w0<=0. && w1<=0. && w2<=0.))) continue;
+
+                const double sum = w0 + w1 + w2;
+                if(sum==0.) continue;
+                if((w0*a.x + w1*b.x + w2*c.x)/sum > p.x) nCrossings++;
+            }
+            return (nCrossings%2)==1;
+        }
+
+    private:
+        int Cell(double value, int k) const
+        {
+            return std::max(0, std::min(fN-1, int((value - fLower[k])/fCellSize[k])));
+        }
+
+        const TriangleMesh&                         fMesh;
+        double                                      fLower[2];
+        double                                      fCellSize[2];
+        int                                         fN;
+        std::vector<std::vector<std::uint32_t>>     fCells;
+    };
+
+    ////    A convex piece as its face planes and bounding box
+    struct ConvexPiece
+    {
+        std::vector<Vector3>    normals;
+        std::vector<double>     offsets;
+        Vector3                 lower, upper;
+
+        ConvexPiece(const TriangleMesh& hull)
+        : lower(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max()),
+        upper(-lower.x, -lower.y, -lower.z)
+        {
+            for(std::size_t i=0; i<hull.GetNumberOfVertices(); i++)
+            {
+                const Vector3 p = GetVertex(hull, i);
+                lower = Vector3(std::min(lower.x, p.x), std::min(lower.y, p.y), std::min(lower.z, p.z));
+                upper = Vector3(std::max(upper.x, p.x), std::max(upper.y, p.y), std::max(upper.z, p.z));
+            }
+            for(std::size_t t=0; t<hull.GetNumberOfTriangles(); t++)
+            {
+                const Vector3 p0 = GetVertex(hull, hull.triangles[3*t]);
+                Vector3 normal = (GetVertex(hull, hull.triangles[3*t + 1]) - p0).Cross(GetVertex(hull, hull.triangles[3*t + 2]) - p0);
+                const double length = std::sqrt(normal.Mag2());
+                if(length==0.) continue;
+                normal = normal*(1./length);
+                normals.push_back(normal);
+                offsets.push_back(normal.Dot(p0));
+            }
+        }
+
+        bool Inside(const Vector3& p) const
+        {
+            if(p.x < lower.x || p.y < lower.y || p.z < lower.z || p.x > upper.x || p.y > upper.y || p.z > upper.z) return false;
+            for(std::size_t f=0; f<normals.size(); f++) if(normals[f].Dot(p) > offsets[f]) return false;
+            return true;
+        }
+    };
+
+    //------------------------------------------------------------------
+    //      Pieces of the decomposition: the part of the surface in an
+    //      axis-aligned cell, and the hull of the piece of solid it bounds
+
+    const std::size_t kRandomSamples = 1000;
+    const std::size_t kMaxHullPoints = 2000;
+    const double kBalance = 0.02;
+
+    struct Piece
+    {
+        TriangleMesh    surface;
+        double          lower[3];
+        double          upper[3];
+        TriangleMesh    hull;
+        double          concavity;      // largest depth of the surface below the hull
+        bool            final;
+    };
+
+    ////    The hull of a piece is that of its surface and of the corners of its cell inside the solid.
+    ////    To compare cuts, only the hull of a sample of the surface (maxPoints) is needed.
+    void Evaluate(Piece& piece, const MeshInsideTest& solid, double tolerance, std::size_t maxPoints = 0)
+    {
+        const std::size_t nVertices = piece.surface.GetNumberOfVertices();
+        const std::size_t stride = (maxPoints>0 && nVertices>maxPoints) ? (nVertices + maxPoints - 1)/maxPoints : 1;
+
+        ////    Points on the faces of the cell are kept exactly, so that neighbouring hulls leave no gap
+        double epsilon = 0.;
+        for(int k=0; k<3; k++) epsilon = std::max(epsilon, 1e-9*(piece.upper[k] - piece.lower[k]));
+
+        std::vector<Vector3> points;
+        std::vector<bool> exact;
+        points.reserve(nVertices/stride + 8);
+        exact.reserve(nVertices/stride + 8);
+        for(std::size_t i=0; i<nVertices; i+=stride)
+        {
+            const Vector3 p = GetVertex(piece.surface, i);
+            G4bool onCell = false;
+            for(int k=0; k<3; k++) onCell = onCell || (p.Component(k) - piece.lower[k] <= epsilon) || (piece.upper[k] - p.Component(k) <= epsilon);
+            points.push_back(p);
+            exact.push_back(onCell);
+        }
+        const std::size_t nSurfacePoints = points.size();
+
+        for(int c=0; c<8; c++)
+        {
+            const Vector3 corner((c&1) ? piece.upper[0] : piece.lower[0], (c&2) ? piece.upper[1] : piece.lower[1], (c&4) ? piece.upper[2] : piece.lower[2]);
+            if(solid.Inside(corner))
+            {
+                points.push_back(corner);
+                exact.push_back(true);
+            }
+        }
+
+        HullBuilder builder(points, tolerance, &exact);
+        piece.hull = builder.Build() ? builder.GetMesh() : TriangleMesh();
+        piece.final = false;
+        piece.concavity = 0.;
+        if(maxPoints>0) return;
+
+        ////    The depth is sampled at the vertices, at the centres of the facets and at random points of the facets:
+        ////    the long facets of a bore may have all their vertices on the hull
+        const std::size_t nTriangles = piece.surface.GetNumberOfTriangles();
+        const std::size_t triangleStride = (maxPoints>0 && nTriangles>maxPoints) ? (nTriangles + maxPoints - 1)/maxPoints : 1;
+        std::vector<Vector3> samples;
+        samples.reserve(nSurfacePoints + nTriangles/triangleStride + kRandomSamples);
+        samples.insert(samples.end(), points.begin(), points.begin() + nSurfacePoints);
+
+        std::vector<double> cumulativeArea(nTriangles);
+        double area = 0.;
+        for(std::size_t t=0; t<nTriangles; t++)
+        {
+            const Vector3 p0 = GetVertex(piece.surface, piece.surface.triangles[3*t]);
+            const Vector3 p1 = GetVertex(piece.surface, piece.surface.triangles[3*t + 1]);
+            const Vector3 p2 = GetVertex(piece.surface, piece.surface.triangles[3*t + 2]);
+            area += std::sqrt((p1 - p0).Cross(p2 - p0).Mag2());
+            cumulativeArea[t] = area;
+            if(t%triangleStride==0) samples.push_back((p0 + p1 + p2)*(1./3.));
+        }
+
+        std::mt19937_64 engine(4357);
+        std::uniform_real_distribution<double> uniform(0., 1.);
+        for(std::size_t n=0; n<kRandomSamples && nTriangles>0; n++)
+        {
+            const std::size_t t = std::min<std::size_t>(nTriangles - 1,
+                std::lower_bound(cumulativeArea.begin(), cumulativeArea.end(), uniform(engine)*area) - cumulativeArea.begin());
+            const double r1 = std::sqrt(uniform(engine)), r2 = uniform(engine);
+            samples.push_back(GetVertex(piece.surface, piece.surface.triangles[3*t])*(1 - r1)
+                              + GetVertex(piece.surface, piece.surface.triangles[3*t + 1])*(r1*(1 - r2))
+                              + GetVertex(piece.surface, piece.surface.triangles[3*t + 2])*(r1*r2));
+        }
+
+        const ConvexPiece hull(piece.hull);
+        for(std::size_t i=0; i<samples.size() && !hull.normals.empty(); i++)
+        {
+            const Vector3& p = samples[i];
+            double depth = std::numeric_limits<double>::max();
+            for(std::size_t f=0; f<hull.normals.size() && depth>piece.concavity; f++) depth = std::min(depth, hull.offsets[f] - hull.normals[f].Dot(p));
+            piece.concavity = std::max(piece.concavity, depth);
+        }
+    }
+
+    ////    The two pieces on either side of the plane x[axis] = offset; false if the surface is not cut
+    bool Cut(const Piece& piece, int axis, double offset, double epsilon, const MeshInsideTest& solid,
+             double tolerance, std::size_t maxPoints, Piece parts[2])
+    {
+        TriangleMesh surfaces[2];
+        Split(piece.surface, axis, offset, epsilon, surfaces);
+        if(surfaces[0].triangles.empty() || surfaces[1].triangles.empty()) return false;
+
+        for(int p=0; p<2; p++)
+        {
+            parts[p].surface.vertices.swap(surfaces[p].vertices);
+            parts[p].surface.triangles.swap(surfaces[p].triangles);
+            std::copy(piece.lower, piece.lower + 3, parts[p].lower);
+            std::copy(piece.upper, piece.upper + 3, parts[p].upper);
+            (p==0 ? parts[p].upper : parts[p].lower)[axis] = offset;
+            Evaluate(parts[p], solid, tolerance, maxPoints);
+        }
+        return true;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TriangleMesh MeshConvexDecomposition::ConvexHull(const std::vector<double>& coordinates, G4double tolerance)
+{
+    std::vector<Vector3> points(coordinates.size()/3);
+    for(std::size_t i=0; i<points.size(); i++) points[i] = Vector3(coordinates[3*i], coordinates[3*i + 1], coordinates[3*i + 2]);
+
+    HullBuilder builder(points, tolerance);
+    if(!builder.Build()) return TriangleMesh();
+    return builder.GetMesh();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<TriangleMesh> MeshConvexDecomposition::Decompose(const TriangleMesh& mesh, G4double tolerance, std::size_t maxPieces)
+{
+    TriangleMesh welded = mesh;
+    welded.WeldVertices();
+    const MeshInsideTest solid(welded);
+
+    std::vector<Piece> pieces(1);
+    pieces[0].surface = welded;
+    for(int k=0; k<3; k++) { pieces[0].lower[k] = std::numeric_limits<double>::max(); pieces[0].upper[k] = -pieces[0].lower[k]; }
+    for(std::size_t i=0; i<welded.GetNumberOfVertices(); i++)
+    {
+        for(int k=0; k<3; k++)
+        {
+            pieces[0].lower[k] = std::min(pieces[0].lower[k], welded.vertices[3*i + k]);
+            pieces[0].upper[k] = std::max(pieces[0].upper[k], welded.vertices[3*i + k]);
+        }
+    }
+    Evaluate(pieces[0], solid, tolerance);
+
+    while(pieces.size() < maxPieces)
+    {
+        ////    The piece farthest from its hull
+        std::size_t worst = pieces.size();
+        double worstConcavity = tolerance;
+        for(std::size_t i=0; i<pieces.size(); i++)
+        {
+            if(!pieces[i].final && pieces[i].concavity > worstConcavity) { worst = i; worstConcavity = pieces[i].concavity; }
+        }
+        if(worst==pieces.size()) break;
+
+        const Piece& piece = pieces[worst];
+        const double epsilon = 1e-9*std::max(piece.upper[0] - piece.lower[0], std::max(piece.upper[1] - piece.lower[1], piece.upper[2] - piece.lower[2]));
+
+        //------------------------------------------------
+        //      The cut leaving the least volume between the two parts and their hulls,
+        //      compared on samples of the surface
+        double bestCost = std::numeric_limits<double>::max();
+        int bestAxis = -1;
+        double bestOffset = 0.;
+
+        Piece parts[2];
+        for(int axis=0; axis<3; axis++)
+        {
+            for(int k=1; k<8; k++)
+            {
+                const double offset = piece.lower[axis] + (piece.upper[axis] - piece.lower[axis])*k/8.;
+                if(!Cut(piece, axis, offset, epsilon, solid, tolerance, kMaxHullPoints, parts)) continue;
+
+                ////    The volume of the solid is the same for all cuts; balanced cuts are preferred among equal ones,
+                ////    as a bore only shows after several
+                const double volume0 = parts[0].hull.GetVolume(), volume1 = parts[1].hull.GetVolume();
+                const double cost = volume0 + volume1 + kBalance*std::abs(volume0 - volume1);
+                if(cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestOffset = offset;
+                }
+            }
+        }
+
+        if(bestAxis<0)
+        {
+            pieces[worst].final = true;
+            continue;
+        }
+
+        ////    Cells outside the solid, or without volume, leave no hull
+        Cut(piece, bestAxis, bestOffset, epsilon, solid, tolerance, 0, parts);
+        pieces.erase(pieces.begin() + worst);
+        for(int p=0; p<2; p++)
+        {
+            if(parts[p].hull.triangles.empty()) continue;
+            pieces.push_back(Piece());
+            std::swap(pieces.back(), parts[p]);
+        }
+    }
+
+    std::vector<TriangleMesh> hulls;
+    for(std::size_t i=0; i<pieces.size(); i++) hulls.push_back(pieces[i].hull);
+    return hulls;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double MeshConvexDecomposition::ClassificationMismatch(const TriangleMesh& mesh, const std::vector<TriangleMesh>& pieces, std::size_t nProbes)
+{
+    const double volume = std::abs(mesh.GetVolume());
+    if(nProbes==0 || mesh.vertices.empty() || volume==0.) return 0.;
+
+    Vector3 lower(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+    Vector3 upper(-lower.x, -lower.y, -lower.z);
+    for(std::size_t i=0; i<mesh.GetNumberOfVertices(); i++)
+    {
+        const Vector3 p = GetVertex(mesh, i);
+        lower = Vector3(std::min(lower.x, p.x), std::min(lower.y, p.y), std::min(lower.z, p.z));
+        upper = Vector3(std::max(upper.x, p.x), std::max(upper.y, p.y), std::max(upper.z, p.z));
+    }
+    const Vector3 centre = (lower + upper)*0.5;
+    const Vector3 halfSize = (upper - lower)*0.55;
+
+    const MeshInsideTest meshTest(mesh);
+    std::vector<ConvexPiece> convexPieces;
+    for(std::size_t i=0; i<pieces.size(); i++) convexPieces.push_back(ConvexPiece(pieces[i]));
+
+    std::mt19937_64 engine(4357);
+    std::uniform_real_distribution<double> uniform(-1., 1.);
+
+    std::size_t nMismatches = 0;
+    for(std::size_t n=0; n<nProbes; n++)
+    {
+        const Vector3 p = centre + Vector3(uniform(engine)*halfSize.x, uniform(engine)*halfSize.y, uniform(engine)*halfSize.z);
+
+        bool insideUnion = false;
+        for(std::size_t i=0; i<convexPieces.size() && !insideUnion; i++) insideUnion = convexPieces[i].Inside(p);
+
+        if(insideUnion!=meshTest.Inside(p)) nMismatches++;
+    }
+
+    const double boxVolume = 8.*halfSize.x*halfSize.y*halfSize.z;
+    return double(nMismatches)/nProbes*boxVolume/volume;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool MeshConvexDecomposition::WritePLY(const G4String& filename, const std::vector<TriangleMesh>& pieces)
+{
+    TriangleMesh all;
+    for(std::size_t i=0; i<pieces.size(); i++)
+    {
+        const std::uint32_t first = all.GetNumberOfVertices();
+        all.vertices.insert(all.vertices.end(), pieces[i].vertices.begin(), pieces[i].vertices.end());
+        for(std::size_t j=0; j<pieces[i].triangles.size(); j++) all.triangles.push_back(first + pieces[i].triangles[j]);
+    }
+    return all.WritePLY(filename);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool MeshConvexDecomposition::ReadPLY(const G4String& filename, std::vector<TriangleMesh>& pieces)
+{
+    TriangleMesh all;
+    if(!all.ReadPLY(filename)) return false;
+
+    ////    Connected parts: union-find over the vertices of each facet
+    std::vector<std::uint32_t> parent(all.GetNumberOfVertices());
+    for(std::size_t i=0; i<parent.size(); i++) parent[i] = i;
+
+    auto Root = [&parent](std::uint32_t i)
+    {
+        while(parent[i]!=i) i = parent[i] = parent[parent[i]];
+        return i;
+    };
+
+    for(std::size_t t=0; t<all.GetNumberOfTriangles(); t++)
+    {
+        const std::uint32_t r0 = Root(all.triangles[3*t]);
+        parent[Root(all.triangles[3*t + 1])] = r0;
+        parent[Root(all.triangles[3*t + 2])] = r0;
+    }
+
+    std::unordered_map<std::uint32_t, std::size_t> pieceOfRoot;
+    std::vector<std::uint32_t> newIndex(all.GetNumberOfVertices(), 0xffffffffu);
+
+    pieces.clear();
+    for(std::size_t t=0; t<all.GetNumberOfTriangles(); t++)
+    {
+        const std::uint32_t root = Root(all.triangles[3*t]);
+        std::unordered_map<std::uint32_t, std::size_t>::const_iterator found = pieceOfRoot.find(root);
+        if(found==pieceOfRoot.end())
+        {
+            found = pieceOfRoot.insert(std::make_pair(root, pieces.size())).first;
+            pieces.push_back(TriangleMesh());
+        }
+
+        TriangleMesh& piece = pieces[found->second];
+        for(int j=0; j<3; j++)
+        {
+            const std::uint32_t v = all.triangles[3*t + j];
+            if(newIndex[v]==0xffffffffu)
+            {
+                newIndex[v] = piece.GetNumberOfVertices();
+                piece.vertices.insert(piece.vertices.end(), &all.vertices[3*v], &all.vertices[3*v] + 3);
+            }
+            piece.triangles.push_back(newIndex[v]);
+        }
+    }
+
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String MeshConvexDecomposition::GetDecompositionFileName(const G4String& meshPath)
+{
+    const std::size_t slash = meshPath.find_last_of('/');
+    std::size_t dot = meshPath.find_last_of('.');
+    if(dot==std::string::npos || (slash!=std::string::npos && dot<slash)) dot = meshPath.length();
+
+    return G4String(meshPath.substr(0, dot)) + ".convex" + G4String(meshPath.substr(dot));
+}
@@ -0,0 +1,817 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "MeshDecimation.hh"
+
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <queue>
+#include <random>
+#include <sstream>
+
+namespace {
+
+    //------------------------------------------------------------------
+    //      PLY input
+
+    enum PLYType { kInt8, kUInt8, kInt16, kUInt16, kInt32, kUInt32, kFloat32, kFloat64, kUnknownType };
+    enum PLYFormat { kAscii, kLittleEndian, kBigEndian };
+
+    struct PLYProperty
+    {
+        std::string name;
+        PLYType     type;
+        bool        isList;
+        PLYType     countType;
+    };
+
+    struct PLYElement
+    {
+        std::string                 name;
+        std::size_t                 count;
+        std::vector<PLYProperty>    properties;
+    };
+
+    PLYType ParseType(const std::string& name)
+    {
+        if(name=="char" || name=="int8") return kInt8;
+        if(name=="uchar" || name=="uint8") return kUInt8;
+        if(name=="short" || name=="int16") return kInt16;
+        if(name=="ushort" || name=="uint16") return kUInt16;
+        if(name=="int" || name=="int32") return kInt32;
+        if(name=="uint" || name=="uint32") return kUInt32;
+        if(name=="float" || name=="float32") return kFloat32;
+        if(name=="double" || name=="float64") return kFloat64;
+        return kUnknownType;
+    }
+
+    int TypeSize(PLYType type)
+    {
+        switch(type)
+        {
+            case kInt8: case kUInt8: return 1;
+            case kInt16: case kUInt16: return 2;
+            case kInt32: case kUInt32: case kFloat32: return 4;
+            case kFloat64: return 8;
+            default: return 0;
+        }
+    }
+
+    bool IsLittleEndianHost()
+    {
+        const std::uint16_t one = 1;
+        return *reinterpret_cast<const unsigned char*>(&one)==1;
+    }
+
+    double ReadValue(std::istream& in, PLYType type, PLYFormat format)
+    {
+        if(format==kAscii)
+        {
+            double value = 0.;
+            in >> value;
+            return value;
+        }
+
+        unsigned char bytes[8];
+        const int size = TypeSize(type);
+        in.read(reinterpret_cast<char*>(bytes), size);
+        if((format==kLittleEndian)!=IsLittleEndianHost()) std::reverse(bytes, bytes + size);
+
+        switch(type)
+        {
+            case kInt8:     { std::int8_t v;   std::memcpy(&v, bytes, 1); return v; }
+            case kUInt8:    { std::uint8_t v;  std::memcpy(&v, bytes, 1); return v; }
+            case kInt16:    { std::int16_t v;  std::memcpy(&v, bytes, 2); return v; }
+            case kUInt16:   { std::uint16_t v; std::memcpy(&v, bytes, 2); return v; }
+            case kInt32:    { std::int32_t v;  std::memcpy(&v, bytes, 4); return v; }
+            case kUInt32:   { std::uint32_t v; std::memcpy(&v, bytes, 4); return v; }
+            case kFloat32:  { float v;         std::memcpy(&v, bytes, 4); return v; }
+            case kFloat64:  { double v;        std::memcpy(&v, bytes, 8); return v; }
+            default: return 0.;
+        }
+    }
+
+    //------------------------------------------------------------------
+    //      Geometry
+
+    struct Vector3
+    {
+        double x, y, z;
+        Vector3() : x(0.), y(0.), z(0.) {}
+        Vector3(double a, double b, double c) : x(a), y(b), z(c) {}
+        Vector3 operator+(const Vector3& o) const  { return Vector3(x+o.x, y+o.y, z+o.z); }
+        Vector3 operator-(const Vector3& o) const  { return Vector3(x-o.x, y-o.y, z-o.z); }
+        Vector3 operator*(double s) const          { return Vector3(x*s, y*s, z*s); }
+        double  Dot(const Vector3& o) const        { return x*o.x + y*o.y + z*o.z; }
+        Vector3 Cross(const Vector3& o) const      { return Vector3(y*o.z - z*o.y, z*o.x - x*o.z, x*o.y - y*o.x); }
+        double  Mag2() const                       { return Dot(*this); }
+    };
+
+    Vector3 GetVertex(const TriangleMesh& mesh, std::uint32_t i)
+    {
+        return Vector3(mesh.vertices[3*i], mesh.vertices[3*i + 1], mesh.vertices[3*i + 2]);
+    }
+
+    ////    Closest point of the triangle (a, b, c) to p (Ericson, Real-Time Collision Detection 5.1.5)
+    Vector3 ClosestPointOnTriangle(const Vector3& p, const Vector3& a, const Vector3& b, const Vector3& c)
+    {
+        const Vector3 ab = b - a, ac = c - a, ap = p - a;
+        const double d1 = ab.Dot(ap), d2 = ac.Dot(ap);
+        if(d1<=0. && d2<=0.) return a;
+
+        const Vector3 bp = p - b;
+        const double d3 = ab.Dot(bp), d4 = ac.Dot(bp);
+        if(d3>=0. && d4<=d3) return b;
+
+        const double vc = d1*d4 - d3*d2;
+        if(vc<=0. && d1>=0. && d3<=0.) return a + ab*(d1/(d1 - d3));
+
+        const Vector3 cp = p - c;
+        const double d5 = ab.Dot(cp), d6 = ac.Dot(cp);
+        if(d6>=0. && d5<=d6) return c;
+
+        const double vb = d5*d2 - d1*d6;
+        if(vb<=0. && d2>=0. && d6<=0.) return a + ac*(d2/(d2 - d6));
+
+        const double va = d3*d6 - d5*d4;
+        if(va<=0. && (d4 - d3)>=0. && (d5 - d6)>=0.) return b + (c - b)*((d4 - d3)/((d4 - d3) + (d5 - d6)));
+
+        const double denominator = 1./(va + vb + vc);
+        return a + ab*(vb*denominator) + ac*(vc*denominator);
+    }
+
+    //------------------------------------------------------------------
+    //      Quadric of squared plane distances, symmetric 4x4:
+    //      a00 a01 a02 a03 a11 a12 a13 a22 a23 a33
+
+    struct Quadric
+    {
+        double a[10];
+
+        Quadric() { std::fill(a, a + 10, 0.); }
+
+        void AddPlane(const Vector3& n, double d)
+        {
+            a[0] += n.x*n.x; a[1] += n.x*n.y; a[2] += n.x*n.z; a[3] += n.x*d;
+            a[4] += n.y*n.y; a[5] += n.y*n.z; a[6] += n.y*d;
+            a[7] += n.z*n.z; a[8] += n.z*d;
+            a[9] += d*d;
+        }
+
+        Quadric operator+(const Quadric& o) const
+        {
+            Quadric sum;
+            for(int i=0; i<10; i++) sum.a[i] = a[i] + o.a[i];
+            return sum;
+        }
+
+        double Evaluate(const Vector3& p) const
+        {
+            return a[0]*p.x*p.x + 2*a[1]*p.x*p.y + 2*a[2]*p.x*p.z + 2*a[3]*p.x
+                 + a[4]*p.y*p.y + 2*a[5]*p.y*p.z + 2*a[6]*p.y
+                 + a[7]*p.z*p.z + 2*a[8]*p.z
+                 + a[9];
+        }
+
+        ////    Minimum of the quadric, if well defined
+        bool Minimum(Vector3& p) const
+        {
+            const double det = a[0]*(a[4]*a[7] - a[5]*a[5]) - a[1]*(a[1]*a[7] - a[5]*a[2]) + a[2]*(a[1]*a[5] - a[4]*a[2]);
+            const double scale = a[0]*a[4]*a[7];
+            if(!(std::abs(det) > 1e-10*std::abs(scale)) || det==0.) return false;
+
+            const double b0 = -a[3], b1 = -a[6], b2 = -a[8];
+            p.x = (b0*(a[4]*a[7] - a[5]*a[5]) - a[1]*(b1*a[7] - a[5]*b2) + a[2]*(b1*a[5] - a[4]*b2))/det;
+            p.y = (a[0]*(b1*a[7] - b2*a[5]) - b0*(a[1]*a[7] - a[5]*a[2]) + a[2]*(a[1]*b2 - b1*a[2]))/det;
+            p.z = (a[0]*(a[4]*b2 - a[5]*b1) - a[1]*(a[1]*b2 - b1*a[2]) + b0*(a[1]*a[5] - a[4]*a[2]))/det;
+            return true;
+        }
+    };
+
+    struct Collapse
+    {
+        double          cost;
+        std::uint32_t   u, v;
+        std::uint32_t   versionU, versionV;
+        Vector3         position;
+
+        bool operator>(const Collapse& o) const     { return cost > o.cost; }
+    };
+
+    //------------------------------------------------------------------
+    //      Uniform grid of the triangles of a mesh, for nearest-surface queries
+
+    class TriangleGrid
+    {
+    public:
+        TriangleGrid(const TriangleMesh& mesh) : fMesh(mesh)
+        {
+            const std::size_t nTriangles = mesh.GetNumberOfTriangles();
+            fLower = Vector3(1e300, 1e300, 1e300);
+            Vector3 upper(-1e300, -1e300, -1e300);
+            for(std::size_t i=0; i<mesh.GetNumberOfVertices(); i++)
+            {
+                const Vector3 p = GetVertex(mesh, i);
+                fLower = Vector3(std::min(fLower.x, p.x), std::min(fLower.y, p.y), std::min(fLower.z, p.z));
+                upper = Vector3(std::max(upper.x, p.x), std::max(upper.y, p.y), std::max(upper.z, p.z));
+            }
+
+            const Vector3 extent = upper - fLower;
+            const double volume = std::max(extent.x, 1e-9)*std::max(extent.y, 1e-9)*std::max(extent.z, 1e-9);
+            fCellSize = std::cbrt(volume/std::max<std::size_t>(nTriangles, 1))*2;
+            fCellSize = std::max(fCellSize, 1e-6*std::sqrt(extent.Mag2()));
+
+            fN[0] = std::max(1, int(extent.x/fCellSize) + 1);
+            fN[1] = std::max(1, int(extent.y/fCellSize) + 1);
+            fN[2] = std::max(1, int(extent.z/fCellSize) + 1);
+            fCells.resize(std::size_t(fN[0])*fN[1]*fN[2]);
+
+            for(std::size_t t=0; t<nTriangles; t++)
+            {
+                int lower[3] = {fN[0], fN[1], fN[2]}, higher[3] = {-1, -1, -1};
+                for(int j=0; j<3; j++)
+                {
+                    int cell[3];
+                    Cell(GetVertex(mesh, mesh.triangles[3*t + j]), cell);
+                    for(int k=0; k<3; k++) { lower[k] = std::min(lower[k], cell[k]); higher[k] = std::max(higher[k], cell[k]); }
+                }
+                for(int i=lower[0]; i<=higher[0]; i++)
+                    for(int j=lower[1]; j<=higher[1]; j++)
+                        for(int k=lower[2]; k<=higher[2]; k++) fCells[Index(i, j, k)].push_back(t);
+            }
+        }
+
+        double Distance(const Vector3& p) const
+        {
+            int centre[3];
+            Cell(p, centre);
+
+            double best2 = 1e300;
+            for(int ring=0; ; ring++)
+            {
+                for(int i=std::max(0, centre[0]-ring); i<=std::min(fN[0]-1, centre[0]+ring); i++)
+                    for(int j=std::max(0, centre[1]-ring); j<=std::min(fN[1]-1, centre[1]+ring); j++)
+                        for(int k=std::max(0, centre[2]-ring); k<=std::min(fN[2]-1, centre[2]+ring); k++)
+                        {
+                            if(std::max(std::abs(i-centre[0]), std::max(std::abs(j-centre[1]), std::abs(k-centre[2])))!=ring) continue;
+
+                            const std::vector<std::uint32_t>& cell = fCells[Index(i, j, k)];
+                            for(std::size_t n=0; n<cell.size(); n++)
+                            {
+                                const std::uint32_t* t = &fMesh.triangles[3*cell[n]];
+                                const Vector3 q = ClosestPointOnTriangle(p, GetVertex(fMesh, t[0]), GetVertex(fMesh, t[1]), GetVertex(fMesh, t[2]));
+                                best2 = std::min(best2, (q - p).Mag2());
+                            }
+                        }
+
+                ////    Distance to the nearest cell not searched yet
+                double bound = 1e300;
+                const double position[3] = {p.x - fLower.x, p.y - fLower.y, p.z - fLower.z};
+                for(int k=0; k<3; k++)
+                {
+                    if(centre[k]-ring > 0) bound = std::min(bound, position[k] - (centre[k]-ring)*fCellSize);
+                    if(centre[k]+ring < fN[k]-1) bound = std::min(bound, (centre[k]+ring+1)*fCellSize - position[k]);
+                }
+                if(bound==1e300 || best2 <= bound*bound) break;
+            }
+            return std::sqrt(best2);
+        }
+
+    private:
+        void Cell(const Vector3& p, int cell[3]) const
+        {
+            const double position[3] = {p.x - fLower.x, p.y - fLower.y, p.z - fLower.z};
+            for(int k=0; k<3; k++) cell[k] = std::max(0, std::min(fN[k]-1, int(std::floor(position[k]/fCellSize))));
+        }
+
+        std::size_t Index(int i, int j, int k) const { return (std::size_t(i)*fN[1] + j)*fN[2] + k; }
+
+        const TriangleMesh&                         fMesh;
+        Vector3                                     fLower;
+        double                                      fCellSize;
+        int                                         fN[3];
+        std::vector<std::vector<std::uint32_t>>     fCells;
+    };
+
+    ////    Largest distance of the vertices and of nSamples random surface points of a to the surface of b
+    double OneSidedDistance(const TriangleMesh& a, const TriangleGrid& b, std::size_t nSamples)
+    {
+        double maxDistance = 0.;
+        for(std::size_t i=0; i<a.GetNumberOfVertices(); i++) maxDistance = std::max(maxDistance, b.Distance(GetVertex(a, i)));
+
+        const std::size_t nTriangles = a.GetNumberOfTriangles();
+        if(nTriangles==0) return maxDistance;
+
+        std::vector<double> cumulativeArea(nTriangles);
+        double area = 0.;
+        for(std::size_t t=0; t<nTriangles; t++)
+        {
+            const Vector3 p0 = GetVertex(a, a.triangles[3*t]), p1 = GetVertex(a, a.triangles[3*t + 1]), p2 = GetVertex(a, a.triangles[3*t + 2]);
+            area += 0.5*std::sqrt((p1 - p0).Cross(p2 - p0).Mag2());
+            cumulativeArea[t] = area;
+        }
+
+        std::mt19937_64 engine(4357);
+        std::uniform_real_distribution<double> uniform(0., 1.);
+        for(std::size_t n=0; n<nSamples; n++)
+        {
+            const std::size_t t = std::min<std::size_t>(nTriangles - 1,
+                std::lower_bound(cumulativeArea.begin(), cumulativeArea.end(), uniform(engine)*area) - cumulativeArea.begin());
+            const double r1 = std::sqrt(uniform(engine)), r2 = uniform(engine);
+            const Vector3 p0 = GetVertex(a, a.triangles[3*t]), p1 = GetVertex(a, a.triangles[3*t + 1]), p2 = GetVertex(a, a.triangles[3*t + 2]);
+            const Vector3 p = p0*(1 - r1) + p1*(r1*(1 - r2)) + p2*(r1*r2);
+            maxDistance = std::max(maxDistance, b.Distance(p));
+        }
+        return maxDistance;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TriangleMesh::ReadPLY(const G4String& filename)
+{
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if(!file) return false;
+
+    //------------------------------------------------
+    //      Header
+    std::string line;
+    std::getline(file, line);
+    if(line.compare(0, 3, "ply")!=0) return false;
+
+    PLYFormat format = kAscii;
+    std::vector<PLYElement> elements;
+
+    while(std::getline(file, line))
+    {
+        if(!line.empty() && line[line.size()-1]=='\r') line.erase(line.size()-1);
+
+        std::istringstream words(line);
+        std::string keyword;
+        words >> keyword;
+
+        if(keyword=="format")
+        {
+            std::string name;
+            words >> name;
+            if(name=="ascii") format = kAscii;
+            else if(name=="binary_little_endian") format = kLittleEndian;
+            else if(name=="binary_big_endian") format = kBigEndian;
+            else return false;
+        }
+        else if(keyword=="element")
+        {
+            PLYElement element;
+            words >> element.name >> element.count;
+            elements.push_back(element);
+        }
+        else if(keyword=="property" && !elements.empty())
+        {
+            PLYProperty property;
+            std::string type;
+            words >> type;
+            property.isList = (type=="list");
+            if(property.isList)
+            {
+                std::string countType, itemType;
+                words >> countType >> itemType;
+                property.countType = ParseType(countType);
+                property.type = ParseType(itemType);
+                if(property.countType==kUnknownType) return false;
+            }
+            else
+            {
+                property.type = ParseType(type);
+                property.countType = kUnknownType;
+            }
+            if(property.type==kUnknownType) return false;
+            words >> property.name;
+            elements.back().properties.push_back(property);
+        }
+        else if(keyword=="end_header") break;
+    }
+
+    //------------------------------------------------
+    //      Data
+    vertices.clear();
+    triangles.clear();
+
+    for(std::size_t e=0; e<elements.size(); e++)
+    {
+        const PLYElement& element = elements[e];
+        const bool isVertex = (element.name=="vertex");
+        const bool isFace = (element.name=="face");
+
+        if(isVertex) vertices.reserve(3*element.count);
+        if(isFace) triangles.reserve(3*element.count);
+
+        std::vector<std::uint32_t> polygon;
+        for(std::size_t i=0; i<element.count && file; i++)
+        {
+            double position[3] = {0., 0., 0.};
+            for(std::size_t p=0; p<element.properties.size(); p++)
+            {
+                const PLYProperty& property = element.properties[p];
+                if(property.isList)
+                {
+                    const std::size_t n = std::size_t(ReadValue(file, property.countType, format));
+                    polygon.resize(n);
+                    for(std::size_t k=0; k<n; k++) polygon[k] = std::uint32_t(ReadValue(file, property.type, format));
+
+                    if(isFace && (property.name=="vertex_indices" || property.name=="vertex_index"))
+                    {
+                        for(std::size_t k=1; k+1<n; k++)
+                        {
+                            triangles.push_back(polygon[0]);
+                            triangles.push_back(polygon[k]);
+                            triangles.push_back(polygon[k+1]);
+                        }
+                    }
+                }
+                else
+                {
+                    const double value = ReadValue(file, property.type, format);
+                    if(property.name=="x") position[0] = value;
+                    else if(property.name=="y") position[1] = value;
+                    else if(property.name=="z") position[2] = value;
+                }
+            }
+            if(isVertex) vertices.insert(vertices.end(), position, position + 3);
+        }
+    }
+
+    if(!file || vertices.empty() || triangles.empty()) return false;
+
+    const std::size_t nVertices = GetNumberOfVertices();
+    for(std::size_t i=0; i<triangles.size(); i++)
+    {
+        if(triangles[i]>=nVertices) return false;
+    }
+
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TriangleMesh::WritePLY(const G4String& filename) const
+{
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    if(!file) return false;
+
+    file << "ply\n"
+    << "format " << (IsLittleEndianHost() ? "binary_little_endian" : "binary_big_endian") << " 1.0\n"
+    << "comment Decimated by the K600 MeshDecimator\n"
+    << "element vertex " << GetNumberOfVertices() << "\n"
+    << "property float x\nproperty float y\nproperty float z\n"
+    << "element face " << GetNumberOfTriangles() << "\n"
+    << "property list uchar int vertex_indices\n"
+    << "end_header\n";
+
+    ////    Same layout as the exported meshes, so CADMesh reads them alike
+    for(std::size_t i=0; i<vertices.size(); i++)
+    {
+        const float value = float(vertices[i]);
+        file.write(reinterpret_cast<const char*>(&value), sizeof(float));
+    }
+
+    const unsigned char three = 3;
+    for(std::size_t t=0; t<GetNumberOfTriangles(); t++)
+    {
+        const std::int32_t indices[3] = {std::int32_t(triangles[3*t]), std::int32_t(triangles[3*t + 1]), std::int32_t(triangles[3*t + 2])};
+        file.write(reinterpret_cast<const char*>(&three), 1);
+        file.write(reinterpret_cast<const char*>(indices), sizeof(indices));
+    }
+
+    return bool(file);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TriangleMesh::WeldVertices()
+{
+    std::map<std::array<double, 3>, std::uint32_t> index;
+    std::vector<double> welded;
+    std::vector<std::uint32_t> remap(GetNumberOfVertices());
+
+    for(std::size_t i=0; i<GetNumberOfVertices(); i++)
+    {
+        const std::array<double, 3> key = {{vertices[3*i], vertices[3*i + 1], vertices[3*i + 2]}};
+        std::map<std::array<double, 3>, std::uint32_t>::const_iterator found = index.find(key);
+        if(found==index.end())
+        {
+            remap[i] = welded.size()/3;
+            index[key] = remap[i];
+            welded.insert(welded.end(), key.begin(), key.end());
+        }
+        else remap[i] = found->second;
+    }
+
+    ////    Triangles collapsed by the welding are dropped
+    std::vector<std::uint32_t> kept;
+    kept.reserve(triangles.size());
+    for(std::size_t t=0; t<GetNumberOfTriangles(); t++)
+    {
+        const std::uint32_t i0 = remap[triangles[3*t]], i1 = remap[triangles[3*t + 1]], i2 = remap[triangles[3*t + 2]];
+        if(i0==i1 || i1==i2 || i2==i0) continue;
+        kept.push_back(i0);
+        kept.push_back(i1);
+        kept.push_back(i2);
+    }
+
+    vertices.swap(welded);
+    triangles.swap(kept);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double TriangleMesh::GetVolume() const
+{
+    double volume = 0.;
+    for(std::size_t t=0; t<GetNumberOfTriangles(); t++)
+    {
+        const Vector3 p0 = GetVertex(*this, triangles[3*t]), p1 = GetVertex(*this, triangles[3*t + 1]), p2 = GetVertex(*this, triangles[3*t + 2]);
+        volume += p0.Dot(p1.Cross(p2));
+    }
+    return volume/6.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TriangleMesh MeshDecimation::Decimate(const TriangleMesh& input, G4double tolerance, std::size_t targetTriangles)
+{
+    TriangleMesh mesh = input;
+    mesh.WeldVertices();
+
+    const std::size_t nVertices = mesh.GetNumberOfVertices();
+    const std::size_t nTriangles = mesh.GetNumberOfTriangles();
+
+    std::vector<Vector3> position(nVertices);
+    for(std::size_t i=0; i<nVertices; i++) position[i] = GetVertex(mesh, i);
+
+    std::vector<std::array<std::uint32_t, 3>> triangle(nTriangles);
+    std::vector<bool> triangleAlive(nTriangles, true);
+    std::vector<std::vector<std::uint32_t>> vertexTriangles(nVertices);
+    for(std::size_t t=0; t<nTriangles; t++)
+    {
+        for(int j=0; j<3; j++)
+        {
+            triangle[t][j] = mesh.triangles[3*t + j];
+            vertexTriangles[triangle[t][j]].push_back(t);
+        }
+    }
+
+    //------------------------------------------------
+    //      Vertices on open or non-manifold edges stay where they are
+    std::vector<bool> locked(nVertices, false);
+    {
+        std::map<std::pair<std::uint32_t, std::uint32_t>, int> edgeUse;
+        for(std::size_t t=0; t<nTriangles; t++)
+        {
+            for(int j=0; j<3; j++)
+            {
+                const std::uint32_t a = triangle[t][j], b = triangle[t][(j+1)%3];
+                edgeUse[std::make_pair(std::min(a, b), std::max(a, b))]++;
+            }
+        }
+        for(std::map<std::pair<std::uint32_t, std::uint32_t>, int>::const_iterator edge=edgeUse.begin(); edge!=edgeUse.end(); ++edge)
+        {
+            if(edge->second!=2) locked[edge->first.first] = locked[edge->first.second] = true;
+        }
+    }
+
+    //------------------------------------------------
+    //      Quadrics of the facet planes
+    std::vector<Quadric> quadric(nVertices);
+    for(std::size_t t=0; t<nTriangles; t++)
+    {
+        const Vector3& p0 = position[triangle[t][0]];
+        Vector3 normal = (position[triangle[t][1]] - p0).Cross(position[triangle[t][2]] - p0);
+        const double length = std::sqrt(normal.Mag2());
+        if(length==0.) continue;
+        normal = normal*(1./length);
+        for(int j=0; j<3; j++) quadric[triangle[t][j]].AddPlane(normal, -normal.Dot(p0));
+    }
+
+    std::vector<std::uint32_t> version(nVertices, 0);
+    std::vector<bool> vertexAlive(nVertices, true);
+
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+
+    auto PushCollapse = [&](std::uint32_t u, std::uint32_t v)
+    {
+        if(locked[u] || locked[v]) return;
+
+        const Quadric q = quadric[u] + quadric[v];
+        Collapse collapse;
+        collapse.u = u;
+        collapse.v = v;
+        collapse.versionU = version[u];
+        collapse.versionV = version[v];
+
+        if(!q.Minimum(collapse.position))
+        {
+            ////    Flat or cylindrical neighbourhood: the better of the ends and the midpoint
+            const Vector3 candidates[3] = {position[u], position[v], (position[u] + position[v])*0.5};
+            collapse.position = candidates[0];
+            for(int c=1; c<3; c++)
+            {
+                if(q.Evaluate(candidates[c]) < q.Evaluate(collapse.position)) collapse.position = candidates[c];
+            }
+        }
+        collapse.cost = std::max(0., q.Evaluate(collapse.position));
+
+        if(collapse.cost <= tolerance*tolerance) queue.push(collapse);
+    };
+
+    auto Neighbours = [&](std::uint32_t u, std::vector<std::uint32_t>& neighbours)
+    {
+        neighbours.clear();
+        for(std::size_t n=0; n<vertexTriangles[u].size(); n++)
+        {
+            const std::uint32_t t = vertexTriangles[u][n];
+            if(!triangleAlive[t]) continue;
+            for(int j=0; j<3; j++) if(triangle[t][j]!=u) neighbours.push_back(triangle[t][j]);
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+    };
+
+    for(std::size_t t=0; t<nTriangles; t++)
+    {
+        for(int j=0; j<3; j++)
+        {
+            const std::uint32_t a = triangle[t][j], b = triangle[t][(j+1)%3];
+            if(a<b) PushCollapse(a, b);
+        }
+    }
+
+    //------------------------------------------------
+    //      Cheapest collapses first
+    std::size_t nAlive = nTriangles;
+    std::vector<std::uint32_t> neighboursU, neighboursV, common;
+
+    while(!queue.empty() && (targetTriangles==0 || nAlive>targetTriangles))
+    {
+        const Collapse collapse = queue.top();
+        queue.pop();
+
+        const std::uint32_t u = collapse.u, v = collapse.v;
+        if(!vertexAlive[u] || !vertexAlive[v] || version[u]!=collapse.versionU || version[v]!=collapse.versionV) continue;
+
+        ////    Link condition: the edge must be shared by exactly two facets whose third vertices are the only common neighbours
+        Neighbours(u, neighboursU);
+        Neighbours(v, neighboursV);
+        common.clear();
+        std::set_intersection(neighboursU.begin(), neighboursU.end(), neighboursV.begin(), neighboursV.end(), std::back_inserter(common));
+        if(common.size()!=2) continue;
+
+        ////    No facet may be folded over or degenerate
+        G4bool valid = true;
+        for(int end=0; end<2 && valid; end++)
+        {
+            const std::uint32_t w = end==0 ? u : v;
+            for(std::size_t n=0; n<vertexTriangles[w].size() && valid; n++)
+            {
+                const std::uint32_t t = vertexTriangles[w][n];
+                if(!triangleAlive[t]) continue;
+
+                Vector3 corner[3], moved[3];
+                G4bool hasU = false, hasV = false;
+                for(int j=0; j<3; j++)
+                {
+                    corner[j] = position[triangle[t][j]];
+                    moved[j] = corner[j];
+                    if(triangle[t][j]==u) { hasU = true; moved[j] = collapse.position; }
+                    if(triangle[t][j]==v) { hasV = true; moved[j] = collapse.position; }
+                }
+                if(hasU && hasV) continue;
+
+                const Vector3 before = (corner[1] - corner[0]).Cross(corner[2] - corner[0]);
+                const Vector3 after = (moved[1] - moved[0]).Cross(moved[2] - moved[0]);
+                const double before2 = before.Mag2(), after2 = after.Mag2();
+                if(after2 <= 1e-12*before2 || before.Dot(after) < 0.5*std::sqrt(before2*after2)) valid = false;
+            }
+        }
+        if(!valid) continue;
+
+        //------------------------------------------------
+        //      Collapse v into u
+        for(std::size_t n=0; n<vertexTriangles[v].size(); n++)
+        {
+            const std::uint32_t t = vertexTriangles[v][n];
+            if(!triangleAlive[t]) continue;
+
+            G4bool hasU = false;
+            for(int j=0; j<3; j++) if(triangle[t][j]==u) hasU = true;
+
+            if(hasU)
+            {
+                triangleAlive[t] = false;
+                nAlive--;
+            }
+            else
+            {
+                for(int j=0; j<3; j++) if(triangle[t][j]==v) triangle[t][j] = u;
+                vertexTriangles[u].push_back(t);
+            }
+        }
+
+        std::vector<std::uint32_t>& trianglesU = vertexTriangles[u];
+        std::size_t kept = 0;
+        for(std::size_t n=0; n<trianglesU.size(); n++) if(triangleAlive[trianglesU[n]]) trianglesU[kept++] = trianglesU[n];
+        trianglesU.resize(kept);
+        std::vector<std::uint32_t>().swap(vertexTriangles[v]);
+
+        position[u] = collapse.position;
+        quadric[u] = quadric[u] + quadric[v];
+        vertexAlive[v] = false;
+        version[u]++;
+
+        Neighbours(u, neighboursU);
+        for(std::size_t n=0; n<neighboursU.size(); n++) PushCollapse(std::min(u, neighboursU[n]), std::max(u, neighboursU[n]));
+    }
+
+    //------------------------------------------------
+    //      Compact
+    TriangleMesh result;
+    std::vector<std::uint32_t> newIndex(nVertices, 0xffffffffu);
+    for(std::size_t t=0; t<nTriangles; t++)
+    {
+        if(!triangleAlive[t]) continue;
+        for(int j=0; j<3; j++)
+        {
+            const std::uint32_t i = triangle[t][j];
+            if(newIndex[i]==0xffffffffu)
+            {
+                newIndex[i] = result.vertices.size()/3;
+                result.vertices.push_back(position[i].x);
+                result.vertices.push_back(position[i].y);
+                result.vertices.push_back(position[i].z);
+            }
+            result.triangles.push_back(newIndex[i]);
+        }
+    }
+
+    return result;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double MeshDecimation::HausdorffDistance(const TriangleMesh& a, const TriangleMesh& b, std::size_t samplesPerMesh)
+{
+    const TriangleGrid gridA(a), gridB(b);
+    return std::max(OneSidedDistance(a, gridB, samplesPerMesh), OneSidedDistance(b, gridA, samplesPerMesh));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String MeshDecimation::GetLevelOfDetailFileName(const G4String& meshPath, G4double tolerance)
+{
+    const std::size_t slash = meshPath.find_last_of('/');
+    std::size_t dot = meshPath.find_last_of('.');
+    if(dot==std::string::npos || (slash!=std::string::npos && dot<slash)) dot = meshPath.length();
+
+    char level[64];
+    std::snprintf(level, sizeof(level), ".lod%gum", tolerance/um);
+    return G4String(meshPath.substr(0, dot)) + level + G4String(meshPath.substr(dot));
+}
@@ -0,0 +1,383 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "MultipoleFieldExpansion.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+    ////    Taylor coefficients f_m = f^(m)/m! of the fringe profile, m = 0 ... 2K+1
+    const int kJetSize = 2*MultipoleFieldExpansion::kMaxPseudoOrder + 2;
+
+    ////    c_nk/n, c_n0 = 1, c_nk = -c_n(k-1)/(4k(n+k)), and m! for the jets
+    struct ExpansionConstants
+    {
+        double  coefficient[MultipoleFieldExpansion::kMaxOrder+1][MultipoleFieldExpansion::kMaxPseudoOrder+1];
+        double  factorial[kJetSize];
+        double  inverse[kJetSize];
+
+        ExpansionConstants()
+        {
+            for(int n=1; n<=MultipoleFieldExpansion::kMaxOrder; n++)
+            {
+                double c = 1.;
+                for(int k=0; k<=MultipoleFieldExpansion::kMaxPseudoOrder; k++)
+                {
+                    if(k>0) c *= -1./(4.*k*(n+k));
+                    coefficient[n][k] = c/n;
+                }
+            }
+
+            factorial[0] = 1.;
+            inverse[0] = 0.;
+            for(int m=1; m<kJetSize; m++)
+            {
+                factorial[m] = m*factorial[m-1];
+                inverse[m] = 1./m;
+            }
+        }
+    };
+
+    const ExpansionConstants kConstants;
+
+    ////    Enge function of s(t) = s0 + ds*t as a truncated Taylor series in t
+    void EngeJet(const double* e, double s0, double ds, double range, int order, double* E)
+    {
+        for(int m=0; m<=order; m++) E[m] = 0.;
+
+        if(s0<=-range) { E[0] = 1.; return; }
+        if(s0>=range) return;
+
+        ////    Exponent p(t) = e0 + e1 s + e2 s^2 + e3 s^3
+        double p[kJetSize] = {0.};
+        p[0] = e[0] + s0*(e[1] + s0*(e[2] + s0*e[3]));
+        if(order>=1) p[1] = (e[1] + s0*(2.*e[2] + 3.*s0*e[3]))*ds;
+        if(order>=2) p[2] = (e[2] + 3.*s0*e[3])*ds*ds;
+        if(order>=3) p[3] = e[3]*ds*ds*ds;
+
+        ////    q = 1 + exp(p), exp by the recurrence k x_k = sum_j j p_j x_(k-j)
+        double q[kJetSize];
+        q[0] = std::exp(std::min(p[0], 700.));
+        for(int k=1; k<=order; k++)
+        {
+            double sum = 0.;
+            for(int j=1; j<=std::min(k, 3); j++) sum += j*p[j]*q[k-j];
+            q[k] = sum*kConstants.inverse[k];
+        }
+        q[0] += 1.;
+
+        ////    E = 1/q
+        E[0] = 1./q[0];
+        for(int k=1; k<=order; k++)
+        {
+            double sum = 0.;
+            for(int j=1; j<=k; j++) sum += q[j]*E[k-j];
+            E[k] = -E[0]*sum;
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MultipoleFieldParameters::MultipoleFieldParameters()
+: order(2),
+pseudoOrder(2),
+referenceRadius(5.*cm),
+x0(0.),
+y0(0.),
+zEntrance(-10.*cm),
+zExit(10.*cm),
+engeLength(10.*cm),
+engeRange(3.),
+rMax(5.*cm),
+zMin(-50.*cm),
+zMax(50.*cm)
+{
+    const double defaultEnge[4] = {0., 4., 0., 0.};
+    for(int i=0; i<4; i++)
+    {
+        engeEntrance[i] = defaultEnge[i];
+        engeExit[i] = defaultEnge[i];
+    }
+
+    normal.assign(order, 0.);
+    skew.assign(order, 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool MultipoleFieldParameters::Read(const G4String& filename)
+{
+    std::ifstream file(filename.c_str());
+    if(!file) return false;
+
+    ////    Lengths in mm, fields in tesla
+    std::string line;
+    while(std::getline(file, line))
+    {
+        std::istringstream values(line);
+        std::string keyword;
+
+        if(!(values >> keyword) || keyword[0]=='#') continue;
+
+        if(keyword=="order")                values >> order;
+        else if(keyword=="pseudoOrder")     values >> pseudoOrder;
+        else if(keyword=="referenceRadius") { values >> referenceRadius; referenceRadius *= mm; }
+        else if(keyword=="axis")            { values >> x0 >> y0; x0 *= mm; y0 *= mm; }
+        else if(keyword=="boundaries")      { values >> zEntrance >> zExit; zEntrance *= mm; zExit *= mm; }
+        else if(keyword=="engeLength")      { values >> engeLength; engeLength *= mm; }
+        else if(keyword=="engeRange")       values >> engeRange;
+        else if(keyword=="engeEntrance")    values >> engeEntrance[0] >> engeEntrance[1] >> engeEntrance[2] >> engeEntrance[3];
+        else if(keyword=="engeExit")        values >> engeExit[0] >> engeExit[1] >> engeExit[2] >> engeExit[3];
+        else if(keyword=="validity")        { values >> rMax >> zMin >> zMax; rMax *= mm; zMin *= mm; zMax *= mm; }
+        else if(keyword=="normal" || keyword=="skew")
+        {
+            std::vector<G4double>& coefficients = (keyword=="normal") ? normal : skew;
+            coefficients.clear();
+
+            G4double value;
+            while(values >> value) coefficients.push_back(value*tesla);
+        }
+        else
+        {
+            G4ExceptionDescription msg;
+            msg << "Unknown keyword \"" << keyword << "\" in " << filename << G4endl;
+            G4Exception("MultipoleFieldParameters::Read()", "MultipoleField0001", JustWarning, msg);
+        }
+
+        if(values.fail() && !values.eof()) return false;
+    }
+
+    if(order<1 || order>MultipoleFieldExpansion::kMaxOrder || pseudoOrder<0 || pseudoOrder>MultipoleFieldExpansion::kMaxPseudoOrder
+       || referenceRadius<=0. || engeLength<=0.) return false;
+
+    normal.resize(order, 0.);
+    skew.resize(order, 0.);
+
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool MultipoleFieldParameters::Write(const G4String& filename) const
+{
+    std::ofstream file(filename.c_str());
+    if(!file) return false;
+
+    file << std::setprecision(10)
+    << "# K600 multipole field expansion (see MultipoleFieldExpansion.hh)\n"
+    << "# lengths in mm, fields in tesla\n"
+    << "order " << order << "\n"
+    << "pseudoOrder " << pseudoOrder << "\n"
+    << "referenceRadius " << referenceRadius/mm << "\n"
+    << "axis " << x0/mm << " " << y0/mm << "\n"
+    << "boundaries " << zEntrance/mm << " " << zExit/mm << "\n"
+    << "engeLength " << engeLength/mm << "\n"
+    << "engeRange " << engeRange << "\n"
+    << "engeEntrance " << engeEntrance[0] << " " << engeEntrance[1] << " " << engeEntrance[2] << " " << engeEntrance[3] << "\n"
+    << "engeExit " << engeExit[0] << " " << engeExit[1] << " " << engeExit[2] << " " << engeExit[3] << "\n"
+    << "validity " << rMax/mm << " " << zMin/mm << " " << zMax/mm << "\n";
+
+    file << "normal";
+    for(int n=0; n<order; n++) file << " " << normal[n]/tesla;
+    file << "\nskew";
+    for(int n=0; n<order; n++) file << " " << skew[n]/tesla;
+    file << "\n";
+
+    return file.good();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MultipoleFieldExpansion::MultipoleFieldExpansion(const G4String& filename, G4double zOffset)
+: fZoffset(zOffset),
+fRMax2(0.)
+{
+    if(!fParameters.Read(filename))
+    {
+        G4ExceptionDescription msg;
+        msg << "Cannot read the multipole expansion " << filename << G4endl;
+        G4Exception("MultipoleFieldExpansion::MultipoleFieldExpansion()", "MultipoleField0002", FatalException, msg);
+    }
+
+    G4cout << "MultipoleFieldExpansion: " << filename << ", multipoles up to n = " << fParameters.order
+    << ", pseudo-multipoles up to k = " << fParameters.pseudoOrder << G4endl;
+
+    Setup();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MultipoleFieldExpansion::MultipoleFieldExpansion(const MultipoleFieldParameters& parameters, G4double zOffset)
+: fParameters(parameters),
+fZoffset(zOffset),
+fRMax2(0.)
+{
+    Setup();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MultipoleFieldExpansion::Setup()
+{
+    fParameters.order = std::max(1, std::min(fParameters.order, G4int(kMaxOrder)));
+    fParameters.pseudoOrder = std::max(0, std::min(fParameters.pseudoOrder, G4int(kMaxPseudoOrder)));
+    fParameters.normal.resize(fParameters.order, 0.);
+    fParameters.skew.resize(fParameters.order, 0.);
+
+    fRMax2 = fParameters.rMax*fParameters.rMax;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MultipoleFieldExpansion::GetFieldValue(const G4double point[4], G4double* Bfield) const
+{
+    const G4double x = point[0] - fParameters.x0;
+    const G4double y = point[1] - fParameters.y0;
+    const G4double z = point[2] + fZoffset;
+
+    Bfield[0] = 0.;
+    Bfield[1] = 0.;
+    Bfield[2] = 0.;
+
+    if(x*x + y*y > fRMax2 || z<fParameters.zMin || z>fParameters.zMax) return;
+
+    G4double basis[kMaxBasis][3];
+    const G4int nBasis = EvaluateBasis(fParameters, x, y, z, basis);
+    const G4int order = fParameters.order;
+
+    for(G4int i=0; i<nBasis; i++)
+    {
+        const G4double coefficient = (i<order) ? fParameters.normal[i] : fParameters.skew[i-order];
+        if(coefficient==0.) continue;
+
+        Bfield[0] += coefficient*basis[i][0];
+        Bfield[1] += coefficient*basis[i][1];
+        Bfield[2] += coefficient*basis[i][2];
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int MultipoleFieldExpansion::EvaluateBasis(const MultipoleFieldParameters& parameters,
+                                             G4double x, G4double y, G4double z, G4double (*basis)[3])
+{
+    const G4int order = std::max(1, std::min(parameters.order, G4int(kMaxOrder)));
+    const G4int K = std::max(0, std::min(parameters.pseudoOrder, G4int(kMaxPseudoOrder)));
+    const G4int jetOrder = 2*K + 1;
+    const G4double R = parameters.referenceRadius;
+
+    //------------------------------------------------
+    //      Fringe profile F(t), t = z/R, and its derivatives
+    const G4double scale = R/parameters.engeLength;
+    G4double entrance[kJetSize], exit[kJetSize], F[kJetSize];
+
+    EngeJet(parameters.engeEntrance, (parameters.zEntrance - z)/parameters.engeLength, -scale, parameters.engeRange, jetOrder, entrance);
+    EngeJet(parameters.engeExit, (z - parameters.zExit)/parameters.engeLength, scale, parameters.engeRange, jetOrder, exit);
+
+    for(G4int m=0; m<=jetOrder; m++)
+    {
+        G4double product = 0.;
+        for(G4int j=0; j<=m; j++) product += entrance[j]*exit[m-j];
+
+        F[m] = kConstants.factorial[m]*product;
+    }
+
+    //------------------------------------------------
+    //      Powers of w = (x + iy)/R and |w|^2
+    const G4double u = x/R, v = y/R;
+    const G4double rho = u*u + v*v;
+
+    G4double wRe[kMaxOrder+1], wIm[kMaxOrder+1];
+    wRe[0] = 1.;
+    wIm[0] = 0.;
+    for(G4int n=1; n<=order; n++)
+    {
+        wRe[n] = wRe[n-1]*u - wIm[n-1]*v;
+        wIm[n] = wRe[n-1]*v + wIm[n-1]*u;
+    }
+
+    G4double rhoPower[kMaxPseudoOrder+1];
+    rhoPower[0] = 1.;
+    for(G4int k=1; k<=K; k++) rhoPower[k] = rhoPower[k-1]*rho;
+
+    //------------------------------------------------
+    //      B = (1/n) grad_(u,v,t) of the normalised potential of each multipole
+    for(G4int n=1; n<=order; n++)
+    {
+        const G4double* c = kConstants.coefficient[n];
+        const G4double PRe = wRe[n], PIm = wIm[n];
+        const G4double dPRe = n*wRe[n-1], dPIm = n*wIm[n-1];
+
+        G4double normalU = 0., normalV = 0., normalT = 0.;
+        G4double skewU = 0., skewV = 0., skewT = 0.;
+
+        for(G4int k=0; k<=K; k++)
+        {
+            const G4double cF = c[k]*F[2*k];
+            const G4double cdF = c[k]*F[2*k+1];
+            const G4double rhoK = rhoPower[k];
+            const G4double dRhoK = (k>0) ? 2.*k*rhoPower[k-1] : 0.;
+
+            normalU += cF*(dRhoK*u*PIm + rhoK*dPIm);
+            normalV += cF*(dRhoK*v*PIm + rhoK*dPRe);
+            normalT += cdF*rhoK*PIm;
+
+            skewU += cF*(dRhoK*u*PRe + rhoK*dPRe);
+            skewV += cF*(dRhoK*v*PRe - rhoK*dPIm);
+            skewT += cdF*rhoK*PRe;
+        }
+
+        basis[n-1][0] = normalU;
+        basis[n-1][1] = normalV;
+        basis[n-1][2] = normalT;
+
+        basis[order+n-1][0] = skewU;
+        basis[order+n-1][1] = skewV;
+        basis[order+n-1][2] = skewT;
+    }
+
+    return 2*order;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,304 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "PrimaryEventFile.hh"
+
+#include "G4ios.hh"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const char kPrimaryEventFileMagic[8] = {'K','6','0','0','E','V','T','\0'};
+
+    ////    Files already mapped by this process, shared between the worker threads
+    std::mutex mutex_primaryEventFiles;
+    std::map<G4String, std::weak_ptr<const PrimaryEventFile>> primaryEventFiles;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PrimaryEventFile::PrimaryEventFile()
+: fMapping(0),
+fMappingSize(0),
+fNEvents(0),
+fNParticles(0),
+fEvents(0),
+fParticles(0),
+fNextEvent(0)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PrimaryEventFile::~PrimaryEventFile()
+{
+    if(fMapping) munmap(fMapping, fMappingSize);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::shared_ptr<const PrimaryEventFile> PrimaryEventFile::Open(const G4String& filename)
+{
+    std::lock_guard<std::mutex> lock(mutex_primaryEventFiles);
+
+    std::shared_ptr<const PrimaryEventFile> eventFile = primaryEventFiles[filename].lock();
+
+    if(!eventFile)
+    {
+        std::shared_ptr<PrimaryEventFile> newEventFile(new PrimaryEventFile());
+
+        if(!newEventFile->Map(filename)) return std::shared_ptr<const PrimaryEventFile>();
+
+        G4cout << "PrimaryEventFile: mapped " << newEventFile->fNEvents << " events ("
+        << newEventFile->fNParticles << " particles) from " << filename << G4endl;
+
+        eventFile = newEventFile;
+        primaryEventFiles[filename] = eventFile;
+    }
+
+    return eventFile;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PrimaryEventFile::Map(const G4String& filename)
+{
+    fFileName = filename;
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        G4ExceptionDescription msg;
+        msg << "Cannot open the primary event file " << filename << G4endl;
+        G4Exception("PrimaryEventFile::Map()", "PrimaryEventFile0001", JustWarning, msg);
+        return false;
+    }
+
+    struct stat fileStatus;
+    if(fstat(fd, &fileStatus)!=0 || fileStatus.st_size < (off_t) sizeof(PrimaryEventFileHeader))
+    {
+        close(fd);
+        G4ExceptionDescription msg;
+        msg << filename << " is too short to be a primary event file" << G4endl;
+        G4Exception("PrimaryEventFile::Map()", "PrimaryEventFile0002", JustWarning, msg);
+        return false;
+    }
+
+    fMappingSize = fileStatus.st_size;
+    void* mapping = mmap(0, fMappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(mapping==MAP_FAILED)
+    {
+        G4ExceptionDescription msg;
+        msg << "mmap of " << filename << " failed" << G4endl;
+        G4Exception("PrimaryEventFile::Map()", "PrimaryEventFile0003", JustWarning, msg);
+        return false;
+    }
+
+    fMapping = mapping;
+
+    ////    The threads claim events in order through a shared cursor, front to back
+    madvise(fMapping, fMappingSize, MADV_SEQUENTIAL);
+
+    //------------------------------------------------
+    //      Validate the header and the table extents
+    const PrimaryEventFileHeader* header = static_cast<const PrimaryEventFileHeader*>(fMapping);
+
+    G4bool valid = (std::memcmp(header->magic, kPrimaryEventFileMagic, sizeof(kPrimaryEventFileMagic))==0)
+    && (header->version==kVersion)
+    && (header->headerSize==sizeof(PrimaryEventFileHeader));
+
+    if(valid)
+    {
+        std::uint64_t eventTableEnd = header->eventTableOffset + header->nEvents*sizeof(PrimaryEventRecord);
+        std::uint64_t particleTableEnd = header->particleTableOffset + header->nParticles*sizeof(PrimaryParticleRecord);
+
+        valid = (header->eventTableOffset>=sizeof(PrimaryEventFileHeader))
+        && (header->particleTableOffset>=sizeof(PrimaryEventFileHeader))
+        && (header->eventTableOffset%alignof(PrimaryEventRecord)==0)
+        && (header->particleTableOffset%alignof(PrimaryParticleRecord)==0)
+        && (eventTableEnd<=fMappingSize) && (particleTableEnd<=fMappingSize);
+    }
+
+    if(!valid)
+    {
+        G4ExceptionDescription msg;
+        msg << filename << " is not a valid version " << kVersion << " primary event file" << G4endl;
+        G4Exception("PrimaryEventFile::Map()", "PrimaryEventFile0004", JustWarning, msg);
+        return false;
+    }
+
+    const char* base = static_cast<const char*>(fMapping);
+
+    fNEvents = header->nEvents;
+    fNParticles = header->nParticles;
+    fEvents = reinterpret_cast<const PrimaryEventRecord*>(base + header->eventTableOffset);
+    fParticles = reinterpret_cast<const PrimaryParticleRecord*>(base + header->particleTableOffset);
+
+    ////    A corrupt particle range would otherwise only show up deep inside a run
+    for(std::uint64_t i=0; i<fNEvents; i++)
+    {
+        if(fEvents[i].firstParticle + fEvents[i].nParticles > fNParticles)
+        {
+            G4ExceptionDescription msg;
+            msg << filename << ": event " << i << " refers to particles beyond the particle table" << G4endl;
+            G4Exception("PrimaryEventFile::Map()", "PrimaryEventFile0005", JustWarning, msg);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PrimaryEventFile::NextEvent(std::uint64_t& index) const
+{
+    ////    Past the end the cursor simply keeps counting, so no event is ever handed out twice
+    index = fNextEvent.fetch_add(1, std::memory_order_relaxed);
+
+    return index<fNEvents;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PrimaryEventFileWriter::PrimaryEventFileWriter()
+: fFile(0),
+fNParticles(0)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PrimaryEventFileWriter::~PrimaryEventFileWriter()
+{
+    if(fFile) Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PrimaryEventFileWriter::Open(const G4String& filename)
+{
+    if(fFile) Close();
+
+    fFileName = filename;
+    fEvents.clear();
+    fNParticles = 0;
+
+    fFile = std::fopen(filename.c_str(), "wb");
+    if(!fFile) return false;
+
+    ////    Placeholder header, completed by Close() once the counts are known.
+    ////    The particle table is streamed straight after it.
+    PrimaryEventFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+
+    return std::fwrite(&header, sizeof(header), 1, fFile)==1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryEventFileWriter::BeginEvent(double x, double y, double z, double t, float weight)
+{
+    PrimaryEventRecord event;
+    event.x = x;
+    event.y = y;
+    event.z = z;
+    event.t = t;
+    event.firstParticle = fNParticles;
+    event.nParticles = 0;
+    event.weight = weight;
+
+    fEvents.push_back(event);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryEventFileWriter::AddParticle(std::int32_t pdg, double kineticEnergy,
+                                         double dx, double dy, double dz,
+                                         double time, float weight)
+{
+    if(!fFile || fEvents.empty()) return;
+
+    PrimaryParticleRecord particle;
+    particle.pdg = pdg;
+    particle.weight = weight;
+    particle.kineticEnergy = kineticEnergy;
+    particle.time = time;
+    particle.dx = dx;
+    particle.dy = dy;
+    particle.dz = dz;
+    particle.reserved = 0;
+
+    std::fwrite(&particle, sizeof(particle), 1, fFile);
+
+    fEvents.back().nParticles++;
+    fNParticles++;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PrimaryEventFileWriter::Close()
+{
+    if(!fFile) return false;
+
+    PrimaryEventFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kPrimaryEventFileMagic, sizeof(header.magic));
+    header.version = PrimaryEventFile::kVersion;
+    header.headerSize = sizeof(PrimaryEventFileHeader);
+    header.nEvents = fEvents.size();
+    header.nParticles = fNParticles;
+    header.particleTableOffset = sizeof(PrimaryEventFileHeader);
+    header.eventTableOffset = header.particleTableOffset + fNParticles*sizeof(PrimaryParticleRecord);
+
+    G4bool success = fEvents.empty() || (std::fwrite(&fEvents[0], sizeof(PrimaryEventRecord), fEvents.size(), fFile)==fEvents.size());
+
+    success = success && (std::fseek(fFile, 0, SEEK_SET)==0);
+    success = success && (std::fwrite(&header, sizeof(header), 1, fFile)==1);
+    success = (std::fclose(fFile)==0) && success;
+
+    fFile = 0;
+    fEvents.clear();
+
+    return success;
+}
@@ -35,6 +35,9 @@
 //
 
 #include "PrimaryGeneratorAction.hh"
+#include "PrimaryGeneratorMessenger.hh"
+#include "DetectorConstruction.hh"
+#include "EnergySweepScheduler.hh"
 
 #include "G4RunManager.hh"
 #include "G4LogicalVolumeStore.hh"
@@ -42,6 +45,8 @@
 #include "G4Box.hh"
 #include "G4Event.hh"
 #include "G4ParticleGun.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
 
 #include "G4ParticleTable.hh"
 #include "G4ParticleDefinition.hh"
@@ -76,14 +81,31 @@
 
 #include "EventGenerator.h"
 
+////    Angular correlations of the decay cascade
+#include "alpha0_0plus_0plus_15097_L0.h"
+#include "alpha1_2plus_2plus_15097_L0.h"
+
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-PrimaryGeneratorAction::PrimaryGeneratorAction(EventAction* eventAction)
+PrimaryGeneratorAction::PrimaryGeneratorAction(EventAction* eventAction, DetectorConstruction* detectorConstruction)
 : G4VUserPrimaryGeneratorAction(),
 fParticleGun(0),
-fEventAction(eventAction)
+fEventAction(eventAction),
+fMessenger(0),
+fSource("gun"),
+fCascadeGenerator(0),
+fDetectorConstruction(detectorConstruction),
+fBiasDirections(false),
+fBiasSamplerUpToDate(false),
+fBiasLayoutChanges(0),
+fBiasArrays("all"),
+fBiasRadius_CLOVER(5.0*cm),
+fBiasRadius_LaBr3Ce(3.81*cm),
+fBiasIsotropicFraction(0.1)
 {
+    fMessenger = new PrimaryGeneratorMessenger(this);
+    
     ///////////////////////////////////////////////////////////////
     //          To generate radioactive decay - enabled particles
     ///////////////////////////////////////////////////////////////
@@ -133,8 +155,7 @@ fEventAction(eventAction)
 
     
     //----------------------------------------------------
-    particleN = 0;
-    nEnergies = 0;
+    //      The gun energies of efficiency runs are now scheduled through /K600/sweep/ (EnergySweepScheduler)
     
     //----------------------------------------------------
     /*
@@ -180,17 +201,8 @@ fEventAction(eventAction)
 
     
     //----------------------------------------------------
-    nEnergies += 20;
-    nParticlesPerEnergy = 2000000; // 20000000 particles to be simulated
-    
-    double energyMin = 0.5;
-    double energyMax = 10.0;
-    double energyDivision = ((energyMax-energyMin)/(nEnergies-1));
-    
-    for(int i=0; i<nEnergies; i++)
-    {
-        initialKineticEnergies.push_back(((i*energyDivision) + energyMin)*MeV);
-    }
+    //      e.g. /K600/sweep/range 0.5 10.0 20 MeV
+    //           /K600/sweep/eventsPerEnergy 2000000
     
     
     //================================================================================
@@ -239,6 +251,8 @@ fEventAction(eventAction)
 
 PrimaryGeneratorAction::~PrimaryGeneratorAction()
 {
+    delete fMessenger;
+    delete fCascadeGenerator;
     delete fParticleGun;
 }
 
@@ -246,6 +260,17 @@ PrimaryGeneratorAction::~PrimaryGeneratorAction()
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 {
+    if(fSource=="file")
+    {
+        GeneratePrimariesFromFile(anEvent);
+        return;
+    }
+    else if(fSource=="cascade")
+    {
+        GeneratePrimariesFromCascade(anEvent);
+        return;
+    }
+    
     //================================================================================
     //      EPHEMERAL EVENT GENERATOR
     //================================================================================
@@ -464,18 +489,22 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
     */
     
     //--------------------------------------------------------------------
+    //      Energy sweep (/K600/sweep/), otherwise the fixed gun energy
     
-    G4double initialParticleKineticEnergy = 0.0*MeV;
+    G4double initialParticleKineticEnergy = fParticleGun->GetParticleEnergy();
     
-    int energyN = (int) GetParticleN()/nParticlesPerEnergy;
+    EnergySweepScheduler* energySweep = EnergySweepScheduler::Instance();
     
-    if(energyN<((int) initialKineticEnergies.size()))
-    {
-        initialParticleKineticEnergy = initialKineticEnergies[energyN];
-    }
-    else
+    if(energySweep->IsActive())
     {
-        initialParticleKineticEnergy = 30.0*MeV;
+        if(!energySweep->NextEvent(initialParticleKineticEnergy))
+        {
+            ////    This energy is exhausted or has reached its precision target:
+            ////    the event is marked aborted so that it is not scored
+            anEvent->SetEventAborted();
+            G4RunManager::GetRunManager()->AbortRun(true);
+            return;
+        }
     }
     
     fParticleGun->SetParticleEnergy(initialParticleKineticEnergy);
@@ -510,9 +539,24 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
     //G4ThreeVector direction_gamma0(0, 0, 1.);
     //G4ThreeVector direction_gamma1 = -direction_gamma0;
     
+    ////////////////////////////////////////////////////
+    ////    IMPORTANCE SAMPLED - towards the detector arrays, with a compensating weight
+    
+    G4double eventWeight = 1.0;
+    
+    if(fBiasDirections)
+    {
+        if(!fBiasSamplerUpToDate || (fDetectorConstruction && fBiasLayoutChanges!=fDetectorConstruction->GetLayoutChanges())) SetupBiasedDirectionSampler();
+        eventWeight = fBiasedDirectionSampler.Sample(direction_gamma0);
+    }
+    
+    fEventAction->SetEventWeight(eventWeight);
+    
     fParticleGun->SetParticleMomentumDirection(direction_gamma0);
     fParticleGun->GeneratePrimaryVertex(anEvent); // This generates a particle vertex (essentially produces the particle with all the previous definitions given to fParticleGun)
     
+    anEvent->GetPrimaryVertex(anEvent->GetNumberOfPrimaryVertex()-1)->SetWeight(eventWeight);
+    
     
     //fParticleGun->SetParticleMomentumDirection(direction_gamma1);
     //fParticleGun->GeneratePrimaryVertex(anEvent); // This generates a particle vertex (essentially produces the particle with all the previous definitions given to fParticleGun)
@@ -1578,3 +1622,257 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+
+void PrimaryGeneratorAction::SetSource(const G4String& source)
+{
+    if(source=="file" && !fEventFile)
+    {
+        G4ExceptionDescription msg;
+        msg << "No primary event file has been loaded (/K600/generator/eventFile)." << G4endl;
+        msg << "Keeping the current primary source.";
+        G4Exception("PrimaryGeneratorAction::SetSource()", "PrimaryGenerator0001", JustWarning, msg);
+        return;
+    }
+    
+    if(source=="cascade" && !fCascadeGenerator)
+    {
+        G4ExceptionDescription msg;
+        msg << "No decay cascade has been loaded (/K600/generator/cascadeFile)." << G4endl;
+        msg << "Keeping the current primary source.";
+        G4Exception("PrimaryGeneratorAction::SetSource()", "PrimaryGenerator0007", JustWarning, msg);
+        return;
+    }
+    
+    fSource = source;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::SetEventFile(const G4String& filename)
+{
+    std::shared_ptr<const PrimaryEventFile> eventFile = PrimaryEventFile::Open(filename);
+    
+    if(!eventFile || eventFile->GetNumberOfEvents()==0)
+    {
+        G4ExceptionDescription msg;
+        msg << "The primary event file " << filename << " could not be used.";
+        G4Exception("PrimaryGeneratorAction::SetEventFile()", "PrimaryGenerator0002", JustWarning, msg);
+        return;
+    }
+    
+    ////    The workers share one mapping and claim its events through its atomic cursor,
+    ////    so however the events are balanced between threads each record is used once
+    fEventFile = eventFile;
+    fSource = "file";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::GeneratePrimariesFromFile(G4Event* anEvent)
+{
+    std::uint64_t eventIndex = 0;
+    
+    if(!fEventFile->NextEvent(eventIndex))
+    {
+        ////    Every record of the file has been simulated: records are never reused,
+        ////    the event is marked aborted so that it is not scored and the run ends
+        if(eventIndex==fEventFile->GetNumberOfEvents())
+        {
+            G4ExceptionDescription msg;
+            msg << "All " << fEventFile->GetNumberOfEvents() << " events of " << fEventFile->GetFileName()
+            << " have been used, the run is aborted.";
+            G4Exception("PrimaryGeneratorAction::GeneratePrimariesFromFile()", "PrimaryGenerator0003", JustWarning, msg);
+        }
+        
+        anEvent->SetEventAborted();
+        G4RunManager::GetRunManager()->AbortRun(true);
+        return;
+    }
+    
+    const PrimaryEventRecord& event = fEventFile->GetEvent(eventIndex);
+    
+    const G4ThreeVector position(event.x*mm, event.y*mm, event.z*mm);
+    G4PrimaryVertex* vertex = new G4PrimaryVertex(position, event.t*ns);
+    vertex->SetWeight(event.weight);
+    fEventAction->SetEventWeight(event.weight);
+    
+    ////    Particles emitted with a time offset get their own vertex at the same position, at time t + offset
+    ////    (the proper time of a G4PrimaryParticle would force its decay time instead)
+    std::map<double, G4PrimaryVertex*> delayedVertices;
+    
+    for(std::uint32_t i=0; i<event.nParticles; i++)
+    {
+        const PrimaryParticleRecord& record = fEventFile->GetParticle(event.firstParticle + i);
+        
+        G4ParticleDefinition* particleDefinition = GetParticleDefinition(record.pdg);
+        if(!particleDefinition) continue;
+        
+        G4ThreeVector direction(record.dx, record.dy, record.dz);
+        direction = direction.unit();
+        
+        G4PrimaryParticle* particle = new G4PrimaryParticle(particleDefinition);
+        particle->SetKineticEnergy(record.kineticEnergy*MeV);
+        particle->SetMomentumDirection(direction);
+        particle->SetWeight(record.weight);
+        
+        if(record.time==0.0) vertex->SetPrimary(particle);
+        else
+        {
+            G4PrimaryVertex*& delayedVertex = delayedVertices[record.time];
+            if(!delayedVertex)
+            {
+                delayedVertex = new G4PrimaryVertex(position, (event.t + record.time)*ns);
+                delayedVertex->SetWeight(event.weight);
+            }
+            
+            delayedVertex->SetPrimary(particle);
+        }
+        
+        ////    The ntuple records the first particle of the event
+        if(i==0)
+        {
+            fEventAction->SetInitialParticleKineticEnergy(record.kineticEnergy*MeV);
+            fEventAction->SetInitialParticleTheta(direction.theta()/deg);
+            fEventAction->SetInitialParticlePhi(direction.phi()/deg);
+        }
+    }
+    
+    anEvent->AddPrimaryVertex(vertex);
+    
+    for(std::map<double, G4PrimaryVertex*>::iterator it=delayedVertices.begin(); it!=delayedVertices.end(); ++it)
+    {
+        anEvent->AddPrimaryVertex(it->second);
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ParticleDefinition* PrimaryGeneratorAction::GetParticleDefinition(G4int pdg)
+{
+    std::map<G4int, G4ParticleDefinition*>::iterator it = fParticleDefinitions.find(pdg);
+    if(it!=fParticleDefinitions.end()) return it->second;
+    
+    G4ParticleDefinition* particleDefinition = G4ParticleTable::GetParticleTable()->FindParticle(pdg);
+    
+    ////    Nuclei (100ZZZAAAI) are created on demand by the ion table
+    if(!particleDefinition && pdg>1000000000) particleDefinition = G4IonTable::GetIonTable()->GetIon(pdg);
+    
+    if(!particleDefinition)
+    {
+        G4ExceptionDescription msg;
+        msg << "Unknown PDG code " << pdg << " in the primary event file, the particle is skipped.";
+        G4Exception("PrimaryGeneratorAction::GetParticleDefinition()", "PrimaryGenerator0004", JustWarning, msg);
+    }
+    
+    fParticleDefinitions[pdg] = particleDefinition;
+    
+    return particleDefinition;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PrimaryGeneratorAction::SetCascadeFile(const G4String& filename)
+{
+    ////    The angular correlation tables are shared by all threads: fill them once
+    mutex_EventGeneratorSetup.lock();
+    
+    static bool angularCorrelationsInitialised = false;
+    
+    if(!angularCorrelationsInitialised)
+    {
+        initialiseAngCor_alpha0_0plus_0plus_15097_L0();
+        initialiseAngCor_alpha1_2plus_2plus_15097_L0();
+    }
+    
+    angularCorrelationsInitialised = true;
+    
+    mutex_EventGeneratorSetup.unlock();
+    
+    ////    The reaction, levels, branching ratios and correlations all come from the file:
+    ////    there is no built-in scheme with placeholder branches to fall back on
+    DecayCascadeGenerator* cascadeGenerator = new DecayCascadeGenerator();
+    cascadeGenerator->RegisterAngularTable("alpha0_0plus_0plus_15097_L0", fAngCor_alpha0_0plus_0plus_15097_L0, 181);
+    cascadeGenerator->RegisterAngularTable("alpha1_2plus_2plus_15097_L0", fAngCor_alpha1_2plus_2plus_15097_L0, 181);
+    
+    if(!cascadeGenerator->ReadFile(filename) || !cascadeGenerator->Initialise())
+    {
+        delete cascadeGenerator;
+        return false;
+    }
+    
+    delete fCascadeGenerator;
+    fCascadeGenerator = cascadeGenerator;
+    fSource = "cascade";
+    
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::GeneratePrimariesFromCascade(G4Event* anEvent)
+{
+    fCascadeGenerator->GeneratePrimaries(anEvent, G4ThreeVector(0.,0.,0.));
+    fEventAction->SetEventWeight(1.0);
+    
+    fEventAction->SetInitialParticleKineticEnergy(fCascadeGenerator->GetLastFirstProductEnergy());
+    fEventAction->SetInitialParticleTheta(fCascadeGenerator->GetLastFirstProductTheta());
+    fEventAction->SetInitialParticlePhi(fCascadeGenerator->GetLastFirstProductPhi());
+    fEventAction->SetRecoilExcitationEnergy(fCascadeGenerator->GetLastExcitationEnergy());
+    fEventAction->SetDecayMode(fCascadeGenerator->GetLastDecayPath());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::SetupBiasedDirectionSampler()
+{
+    fBiasedDirectionSampler.Clear();
+    fBiasedDirectionSampler.SetIsotropicFraction(fBiasIsotropicFraction);
+    
+    if(!fDetectorConstruction)
+    {
+        G4Exception("PrimaryGeneratorAction::SetupBiasedDirectionSampler()", "PrimaryGenerator0005", JustWarning,
+                    "No detector construction is available, the directions remain isotropic.");
+        fBiasSamplerUpToDate = true;
+        return;
+    }
+    
+    ////    One cone per active detector, subtending its front face as seen from the target
+    fBiasLayoutChanges = fDetectorConstruction->GetLayoutChanges();
+    
+    if(fBiasArrays=="all" || fBiasArrays=="CLOVER")
+    {
+        std::vector<std::tuple<int, double, double>> angles = fDetectorConstruction->GetAngles_CLOVER();
+        
+        for(size_t i=0; i<angles.size(); i++)
+        {
+            G4int detector = std::get<0>(angles[i]);
+            if(!fDetectorConstruction->GetPresence_CLOVER(detector)) continue;
+            
+            G4ThreeVector axis;
+            axis.setRThetaPhi(1.0, std::get<1>(angles[i])*deg, std::get<2>(angles[i])*deg);
+            fBiasedDirectionSampler.AddCone(axis, atan2(fBiasRadius_CLOVER, fDetectorConstruction->GetDistance_CLOVER(detector)));
+        }
+    }
+    
+    if(fBiasArrays=="all" || fBiasArrays=="LaBr3Ce")
+    {
+        std::vector<std::tuple<int, double, double>> angles = fDetectorConstruction->GetAngles_ALBA_LaBr3Ce();
+        
+        for(size_t i=0; i<angles.size(); i++)
+        {
+            G4int detector = std::get<0>(angles[i]);
+            if(!fDetectorConstruction->GetPresence_ALBA_LaBr3Ce(detector)) continue;
+            
+            G4ThreeVector axis;
+            axis.setRThetaPhi(1.0, std::get<1>(angles[i])*deg, std::get<2>(angles[i])*deg);
+            fBiasedDirectionSampler.AddCone(axis, atan2(fBiasRadius_LaBr3Ce, fDetectorConstruction->GetDistance_ALBA_LaBr3Ce(detector)));
+        }
+    }
+    
+    G4cout << "PrimaryGeneratorAction: biasing the gun direction towards " << fBiasedDirectionSampler.GetNumberOfCones()
+    << " detectors (isotropic fraction " << fBiasedDirectionSampler.GetIsotropicFraction() << ")" << G4endl;
+    
+    fBiasSamplerUpToDate = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,175 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "PrimaryGeneratorMessenger.hh"
+#include "PrimaryGeneratorAction.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PrimaryGeneratorMessenger::PrimaryGeneratorMessenger(PrimaryGeneratorAction* primaryGeneratorAction)
+: G4UImessenger(),
+fPrimaryGeneratorAction(primaryGeneratorAction)
+{
+    fGeneratorDirectory = new G4UIdirectory("/K600/generator/");
+    fGeneratorDirectory->SetGuidance("Selection of the primary event source.");
+
+    fSourceCmd = new G4UIcmdWithAString("/K600/generator/source", this);
+    fSourceCmd->SetGuidance("Select the primary event source:");
+    fSourceCmd->SetGuidance("  gun  - the built-in particle gun / event generator");
+    fSourceCmd->SetGuidance("  file - pre-generated events (see /K600/generator/eventFile)");
+    fSourceCmd->SetGuidance("  cascade - reaction followed by its decay cascade (see /K600/generator/cascadeFile)");
+    fSourceCmd->SetParameterName("source", false);
+    fSourceCmd->SetCandidates("gun file cascade");
+    fSourceCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fEventFileCmd = new G4UIcmdWithAString("/K600/generator/eventFile", this);
+    fEventFileCmd->SetGuidance("Memory-map a pre-generated primary event file and select it as the source.");
+    fEventFileCmd->SetGuidance("The worker threads share one cursor: every event is simulated once, and the run");
+    fEventFileCmd->SetGuidance("is aborted when the file is exhausted.");
+    fEventFileCmd->SetParameterName("filename", false);
+    fEventFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fCascadeFileCmd = new G4UIcmdWithAString("/K600/generator/cascadeFile", this);
+    fCascadeFileCmd->SetGuidance("Read a reaction and its decay scheme (levels, branching ratios, angular");
+    fCascadeFileCmd->SetGuidance("correlations) from a cascade file and select it as the source.");
+    fCascadeFileCmd->SetGuidance("A file with a missing or placeholder (?) branching ratio is refused.");
+    fCascadeFileCmd->SetParameterName("filename", false);
+    fCascadeFileCmd->AvailableForStates(G4State_Idle);
+
+    //------------------------------------------------
+    //      Importance sampling of the gun direction
+    fBiasDirectory = new G4UIdirectory("/K600/generator/bias/");
+    fBiasDirectory->SetGuidance("Bias the particle gun direction towards the active detector arrays.");
+    fBiasDirectory->SetGuidance("Each event carries a compensating weight (ntuple column EventWeight).");
+
+    fBiasEnableCmd = new G4UIcmdWithABool("/K600/generator/bias/enable", this);
+    fBiasEnableCmd->SetGuidance("Enable/disable direction biasing of the particle gun.");
+    fBiasEnableCmd->SetParameterName("enable", true);
+    fBiasEnableCmd->SetDefaultValue(true);
+    fBiasEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fBiasArraysCmd = new G4UIcmdWithAString("/K600/generator/bias/arrays", this);
+    fBiasArraysCmd->SetGuidance("Detector arrays the directions are biased towards.");
+    fBiasArraysCmd->SetParameterName("arrays", false);
+    fBiasArraysCmd->SetCandidates("all CLOVER LaBr3Ce");
+    fBiasArraysCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fBiasIsotropicFractionCmd = new G4UIcmdWithADouble("/K600/generator/bias/isotropicFraction", this);
+    fBiasIsotropicFractionCmd->SetGuidance("Fraction of the primaries that are still emitted isotropically.");
+    fBiasIsotropicFractionCmd->SetParameterName("fraction", false);
+    fBiasIsotropicFractionCmd->SetRange("fraction>0. && fraction<=1.");
+    fBiasIsotropicFractionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fBiasRadiusCLOVERCmd = new G4UIcmdWithADoubleAndUnit("/K600/generator/bias/radiusCLOVER", this);
+    fBiasRadiusCLOVERCmd->SetGuidance("Effective front-face radius of a CLOVER, defining its sampling cone.");
+    fBiasRadiusCLOVERCmd->SetParameterName("radius", false);
+    fBiasRadiusCLOVERCmd->SetRange("radius>0.");
+    fBiasRadiusCLOVERCmd->SetUnitCategory("Length");
+    fBiasRadiusCLOVERCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fBiasRadiusLaBr3CeCmd = new G4UIcmdWithADoubleAndUnit("/K600/generator/bias/radiusLaBr3Ce", this);
+    fBiasRadiusLaBr3CeCmd->SetGuidance("Effective front-face radius of a LaBr3:Ce detector, defining its sampling cone.");
+    fBiasRadiusLaBr3CeCmd->SetParameterName("radius", false);
+    fBiasRadiusLaBr3CeCmd->SetRange("radius>0.");
+    fBiasRadiusLaBr3CeCmd->SetUnitCategory("Length");
+    fBiasRadiusLaBr3CeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PrimaryGeneratorMessenger::~PrimaryGeneratorMessenger()
+{
+    delete fSourceCmd;
+    delete fEventFileCmd;
+    delete fCascadeFileCmd;
+    delete fBiasEnableCmd;
+    delete fBiasArraysCmd;
+    delete fBiasIsotropicFractionCmd;
+    delete fBiasRadiusCLOVERCmd;
+    delete fBiasRadiusLaBr3CeCmd;
+    delete fBiasDirectory;
+    delete fGeneratorDirectory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if(command==fSourceCmd)
+    {
+        fPrimaryGeneratorAction->SetSource(newValue);
+    }
+    else if(command==fEventFileCmd)
+    {
+        fPrimaryGeneratorAction->SetEventFile(newValue);
+    }
+    else if(command==fCascadeFileCmd)
+    {
+        ////    Failing the command stops a batch macro before it runs with another source
+        if(!fPrimaryGeneratorAction->SetCascadeFile(newValue))
+        {
+            G4ExceptionDescription msg;
+            msg << "The cascade file " << newValue << " could not be used, the current primary source is kept.";
+            command->CommandFailed(msg);
+        }
+    }
+    else if(command==fBiasEnableCmd)
+    {
+        fPrimaryGeneratorAction->SetDirectionBiasing(G4UIcmdWithABool::GetNewBoolValue(newValue));
+    }
+    else if(command==fBiasArraysCmd)
+    {
+        fPrimaryGeneratorAction->SetBiasArrays(newValue);
+    }
+    else if(command==fBiasIsotropicFractionCmd)
+    {
+        fPrimaryGeneratorAction->SetBiasIsotropicFraction(G4UIcmdWithADouble::GetNewDoubleValue(newValue));
+    }
+    else if(command==fBiasRadiusCLOVERCmd)
+    {
+        fPrimaryGeneratorAction->SetBiasRadius_CLOVER(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue));
+    }
+    else if(command==fBiasRadiusLaBr3CeCmd)
+    {
+        fPrimaryGeneratorAction->SetBiasRadius_LaBr3Ce(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue));
+    }
+}
@@ -36,9 +36,12 @@
 
 #include "RunAction.hh"
 #include "Analysis.hh"
+#include "EnergySweepScheduler.hh"
+#include "K600PhysicsList.hh"
 
 #include "G4Run.hh"
 #include "G4RunManager.hh"
+#include "G4RunManagerKernel.hh"
 #include "G4UnitsTable.hh"
 #include "G4SystemOfUnits.hh"
 
@@ -150,6 +153,9 @@ RunAction::RunAction()
     analysisManager->CreateNtupleDColumn(0, "LaBr3Ce_yPos", laBr3Ce_yPos); // cm (relative to the target/origin)
     analysisManager->CreateNtupleDColumn(0, "LaBr3Ce_zPos", laBr3Ce_zPos); // cm (relative to the target/origin)
     
+    //--------------------------------
+    //      Statistical weight of the event (1 unless the primaries are biased)
+    analysisManager->CreateNtupleDColumn(0, "EventWeight");
     
     analysisManager->FinishNtuple(0);
     
@@ -203,8 +209,23 @@ RunAction::~RunAction()
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void RunAction::BeginOfRunAction(const G4Run* /*run*/)
+void RunAction::BeginOfRunAction(const G4Run* run)
 {
+    if(IsMaster())
+    {
+        ////    The physics tables are built just before the first run: its beginning closes the
+        ////    initialisation (anything run between /run/initialize and the first /run/beamOn is included)
+        K600PhysicsList* physicsList = dynamic_cast<K600PhysicsList*>(G4RunManagerKernel::GetRunManagerKernel()->GetPhysicsList());
+        if(physicsList && run->GetRunID()==0)
+        {
+            physicsList->StopInitialisationTimer();
+            G4cout << "\n Initialisation (/run/initialize and physics tables) with the " << physicsList->GetConfiguration()
+            << " physics: " << physicsList->GetInitialisationTime() << " s" << G4endl;
+        }
+        
+        fRunTimer.Start();
+    }
+    
     //inform the runManager to save random number seed
     //G4RunManager::GetRunManager()->SetRandomNumberStore(true);
     
@@ -212,15 +233,26 @@ void RunAction::BeginOfRunAction(const G4Run* /*run*/)
     G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
     
     // Open an output file
-    //
+    //  (one file per energy during an energy sweep)
     G4String fileName = "K600Output";
+    if(EnergySweepScheduler::Instance()->IsActive()) fileName = EnergySweepScheduler::Instance()->GetOutputFileName();
     analysisManager->OpenFile(fileName);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void RunAction::EndOfRunAction(const G4Run* /*run*/)
+void RunAction::EndOfRunAction(const G4Run* run)
 {
+    if(IsMaster() && run->GetNumberOfEvent()>0)
+    {
+        fRunTimer.Stop();
+        const K600PhysicsList* physicsList = dynamic_cast<const K600PhysicsList*>(G4RunManager::GetRunManager()->GetUserPhysicsList());
+        
+        G4cout << "\n Run " << run->GetRunID() << ": " << run->GetNumberOfEvent() << " events in "
+        << fRunTimer.GetRealElapsed() << " s, " << run->GetNumberOfEvent()/fRunTimer.GetRealElapsed() << " events/s";
+        if(physicsList) G4cout << " (" << physicsList->GetConfiguration() << " physics)";
+        G4cout << G4endl;
+    }
     
     G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
     
@@ -259,6 +291,9 @@ void RunAction::EndOfRunAction(const G4Run* /*run*/)
      }
      */
     
+    // merge this thread's energy sweep tallies (also the master in a sequential build; a no-op for the MT master)
+    if(EnergySweepScheduler::Instance()->IsActive()) EnergySweepScheduler::Instance()->FlushThread();
+    
     // save histograms & ntuple
     //
     analysisManager->Write();
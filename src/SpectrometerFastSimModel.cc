@@ -0,0 +1,126 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "SpectrometerFastSimModel.hh"
+
+#include "G4FastTrack.hh"
+#include "G4FastStep.hh"
+#include "G4Track.hh"
+#include "G4DynamicParticle.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SpectrometerFastSimModel::SpectrometerFastSimModel(const G4String& name, G4Region* envelope, const G4String& transferMapFile)
+: G4VFastSimulationModel(name, envelope),
+fTransferMapLoaded(false),
+fPlaneTolerance(1.0e-3*mm)
+{
+    fTransferMapLoaded = fTransferMap.Read(transferMapFile);
+    
+    if(!fTransferMapLoaded)
+    {
+        G4ExceptionDescription description;
+        description << "Cannot read the transfer map " << transferMapFile << ", the spectrometer is tracked in full." << G4endl;
+        G4Exception("SpectrometerFastSimModel::SpectrometerFastSimModel()", "TransferMap0002", JustWarning, description);
+    }
+    
+    for(G4int i=0; i<SpectrometerTransferMap::kNumberOfCoordinates; i++) fExitCoordinates[i] = 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SpectrometerFastSimModel::~SpectrometerFastSimModel()
+{
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool SpectrometerFastSimModel::IsApplicable(const G4ParticleDefinition& particle)
+{
+    return fTransferMapLoaded && particle.GetPDGCharge()!=0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool SpectrometerFastSimModel::ModelTrigger(const G4FastTrack& fastTrack)
+{
+    const TransferMapPlane& entryPlane = fTransferMap.GetEntryPlane();
+    
+    ////    Only at the entry plane, moving downstream
+    const G4ThreeVector position = fastTrack.GetPrimaryTrackLocalPosition();
+    const G4ThreeVector direction = fastTrack.GetPrimaryTrackLocalDirection();
+    
+    if(std::abs((position - entryPlane.origin).dot(entryPlane.zAxis))>fPlaneTolerance) return false;
+    if(direction.dot(entryPlane.zAxis)<=0.) return false;
+    
+    const G4DynamicParticle* particle = fastTrack.GetPrimaryTrack()->GetDynamicParticle();
+    const G4double charge = std::abs(particle->GetCharge()/eplus);
+    if(charge<=0.) return false;
+    
+    G4double entryCoordinates[SpectrometerTransferMap::kNumberOfCoordinates];
+    entryPlane.ToPhaseSpace(position, direction, entryCoordinates[0], entryCoordinates[1], entryCoordinates[2], entryCoordinates[3]);
+    entryCoordinates[4] = (particle->GetTotalMomentum()/charge)/fTransferMap.GetReferenceRigidity() - 1.0;
+    
+    return fTransferMap.Evaluate(entryCoordinates, fExitCoordinates);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SpectrometerFastSimModel::DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep)
+{
+    const G4Track* track = fastTrack.GetPrimaryTrack();
+    const G4DynamicParticle* particle = track->GetDynamicParticle();
+    
+    G4ThreeVector position, direction;
+    fTransferMap.GetExitPlane().FromPhaseSpace(fExitCoordinates[0], fExitCoordinates[1], fExitCoordinates[2], fExitCoordinates[3],
+                                               position, direction);
+    
+    const G4double pathLength = fExitCoordinates[4];
+    const G4double momentum = particle->GetTotalMomentum();
+    const G4double velocity = c_light*momentum/particle->GetTotalEnergy();
+    
+    ////    Transport in vacuum: only position, direction and time change
+    fastStep.ProposePrimaryTrackFinalPosition(position, true);
+    fastStep.ProposePrimaryTrackFinalMomentumDirection(direction, true);
+    fastStep.ProposePrimaryTrackPathLength(pathLength);
+    fastStep.ProposePrimaryTrackFinalTime(track->GetGlobalTime() + pathLength/velocity);
+    fastStep.ProposePrimaryTrackFinalProperTime(track->GetProperTime() + pathLength*particle->GetMass()/(momentum*c_light));
+}
@@ -0,0 +1,454 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "SpectrometerTransferMap.hh"
+
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+    
+    const G4int kN = SpectrometerTransferMap::kNumberOfCoordinates;
+    
+    void ReadPlane(std::istream& values, TransferMapPlane& plane)
+    {
+        G4double v[12];
+        for(G4int i=0; i<12; i++) values >> v[i];
+        
+        plane.origin.set(v[0]*mm, v[1]*mm, v[2]*mm);
+        plane.xAxis.set(v[3], v[4], v[5]);
+        plane.yAxis.set(v[6], v[7], v[8]);
+        plane.zAxis.set(v[9], v[10], v[11]);
+    }
+    
+    void WritePlane(std::ostream& file, const TransferMapPlane& plane)
+    {
+        file << " " << plane.origin.x()/mm << " " << plane.origin.y()/mm << " " << plane.origin.z()/mm
+        << "  " << plane.xAxis.x() << " " << plane.xAxis.y() << " " << plane.xAxis.z()
+        << "  " << plane.yAxis.x() << " " << plane.yAxis.y() << " " << plane.yAxis.z()
+        << "  " << plane.zAxis.x() << " " << plane.zAxis.y() << " " << plane.zAxis.z() << "\n";
+    }
+    
+    ////    Solves the symmetric positive definite system A x = b in place (A: n x n, b: n x nRhs)
+    G4bool SolveCholesky(std::vector<G4double>& A, std::vector<G4double>& b, G4int n, G4int nRhs)
+    {
+        for(G4int j=0; j<n; j++)
+        {
+            G4double diagonal = A[j*n + j];
+            for(G4int k=0; k<j; k++) diagonal -= A[j*n + k]*A[j*n + k];
+            if(diagonal<=0.) return false;
+            
+            const G4double Ljj = std::sqrt(diagonal);
+            A[j*n + j] = Ljj;
+            
+            for(G4int i=j+1; i<n; i++)
+            {
+                G4double sum = A[i*n + j];
+                for(G4int k=0; k<j; k++) sum -= A[i*n + k]*A[j*n + k];
+                A[i*n + j] = sum/Ljj;
+            }
+        }
+        
+        for(G4int r=0; r<nRhs; r++)
+        {
+            ////    L y = b, then L^T x = y
+            for(G4int i=0; i<n; i++)
+            {
+                G4double sum = b[i*nRhs + r];
+                for(G4int k=0; k<i; k++) sum -= A[i*n + k]*b[k*nRhs + r];
+                b[i*nRhs + r] = sum/A[i*n + i];
+            }
+            
+            for(G4int i=n-1; i>=0; i--)
+            {
+                G4double sum = b[i*nRhs + r];
+                for(G4int k=i+1; k<n; k++) sum -= A[k*n + i]*b[k*nRhs + r];
+                b[i*nRhs + r] = sum/A[i*n + i];
+            }
+        }
+        
+        return true;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TransferMapPlane::ToPhaseSpace(const G4ThreeVector& position, const G4ThreeVector& direction,
+                                    G4double& x, G4double& a, G4double& y, G4double& b) const
+{
+    const G4ThreeVector offset = position - origin;
+    const G4double dz = direction.dot(zAxis);
+    
+    x = offset.dot(xAxis);
+    y = offset.dot(yAxis);
+    a = direction.dot(xAxis)/dz;
+    b = direction.dot(yAxis)/dz;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TransferMapPlane::FromPhaseSpace(G4double x, G4double a, G4double y, G4double b,
+                                      G4ThreeVector& position, G4ThreeVector& direction) const
+{
+    position = origin + x*xAxis + y*yAxis;
+    direction = (a*xAxis + b*yAxis + zAxis).unit();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SpectrometerTransferMap::SpectrometerTransferMap()
+: fOrder(0),
+fReferenceRigidity(0.)
+{
+    for(G4int i=0; i<kN; i++)
+    {
+        fCentre[i] = 0.;
+        fHalfWidth[i] = 1.;
+    }
+    
+    for(G4int i=0; i<4; i++) fExitRange[i] = 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SpectrometerTransferMap::SetPlanes(const TransferMapPlane& entryPlane, const TransferMapPlane& exitPlane)
+{
+    fEntryPlane = entryPlane;
+    fExitPlane = exitPlane;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SpectrometerTransferMap::BuildExponents(G4int order)
+{
+    fOrder = order;
+    fExponents.clear();
+    
+    ////    Graded order: all terms of total order 0, then 1, ...
+    for(G4int total=0; total<=order; total++)
+    {
+        for(G4int e0=total; e0>=0; e0--)
+            for(G4int e1=total-e0; e1>=0; e1--)
+                for(G4int e2=total-e0-e1; e2>=0; e2--)
+                    for(G4int e3=total-e0-e1-e2; e3>=0; e3--)
+                    {
+                        const G4int e4 = total-e0-e1-e2-e3;
+                        fExponents.push_back(e0);
+                        fExponents.push_back(e1);
+                        fExponents.push_back(e2);
+                        fExponents.push_back(e3);
+                        fExponents.push_back(e4);
+                    }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool SpectrometerTransferMap::Fit(const std::vector<TransferMapSample>& samples, G4int order, G4double referenceRigidity)
+{
+    if(order<1 || order>kMaxOrder || referenceRigidity<=0. || samples.empty()) return false;
+    
+    fReferenceRigidity = referenceRigidity;
+    BuildExponents(order);
+    
+    const G4int nTerms = G4int(fExponents.size())/kN;
+    const G4int nSamples = G4int(samples.size());
+    if(nSamples<2*nTerms) return false;
+    
+    ////    Inputs with delta in place of the rigidity
+    std::vector<G4double> inputs(nSamples*kN);
+    for(G4int s=0; s<nSamples; s++)
+    {
+        for(G4int i=0; i<4; i++) inputs[s*kN + i] = samples[s].in[i];
+        inputs[s*kN + 4] = samples[s].in[4]/referenceRigidity - 1.0;
+    }
+    
+    ////    Fitted domain
+    for(G4int i=0; i<kN; i++)
+    {
+        G4double minimum = inputs[i], maximum = inputs[i];
+        for(G4int s=1; s<nSamples; s++)
+        {
+            minimum = std::min(minimum, inputs[s*kN + i]);
+            maximum = std::max(maximum, inputs[s*kN + i]);
+        }
+        
+        fCentre[i] = 0.5*(minimum + maximum);
+        fHalfWidth[i] = std::max(0.5*(maximum - minimum), 1.0e-12);
+    }
+    
+    fExitRange[0] = fExitRange[1] = samples[0].out[0];
+    fExitRange[2] = fExitRange[3] = samples[0].out[2];
+    for(G4int s=1; s<nSamples; s++)
+    {
+        fExitRange[0] = std::min(fExitRange[0], samples[s].out[0]);
+        fExitRange[1] = std::max(fExitRange[1], samples[s].out[0]);
+        fExitRange[2] = std::min(fExitRange[2], samples[s].out[2]);
+        fExitRange[3] = std::max(fExitRange[3], samples[s].out[2]);
+    }
+    
+    ////    Normal equations in the scaled inputs
+    std::vector<G4double> normalMatrix(nTerms*nTerms, 0.);
+    std::vector<G4double> rightHandSide(nTerms*kN, 0.);
+    std::vector<G4double> monomials(nTerms);
+    G4double powers[kN][kMaxOrder+1];
+    
+    for(G4int s=0; s<nSamples; s++)
+    {
+        for(G4int i=0; i<kN; i++)
+        {
+            const G4double u = (inputs[s*kN + i] - fCentre[i])/fHalfWidth[i];
+            powers[i][0] = 1.;
+            for(G4int k=1; k<=order; k++) powers[i][k] = powers[i][k-1]*u;
+        }
+        
+        for(G4int t=0; t<nTerms; t++)
+        {
+            const G4int* e = &fExponents[t*kN];
+            monomials[t] = powers[0][e[0]]*powers[1][e[1]]*powers[2][e[2]]*powers[3][e[3]]*powers[4][e[4]];
+        }
+        
+        for(G4int t=0; t<nTerms; t++)
+        {
+            const G4double m = monomials[t];
+            for(G4int u=0; u<=t; u++) normalMatrix[t*nTerms + u] += m*monomials[u];
+            for(G4int j=0; j<kN; j++) rightHandSide[t*kN + j] += m*samples[s].out[j];
+        }
+    }
+    
+    ////    Symmetrise, with a tiny ridge against exactly degenerate sample sets
+    G4double trace = 0.;
+    for(G4int t=0; t<nTerms; t++) trace += normalMatrix[t*nTerms + t];
+    for(G4int t=0; t<nTerms; t++)
+    {
+        normalMatrix[t*nTerms + t] += 1.0e-12*trace/nTerms;
+        for(G4int u=0; u<t; u++) normalMatrix[u*nTerms + t] = normalMatrix[t*nTerms + u];
+    }
+    
+    if(!SolveCholesky(normalMatrix, rightHandSide, nTerms, kN)) return false;
+    
+    fCoefficients = rightHandSide;
+    
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool SpectrometerTransferMap::Evaluate(const G4double* in, G4double* out) const
+{
+    if(fCoefficients.empty()) return false;
+    
+    G4double powers[kN][kMaxOrder+1];
+    for(G4int i=0; i<kN; i++)
+    {
+        const G4double u = (in[i] - fCentre[i])/fHalfWidth[i];
+        if(std::abs(u)>1.0) return false;
+        
+        powers[i][0] = 1.;
+        for(G4int k=1; k<=fOrder; k++) powers[i][k] = powers[i][k-1]*u;
+    }
+    
+    for(G4int j=0; j<kN; j++) out[j] = 0.;
+    
+    const G4int nTerms = GetNumberOfTerms();
+    for(G4int t=0; t<nTerms; t++)
+    {
+        const G4int* e = &fExponents[t*kN];
+        const G4double m = powers[0][e[0]]*powers[1][e[1]]*powers[2][e[2]]*powers[3][e[3]]*powers[4][e[4]];
+        const G4double* c = &fCoefficients[t*kN];
+        
+        for(G4int j=0; j<kN; j++) out[j] += c[j]*m;
+    }
+    
+    return out[0]>=fExitRange[0] && out[0]<=fExitRange[1] && out[2]>=fExitRange[2] && out[2]<=fExitRange[3];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool SpectrometerTransferMap::Read(const G4String& filename)
+{
+    std::ifstream file(filename.c_str());
+    if(!file) return false;
+    
+    fCoefficients.clear();
+    fExponents.clear();
+    
+    ////    Lengths in mm, rigidities in MeV/c per unit charge
+    std::string line;
+    while(std::getline(file, line))
+    {
+        std::istringstream values(line);
+        std::string keyword;
+        
+        if(!(values >> keyword) || keyword[0]=='#') continue;
+        
+        if(keyword=="order")                    values >> fOrder;
+        else if(keyword=="referenceRigidity")   { values >> fReferenceRigidity; fReferenceRigidity *= MeV; }
+        else if(keyword=="entryPlane")          ReadPlane(values, fEntryPlane);
+        else if(keyword=="exitPlane")           ReadPlane(values, fExitPlane);
+        else if(keyword=="domain")              { for(G4int i=0; i<kN; i++) values >> fCentre[i] >> fHalfWidth[i]; }
+        else if(keyword=="exitRange")           values >> fExitRange[0] >> fExitRange[1] >> fExitRange[2] >> fExitRange[3];
+        else if(keyword=="term")
+        {
+            G4int e[kN];
+            G4double c[kN];
+            for(G4int i=0; i<kN; i++) values >> e[i];
+            for(G4int j=0; j<kN; j++) values >> c[j];
+            
+            fExponents.insert(fExponents.end(), e, e + kN);
+            fCoefficients.insert(fCoefficients.end(), c, c + kN);
+        }
+        else
+        {
+            G4ExceptionDescription msg;
+            msg << "Unknown keyword \"" << keyword << "\" in " << filename << G4endl;
+            G4Exception("SpectrometerTransferMap::Read()", "TransferMap0001", JustWarning, msg);
+        }
+        
+        if(values.fail() && !values.eof()) return false;
+    }
+    
+    if(fOrder<1 || fOrder>kMaxOrder || fReferenceRigidity<=0. || fCoefficients.empty()) return false;
+    
+    for(size_t i=0; i<fExponents.size(); i++)
+    {
+        if(fExponents[i]<0 || fExponents[i]>fOrder) return false;
+    }
+    
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool SpectrometerTransferMap::Write(const G4String& filename) const
+{
+    std::ofstream file(filename.c_str());
+    if(!file) return false;
+    
+    file << std::setprecision(15)
+    << "# K600 spectrometer transfer map (see SpectrometerTransferMap.hh)\n"
+    << "# lengths in mm, rigidity in MeV/c per unit charge; inputs x a y b delta, outputs x a y b l\n"
+    << "order " << fOrder << "\n"
+    << "referenceRigidity " << fReferenceRigidity/MeV << "\n";
+    
+    file << "entryPlane";
+    WritePlane(file, fEntryPlane);
+    file << "exitPlane";
+    WritePlane(file, fExitPlane);
+    
+    file << "domain";
+    for(G4int i=0; i<kN; i++) file << " " << fCentre[i] << " " << fHalfWidth[i];
+    file << "\nexitRange " << fExitRange[0] << " " << fExitRange[1] << " " << fExitRange[2] << " " << fExitRange[3] << "\n";
+    
+    const G4int nTerms = GetNumberOfTerms();
+    for(G4int t=0; t<nTerms; t++)
+    {
+        file << "term";
+        for(G4int i=0; i<kN; i++) file << " " << fExponents[t*kN + i];
+        for(G4int j=0; j<kN; j++) file << " " << fCoefficients[t*kN + j];
+        file << "\n";
+    }
+    
+    return file.good();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SpectrometerTransferMap::WriteSampleHeader(std::ostream& file, const TransferMapPlane& entryPlane, const TransferMapPlane& exitPlane)
+{
+    file << std::setprecision(12)
+    << "# K600 transfer-map samples (see SpectrometerTransferMap.hh)\n"
+    << "# x a y b rigidity  ->  x a y b l   (mm, MeV/c per unit charge)\n";
+    
+    file << "entryPlane";
+    WritePlane(file, entryPlane);
+    file << "exitPlane";
+    WritePlane(file, exitPlane);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SpectrometerTransferMap::WriteSample(std::ostream& file, const TransferMapSample& sample)
+{
+    file << sample.in[0]/mm << " " << sample.in[1] << " " << sample.in[2]/mm << " " << sample.in[3] << " " << sample.in[4]/MeV
+    << "  " << sample.out[0]/mm << " " << sample.out[1] << " " << sample.out[2]/mm << " " << sample.out[3] << " " << sample.out[4]/mm << "\n";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool SpectrometerTransferMap::ReadSamples(const G4String& filename, std::vector<TransferMapSample>& samples,
+                                            TransferMapPlane& entryPlane, TransferMapPlane& exitPlane)
+{
+    std::ifstream file(filename.c_str());
+    if(!file) return false;
+    
+    std::string line;
+    while(std::getline(file, line))
+    {
+        std::istringstream values(line);
+        std::string keyword;
+        
+        if(!(values >> keyword) || keyword[0]=='#') continue;
+        
+        if(keyword=="entryPlane")       ReadPlane(values, entryPlane);
+        else if(keyword=="exitPlane")   ReadPlane(values, exitPlane);
+        else
+        {
+            std::istringstream row(line);
+            TransferMapSample sample;
+            
+            row >> sample.in[0] >> sample.in[1] >> sample.in[2] >> sample.in[3] >> sample.in[4]
+            >> sample.out[0] >> sample.out[1] >> sample.out[2] >> sample.out[3] >> sample.out[4];
+            if(row.fail()) return false;
+            
+            sample.in[0] *= mm;
+            sample.in[2] *= mm;
+            sample.in[4] *= MeV;
+            sample.out[0] *= mm;
+            sample.out[2] *= mm;
+            sample.out[4] *= mm;
+            
+            samples.push_back(sample);
+        }
+    }
+    
+    return true;
+}
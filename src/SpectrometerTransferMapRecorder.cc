@@ -0,0 +1,149 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+#include "SpectrometerTransferMapRecorder.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4StepPoint.hh"
+#include "G4VTouchable.hh"
+#include "G4NavigationHistory.hh"
+#include "G4AffineTransform.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Threading.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SpectrometerTransferMapRecorder::SpectrometerTransferMapRecorder(const G4VPhysicalVolume* envelope,
+                                                                 const TransferMapPlane& entryPlane, const TransferMapPlane& exitPlane,
+                                                                 const G4String& filename)
+: fEnvelope(envelope),
+fEntryPlane(entryPlane),
+fExitPlane(exitPlane),
+fPlaneTolerance(1.0e-3*mm),
+fNSamples(0)
+{
+    std::ostringstream threadFilename;
+    threadFilename << filename;
+    if(G4Threading::G4GetThreadId()>=0) threadFilename << "." << G4Threading::G4GetThreadId();
+    
+    fFile.open(threadFilename.str().c_str());
+    
+    if(!fFile)
+    {
+        G4ExceptionDescription description;
+        description << "Cannot write the transfer-map samples to " << threadFilename.str() << G4endl;
+        G4Exception("SpectrometerTransferMapRecorder::SpectrometerTransferMapRecorder()", "TransferMap0003", JustWarning, description);
+    }
+    else SpectrometerTransferMap::WriteSampleHeader(fFile, fEntryPlane, fExitPlane);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SpectrometerTransferMapRecorder::~SpectrometerTransferMapRecorder()
+{
+    fFile.close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool SpectrometerTransferMapRecorder::IsInsideEnvelope(const G4StepPoint* stepPoint) const
+{
+    ////    The envelope is placed directly in the world (depth 1); its daughters count as inside
+    const G4VTouchable* touchable = stepPoint->GetTouchable();
+    if(!touchable || !stepPoint->GetPhysicalVolume()) return false;
+    
+    const G4NavigationHistory* history = touchable->GetHistory();
+    return history->GetDepth()>=1 && history->GetVolume(1)==fEnvelope;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SpectrometerTransferMapRecorder::Record(const G4Step* step)
+{
+    const G4StepPoint* preStepPoint = step->GetPreStepPoint();
+    const G4StepPoint* postStepPoint = step->GetPostStepPoint();
+    
+    if(postStepPoint->GetStepStatus()!=fGeomBoundary || !fFile) return;
+    
+    const G4Track* track = step->GetTrack();
+    const G4double charge = std::abs(track->GetDynamicParticle()->GetCharge()/eplus);
+    if(charge<=0.) return;
+    
+    const G4bool preInside = IsInsideEnvelope(preStepPoint);
+    const G4bool postInside = IsInsideEnvelope(postStepPoint);
+    if(preInside==postInside) return;
+    
+    ////    World -> envelope coordinates, from whichever point is inside
+    const G4AffineTransform& toEnvelope = (postInside ? postStepPoint : preStepPoint)->GetTouchable()->GetHistory()->GetTransform(1);
+    const G4ThreeVector position = toEnvelope.TransformPoint(postStepPoint->GetPosition());
+    const G4ThreeVector direction = toEnvelope.TransformAxis(postStepPoint->GetMomentumDirection());
+    
+    if(postInside)
+    {
+        ////    Entering
+        if(std::abs((position - fEntryPlane.origin).dot(fEntryPlane.zAxis))>fPlaneTolerance) return;
+        if(direction.dot(fEntryPlane.zAxis)<=0.) return;
+        
+        TransferMapSample& sample = fOpenSamples[track->GetTrackID()];
+        fEntryPlane.ToPhaseSpace(position, direction, sample.in[0], sample.in[1], sample.in[2], sample.in[3]);
+        sample.in[4] = postStepPoint->GetMomentum().mag()/charge;
+        sample.out[4] = track->GetTrackLength();
+    }
+    else
+    {
+        ////    Leaving
+        std::map<G4int, TransferMapSample>::iterator open = fOpenSamples.find(track->GetTrackID());
+        if(open==fOpenSamples.end()) return;
+        
+        TransferMapSample sample = open->second;
+        fOpenSamples.erase(open);
+        
+        if(std::abs((position - fExitPlane.origin).dot(fExitPlane.zAxis))>fPlaneTolerance) return;
+        if(direction.dot(fExitPlane.zAxis)<=0.) return;
+        
+        fExitPlane.ToPhaseSpace(position, direction, sample.out[0], sample.out[1], sample.out[2], sample.out[3]);
+        sample.out[4] = track->GetTrackLength() - sample.out[4];
+        
+        SpectrometerTransferMap::WriteSample(fFile, sample);
+        fNSamples++;
+    }
+}
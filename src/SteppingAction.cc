@@ -37,6 +37,8 @@
 #include "SteppingAction.hh"
 #include "EventAction.hh"
 #include "DetectorConstruction.hh"
+#include "DetectorParameterisations.hh"
+#include "SpectrometerTransferMapRecorder.hh"
 #include "G4SystemOfUnits.hh"
 
 #include "G4Step.hh"
@@ -47,7 +49,9 @@
 SteppingAction::SteppingAction(const DetectorConstruction* detectorConstruction, EventAction* eventAction)
 : G4UserSteppingAction(),
 fDetConstruction(detectorConstruction),
-fEventAction(eventAction)
+fEventAction(eventAction),
+fTransferMapRecorder(0),
+fTransferMapRecorderChecked(false)
 {
     
 }
@@ -56,12 +60,31 @@ fEventAction(eventAction)
 
 SteppingAction::~SteppingAction()
 {
+    delete fTransferMapRecorder;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void SteppingAction::UserSteppingAction(const G4Step* aStep)
 {
+    ////////////////////////////////////////////
+    //      K600 SPECTROMETER - TRANSFER MAP SAMPLES
+    ////////////////////////////////////////////
+    
+    if(!fTransferMapRecorderChecked)
+    {
+        fTransferMapRecorderChecked = true;
+        if(fDetConstruction->GetSpectrometerEnvelope() && !fDetConstruction->GetTransferMapSampleFile().empty())
+        {
+            fTransferMapRecorder = new SpectrometerTransferMapRecorder(fDetConstruction->GetSpectrometerEnvelope(),
+                                                                       fDetConstruction->GetTransferMapEntryPlane(),
+                                                                       fDetConstruction->GetTransferMapExitPlane(),
+                                                                       fDetConstruction->GetTransferMapSampleFile());
+        }
+    }
+    
+    if(fTransferMapRecorder) fTransferMapRecorder->Record(aStep);
+    
     G4StepPoint* preStepPoint = aStep->GetPreStepPoint();
     G4TouchableHandle theTouchable = preStepPoint->GetTouchableHandle();
     
@@ -105,7 +128,8 @@ void SteppingAction::UserSteppingAction(const G4Step* aStep)
         {
             //G4cout << "Here we are in the Stepping Action" << G4endl;
             
-            channelID = volume->GetCopyNo();
+            ////    The pixels are parameterised: the channel comes from the touchable, not the shared volume
+            channelID = CAKEPixelParameterisation::GetChannel(theTouchable());
             
             CAKENo = channelID/128;
             CAKE_RowNo = (channelID - (CAKENo*128))/8;
@@ -160,15 +184,18 @@ void SteppingAction::UserSteppingAction(const G4Step* aStep)
     
     if(interactiontime < VDC_TotalSampledTime)
     {
-        if(volumeName == "VDC_SenseRegion_USDS")
+        if(volumeName == "VDC_SenseRegion_USDS" || volumeName == "VDC_WirePlane")
         {
-            WireChamberNo = volume->GetCopyNo();
+            ////    The wire planes are gas envelopes of the parameterised wires: use their sense region
+            G4int senseRegionDepth = (volumeName == "VDC_WirePlane") ? 1 : 0;
+            
+            WireChamberNo = theTouchable->GetVolume(senseRegionDepth)->GetCopyNo();
             
             iTS = interactiontime/PADDLE_SamplingTime;
             edepVDC = aStep->GetTotalEnergyDeposit()/keV;
             
             worldPosition = preStepPoint->GetPosition();
-            localPosition = theTouchable->GetHistory()->GetTopTransform().TransformPoint(worldPosition);
+            localPosition = theTouchable->GetHistory()->GetTransform(theTouchable->GetHistoryDepth() - senseRegionDepth).TransformPoint(worldPosition);
             
             G4int cellNo = 0;
             G4int bufferNo = 0;
@@ -429,7 +456,8 @@ void SteppingAction::UserSteppingAction(const G4Step* aStep)
         if((((GA_CAKE && (volumeName=="CAKE_AA_RS" || volumeName=="CAKE_SiliconWafer")) || (GA_W1 && (volumeName=="W1_AA"))) && ((GA_LineOfSightMODE && fEventAction->GA_GetLineOfSight()==true) || !GA_LineOfSightMODE)) || (volumeName == "World" && GA_GenInputVar))
         {
             
-            channelID = volume->GetCopyNo();
+            if(volumeName == "CAKE_AA_RS") channelID = CAKEPixelParameterisation::GetChannel(theTouchable());
+            else channelID = volume->GetCopyNo();
             worldPosition = preStepPoint->GetPosition();
             //worldPosition = worldPosition.unit();
             
@@ -0,0 +1,260 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+//      Checks the channel numbering of the CAKE pixels
+//
+//      The 128 ring-sector pixels of a CAKE wafer are one G4PVParameterised, so
+//      the copy number of that volume is only the copy the navigator evaluated
+//      last. SteppingAction therefore takes the channel from the touchable of
+//      the pre-step point (CAKEPixelParameterisation::GetChannel()).
+//
+//      The geometry is built with the Spectrometer layout (CAKE, VDC 1 and the
+//      magnets). A geantino ray is fired at every pixel of every wafer, along
+//      the normal of the wafer, and the channel of the touchable where the ray
+//      enters CAKE_AA_RS must be i*128 + sector + 8*ring of that pixel, i being
+//      the copy number of the wafer. The ray then steps on through the pixel,
+//      as the next step of a track would. The check counts how often the copy
+//      number of the volume itself no longer names the pixel hit. That count is
+//      a report, not a failure.
+//
+//      Exit code 2 if a ray misses its pixel or scores in another channel.
+//
+//      Usage: CAKEChannelValidator
+//
+
+#include "DetectorConstruction.hh"
+#include "DetectorParameterisations.hh"
+
+#include "G4GeometryManager.hh"
+#include "G4Navigator.hh"
+#include "G4TouchableHistory.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPVParameterisation.hh"
+#include "G4VSolid.hh"
+#include "G4AffineTransform.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ThreeVector.hh"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+    
+    ////    Distance in front of the pixel the rays start from
+    const G4double kStandOff = 5.*mm;
+    const G4int kMaxSteps = 1000;
+    
+    ////    The pixels of a CAKE wafer, and the transformation wafer -> world
+    struct Wafer
+    {
+        G4int               copyNo;
+        G4VPhysicalVolume*  pixels;
+        G4AffineTransform   transform;
+    };
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    ////    The wafers under logical, whose transformation to the world is transform
+    void FindWafers(const G4LogicalVolume* logical, const G4AffineTransform& transform, std::vector<Wafer>& wafers)
+    {
+        for(std::size_t i=0; i<logical->GetNoDaughters(); i++)
+        {
+            G4VPhysicalVolume* daughter = logical->GetDaughter(G4int(i));
+            if(daughter->IsReplicated()) continue;
+            
+            const G4AffineTransform daughterTransform = G4AffineTransform(daughter->GetRotation(), daughter->GetTranslation())*transform;
+            
+            if(daughter->GetName()=="CAKE_SiliconWafer")
+            {
+                const G4LogicalVolume* waferLogical = daughter->GetLogicalVolume();
+                for(std::size_t j=0; j<waferLogical->GetNoDaughters(); j++)
+                {
+                    G4VPhysicalVolume* pixels = waferLogical->GetDaughter(G4int(j));
+                    if(pixels->GetName()!="CAKE_AA_RS" || !pixels->IsParameterised()) continue;
+                    
+                    Wafer wafer = {daughter->GetCopyNo(), pixels, daughterTransform};
+                    wafers.push_back(wafer);
+                }
+            }
+            
+            FindWafers(daughter->GetLogicalVolume(), daughterTransform, wafers);
+        }
+    }
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    ////    A point well inside a pixel: of a grid over its bounding box, in the mid-plane,
+    ////    the one farthest from the edges of the pixel (in x and y)
+    G4bool InteriorPoint(const G4VSolid* solid, G4ThreeVector& point)
+    {
+        G4ThreeVector lower, upper;
+        solid->BoundingLimits(lower, upper);
+        
+        const G4int n = 32;
+        const G4ThreeVector directions[4] = {G4ThreeVector(1., 0., 0.), G4ThreeVector(-1., 0., 0.), G4ThreeVector(0., 1., 0.), G4ThreeVector(0., -1., 0.)};
+        G4double largest = 0.;
+        
+        for(G4int i=0; i<n; i++)
+        {
+            for(G4int j=0; j<n; j++)
+            {
+                const G4ThreeVector p(lower.x() + (i + 0.5)*(upper.x() - lower.x())/n,
+                                      lower.y() + (j + 0.5)*(upper.y() - lower.y())/n,
+                                      0.5*(lower.z() + upper.z()));
+                if(solid->Inside(p)!=kInside) continue;
+                
+                G4double depth = kInfinity;
+                for(G4int k=0; k<4; k++) depth = std::min(depth, solid->DistanceToOut(p, directions[k]));
+                
+                if(depth>largest)
+                {
+                    largest = depth;
+                    point = p;
+                }
+            }
+        }
+        
+        return largest>0.;
+    }
+}
+
+int main(int argc, char**)
+{
+    if(argc>1)
+    {
+        G4cerr << " Usage: CAKEChannelValidator" << G4endl;
+        return 1;
+    }
+    
+    //------------------------------------------------
+    //      Geometry
+    DetectorConstruction* detectorConstruction = new DetectorConstruction();
+    detectorConstruction->SetBenchmarkLayout("Spectrometer");
+    G4VPhysicalVolume* world = detectorConstruction->Construct();
+    G4GeometryManager::GetInstance()->CloseGeometry(true);
+    
+    std::vector<Wafer> wafers;
+    FindWafers(world->GetLogicalVolume(), G4AffineTransform(), wafers);
+    
+    if(wafers.empty())
+    {
+        G4cerr << "CAKEChannelValidator: no CAKE wafer in the geometry" << G4endl;
+        return 2;
+    }
+    
+    G4Navigator navigator;
+    navigator.SetWorldVolume(world);
+    
+    G4int nPixels = 0, nMissed = 0, nWrong = 0, nStale = 0;
+    
+    for(std::size_t w=0; w<wafers.size(); w++)
+    {
+        const Wafer& wafer = wafers[w];
+        G4VPVParameterisation* parameterisation = wafer.pixels->GetParameterisation();
+        
+        for(G4int n=0; n<wafer.pixels->GetMultiplicity(); n++)
+        {
+            ////    The pixel, in the world: its interior point is the target of the ray
+            wafer.pixels->SetCopyNo(n);
+            const G4VSolid* solid = parameterisation->ComputeSolid(n, wafer.pixels);
+            parameterisation->ComputeTransformation(n, wafer.pixels);
+            const G4AffineTransform pixelTransform = G4AffineTransform(wafer.pixels->GetRotation(), wafer.pixels->GetTranslation())*wafer.transform;
+            
+            G4ThreeVector point;
+            if(!InteriorPoint(solid, point))
+            {
+                G4cout << " wafer " << wafer.copyNo << ", pixel " << n << ": no interior point found, skipped" << G4endl;
+                continue;
+            }
+            
+            nPixels++;
+            
+            const G4int expected = 128*wafer.copyNo + n;
+            const G4ThreeVector direction = pixelTransform.TransformAxis(G4ThreeVector(0., 0., 1.)).unit();
+            G4ThreeVector position = pixelTransform.TransformPoint(point) - kStandOff*direction;
+            
+            ////    Transportation only, until the ray enters a pixel
+            G4VPhysicalVolume* volume = navigator.LocateGlobalPointAndSetup(position, &direction, false, false);
+            for(G4int step=0; volume && volume->GetName()!="CAKE_AA_RS" && step<kMaxSteps; step++)
+            {
+                G4double safety = 0.;
+                const G4double length = navigator.ComputeStep(position, direction, kInfinity, safety);
+                if(length>=kInfinity)
+                {
+                    volume = 0;
+                    break;
+                }
+                
+                position += length*direction;
+                navigator.SetGeometricallyLimitedStep();
+                volume = navigator.LocateGlobalPointAndSetup(position, &direction, true);
+            }
+            
+            if(!volume || volume->GetName()!="CAKE_AA_RS")
+            {
+                G4cout << " wafer " << wafer.copyNo << ", pixel " << n << " (channel " << expected << "): missed" << G4endl;
+                nMissed++;
+                continue;
+            }
+            
+            G4TouchableHistory* touchable = navigator.CreateTouchableHistory();
+            const G4int channel = CAKEPixelParameterisation::GetChannel(touchable);
+            
+            ////    As the next step of the track: the navigator evaluates the neighbouring copies
+            G4double safety = 0.;
+            navigator.ComputeStep(position, direction, kInfinity, safety);
+            if(128*wafer.copyNo + touchable->GetVolume()->GetCopyNo()!=expected) nStale++;
+            
+            if(channel!=expected)
+            {
+                G4cout << " wafer " << wafer.copyNo << ", pixel " << n << " (channel " << expected << "): scored in channel " << channel << G4endl;
+                nWrong++;
+            }
+            
+            delete touchable;
+        }
+    }
+    
+    G4cout << "\n CAKEChannelValidator: " << nPixels << " pixels in " << wafers.size() << " wafers, "
+    << nWrong << " scored in another channel, " << nMissed << " missed\n"
+    << " (the copy number of the parameterised volume no longer named the pixel after the next step for "
+    << nStale << " of them)\n" << G4endl;
+    
+    G4GeometryManager::GetInstance()->OpenGeometry();
+    
+    return (nWrong>0 || nMissed>0) ? 2 : 0;
+}
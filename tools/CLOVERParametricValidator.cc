@@ -0,0 +1,318 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+//      Validates the parametric CLOVER solids (CLOVERParametricGeometry)
+//      against the meshes they replace: the HPGe crystals, their lithium
+//      contacts and the BGO crystals of the shield.
+//
+//      For every solid it compares
+//
+//          - the volume, from random points of the bounding box of the mesh
+//            classified by both solids (with the misclassified fraction);
+//          - the distance from the surface of the mesh to that of the CSG
+//            solid, along the mesh normals at random points of its facets;
+//          - the distance from the surface of the CSG solid (GetPointOnSurface())
+//            to that of the mesh;
+//          - the calls per second of Inside().
+//
+//      It fails (exit code 2) if a volume or a largest distance is out of tolerance.
+//
+//      Usage: CLOVERParametricValidator [options] CLOVER-mesh-directory
+//
+//      e.g.   CLOVERParametricValidator ../K600-ALBA/Mesh-Models/DETECTORS/CLOVER
+//
+//      Options:
+//          -probes <n>         random points for the volumes (default 1000000)
+//          -points <n>         surface points of each solid (default 10000)
+//          -volume <f>         largest relative volume difference (default 0.005)
+//          -distance <mm>      largest surface distance (default 0.1 mm)
+//
+
+#include "CLOVERParametricGeometry.hh"
+#include "MeshDecimation.hh"
+
+#include "G4TessellatedSolid.hh"
+#include "G4TriangularFacet.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ThreeVector.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+namespace {
+    
+    void PrintUsage()
+    {
+        G4cerr << " Usage: CLOVERParametricValidator [-probes n] [-points n] [-volume f] [-distance mm] CLOVER-mesh-directory" << G4endl;
+    }
+    
+    G4ThreeVector Vertex(const TriangleMesh& mesh, std::uint32_t i)
+    {
+        return G4ThreeVector(mesh.vertices[3*i], mesh.vertices[3*i + 1], mesh.vertices[3*i + 2])*mm;
+    }
+    
+    G4TessellatedSolid* BuildSolid(const TriangleMesh& mesh, const G4String& name)
+    {
+        G4TessellatedSolid* solid = new G4TessellatedSolid(name);
+        for(std::size_t t=0; t<mesh.GetNumberOfTriangles(); t++)
+        {
+            const std::uint32_t* i = &mesh.triangles[3*t];
+            G4TriangularFacet* facet = new G4TriangularFacet(Vertex(mesh, i[0]), Vertex(mesh, i[1]), Vertex(mesh, i[2]), ABSOLUTE);
+            if(!solid->AddFacet(facet)) delete facet;
+        }
+        solid->SetSolidClosed(true);
+        return solid;
+    }
+    
+    struct Comparison
+    {
+        double  meshVolume;             // exact, of the mesh
+        double  volumeDifference;       // relative, from the same random points
+        double  mismatch;               // misclassified volume, relative to that of the mesh
+        double  meshToSolidMean, meshToSolidMax;
+        double  solidToMeshMean, solidToMeshMax;
+        double  meshInsideRate, solidInsideRate;
+    };
+    
+    ////    Distance from p, on the surface of the mesh with outward normal, to the surface of solid
+    double DistanceToSolid(const G4VSolid* solid, const G4ThreeVector& p, const G4ThreeVector& normal)
+    {
+        const EInside inside = solid->Inside(p);
+        if(inside==kSurface) return 0.;
+        
+        double distance = (inside==kInside) ? solid->DistanceToOut(p, normal) : solid->DistanceToIn(p, -normal);
+        if(distance>=kInfinity) distance = (inside==kInside) ? solid->DistanceToOut(p) : solid->DistanceToIn(p);
+        return distance;
+    }
+    
+    Comparison Compare(const TriangleMesh& mesh, G4TessellatedSolid* meshSolid, const G4VSolid* solid,
+                       std::size_t nProbes, std::size_t nPoints, std::mt19937_64& engine)
+    {
+        Comparison result;
+        result.meshVolume = mesh.GetVolume()*mm3;
+        std::uniform_real_distribution<double> uniform(0., 1.);
+        
+        //------------------------------------------------
+        //      Volumes, from random points of the bounding box enlarged by 10%
+        G4ThreeVector lower(kInfinity, kInfinity, kInfinity), upper(-kInfinity, -kInfinity, -kInfinity);
+        for(std::size_t i=0; i<mesh.GetNumberOfVertices(); i++)
+        {
+            const G4ThreeVector p = Vertex(mesh, i);
+            lower = G4ThreeVector(std::min(lower.x(), p.x()), std::min(lower.y(), p.y()), std::min(lower.z(), p.z()));
+            upper = G4ThreeVector(std::max(upper.x(), p.x()), std::max(upper.y(), p.y()), std::max(upper.z(), p.z()));
+        }
+        const G4ThreeVector size = 1.1*(upper - lower);
+        lower -= 0.05*(upper - lower);
+        
+        std::vector<G4ThreeVector> probes(nProbes);
+        for(std::size_t i=0; i<nProbes; i++)
+        {
+            probes[i] = lower + G4ThreeVector(uniform(engine)*size.x(), uniform(engine)*size.y(), uniform(engine)*size.z());
+        }
+        
+        std::vector<bool> meshInside(nProbes), solidInside(nProbes);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(std::size_t i=0; i<nProbes; i++) meshInside[i] = (meshSolid->Inside(probes[i])!=kOutside);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        result.meshInsideRate = nProbes/elapsed.count();
+        
+        start = std::chrono::steady_clock::now();
+        for(std::size_t i=0; i<nProbes; i++) solidInside[i] = (solid->Inside(probes[i])!=kOutside);
+        elapsed = std::chrono::steady_clock::now() - start;
+        result.solidInsideRate = nProbes/elapsed.count();
+        
+        long nMesh = 0, nSolid = 0, nMismatches = 0;
+        for(std::size_t i=0; i<nProbes; i++)
+        {
+            nMesh += meshInside[i];
+            nSolid += solidInside[i];
+            nMismatches += (meshInside[i]!=solidInside[i]);
+        }
+        result.volumeDifference = double(nSolid - nMesh)/std::max(nMesh, 1L);
+        result.mismatch = double(nMismatches)/std::max(nMesh, 1L);
+        
+        //------------------------------------------------
+        //      Mesh -> CSG: random points of the facets, by area
+        std::vector<double> cumulativeArea(mesh.GetNumberOfTriangles());
+        double area = 0.;
+        for(std::size_t t=0; t<mesh.GetNumberOfTriangles(); t++)
+        {
+            const std::uint32_t* i = &mesh.triangles[3*t];
+            area += 0.5*(Vertex(mesh, i[1]) - Vertex(mesh, i[0])).cross(Vertex(mesh, i[2]) - Vertex(mesh, i[0])).mag();
+            cumulativeArea[t] = area;
+        }
+        
+        result.meshToSolidMean = result.meshToSolidMax = 0.;
+        for(std::size_t n=0; n<nPoints; n++)
+        {
+            const std::size_t t = std::min(std::size_t(std::lower_bound(cumulativeArea.begin(), cumulativeArea.end(), uniform(engine)*area)
+                                                        - cumulativeArea.begin()), cumulativeArea.size() - 1);
+            const std::uint32_t* i = &mesh.triangles[3*t];
+            const G4ThreeVector a = Vertex(mesh, i[0]), b = Vertex(mesh, i[1]), c = Vertex(mesh, i[2]);
+            const G4ThreeVector normal = (b - a).cross(c - a).unit();
+            
+            double u = uniform(engine), v = uniform(engine);
+            if(u + v>1.)
+            {
+                u = 1. - u;
+                v = 1. - v;
+            }
+            const double distance = DistanceToSolid(solid, a + u*(b - a) + v*(c - a), normal);
+            result.meshToSolidMean += distance/nPoints;
+            result.meshToSolidMax = std::max(result.meshToSolidMax, distance);
+        }
+        
+        //------------------------------------------------
+        //      CSG -> mesh
+        result.solidToMeshMean = result.solidToMeshMax = 0.;
+        for(std::size_t n=0; n<nPoints; n++)
+        {
+            const G4ThreeVector p = solid->GetPointOnSurface();
+            const EInside inside = meshSolid->Inside(p);
+            double distance = 0.;
+            if(inside==kInside) distance = meshSolid->SafetyFromInside(p, true);
+            else if(inside==kOutside) distance = meshSolid->SafetyFromOutside(p, true);
+            
+            result.solidToMeshMean += distance/nPoints;
+            result.solidToMeshMax = std::max(result.solidToMeshMax, distance);
+        }
+        
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t nProbes = 1000000;
+    std::size_t nPoints = 10000;
+    double maxVolumeDifference = 0.005;
+    double maxDistance = 0.1*mm;
+    std::vector<G4String> directories;
+    
+    for(int i=1; i<argc; i++)
+    {
+        const G4String argument = argv[i];
+        const bool hasValue = (i+1<argc);
+        
+        if(argument=="-probes" && hasValue)         nProbes = std::strtoul(argv[++i], 0, 10);
+        else if(argument=="-points" && hasValue)    nPoints = std::strtoul(argv[++i], 0, 10);
+        else if(argument=="-volume" && hasValue)    maxVolumeDifference = std::atof(argv[++i]);
+        else if(argument=="-distance" && hasValue)  maxDistance = std::atof(argv[++i])*mm;
+        else if(argument.size()>1 && argument[0]=='-')
+        {
+            PrintUsage();
+            return 1;
+        }
+        else directories.push_back(argument);
+    }
+    
+    if(directories.size()!=1 || nProbes==0 || nPoints==0)
+    {
+        PrintUsage();
+        return 1;
+    }
+    
+    std::mt19937_64 engine(4357);
+    G4bool passed = true;
+    
+    G4cout << "\n " << std::left << std::setw(56) << "mesh" << std::right << std::setw(10) << "facets"
+    << std::setw(12) << "V cm3" << std::setw(10) << "dV %" << std::setw(12) << "mismatch %"
+    << std::setw(16) << "mesh->CSG mm" << std::setw(16) << "CSG->mesh mm" << std::setw(18) << "Inside M/s" << G4endl;
+    
+    for(G4int kind=0; kind<3; kind++)
+    {
+        const G4int nSolids = (kind==2) ? G4int(CLOVERParametricGeometry::kNumberOfShieldCrystals) : G4int(CLOVERParametricGeometry::kNumberOfCrystals);
+        
+        for(G4int n=0; n<nSolids; n++)
+        {
+            std::ostringstream meshName;
+            G4VSolid* solid = 0;
+            if(kind==0)
+            {
+                meshName << "HPGe-Crystals/HPGe_pureCylindricalBorehole_RoundedCrystal" << n + 1 << "_10um.ply";
+                solid = CLOVERParametricGeometry::HPGeCrystal("HPGeCrystal", n, G4ThreeVector());
+            }
+            else if(kind==1)
+            {
+                meshName << "HPGe-Crystals/HPGe_pureCylindricalBorehole_LithiumContact" << n + 1 << "_10um.ply";
+                solid = CLOVERParametricGeometry::LithiumContact("LithiumContact", n, G4ThreeVector());
+            }
+            else
+            {
+                meshName << "Shield/BGO-Crystals/BGO-Crystal_Modified_" << n + 1 << ".ply";
+                solid = CLOVERParametricGeometry::BGOCrystal("BGOCrystal", n, G4ThreeVector());
+            }
+            
+            TriangleMesh mesh;
+            if(!mesh.ReadPLY(directories[0] + "/" + meshName.str()))
+            {
+                G4cerr << "CLOVERParametricValidator: cannot read " << directories[0] << "/" << meshName.str() << G4endl;
+                return 1;
+            }
+            mesh.WeldVertices();
+            G4TessellatedSolid* meshSolid = BuildSolid(mesh, meshName.str());
+            
+            const Comparison result = Compare(mesh, meshSolid, solid, nProbes, nPoints, engine);
+            const G4bool solidPassed = std::fabs(result.volumeDifference)<=maxVolumeDifference
+            && result.meshToSolidMax<=maxDistance && result.solidToMeshMax<=maxDistance;
+            if(!solidPassed) passed = false;
+            
+            const std::string name = meshName.str().substr(meshName.str().rfind('/') + 1);
+            G4cout << " " << std::left << std::setw(56) << name << std::right << std::setw(10) << mesh.GetNumberOfTriangles()
+            << std::fixed << std::setprecision(3)
+            << std::setw(12) << result.meshVolume/cm3 << std::setw(10) << 100.*result.volumeDifference
+            << std::setw(12) << 100.*result.mismatch
+            << std::setw(8) << result.meshToSolidMean/mm << std::setw(8) << result.meshToSolidMax/mm
+            << std::setw(8) << result.solidToMeshMean/mm << std::setw(8) << result.solidToMeshMax/mm
+            << std::setw(9) << result.meshInsideRate/1e6 << std::setw(9) << result.solidInsideRate/1e6
+            << (solidPassed ? "" : "  FAILED") << G4endl;
+            G4cout.unsetf(std::ios::fixed);
+            G4cout << std::setprecision(6);
+            
+            delete meshSolid;
+        }
+    }
+    
+    G4cout << "\n Validation:            " << (passed ? "passed" : "FAILED") << " (volume within " << 100.*maxVolumeDifference
+    << "%, surfaces within " << maxDistance/mm << " mm)\n" << G4endl;
+    
+    return passed ? 0 : 2;
+}
@@ -0,0 +1,138 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+//      Converts text field-map tables (.TABLE) into the binary cache read by
+//      MagneticFieldMapData, e.g. ahead of a batch of jobs in a read-only area.
+//
+//      Usage: FieldMapConverter [options] table.TABLE [cache.bin]
+//             (the cache defaults to the name looked up at run time for the same options)
+//
+//      Options (see MagneticFieldMapOptions):
+//          -f32                    single precision cells
+//          -quadrupole             mirror planes x = 0 and y = 0 of a quadrupole
+//          -dipole                 midplane y = 0 of a dipole with its field along y
+//          -mirror <a><s><s><s>    mirror plane a = 0 with the parities of Bx, By, Bz, e.g. -mirror z++-
+//          -tile <n>               Morton-ordered tiles of n^3 cells (n rounded up to a power of two)
+//
+
+#include "MagneticFieldMapData.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    void PrintUsage()
+    {
+        G4cerr << " Usage: FieldMapConverter [-f32] [-quadrupole] [-dipole] [-mirror <a><s><s><s>] [-tile <n>] table.TABLE [cache.bin]" << G4endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    MagneticFieldMapOptions options;
+    std::vector<G4String> files;
+    
+    for(int i=1; i<argc; i++)
+    {
+        const G4String argument = argv[i];
+        
+        if(argument=="-f32") options.singlePrecision = true;
+        else if(argument=="-quadrupole" || argument=="-dipole")
+        {
+            const MagneticFieldMapOptions symmetry = (argument=="-quadrupole") ?
+            MagneticFieldMapOptions::Quadrupole() : MagneticFieldMapOptions::DipoleMidplane();
+            
+            for(int a=0; a<3; a++)
+            {
+                if(symmetry.mirror[a]) options.SetMirror(a, symmetry.parity[a][0], symmetry.parity[a][1], symmetry.parity[a][2]);
+            }
+        }
+        else if(argument=="-mirror" && i+1<argc)
+        {
+            const char* plane = argv[++i];
+            const char* axis = (std::strlen(plane)==4) ? std::strchr("xyz", plane[0]) : 0;
+            
+            if(!axis || !std::strchr("+-", plane[1]) || !std::strchr("+-", plane[2]) || !std::strchr("+-", plane[3]))
+            {
+                PrintUsage();
+                return 1;
+            }
+            
+            options.SetMirror(int(axis - "xyz"), (plane[1]=='-') ? -1 : 1, (plane[2]=='-') ? -1 : 1, (plane[3]=='-') ? -1 : 1);
+        }
+        else if(argument=="-tile" && i+1<argc)
+        {
+            options.tileSize = std::atoi(argv[++i]);
+            
+            if(options.tileSize<1)
+            {
+                PrintUsage();
+                return 1;
+            }
+        }
+        else if(argument.size()>1 && argument[0]=='-')
+        {
+            PrintUsage();
+            return 1;
+        }
+        else files.push_back(argument);
+    }
+    
+    if(files.size()<1 || files.size()>2)
+    {
+        PrintUsage();
+        return 1;
+    }
+    
+    const G4String tableFile = files[0];
+    const G4String cacheFile = (files.size()>1) ? files[1] : MagneticFieldMapData::GetCacheFileName(tableFile, options);
+    
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    
+    if(!MagneticFieldMapData::WriteCache(tableFile, cacheFile, options))
+    {
+        G4cerr << "FieldMapConverter: conversion of " << tableFile << " failed" << G4endl;
+        return 1;
+    }
+    
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    
+    G4cout << "FieldMapConverter: " << tableFile << " -> " << cacheFile
+    << " (" << elapsed.count() << " s)" << G4endl;
+    
+    return 0;
+}
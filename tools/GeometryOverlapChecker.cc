@@ -0,0 +1,377 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+//      Checks the full geometry of DetectorConstruction for overlaps, in
+//      parallel: the fCheckOverlaps of the placements is off, as the serial
+//      G4PVPlacement::CheckOverlaps() of every volume takes too long.
+//
+//      The geometry is constructed once. Every daughter of every logical
+//      volume (every copy of a parameterised volume) is then checked as
+//      CheckOverlaps() does, on the available cores, volume by volume:
+//
+//          - random points of its surface (GetPointOnSurface()) outside the
+//            mother: the volume protrudes from its mother;
+//          - the same points inside a sister volume (a daughter of the same
+//            mother whose bounding box contains them): the volumes overlap.
+//            A sister lying completely inside the volume is found by the
+//            check of the sister.
+//
+//      Each clash is reported once, with the number of points, the largest
+//      depth and the position of the deepest point in the frame of the mother.
+//      Logical volumes placed more than once are checked once. Exit code 2 if
+//      there are clashes.
+//
+//      Usage: GeometryOverlapChecker [options]
+//
+//      e.g.   GeometryOverlapChecker -points 100000 -tolerance 0.001
+//
+//      Options:
+//          -points <n>         surface points of each volume (default 10000)
+//          -tolerance <mm>     largest depth that is not a clash (default 0)
+//          -threads <n>        threads (default: one per core)
+//          -volume <name>      only the volumes of this (physical) name, and its sisters
+//
+
+#include "DetectorConstruction.hh"
+
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPVParameterisation.hh"
+#include "G4VSolid.hh"
+#include "G4AffineTransform.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ThreeVector.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+    
+    void PrintUsage()
+    {
+        G4cerr << " Usage: GeometryOverlapChecker [-points n] [-tolerance mm] [-threads n] [-volume name]" << G4endl;
+    }
+    
+    ////    A daughter volume (or a copy of a parameterised one) in the frame of its mother
+    struct Placement
+    {
+        G4String            name;
+        G4int               copyNo;
+        const G4VSolid*     solid;
+        G4AffineTransform   transform;      // daughter -> mother
+        G4ThreeVector       lower, upper;   // bounding box in the mother
+    };
+    
+    ////    The daughters of a logical volume
+    struct Mother
+    {
+        const G4LogicalVolume*  logical;
+        std::vector<Placement>  daughters;
+    };
+    
+    struct Clash
+    {
+        G4int           mother;
+        G4int           daughter;
+        G4int           sister;         // -1: protrusion from the mother
+        G4long          nPoints;
+        G4double        depth;
+        G4ThreeVector   position;       // deepest point, in the mother
+    };
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    void SetBoundingBox(Placement& placement)
+    {
+        G4ThreeVector lower, upper;
+        placement.solid->BoundingLimits(lower, upper);
+        
+        placement.lower = G4ThreeVector(kInfinity, kInfinity, kInfinity);
+        placement.upper = -placement.lower;
+        for(G4int i=0; i<8; i++)
+        {
+            const G4ThreeVector corner((i & 1) ? upper.x() : lower.x(), (i & 2) ? upper.y() : lower.y(), (i & 4) ? upper.z() : lower.z());
+            const G4ThreeVector p = placement.transform.TransformPoint(corner);
+            placement.lower = G4ThreeVector(std::min(placement.lower.x(), p.x()), std::min(placement.lower.y(), p.y()), std::min(placement.lower.z(), p.z()));
+            placement.upper = G4ThreeVector(std::max(placement.upper.x(), p.x()), std::max(placement.upper.y(), p.y()), std::max(placement.upper.z(), p.z()));
+        }
+    }
+    
+    G4bool InBox(const Placement& placement, const G4ThreeVector& p)
+    {
+        return p.x()>=placement.lower.x() && p.x()<=placement.upper.x()
+        && p.y()>=placement.lower.y() && p.y()<=placement.upper.y()
+        && p.z()>=placement.lower.z() && p.z()<=placement.upper.z();
+    }
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    ////    The daughters of every logical volume under logical, each logical volume once.
+    ////    Parameterised copies are evaluated here, on one thread: their solids are
+    ////    cloned where the parameterisation resizes a shared one.
+    void CollectMothers(const G4LogicalVolume* logical, std::set<const G4LogicalVolume*>& visited, std::vector<Mother>& mothers)
+    {
+        if(!visited.insert(logical).second || logical->GetNoDaughters()==0) return;
+        
+        Mother mother;
+        mother.logical = logical;
+        
+        for(std::size_t i=0; i<logical->GetNoDaughters(); i++)
+        {
+            G4VPhysicalVolume* daughter = logical->GetDaughter(G4int(i));
+            
+            if(daughter->IsParameterised())
+            {
+                G4VPVParameterisation* parameterisation = daughter->GetParameterisation();
+                for(G4int n=0; n<daughter->GetMultiplicity(); n++)
+                {
+                    daughter->SetCopyNo(n);
+                    G4VSolid* solid = parameterisation->ComputeSolid(n, daughter);
+                    solid->ComputeDimensions(parameterisation, n, daughter);
+                    parameterisation->ComputeTransformation(n, daughter);
+                    
+                    if(solid==daughter->GetLogicalVolume()->GetSolid()) solid = solid->Clone();
+                    if(!solid)
+                    {
+                        G4cerr << "GeometryOverlapChecker: cannot evaluate the copies of " << daughter->GetName() << ", skipped" << G4endl;
+                        break;
+                    }
+                    
+                    Placement placement;
+                    placement.name = daughter->GetName();
+                    placement.copyNo = daughter->GetCopyNo();
+                    placement.solid = solid;
+                    placement.transform = G4AffineTransform(daughter->GetRotation(), daughter->GetTranslation());
+                    SetBoundingBox(placement);
+                    mother.daughters.push_back(placement);
+                }
+            }
+            else if(daughter->IsReplicated())
+            {
+                G4cerr << "GeometryOverlapChecker: replica " << daughter->GetName() << " skipped" << G4endl;
+            }
+            else
+            {
+                Placement placement;
+                placement.name = daughter->GetName();
+                placement.copyNo = daughter->GetCopyNo();
+                placement.solid = daughter->GetLogicalVolume()->GetSolid();
+                placement.transform = G4AffineTransform(daughter->GetRotation(), daughter->GetTranslation());
+                SetBoundingBox(placement);
+                mother.daughters.push_back(placement);
+            }
+            
+            CollectMothers(daughter->GetLogicalVolume(), visited, mothers);
+        }
+        
+        mothers.push_back(mother);
+    }
+    
+    //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+    
+    ////    CheckOverlaps() of one daughter: its clashes, one per other volume
+    std::vector<Clash> CheckDaughter(const std::vector<Mother>& mothers, G4int m, G4int d, G4long nPoints, G4double tolerance)
+    {
+        const Mother& mother = mothers[m];
+        const Placement& placement = mother.daughters[d];
+        const G4VSolid* motherSolid = mother.logical->GetSolid();
+        
+        std::map<G4int, Clash> clashes;
+        
+        for(G4long n=0; n<nPoints; n++)
+        {
+            const G4ThreeVector p = placement.transform.TransformPoint(placement.solid->GetPointOnSurface());
+            
+            if(motherSolid->Inside(p)==kOutside)
+            {
+                const G4double depth = motherSolid->DistanceToIn(p);
+                if(depth>tolerance)
+                {
+                    Clash& clash = clashes.insert(std::make_pair(-1, Clash{m, d, -1, 0, 0., p})).first->second;
+                    clash.nPoints++;
+                    if(depth>clash.depth)
+                    {
+                        clash.depth = depth;
+                        clash.position = p;
+                    }
+                }
+            }
+            
+            for(std::size_t s=0; s<mother.daughters.size(); s++)
+            {
+                const Placement& sister = mother.daughters[s];
+                if(G4int(s)==d || !InBox(sister, p)) continue;
+                
+                const G4ThreeVector q = sister.transform.InverseTransformPoint(p);
+                if(sister.solid->Inside(q)!=kInside) continue;
+                
+                const G4double depth = sister.solid->DistanceToOut(q);
+                if(depth<=tolerance) continue;
+                
+                Clash& clash = clashes.insert(std::make_pair(G4int(s), Clash{m, d, G4int(s), 0, 0., p})).first->second;
+                clash.nPoints++;
+                if(depth>clash.depth)
+                {
+                    clash.depth = depth;
+                    clash.position = p;
+                }
+            }
+        }
+        
+        std::vector<Clash> result;
+        for(std::map<G4int, Clash>::const_iterator clash = clashes.begin(); clash!=clashes.end(); clash++) result.push_back(clash->second);
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    G4long nPoints = 10000;
+    G4double tolerance = 0.;
+    unsigned int nThreads = std::max(1u, std::thread::hardware_concurrency());
+    G4String volumeName;
+    
+    for(int i=1; i<argc; i++)
+    {
+        const G4String argument = argv[i];
+        const bool hasValue = (i+1<argc);
+        
+        if(argument=="-points" && hasValue)         nPoints = std::atol(argv[++i]);
+        else if(argument=="-tolerance" && hasValue) tolerance = std::atof(argv[++i])*mm;
+        else if(argument=="-threads" && hasValue)   nThreads = std::strtoul(argv[++i], 0, 10);
+        else if(argument=="-volume" && hasValue)    volumeName = argv[++i];
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+    
+    if(nPoints<=0 || nThreads==0 || tolerance<0.)
+    {
+        PrintUsage();
+        return 1;
+    }
+    
+    //------------------------------------------------
+    //      Geometry
+    DetectorConstruction* detectorConstruction = new DetectorConstruction();
+    const G4VPhysicalVolume* world = detectorConstruction->Construct();
+    
+    std::vector<Mother> mothers;
+    std::set<const G4LogicalVolume*> visited;
+    CollectMothers(world->GetLogicalVolume(), visited, mothers);
+    
+    ////    Work list, and the first point of every solid on this thread:
+    ////    some solids (e.g. booleans) set up their surface sampling on first use
+    std::vector<std::pair<G4int, G4int> > work;
+    for(std::size_t m=0; m<mothers.size(); m++)
+    {
+        for(std::size_t d=0; d<mothers[m].daughters.size(); d++)
+        {
+            if(!volumeName.empty() && mothers[m].daughters[d].name!=volumeName) continue;
+            mothers[m].daughters[d].solid->GetPointOnSurface();
+            work.push_back(std::make_pair(G4int(m), G4int(d)));
+        }
+    }
+    
+    G4cout << "\n GeometryOverlapChecker: " << work.size() << " volumes, " << nPoints << " points each, "
+    << nThreads << " threads, tolerance " << tolerance/mm << " mm" << G4endl;
+    
+    //------------------------------------------------
+    //      Checks, volume by volume
+    std::atomic<std::size_t> next(0);
+    std::mutex mutex_clashes;
+    std::vector<Clash> clashes;
+    
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    
+    std::vector<std::thread> threads;
+    for(unsigned int t=0; t<nThreads; t++)
+    {
+        threads.push_back(std::thread([&]()
+        {
+            for(std::size_t i=next++; i<work.size(); i=next++)
+            {
+                const std::vector<Clash> found = CheckDaughter(mothers, work[i].first, work[i].second, nPoints, tolerance);
+                if(found.empty()) continue;
+                
+                std::lock_guard<std::mutex> lock(mutex_clashes);
+                clashes.insert(clashes.end(), found.begin(), found.end());
+            }
+        }));
+    }
+    for(std::size_t t=0; t<threads.size(); t++) threads[t].join();
+    
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    
+    //------------------------------------------------
+    //      Report, in geometry order
+    std::sort(clashes.begin(), clashes.end(), [](const Clash& a, const Clash& b)
+    {
+        return a.mother!=b.mother ? a.mother<b.mother : (a.daughter!=b.daughter ? a.daughter<b.daughter : a.sister<b.sister);
+    });
+    
+    for(std::size_t i=0; i<clashes.size(); i++)
+    {
+        const Clash& clash = clashes[i];
+        const Mother& mother = mothers[clash.mother];
+        const Placement& daughter = mother.daughters[clash.daughter];
+        
+        G4cout << " " << daughter.name << " [" << daughter.copyNo << "] ";
+        if(clash.sister<0) G4cout << "protrudes from its mother " << mother.logical->GetName();
+        else
+        {
+            const Placement& sister = mother.daughters[clash.sister];
+            G4cout << "overlaps " << sister.name << " [" << sister.copyNo << "] in " << mother.logical->GetName();
+        }
+        G4cout << ": " << clash.nPoints << " points, up to " << clash.depth/mm << " mm at ("
+        << clash.position.x()/mm << ", " << clash.position.y()/mm << ", " << clash.position.z()/mm << ") mm" << G4endl;
+    }
+    
+    G4cout << "\n GeometryOverlapChecker: " << clashes.size() << " clashes in " << work.size() << " volumes ("
+    << std::fixed << std::setprecision(1) << elapsed.count() << " s)\n" << G4endl;
+    
+    return clashes.empty() ? 0 : 2;
+}
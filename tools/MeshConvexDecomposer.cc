@@ -0,0 +1,147 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+//      Writes the approximate convex decomposition of a closed PLY mesh
+//      (MeshConvexDecomposition), for use in place of the tessellated solid
+//      with CachedCADMesh::SetConvexDecomposition().
+//
+//      Usage: MeshConvexDecomposer [options] input.ply [output.ply]
+//
+//      Options:
+//          -tolerance <mm>     largest depth of the surface below the hull of its piece (default 0.5 mm)
+//          -pieces <n>         largest number of pieces (default 256)
+//          -probes <n>         random probes of the inside/outside regression check (default 1000000)
+//          -mismatch <f>       largest misclassified volume, relative to that of the mesh (default 0.01)
+//          -force              write the decomposition even if it fails the check
+//
+//      The output defaults to MeshConvexDecomposition::GetDecompositionFileName(),
+//      next to the input, which is where CachedCADMesh looks for it. Thin
+//      curved shells need many pieces; for them, tune the voxels of the
+//      tessellated solid instead (CachedCADMesh::SetMaxVoxels()).
+//
+
+#include "MeshConvexDecomposition.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <chrono>
+#include <cstdlib>
+
+namespace {
+    
+    void PrintUsage()
+    {
+        G4cerr << " Usage: MeshConvexDecomposer [-tolerance mm] [-pieces n] [-probes n] [-mismatch f] [-force] input.ply [output.ply]" << G4endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double tolerance = 0.5*mm;
+    std::size_t maxPieces = 256;
+    std::size_t nProbes = 1000000;
+    double maxMismatch = 0.01;
+    bool force = false;
+    std::vector<G4String> files;
+    
+    for(int i=1; i<argc; i++)
+    {
+        const G4String argument = argv[i];
+        const bool hasValue = (i+1<argc);
+        
+        if(argument=="-tolerance" && hasValue)      tolerance = std::atof(argv[++i])*mm;
+        else if(argument=="-pieces" && hasValue)    maxPieces = std::strtoul(argv[++i], 0, 10);
+        else if(argument=="-probes" && hasValue)    nProbes = std::strtoul(argv[++i], 0, 10);
+        else if(argument=="-mismatch" && hasValue)  maxMismatch = std::atof(argv[++i]);
+        else if(argument=="-force")                 force = true;
+        else if(argument.size()>1 && argument[0]=='-')
+        {
+            PrintUsage();
+            return 1;
+        }
+        else files.push_back(argument);
+    }
+    
+    if(files.empty() || files.size()>2 || tolerance<=0. || maxPieces==0)
+    {
+        PrintUsage();
+        return 1;
+    }
+    
+    const G4String output = (files.size()==2) ? files[1] : MeshConvexDecomposition::GetDecompositionFileName(files[0]);
+    
+    TriangleMesh mesh;
+    if(!mesh.ReadPLY(files[0]))
+    {
+        G4cerr << "MeshConvexDecomposer: cannot read " << files[0] << G4endl;
+        return 1;
+    }
+    
+    //------------------------------------------------
+    //      Decompose (the PLY files are in mm)
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const std::vector<TriangleMesh> pieces = MeshConvexDecomposition::Decompose(mesh, tolerance/mm, maxPieces);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    std::size_t nTriangles = 0;
+    double volume = 0.;
+    for(std::size_t i=0; i<pieces.size(); i++)
+    {
+        nTriangles += pieces[i].GetNumberOfTriangles();
+        volume += pieces[i].GetVolume();
+    }
+    
+    ////    Regression check: inside/outside of the union against the mesh
+    const double mismatch = MeshConvexDecomposition::ClassificationMismatch(mesh, pieces, nProbes);
+    const bool passed = (mismatch <= maxMismatch);
+    
+    G4cout << "MeshConvexDecomposer: " << files[0] << G4endl
+    << "  pieces:             " << pieces.size() << (pieces.size()>=maxPieces ? " (limit reached)" : "") << " in " << seconds << " s" << G4endl
+    << "  facets:             " << mesh.GetNumberOfTriangles() << " -> " << nTriangles << G4endl
+    << "  volume:             " << mesh.GetVolume()/1000. << " cm3, pieces " << volume/1000. << " cm3 (with overlaps)" << G4endl
+    << "  misclassified:      " << 100.*mismatch << "% of the volume, " << nProbes << " probes (limit " << 100.*maxMismatch << "%): "
+    << (passed ? "passed" : "FAILED") << G4endl;
+    
+    if(!passed && !force) return 2;
+    
+    if(!MeshConvexDecomposition::WritePLY(output, pieces))
+    {
+        G4cerr << "MeshConvexDecomposer: cannot write " << output << G4endl;
+        return 1;
+    }
+    G4cout << "  written to " << output << G4endl;
+    
+    return passed ? 0 : 2;
+}
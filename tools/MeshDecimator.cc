@@ -0,0 +1,127 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+//      Writes a decimated level of detail of a PLY mesh (MeshDecimation),
+//      for use in place of the full mesh with CachedCADMesh::SetLevelOfDetail().
+//
+//      Usage: MeshDecimator [options] input.ply [output.ply]
+//
+//      Options:
+//          -tolerance <mm>     largest deviation from the original facet planes (default 0.1 mm)
+//          -target <n>         stop at n triangles, even if the tolerance would allow fewer
+//          -samples <n>        random surface points per mesh for the Hausdorff check (default 100000)
+//
+//      The output defaults to MeshDecimation::GetLevelOfDetailFileName(), next
+//      to the input, which is where CachedCADMesh looks for it.
+//
+
+#include "MeshDecimation.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <chrono>
+#include <cstdlib>
+
+namespace {
+    
+    void PrintUsage()
+    {
+        G4cerr << " Usage: MeshDecimator [-tolerance mm] [-target n] [-samples n] input.ply [output.ply]" << G4endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double tolerance = 0.1*mm;
+    std::size_t targetTriangles = 0;
+    std::size_t nSamples = 100000;
+    std::vector<G4String> files;
+    
+    for(int i=1; i<argc; i++)
+    {
+        const G4String argument = argv[i];
+        const bool hasValue = (i+1<argc);
+        
+        if(argument=="-tolerance" && hasValue)          tolerance = std::atof(argv[++i])*mm;
+        else if(argument=="-target" && hasValue)        targetTriangles = std::strtoul(argv[++i], 0, 10);
+        else if(argument=="-samples" && hasValue)       nSamples = std::strtoul(argv[++i], 0, 10);
+        else if(argument.size()>1 && argument[0]=='-')
+        {
+            PrintUsage();
+            return 1;
+        }
+        else files.push_back(argument);
+    }
+    
+    if(files.empty() || files.size()>2 || tolerance<=0.)
+    {
+        PrintUsage();
+        return 1;
+    }
+    
+    const G4String output = (files.size()==2) ? files[1] : MeshDecimation::GetLevelOfDetailFileName(files[0], tolerance);
+    
+    TriangleMesh mesh;
+    if(!mesh.ReadPLY(files[0]))
+    {
+        G4cerr << "MeshDecimator: cannot read " << files[0] << G4endl;
+        return 1;
+    }
+    
+    //------------------------------------------------
+    //      Decimate (the PLY files are in mm)
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const TriangleMesh decimated = MeshDecimation::Decimate(mesh, tolerance/mm, targetTriangles);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    const double volume = mesh.GetVolume(), decimatedVolume = decimated.GetVolume();
+    const double distance = MeshDecimation::HausdorffDistance(mesh, decimated, nSamples);
+    
+    G4cout << "MeshDecimator: " << files[0] << G4endl
+    << "  triangles:          " << mesh.GetNumberOfTriangles() << " -> " << decimated.GetNumberOfTriangles()
+    << " (" << 100.*decimated.GetNumberOfTriangles()/mesh.GetNumberOfTriangles() << "%) in " << seconds << " s" << G4endl
+    << "  volume:             " << volume/1000. << " -> " << decimatedVolume/1000. << " cm3 ("
+    << 100.*(decimatedVolume - volume)/volume << "%)" << G4endl
+    << "  Hausdorff distance: " << distance*mm/um << " um (tolerance " << tolerance/um << " um)" << G4endl;
+    
+    if(!decimated.WritePLY(output))
+    {
+        G4cerr << "MeshDecimator: cannot write " << output << G4endl;
+        return 1;
+    }
+    G4cout << "  written to " << output << G4endl;
+    
+    return 0;
+}
@@ -0,0 +1,473 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+//      Fits a multipole expansion with Enge fringe fields (MultipoleFieldExpansion)
+//      to a tabulated field map, e.g. the measured K600 quadrupole map.
+//
+//      Usage: MultipoleFieldFitter [options] table.TABLE output.txt
+//
+//      Options (lengths in mm):
+//          -order <n>          highest multipole (default 4: up to the octupole)
+//          -pseudo <k>         highest pseudo-multipole term (default 2)
+//          -radius <R>         reference radius (default: the largest circle inside the map)
+//          -rmax <r>           only fit points within r of the axis (default R)
+//          -enge <D>           length scale of the Enge functions (default 2R)
+//          -maxPoints <n>      fit a regular subsample of at most n points (default 200000)
+//
+//      The amplitudes b_n, a_n enter linearly and are solved for exactly at
+//      every step; the axis position, effective field boundaries and Enge
+//      coefficients are found with Levenberg-Marquardt.
+//
+
+#include "MagneticFieldMapData.hh"
+#include "MultipoleFieldExpansion.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    struct FitPoint
+    {
+        double  x, y, z;
+        double  B[3];
+    };
+    
+    const int kNumberOfParameters = 10;   // x0, y0, zEntrance, zExit, engeEntrance[1..3], engeExit[1..3]
+    
+    //------------------------------------------------------------------
+    void PrintUsage()
+    {
+        G4cerr << " Usage: MultipoleFieldFitter [-order n] [-pseudo k] [-radius R] [-rmax r] [-enge D] [-maxPoints n]"
+        << " table.TABLE output.txt" << G4endl;
+    }
+    
+    //------------------------------------------------------------------
+    void SetParameters(const double* p, MultipoleFieldParameters& parameters)
+    {
+        parameters.x0 = p[0];
+        parameters.y0 = p[1];
+        parameters.zEntrance = p[2];
+        parameters.zExit = p[3];
+        for(int i=1; i<4; i++)
+        {
+            parameters.engeEntrance[i] = p[3+i];
+            parameters.engeExit[i] = p[6+i];
+        }
+    }
+    
+    //------------------------------------------------------------------
+    ////    Solves A x = b (n x n, row-major) by Gaussian elimination with partial pivoting
+    bool SolveLinearSystem(std::vector<double> A, std::vector<double>& b, int n)
+    {
+        for(int col=0; col<n; col++)
+        {
+            int pivot = col;
+            for(int row=col+1; row<n; row++)
+            {
+                if(std::abs(A[row*n + col])>std::abs(A[pivot*n + col])) pivot = row;
+            }
+            if(A[pivot*n + col]==0.) return false;
+            
+            if(pivot!=col)
+            {
+                for(int k=0; k<n; k++) std::swap(A[col*n + k], A[pivot*n + k]);
+                std::swap(b[col], b[pivot]);
+            }
+            
+            for(int row=col+1; row<n; row++)
+            {
+                const double factor = A[row*n + col]/A[col*n + col];
+                for(int k=col; k<n; k++) A[row*n + k] -= factor*A[col*n + k];
+                b[row] -= factor*b[col];
+            }
+        }
+        
+        for(int row=n-1; row>=0; row--)
+        {
+            double sum = b[row];
+            for(int k=row+1; k<n; k++) sum -= A[row*n + k]*b[k];
+            b[row] = sum/A[row*n + row];
+        }
+        
+        return true;
+    }
+    
+    //------------------------------------------------------------------
+    ////    Least-squares amplitudes for the current non-linear parameters, and the residuals
+    double FitAmplitudes(MultipoleFieldParameters& parameters, const std::vector<FitPoint>& points,
+                         std::vector<double>& residuals)
+    {
+        const int order = parameters.order;
+        const int nBasis = 2*order;
+        
+        std::vector<double> normalMatrix(nBasis*nBasis, 0.), rightHandSide(nBasis, 0.);
+        double basis[MultipoleFieldExpansion::kMaxBasis][3];
+        
+        for(std::size_t i=0; i<points.size(); i++)
+        {
+            const FitPoint& point = points[i];
+            MultipoleFieldExpansion::EvaluateBasis(parameters, point.x - parameters.x0, point.y - parameters.y0, point.z, basis);
+            
+            for(int l=0; l<nBasis; l++)
+            {
+                for(int m=l; m<nBasis; m++)
+                {
+                    normalMatrix[l*nBasis + m] += basis[l][0]*basis[m][0] + basis[l][1]*basis[m][1] + basis[l][2]*basis[m][2];
+                }
+                rightHandSide[l] += basis[l][0]*point.B[0] + basis[l][1]*point.B[1] + basis[l][2]*point.B[2];
+            }
+        }
+        
+        ////    Symmetrise, with a tiny ridge against unconstrained (e.g. vanishing) basis fields
+        double trace = 0.;
+        for(int l=0; l<nBasis; l++) trace += normalMatrix[l*nBasis + l];
+        for(int l=0; l<nBasis; l++)
+        {
+            for(int m=0; m<l; m++) normalMatrix[l*nBasis + m] = normalMatrix[m*nBasis + l];
+            normalMatrix[l*nBasis + l] += 1e-12*trace/nBasis;
+        }
+        
+        if(!SolveLinearSystem(normalMatrix, rightHandSide, nBasis)) return HUGE_VAL;
+        
+        for(int n=0; n<order; n++)
+        {
+            parameters.normal[n] = rightHandSide[n];
+            parameters.skew[n] = rightHandSide[order + n];
+        }
+        
+        residuals.resize(3*points.size());
+        double sum = 0.;
+        
+        for(std::size_t i=0; i<points.size(); i++)
+        {
+            const FitPoint& point = points[i];
+            MultipoleFieldExpansion::EvaluateBasis(parameters, point.x - parameters.x0, point.y - parameters.y0, point.z, basis);
+            
+            for(int k=0; k<3; k++)
+            {
+                double model = 0.;
+                for(int l=0; l<nBasis; l++) model += rightHandSide[l]*basis[l][k];
+                
+                residuals[3*i + k] = model - point.B[k];
+                sum += residuals[3*i + k]*residuals[3*i + k];
+            }
+        }
+        
+        return sum;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    MultipoleFieldParameters parameters;
+    parameters.order = 4;
+    parameters.pseudoOrder = 2;
+    
+    double referenceRadius = 0., rMax = 0., engeLength = 0.;
+    long maxPoints = 200000;
+    std::vector<G4String> files;
+    
+    for(int i=1; i<argc; i++)
+    {
+        const G4String argument = argv[i];
+        const bool hasValue = (i+1<argc);
+        
+        if(argument=="-order" && hasValue)              parameters.order = std::atoi(argv[++i]);
+        else if(argument=="-pseudo" && hasValue)        parameters.pseudoOrder = std::atoi(argv[++i]);
+        else if(argument=="-radius" && hasValue)        referenceRadius = std::atof(argv[++i])*mm;
+        else if(argument=="-rmax" && hasValue)          rMax = std::atof(argv[++i])*mm;
+        else if(argument=="-enge" && hasValue)          engeLength = std::atof(argv[++i])*mm;
+        else if(argument=="-maxPoints" && hasValue)     maxPoints = std::atol(argv[++i]);
+        else if(argument.size()>1 && argument[0]=='-')
+        {
+            PrintUsage();
+            return 1;
+        }
+        else files.push_back(argument);
+    }
+    
+    if(files.size()!=2 || parameters.order<1 || parameters.order>MultipoleFieldExpansion::kMaxOrder
+       || parameters.pseudoOrder<0 || parameters.pseudoOrder>MultipoleFieldExpansion::kMaxPseudoOrder || maxPoints<1)
+    {
+        PrintUsage();
+        return 1;
+    }
+    
+    parameters.normal.assign(parameters.order, 0.);
+    parameters.skew.assign(parameters.order, 0.);
+    
+    //------------------------------------------------
+    //      The tabulated points
+    std::shared_ptr<const MagneticFieldMapData> map = MagneticFieldMapData::Load(files[0]);
+    if(!map) return 1;
+    
+    const int n[3] = {map->GetNx(), map->GetNy(), map->GetNz()};
+    const double minimum[3] = {map->GetMinX(), map->GetMinY(), map->GetMinZ()};
+    const double maximum[3] = {map->GetMaxX(), map->GetMaxY(), map->GetMaxZ()};
+    const bool invert[3] = {map->GetInvertX(), map->GetInvertY(), map->GetInvertZ()};
+    
+    if(referenceRadius<=0.)
+    {
+        referenceRadius = std::min(std::min(-minimum[0], maximum[0]), std::min(-minimum[1], maximum[1]));
+        if(referenceRadius<=0.)
+        {
+            G4cerr << "MultipoleFieldFitter: the map does not contain the axis x = y = 0, give -radius" << G4endl;
+            return 1;
+        }
+    }
+    if(rMax<=0.) rMax = referenceRadius;
+    if(engeLength<=0.) engeLength = 2.*referenceRadius;
+    
+    parameters.referenceRadius = referenceRadius;
+    parameters.engeLength = engeLength;
+    parameters.rMax = rMax;
+    parameters.zMin = minimum[2];
+    parameters.zMax = maximum[2];
+    
+    std::vector<FitPoint> allPoints;
+    int index[3];
+    
+    for(index[0]=0; index[0]<n[0]; index[0]++)
+    {
+        for(index[1]=0; index[1]<n[1]; index[1]++)
+        {
+            for(index[2]=0; index[2]<n[2]; index[2]++)
+            {
+                double position[3];
+                for(int a=0; a<3; a++)
+                {
+                    const double spacing = (n[a]>1) ? (maximum[a] - minimum[a])/(n[a]-1) : 0.;
+                    position[a] = invert[a] ? maximum[a] - index[a]*spacing : minimum[a] + index[a]*spacing;
+                }
+                
+                if(position[0]*position[0] + position[1]*position[1] > rMax*rMax) continue;
+                
+                FitPoint point;
+                point.x = position[0];
+                point.y = position[1];
+                point.z = position[2];
+                map->GetCellField(index[0], index[1], index[2], point.B);
+                allPoints.push_back(point);
+            }
+        }
+    }
+    
+    std::vector<FitPoint> points;
+    const std::size_t step = (allPoints.size() + maxPoints - 1)/maxPoints;
+    for(std::size_t i=0; i<allPoints.size(); i+=std::max(step, std::size_t(1))) points.push_back(allPoints[i]);
+    
+    if(points.size() < std::size_t(2*parameters.order + kNumberOfParameters))
+    {
+        G4cerr << "MultipoleFieldFitter: only " << points.size() << " map points within r = " << rMax/mm << " mm" << G4endl;
+        return 1;
+    }
+    
+    //------------------------------------------------
+    //      Starting values: boundaries at half the peak transverse field along z
+    std::vector<double> profile(n[2], 0.), profileZ(n[2], 0.);
+    std::vector<int> profileCount(n[2], 0);
+    const double zSpacing = (n[2]>1) ? (maximum[2] - minimum[2])/(n[2]-1) : 1.;
+    
+    for(std::size_t i=0; i<allPoints.size(); i++)
+    {
+        const int iz = int(std::floor((allPoints[i].z - minimum[2])/zSpacing + 0.5));
+        profile[iz] += std::sqrt(allPoints[i].B[0]*allPoints[i].B[0] + allPoints[i].B[1]*allPoints[i].B[1]);
+        profileCount[iz]++;
+    }
+    
+    int peak = 0;
+    for(int iz=0; iz<n[2]; iz++)
+    {
+        profileZ[iz] = minimum[2] + iz*zSpacing;
+        if(profileCount[iz]>0) profile[iz] /= profileCount[iz];
+        if(profile[iz]>profile[peak]) peak = iz;
+    }
+    
+    double zEntrance = minimum[2], zExit = maximum[2];
+    for(int iz=peak; iz>0; iz--)
+    {
+        if(profile[iz-1]<0.5*profile[peak])
+        {
+            zEntrance = profileZ[iz-1] + zSpacing*(0.5*profile[peak] - profile[iz-1])/(profile[iz] - profile[iz-1]);
+            break;
+        }
+    }
+    for(int iz=peak; iz<n[2]-1; iz++)
+    {
+        if(profile[iz+1]<0.5*profile[peak])
+        {
+            zExit = profileZ[iz] + zSpacing*(profile[iz] - 0.5*profile[peak])/(profile[iz] - profile[iz+1]);
+            break;
+        }
+    }
+    
+    double p[kNumberOfParameters] = {0., 0., zEntrance, zExit, 4., 0., 0., 4., 0., 0.};
+    const double stepScale[kNumberOfParameters] = {0.01*mm, 0.01*mm, 0.01*mm, 0.01*mm, 1e-4, 1e-4, 1e-4, 1e-4, 1e-4, 1e-4};
+    
+    G4cout << "MultipoleFieldFitter: " << points.size() << " points within r = " << rMax/mm << " mm, R = "
+    << referenceRadius/mm << " mm, D = " << engeLength/mm << " mm" << G4endl;
+    G4cout << "  starting boundaries " << zEntrance/mm << " / " << zExit/mm << " mm" << G4endl;
+    
+    //------------------------------------------------
+    //      Levenberg-Marquardt over the non-linear parameters
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    
+    std::vector<double> residuals, shiftedResiduals;
+    SetParameters(p, parameters);
+    double cost = FitAmplitudes(parameters, points, residuals);
+    double lambda = 1e-3;
+    
+    for(int iteration=0; iteration<200; iteration++)
+    {
+        ////    Forward-difference Jacobian, accumulated into J^T J and J^T r
+        double JTJ[kNumberOfParameters*kNumberOfParameters] = {0.};
+        double JTr[kNumberOfParameters] = {0.};
+        std::vector<std::vector<double>> jacobian(kNumberOfParameters);
+        
+        for(int j=0; j<kNumberOfParameters; j++)
+        {
+            double shifted[kNumberOfParameters];
+            std::copy(p, p + kNumberOfParameters, shifted);
+            const double h = std::max(1e-6*std::abs(p[j]), stepScale[j]);
+            shifted[j] += h;
+            
+            MultipoleFieldParameters shiftedParameters = parameters;
+            SetParameters(shifted, shiftedParameters);
+            FitAmplitudes(shiftedParameters, points, shiftedResiduals);
+            
+            jacobian[j].resize(residuals.size());
+            for(std::size_t i=0; i<residuals.size(); i++) jacobian[j][i] = (shiftedResiduals[i] - residuals[i])/h;
+        }
+        
+        for(int j=0; j<kNumberOfParameters; j++)
+        {
+            for(std::size_t i=0; i<residuals.size(); i++) JTr[j] += jacobian[j][i]*residuals[i];
+            for(int l=0; l<=j; l++)
+            {
+                double sum = 0.;
+                for(std::size_t i=0; i<residuals.size(); i++) sum += jacobian[j][i]*jacobian[l][i];
+                JTJ[j*kNumberOfParameters + l] = JTJ[l*kNumberOfParameters + j] = sum;
+            }
+        }
+        
+        ////    Damped steps until the cost decreases
+        G4bool improved = false;
+        double trialCost = cost;
+        
+        while(lambda<1e10)
+        {
+            std::vector<double> A(JTJ, JTJ + kNumberOfParameters*kNumberOfParameters);
+            std::vector<double> delta(kNumberOfParameters);
+            for(int j=0; j<kNumberOfParameters; j++)
+            {
+                A[j*kNumberOfParameters + j] += lambda*(JTJ[j*kNumberOfParameters + j] + 1e-30);
+                delta[j] = -JTr[j];
+            }
+            
+            if(SolveLinearSystem(A, delta, kNumberOfParameters))
+            {
+                double trial[kNumberOfParameters];
+                for(int j=0; j<kNumberOfParameters; j++) trial[j] = p[j] + delta[j];
+                
+                MultipoleFieldParameters trialParameters = parameters;
+                SetParameters(trial, trialParameters);
+                std::vector<double> trialResiduals;
+                trialCost = FitAmplitudes(trialParameters, points, trialResiduals);
+                
+                if(trialCost<cost)
+                {
+                    std::copy(trial, trial + kNumberOfParameters, p);
+                    parameters = trialParameters;
+                    residuals.swap(trialResiduals);
+                    lambda = std::max(lambda/3., 1e-12);
+                    improved = true;
+                    break;
+                }
+            }
+            lambda *= 4.;
+        }
+        
+        if(!improved) break;
+        
+        const double relativeChange = (cost - trialCost)/cost;
+        cost = trialCost;
+        if(relativeChange<1e-9) break;
+    }
+    
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    
+    //------------------------------------------------
+    //      Quality of the fit
+    double largestField = 0., largestResidual = 0.;
+    for(std::size_t i=0; i<points.size(); i++)
+    {
+        for(int k=0; k<3; k++)
+        {
+            largestField = std::max(largestField, std::abs(points[i].B[k]));
+            largestResidual = std::max(largestResidual, std::abs(residuals[3*i + k]));
+        }
+    }
+    
+    const double rmsResidual = std::sqrt(cost/residuals.size());
+    
+    G4cout << "  fitted in " << elapsed.count() << " s"
+    << "\n  axis (" << parameters.x0/mm << ", " << parameters.y0/mm << ") mm, boundaries "
+    << parameters.zEntrance/mm << " / " << parameters.zExit/mm << " mm"
+    << "\n  rms residual " << rmsResidual/tesla << " T, largest " << largestResidual/tesla
+    << " T (largest |B_k| " << largestField/tesla << " T)" << G4endl;
+    
+    for(int i=0; i<parameters.order; i++)
+    {
+        G4cout << "  n = " << i+1 << ":  b = " << parameters.normal[i]/tesla << " T,  a = " << parameters.skew[i]/tesla << " T" << G4endl;
+    }
+    if(parameters.order>=2)
+    {
+        G4cout << "  equivalent quadrupole gradient b2/R = " << parameters.normal[1]/referenceRadius/(tesla/cm) << " T/cm" << G4endl;
+    }
+    
+    if(!parameters.Write(files[1]))
+    {
+        G4cerr << "MultipoleFieldFitter: cannot write " << files[1] << G4endl;
+        return 1;
+    }
+    
+    G4cout << "MultipoleFieldFitter: wrote " << files[1] << G4endl;
+    
+    return 0;
+}
@@ -0,0 +1,197 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//      ----------------------------------------------------------------
+//                      K600 Spectrometer (iThemba Labs)
+//      ----------------------------------------------------------------
+//
+//      Github repository: https://www.github.com/KevinCWLi/K600
+//
+//      Main Author:    K.C.W. Li
+//
+//      email: likevincw@gmail.com
+//
+
+//      Fits the ion-optical transfer map of the K600 spectrometer
+//      (SpectrometerTransferMap) to samples recorded in full-tracking runs.
+//
+//      Usage: TransferMapFitter [options] output.txt samples [samples ...]
+//
+//      Options:
+//          -order <n>          total order of the polynomials (default 5)
+//          -reference <R>      reference rigidity p/q in MeV/c (default: the median of the samples)
+//
+//      Every fifth sample is held out of the fit and used to check the map.
+//      The samples are written by SpectrometerTransferMapRecorder when
+//      DetectorConstruction has a K600_TransferMapSampleFile; the rays should
+//      cover the whole acceptance in position, angle and momentum.
+//
+
+#include "SpectrometerTransferMap.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    
+    void PrintUsage()
+    {
+        G4cerr << " Usage: TransferMapFitter [-order n] [-reference rigidity] output.txt samples [samples ...]" << G4endl;
+    }
+    
+    //------------------------------------------------------------------
+    ////    rms and largest residual of every output; returns the number of samples outside the map
+    long Residuals(const SpectrometerTransferMap& map, const std::vector<TransferMapSample>& samples,
+                   double* rms, double* maximum)
+    {
+        const int n = SpectrometerTransferMap::kNumberOfCoordinates;
+        long nOutside = 0, nInside = 0;
+        
+        for(int j=0; j<n; j++) rms[j] = maximum[j] = 0.;
+        
+        for(std::size_t s=0; s<samples.size(); s++)
+        {
+            double in[n], out[n];
+            for(int i=0; i<4; i++) in[i] = samples[s].in[i];
+            in[4] = samples[s].in[4]/map.GetReferenceRigidity() - 1.0;
+            
+            if(!map.Evaluate(in, out))
+            {
+                nOutside++;
+                continue;
+            }
+            
+            for(int j=0; j<n; j++)
+            {
+                const double residual = std::abs(out[j] - samples[s].out[j]);
+                rms[j] += residual*residual;
+                maximum[j] = std::max(maximum[j], residual);
+            }
+            nInside++;
+        }
+        
+        for(int j=0; j<n; j++) rms[j] = (nInside>0) ? std::sqrt(rms[j]/nInside) : 0.;
+        
+        return nOutside;
+    }
+    
+    void PrintResiduals(const char* label, const double* rms, const double* maximum)
+    {
+        G4cout << "  " << label
+        << "  x " << rms[0]/um << " / " << maximum[0]/um << " um"
+        << ",  a " << rms[1]*1e6 << " / " << maximum[1]*1e6 << " urad"
+        << ",  y " << rms[2]/um << " / " << maximum[2]/um << " um"
+        << ",  b " << rms[3]*1e6 << " / " << maximum[3]*1e6 << " urad"
+        << ",  l " << rms[4]/um << " / " << maximum[4]/um << " um" << G4endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int order = 5;
+    double referenceRigidity = 0.;
+    std::vector<G4String> files;
+    
+    for(int i=1; i<argc; i++)
+    {
+        const G4String argument = argv[i];
+        const bool hasValue = (i+1<argc);
+        
+        if(argument=="-order" && hasValue)              order = std::atoi(argv[++i]);
+        else if(argument=="-reference" && hasValue)     referenceRigidity = std::atof(argv[++i])*MeV;
+        else if(argument.size()>1 && argument[0]=='-')
+        {
+            PrintUsage();
+            return 1;
+        }
+        else files.push_back(argument);
+    }
+    
+    if(files.size()<2 || order<1 || order>SpectrometerTransferMap::kMaxOrder)
+    {
+        PrintUsage();
+        return 1;
+    }
+    
+    //------------------------------------------------
+    //      Samples
+    std::vector<TransferMapSample> samples;
+    TransferMapPlane entryPlane, exitPlane;
+    
+    for(std::size_t f=1; f<files.size(); f++)
+    {
+        if(!SpectrometerTransferMap::ReadSamples(files[f], samples, entryPlane, exitPlane))
+        {
+            G4cerr << "TransferMapFitter: cannot read " << files[f] << G4endl;
+            return 1;
+        }
+    }
+    
+    if(referenceRigidity<=0. && !samples.empty())
+    {
+        std::vector<double> rigidities(samples.size());
+        for(std::size_t s=0; s<samples.size(); s++) rigidities[s] = samples[s].in[4];
+        std::nth_element(rigidities.begin(), rigidities.begin() + rigidities.size()/2, rigidities.end());
+        referenceRigidity = rigidities[rigidities.size()/2];
+    }
+    
+    std::vector<TransferMapSample> fitSamples, checkSamples;
+    for(std::size_t s=0; s<samples.size(); s++) ((s%5==4) ? checkSamples : fitSamples).push_back(samples[s]);
+    
+    //------------------------------------------------
+    //      Fit
+    SpectrometerTransferMap map;
+    map.SetPlanes(entryPlane, exitPlane);
+    
+    if(!map.Fit(fitSamples, order, referenceRigidity))
+    {
+        G4cerr << "TransferMapFitter: " << fitSamples.size() << " samples do not determine a map of order " << order << G4endl;
+        return 1;
+    }
+    
+    G4cout << "TransferMapFitter: " << samples.size() << " samples, order " << order << " (" << map.GetNumberOfTerms()
+    << " terms), reference rigidity " << referenceRigidity/MeV << " MeV/c" << G4endl;
+    G4cout << "  residuals, rms / max:" << G4endl;
+    
+    double rms[SpectrometerTransferMap::kNumberOfCoordinates], maximum[SpectrometerTransferMap::kNumberOfCoordinates];
+    
+    Residuals(map, fitSamples, rms, maximum);
+    PrintResiduals("fit samples:     ", rms, maximum);
+    
+    const long nOutside = Residuals(map, checkSamples, rms, maximum);
+    PrintResiduals("held-out samples:", rms, maximum);
+    G4cout << "  held-out samples outside the map: " << nOutside << " of " << checkSamples.size() << G4endl;
+    
+    if(!map.Write(files[0]))
+    {
+        G4cerr << "TransferMapFitter: cannot write " << files[0] << G4endl;
+        return 1;
+    }
+    
+    return 0;
+}